@@ -108,6 +108,7 @@ static gchar* s_debugTrapStr = NULL;
 static gboolean s_forceSoftwareRendering = false;
 static gchar* s_mallocStatsFileStr = NULL;
 static int s_mallocStatsInterval = -1;
+static gboolean s_compileLocaleCatalogs = false;
 
 /**
  * Whether or not to debug crashes
@@ -608,6 +609,7 @@ static void parseCommandlineOptions(int argc, char** argv)
 		{ "force-software-rendering", 'S', 0, G_OPTION_ARG_NONE, &s_forceSoftwareRendering, "Force Software rendering", NULL},
 		{ "malloc-stats-file", 'm', 0, G_OPTION_ARG_STRING,  &s_mallocStatsFileStr, "File for logging malloc stats", "file" },
 		{ "malloc-stats-interval", 'i', 0, G_OPTION_ARG_INT,  &s_mallocStatsInterval, "Interval at which to log malloc stats", "seconds" },
+		{ "compile-locale-catalogs", 0, 0, G_OPTION_ARG_NONE, &s_compileLocaleCatalogs, "Compile every locale's strings.json into a strings.catalog and exit", NULL },
 		{ NULL }
 	};
 
@@ -925,6 +927,10 @@ int main( int argc, char** argv)
 	if (useColor)
 		settings->logger_useColor = (useColor[0] != 0 && useColor[0] != '0');
 
+	// offline, at image build or install time: nothing but the settings is needed for it
+	if (s_compileLocaleCatalogs)
+		return Localization::compileCatalogs() ? 0 : 1;
+
 	HostBase* host = HostBase::instance();
 	// the resolution is just a hint, the actual
 	// resolution may get picked up from the fb driver on arm
@@ -3183,6 +3183,13 @@ void DisplayManager::changeDisplayState (DisplayState newState, DisplayState old
 
 void DisplayManager::emitDisplayStateChange (int displaySignal)
 {
+    // nothing is drawn while the display is off, let the main loop timers batch up their wakeups
+    SingletonTimer* masterTimer = HostBase::instance()->masterTimer();
+    if (displaySignal == DISPLAY_SIGNAL_OFF || displaySignal == DISPLAY_SIGNAL_OFF_ON_CALL)
+        masterTimer->setSlack (Settings::LunaSettings()->timerSlackDisplayOffMs);
+    else
+        masterTimer->setSlack (0);
+
     switch (displaySignal) {
 	case DISPLAY_SIGNAL_OFF:
 	    Q_EMIT signalDisplayStateChange (DISPLAY_SIGNAL_OFF);
@@ -0,0 +1,213 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include "FrameTimings.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+static const uint32_t kVsyncPeriodUs = 16667;
+// frames further apart than this weren't part of the same animation, the gap isn't a drop
+static const uint32_t kContinuousFrameGapUs = 100000;
+
+static const char kDumpMagic[4] = { 'L', 'F', 'T', '1' };
+
+FrameTimings* FrameTimings::instance()
+{
+	static FrameTimings* s_instance = 0;
+	if (G_UNLIKELY(s_instance == 0))
+		s_instance = new FrameTimings;
+	return s_instance;
+}
+
+FrameTimings::FrameTimings()
+	: m_written(0)
+	, m_eventsUs(0)
+	, m_uploadsUs(0)
+	, m_paintStartUs(0)
+	, m_paintEndUs(0)
+	, m_painting(false)
+	, m_lastFrameEndUs(0)
+	, m_inputUs(0)
+	, m_droppedFrames(0)
+	, m_totalFrames(0)
+{
+	memset(m_samples, 0, sizeof(m_samples));
+}
+
+void FrameTimings::beginPaint()
+{
+	m_paintStartUs = nowUs();
+	m_painting = true;
+}
+
+void FrameTimings::endPaint()
+{
+	m_paintEndUs = nowUs();
+	m_painting = false;
+}
+
+void FrameTimings::endFrame()
+{
+	uint64_t now = nowUs();
+
+	FrameTimingSample& sample = m_samples[g_atomic_int_get(&m_written) % kNumSamples];
+	sample.timeMs = (uint32_t) (now / 1000);
+	sample.intervalUs = m_lastFrameEndUs ? (uint32_t) (now - m_lastFrameEndUs) : 0;
+	sample.eventsUs = m_eventsUs;
+	sample.paintUs = (uint32_t) (m_paintEndUs - m_paintStartUs);
+	sample.uploadsUs = m_uploadsUs;
+	sample.swapUs = (uint32_t) (now - m_paintEndUs);
+	// input that didn't cause a frame for this long didn't cause this one either
+	sample.inputUs = (m_inputUs && now - m_inputUs < kContinuousFrameGapUs) ? (uint32_t) (now - m_inputUs) : 0;
+
+	// publish the sample only once it is complete
+	g_atomic_int_inc(&m_written);
+
+	if (sample.intervalUs && sample.intervalUs < kContinuousFrameGapUs) {
+		uint32_t vsyncs = (sample.intervalUs + kVsyncPeriodUs / 2) / kVsyncPeriodUs;
+		if (vsyncs > 1)
+			m_droppedFrames += vsyncs - 1;
+	}
+	m_totalFrames++;
+
+	m_eventsUs = 0;
+	m_uploadsUs = 0;
+	m_inputUs = 0;
+	m_lastFrameEndUs = now;
+}
+
+uint64_t FrameTimings::nextFrameUs(uint64_t now) const
+{
+	// when idle the frame starts now and takes about a vsync to show
+	if (!m_lastFrameEndUs || now - m_lastFrameEndUs >= kContinuousFrameGapUs)
+		return now + kVsyncPeriodUs;
+
+	// while animating frames land a whole number of vsyncs after the last one
+	uint64_t periods = (now - m_lastFrameEndUs) / kVsyncPeriodUs + 1;
+	return m_lastFrameEndUs + periods * kVsyncPeriodUs;
+}
+
+int FrameTimings::copySamples(FrameTimingSample* samples) const
+{
+	guint written = (guint) m_written;
+	int count = MIN(written, (guint) kNumSamples);
+	guint first = written - count;
+
+	for (int i = 0; i < count; i++)
+		samples[i] = m_samples[(first + i) % kNumSamples];
+
+	return count;
+}
+
+static void PrvPercentiles(uint32_t* values, int count, FrameTimings::Percentiles& r_percentiles)
+{
+	memset(&r_percentiles, 0, sizeof(r_percentiles));
+	if (count == 0)
+		return;
+
+	int p50 = (count - 1) * 50 / 100;
+	int p95 = (count - 1) * 95 / 100;
+	int p99 = (count - 1) * 99 / 100;
+
+	// each nth_element leaves everything above the nth in the upper part, so work down from the top
+	std::nth_element(values, values + count - 1, values + count);
+	r_percentiles.maxUs = values[count - 1];
+	std::nth_element(values, values + p99, values + count - 1);
+	r_percentiles.p99Us = values[p99];
+	std::nth_element(values, values + p95, values + p99);
+	r_percentiles.p95Us = values[p95];
+	std::nth_element(values, values + p50, values + p95);
+	r_percentiles.p50Us = values[p50];
+}
+
+void FrameTimings::summarize(Summary& r_summary) const
+{
+	// straight from the ring: the order of the samples doesn't matter here, and the frame path only ever
+	// writes the slot after the newest one
+	uint32_t* values = m_summaryValues;
+	int count = MIN((guint) m_written, (guint) kNumSamples);
+
+	r_summary.frames = count;
+	r_summary.totalFrames = m_totalFrames;
+	r_summary.droppedFrames = m_droppedFrames;
+
+	for (int phase = 0; phase < PhaseCount; phase++) {
+		for (int i = 0; i < count; i++) {
+			const FrameTimingSample& s = m_samples[i];
+			switch (phase) {
+			case PhaseFrame:	values[i] = s.eventsUs + s.paintUs + s.swapUs; break;
+			case PhaseEvents:	values[i] = s.eventsUs; break;
+			case PhasePaint:	values[i] = s.paintUs; break;
+			case PhaseUploads:	values[i] = s.uploadsUs; break;
+			default:			values[i] = s.swapUs; break;
+			}
+		}
+		PrvPercentiles(values, count, r_summary.phases[phase]);
+	}
+
+	int inputFrames = 0;
+	for (int i = 0; i < count; i++) {
+		if (m_samples[i].inputUs)
+			values[inputFrames++] = m_samples[i].inputUs;
+	}
+	r_summary.inputFrames = inputFrames;
+	PrvPercentiles(values, inputFrames, r_summary.inputLatency);
+}
+
+void FrameTimings::reset()
+{
+	g_atomic_int_set(&m_written, 0);
+	m_droppedFrames = 0;
+	m_totalFrames = 0;
+	m_lastFrameEndUs = 0;
+	m_inputUs = 0;
+	m_uploadsUs = 0;
+}
+
+bool FrameTimings::dump(const char* path) const
+{
+	FILE* file = fopen(path, "wb");
+	if (!file) {
+		g_warning("%s: failed to open %s", __PRETTY_FUNCTION__, path);
+		return false;
+	}
+
+	FrameTimingSample* samples = new FrameTimingSample[kNumSamples];
+	uint32_t header[3];
+	header[0] = sizeof(FrameTimingSample);
+	header[1] = copySamples(samples);
+	header[2] = m_droppedFrames;
+
+	bool ok = fwrite(kDumpMagic, sizeof(kDumpMagic), 1, file) == 1 &&
+			  fwrite(header, sizeof(header), 1, file) == 1 &&
+			  (header[1] == 0 || fwrite(samples, sizeof(FrameTimingSample), header[1], file) == header[1]);
+
+	delete [] samples;
+
+	if (fclose(file) != 0)
+		ok = false;
+
+	return ok;
+}
@@ -0,0 +1,152 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef FRAMETIMINGS_H
+#define FRAMETIMINGS_H
+
+#include "Common.h"
+
+#include <stdint.h>
+#include <time.h>
+#include <glib.h>
+
+/*
+ * Per-frame timing telemetry for the WindowServer.
+ *
+ * Every composited frame leaves one fixed-size binary sample in a ring: how long was spent dispatching
+ * events since the previous frame, painting the scene, copying app window buffers (part of the scene
+ * paint) and swapping, plus the time since the previous frame and, if it showed touch input, since that
+ * touch was dispatched (input to photon, as near as sysmgr can tell). Recording is a handful of
+ * clock_gettime()s and stores; there is no allocation, locking or text formatting on the frame path, so it
+ * stays on all the time. Percentiles and dropped frame counts are only computed when somebody asks (getRenderStats, the fps
+ * overlay), and dump() writes the raw samples out for offline analysis.
+ */
+
+struct FrameTimingSample
+{
+	uint32_t timeMs;			// monotonic time the frame finished
+	uint32_t intervalUs;		// since the previous frame finished
+	uint32_t eventsUs;			// dispatching input/sysmgr events since the previous frame
+	uint32_t paintUs;			// painting the scene, including uploadsUs
+	uint32_t uploadsUs;			// copying app window buffers while painting
+	uint32_t swapUs;			// HostBase::flip()
+	uint32_t inputUs;			// from the oldest touch dispatched since the previous frame to this one, 0 if none
+};
+
+class FrameTimings
+{
+public:
+
+	enum Phase {
+		PhaseFrame = 0,			// events + paint + swap
+		PhaseEvents,
+		PhasePaint,
+		PhaseUploads,
+		PhaseSwap,
+		PhaseCount
+	};
+
+	struct Percentiles {
+		uint32_t p50Us;
+		uint32_t p95Us;
+		uint32_t p99Us;
+		uint32_t maxUs;
+	};
+
+	struct Summary {
+		uint32_t frames;		// samples summarized (at most kNumSamples)
+		uint32_t totalFrames;	// since the last reset
+		uint32_t droppedFrames;	// vsyncs missed while frames were being produced back to back
+		Percentiles phases[PhaseCount];
+		uint32_t inputFrames;	// frames that showed touch input
+		Percentiles inputLatency;
+	};
+
+	static FrameTimings* instance();
+
+	// frame path, WindowServer's thread only
+	void beginPaint();
+	void endPaint();
+	void endFrame();
+	void addEventTime(uint32_t us) { m_eventsUs += us; }
+	// only while painting: a window buffer copied for anything else (a screenshot, a card transition) isn't part of a frame
+	void addUploadTime(uint32_t us) { if (m_painting) m_uploadsUs += us; }
+
+	// a touch event went out; the next frame is taken to be the one that shows it
+	void touchDispatched() { if (!m_inputUs) m_inputUs = nowUs(); }
+
+	// when a frame started now is expected to be finished, for resampling touches to it
+	uint64_t nextFrameUs(uint64_t now) const;
+
+	void summarize(Summary& r_summary) const;
+	void reset();
+
+	// writes the samples, oldest first, as a small header followed by raw FrameTimingSamples
+	bool dump(const char* path) const;
+
+	static inline uint64_t nowUs() {
+		struct timespec ts;
+		::clock_gettime(CLOCK_MONOTONIC, &ts);
+		return (uint64_t) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+	}
+
+	// adds the lifetime of the scope to a phase, e.g. event dispatch
+	class Scope {
+	public:
+		Scope(void (FrameTimings::*add)(uint32_t), bool enabled = true)
+			: m_add(add), m_start(enabled ? nowUs() : 0) {}
+		~Scope() {
+			if (m_start)
+				(FrameTimings::instance()->*m_add)((uint32_t) (nowUs() - m_start));
+		}
+	private:
+		void (FrameTimings::*m_add)(uint32_t);
+		uint64_t m_start;
+	};
+
+	static const int kNumSamples = 1024;		// ~17s at 60fps
+
+private:
+
+	FrameTimings();
+
+	int copySamples(FrameTimingSample* samples) const;
+
+	FrameTimingSample m_samples[kNumSamples];
+	mutable uint32_t m_summaryValues[kNumSamples];	// scratch for summarize(), which the fps overlay calls 10 times a second
+	volatile gint m_written;		// samples ever written; the next one goes to m_written % kNumSamples
+
+	uint32_t m_eventsUs;
+	uint32_t m_uploadsUs;
+	uint64_t m_paintStartUs;
+	uint64_t m_paintEndUs;
+	bool m_painting;
+	uint64_t m_lastFrameEndUs;
+	uint64_t m_inputUs;
+
+	uint32_t m_droppedFrames;
+	uint32_t m_totalFrames;
+
+	FrameTimings(const FrameTimings&);
+	FrameTimings& operator=(const FrameTimings&);
+};
+
+#endif /* FRAMETIMINGS_H */
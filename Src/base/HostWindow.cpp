@@ -23,21 +23,28 @@
 
 #include "HostWindow.h"
 
+#include <set>
 #include <PIpcChannel.h>
 #include "HostWindowData.h"
 #include "IpcClientHost.h"
 #include "SystemUiController.h"
 #include "WindowServer.h"
+#include "FrameTimings.h"
 #include "IMEController.h"
+#include "WindowMetaData.h"
 
 #define MESSAGES_INTERNAL_FILE "SysMgrMessagesInternal.h"
 #include <PIpcMessageMacros.h>
 
+// windows whose on-screen state is shared with the web app through their metadata
+static std::set<HostWindow*> s_onScreenWindows;
+
 HostWindow::HostWindow(Type type, int width, int height, bool hasAlpha)
 		: Window(type, width, height, hasAlpha)
 		, m_data(0)
 		, m_isIpcWindow(false)
 		, m_clientHost(0)
+		, m_onScreen(false)
 {
 }
 
@@ -46,6 +53,7 @@ HostWindow::HostWindow(Type type, HostWindowData* data, IpcClientHost* clientHos
 	, m_data(data)
 	, m_isIpcWindow(false)
 	, m_clientHost(clientHost)
+	, m_onScreen(false)
 {
     if (m_clientHost) {
 		m_isIpcWindow = true;
@@ -54,12 +62,18 @@ HostWindow::HostWindow(Type type, HostWindowData* data, IpcClientHost* clientHos
 
 	data->initializePixmap(m_screenPixmap);
 
+	// the web app is told when the window comes on or goes off the screen, see updateAllOnScreen()
+	if (data->metaDataBuffer())
+		s_onScreenWindows.insert(this);
+
 	connect(SystemUiController::instance(), SIGNAL(signalAboutToSendSyncMessage()),
 			SLOT(slotAboutToSendSyncMessage()));
 }
 
 HostWindow::~HostWindow()
 {
+	s_onScreenWindows.erase(this);
+
 	if(m_clientHost)
 		m_clientHost->windowDeleted(this);
 
@@ -74,6 +88,55 @@ int HostWindow::routingId() const
 	return m_data->key();
 }
 
+bool HostWindow::isOnScreen() const
+{
+	return isVisible() && this->sceneBoundingRect().intersects(WindowServer::instance()->sceneRect());
+}
+
+QVariant HostWindow::itemChange(GraphicsItemChange change, const QVariant& value)
+{
+	switch (change) {
+	case ItemVisibleHasChanged:
+	case ItemSceneHasChanged:
+		if (s_onScreenWindows.count(this))
+			updateOnScreen();
+		break;
+	default:
+		break;
+	}
+
+	return Window::itemChange(change, value);
+}
+
+// WebAppDeferredUpdateHandler paints the windows that are on screen first when direct rendering ends.
+// Shared through the metadata rather than a message, since it changes with every frame of a card animation
+void HostWindow::updateOnScreen()
+{
+	bool onScreen = isOnScreen();
+	if (onScreen == m_onScreen)
+		return;
+
+	if (!m_data || !m_data->metaDataBuffer())
+		return;
+
+	m_onScreen = onScreen;
+
+	PIpcBuffer* metaDataBuffer = m_data->metaDataBuffer();
+	WindowMetaData* metaData = (WindowMetaData*) metaDataBuffer->data();
+	metaDataBuffer->lock();
+	metaData->onScreen = onScreen;
+	metaDataBuffer->unlock();
+}
+
+// Windows are mostly moved by their parents (card view scrolling, the dashboard container), which
+// sends no itemChange to the window itself, so the window server checks them once per painted frame
+void HostWindow::updateAllOnScreen()
+{
+	for (std::set<HostWindow*>::const_iterator it = s_onScreenWindows.begin();
+		 it != s_onScreenWindows.end(); ++it)
+		(*it)->updateOnScreen();
+}
+
 void HostWindow::channelRemoved()
 {
 	m_channel = 0;    
@@ -167,7 +230,7 @@ void HostWindow::onAsynchFlipCompleted(int newWidth, int newHeight, int newScree
 
 void HostWindow::resizeEventSync(int w, int h, bool forceSync)
 {
-	bool visible = isVisible() && this->sceneBoundingRect().intersects(WindowServer::instance()->sceneRect());
+	bool visible = isOnScreen();
 
 	if (!m_channel || !m_data)
 		return;
@@ -293,6 +356,7 @@ void HostWindow::asynchFlipCompleted(int newWidth, int newHeight, int newScreenW
 
 const QPixmap* HostWindow::acquireScreenPixmap()
 {
+	FrameTimings::Scope uploadTime(&FrameTimings::addUploadTime);
 	return m_data ? m_data->acquirePixmap(m_screenPixmap) : Window::acquireScreenPixmap();
 }
 
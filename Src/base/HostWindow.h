@@ -88,12 +88,21 @@ public:
 
 	virtual const HostWindowData* hostWindowData() const { return m_data; }
 
+	// shown, and at least partly inside the scene rect
+	bool isOnScreen() const;
+
+	// pushes the current on-screen state of every window that shares it with its web app
+	static void updateAllOnScreen();
+
 private Q_SLOTS:
 
 	void slotAboutToSendSyncMessage();
 
 protected:
 
+	virtual QVariant itemChange(GraphicsItemChange change, const QVariant& value);
+	void updateOnScreen();
+
 	virtual void onEditorFocusChanged(bool focus, const PalmIME::EditorState& state);
     void onAutoCapChanged(bool enabled);
 	virtual void onEnableTouchEvents(bool) {}
@@ -104,6 +113,7 @@ protected:
 	bool m_isIpcWindow;	
 	IpcClientHost* m_clientHost;
 	PIpcBuffer* m_transitionBuffer;
+	bool m_onScreen;
 };
 
 #endif /* HOSTWINDOW_H */
@@ -0,0 +1,337 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include "LocaleCatalog.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <vector>
+
+#include <glib.h>
+
+static const char kCatalogMagic[4] = { 'L', 'L', 'C', 'T' };
+
+// how long to look for a seed that places all the keys of a bucket before giving up on the catalog;
+// with the slack below it takes a handful of tries for all but the last few buckets
+static const uint32_t kMaxSeed = 1 << 20;
+
+namespace {
+
+struct Bucket {
+	uint32_t index;
+	std::vector<const std::string*> keys;
+};
+
+bool biggerBucket(const Bucket* a, const Bucket* b)
+{
+	if (a->keys.size() != b->keys.size())
+		return a->keys.size() > b->keys.size();
+	return a->index < b->index;
+}
+
+}
+
+bool LocaleCatalogWriter::add(const std::string& key, const std::string& value)
+{
+	if (key.empty() || m_strings.find(key) != m_strings.end())
+		return false;
+
+	m_strings[key] = value;
+	return true;
+}
+
+bool LocaleCatalogWriter::write(const std::string& path, const struct stat& source)
+{
+	uint32_t entryCount = m_strings.size();
+
+	// about two keys to a bucket and a quarter of the slots spare keep finding seeds cheap
+	uint32_t bucketCount = entryCount / 2 + 1;
+	uint32_t slotCount = entryCount + entryCount / 4 + 1;
+
+	std::vector<Bucket> buckets(bucketCount);
+	for (uint32_t i = 0; i < bucketCount; i++)
+		buckets[i].index = i;
+
+	for (std::map<std::string, std::string>::const_iterator it = m_strings.begin(); it != m_strings.end(); ++it)
+		buckets[LocaleCatalog::hash(it->first.data(), it->first.size(), 0) % bucketCount].keys.push_back(&it->first);
+
+	// the biggest buckets go first, while most slots are still free
+	std::vector<Bucket*> order;
+	for (uint32_t i = 0; i < bucketCount; i++)
+		order.push_back(&buckets[i]);
+	std::sort(order.begin(), order.end(), biggerBucket);
+
+	std::vector<uint32_t> seeds(bucketCount, 0);
+	std::vector<const std::string*> slots(slotCount, (const std::string*) 0);
+	std::vector<uint32_t> placed;
+
+	for (std::vector<Bucket*>::const_iterator it = order.begin(); it != order.end(); ++it) {
+		const Bucket* bucket = *it;
+		if (bucket->keys.empty())
+			break;
+
+		uint32_t seed = 1;
+		for (; seed < kMaxSeed; seed++) {
+			placed.clear();
+			bool fits = true;
+			for (uint32_t k = 0; k < bucket->keys.size() && fits; k++) {
+				const std::string* key = bucket->keys[k];
+				uint32_t slot = LocaleCatalog::hash(key->data(), key->size(), seed) % slotCount;
+				fits = !slots[slot] && std::find(placed.begin(), placed.end(), slot) == placed.end();
+				placed.push_back(slot);
+			}
+			if (fits)
+				break;
+		}
+
+		if (seed == kMaxSeed) {
+			g_warning("%s: no perfect hash found for %s", __PRETTY_FUNCTION__, path.c_str());
+			return false;
+		}
+
+		seeds[bucket->index] = seed;
+		for (uint32_t k = 0; k < bucket->keys.size(); k++)
+			slots[placed[k]] = bucket->keys[k];
+	}
+
+	std::string strings;
+	std::vector<LocaleCatalogEntry> entries(slotCount);
+	for (uint32_t i = 0; i < slotCount; i++) {
+		LocaleCatalogEntry& entry = entries[i];
+		if (!slots[i]) {
+			entry.key = LocaleCatalogEntry::kEmpty;
+			entry.keyLength = 0;
+			entry.value = LocaleCatalogEntry::kEmpty;
+			entry.valueLength = 0;
+			continue;
+		}
+
+		const std::string& key = *slots[i];
+		const std::string& value = m_strings[key];
+		entry.key = strings.size();
+		entry.keyLength = key.size();
+		strings.append(key.c_str(), key.size() + 1);
+		entry.value = strings.size();
+		entry.valueLength = value.size();
+		strings.append(value.c_str(), value.size() + 1);
+	}
+	strings.push_back('\0');
+
+	LocaleCatalogHeader header;
+	memcpy(header.magic, kCatalogMagic, sizeof(header.magic));
+	header.version = LocaleCatalog::kVersion;
+	header.entryCount = entryCount;
+	header.bucketCount = bucketCount;
+	header.bucketsOffset = sizeof(header);
+	header.slotCount = slotCount;
+	header.slotsOffset = header.bucketsOffset + bucketCount * sizeof(uint32_t);
+	header.stringsOffset = header.slotsOffset + slotCount * sizeof(LocaleCatalogEntry);
+	header.stringsSize = strings.size();
+	header.size = header.stringsOffset + header.stringsSize;
+	header.sourceSize = source.st_size;
+	header.sourceMtime = source.st_mtime;
+	header.sourceMtimeNsec = source.st_mtim.tv_nsec;
+
+	// to the side and renamed over the old one, so sysmgr never maps a half written catalog
+	std::string tmpPath = path + ".tmp";
+	FILE* f = fopen(tmpPath.c_str(), "wb");
+	if (!f) {
+		g_warning("%s: unable to write %s: %s", __PRETTY_FUNCTION__, tmpPath.c_str(), strerror(errno));
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	if (ok)
+		ok = fwrite(&seeds[0], sizeof(uint32_t), seeds.size(), f) == seeds.size();
+	if (ok)
+		ok = fwrite(&entries[0], sizeof(LocaleCatalogEntry), entries.size(), f) == entries.size();
+	if (ok)
+		ok = fwrite(strings.data(), 1, strings.size(), f) == strings.size();
+
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (!ok || ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+		g_warning("%s: failed to write %s", __PRETTY_FUNCTION__, path.c_str());
+		::unlink(tmpPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+LocaleCatalog::LocaleCatalog()
+	: m_map(0)
+	, m_mapSize(0)
+	, m_header(0)
+	, m_buckets(0)
+	, m_slots(0)
+	, m_strings(0)
+{
+}
+
+LocaleCatalog::~LocaleCatalog()
+{
+	close();
+}
+
+bool LocaleCatalog::open(const std::string& path)
+{
+	close();
+
+	int fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(LocaleCatalogHeader)) {
+		::close(fd);
+		return false;
+	}
+
+	void* map = ::mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	m_map = map;
+	m_mapSize = st.st_size;
+
+	const char* base = (const char*) m_map;
+	m_header = (const LocaleCatalogHeader*) base;
+	if (!validate()) {
+		g_warning("%s: %s is not a valid locale catalog", __PRETTY_FUNCTION__, path.c_str());
+		close();
+		return false;
+	}
+
+	m_buckets = (const uint32_t*) (base + m_header->bucketsOffset);
+	m_slots = (const LocaleCatalogEntry*) (base + m_header->slotsOffset);
+	m_strings = base + m_header->stringsOffset;
+	return true;
+}
+
+void LocaleCatalog::close()
+{
+	if (m_map)
+		::munmap(m_map, m_mapSize);
+
+	m_map = 0;
+	m_mapSize = 0;
+	m_header = 0;
+	m_buckets = 0;
+	m_slots = 0;
+	m_strings = 0;
+}
+
+bool LocaleCatalog::compiledFrom(const struct stat& source) const
+{
+	if (!m_header)
+		return false;
+
+	return (uint64_t) source.st_size == m_header->sourceSize &&
+		(uint32_t) source.st_mtime == m_header->sourceMtime &&
+		(uint32_t) source.st_mtim.tv_nsec == m_header->sourceMtimeNsec;
+}
+
+bool LocaleCatalog::lookup(const char* key, uint32_t length, LocalizedStringRef* value) const
+{
+	if (!m_header || m_header->entryCount == 0)
+		return false;
+
+	uint32_t seed = m_buckets[hash(key, length, 0) % m_header->bucketCount];
+	const LocaleCatalogEntry& entry = m_slots[hash(key, length, seed) % m_header->slotCount];
+
+	// a key that isn't in the catalog lands on some slot too
+	if (entry.key == LocaleCatalogEntry::kEmpty || entry.keyLength != length ||
+		memcmp(m_strings + entry.key, key, length) != 0)
+		return false;
+
+	*value = LocalizedStringRef(m_strings + entry.value, entry.valueLength);
+	return true;
+}
+
+// FNV-1a with the seed folded into the basis, then Murmur3's finalizer so that neighbouring seeds send a
+// key to unrelated slots
+uint32_t LocaleCatalog::hash(const char* key, uint32_t length, uint32_t seed)
+{
+	uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+	for (uint32_t i = 0; i < length; i++) {
+		h ^= (unsigned char) key[i];
+		h *= 16777619u;
+	}
+
+	h ^= h >> 16;
+	h *= 0x85ebca6bu;
+	h ^= h >> 13;
+	h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+// the catalogs are files on disk like any other, so nothing in one is trusted before it's been bounds
+// checked once
+bool LocaleCatalog::validate() const
+{
+	const LocaleCatalogHeader* h = m_header;
+	if (memcmp(h->magic, kCatalogMagic, sizeof(h->magic)) != 0 || h->version != kVersion || h->size != m_mapSize)
+		return false;
+
+	uint64_t bucketsEnd = (uint64_t) h->bucketsOffset + (uint64_t) h->bucketCount * sizeof(uint32_t);
+	uint64_t slotsEnd = (uint64_t) h->slotsOffset + (uint64_t) h->slotCount * sizeof(LocaleCatalogEntry);
+	uint64_t stringsEnd = (uint64_t) h->stringsOffset + h->stringsSize;
+
+	if ((h->bucketsOffset | h->slotsOffset) & 3)
+		return false;
+	if (h->bucketsOffset < sizeof(LocaleCatalogHeader) || bucketsEnd > h->size || slotsEnd > h->size ||
+		stringsEnd > h->size || h->stringsSize == 0)
+		return false;
+	if (h->bucketCount == 0 || h->slotCount < h->entryCount)
+		return false;
+
+	const char* base = (const char*) m_map;
+	const char* strings = base + h->stringsOffset;
+	if (strings[h->stringsSize - 1] != '\0')
+		return false;
+
+	uint32_t used = 0;
+	const LocaleCatalogEntry* slots = (const LocaleCatalogEntry*) (base + h->slotsOffset);
+	for (uint32_t i = 0; i < h->slotCount; i++) {
+		const LocaleCatalogEntry& e = slots[i];
+		if (e.key == LocaleCatalogEntry::kEmpty)
+			continue;
+
+		// each string followed by its NUL, so data() can be handed to C APIs as is
+		if ((uint64_t) e.key + e.keyLength >= h->stringsSize || strings[e.key + e.keyLength] != '\0' ||
+			(uint64_t) e.value + e.valueLength >= h->stringsSize || strings[e.value + e.valueLength] != '\0')
+			return false;
+		used++;
+	}
+
+	return used == h->entryCount;
+}
@@ -0,0 +1,155 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef LOCALECATALOG_H_
+#define LOCALECATALOG_H_
+
+#include "Common.h"
+
+/*
+ * A locale's strings.json compiled into a file that is mmap()ed and looked up in place, instead of parsed,
+ * schema checked and copied into a hash table every time the locale is loaded.
+ *
+ * The file is a LocaleCatalogHeader, one uint32_t seed per bucket, the LocaleCatalogEntry slots and a
+ * string table of NUL terminated UTF-8 that the entries point into. The keys are placed with a perfect hash
+ * (hash and displace): a key's bucket comes from hashing it with seed 0, and hashing it again with its
+ * bucket's seed gives its slot, which no other key shares. A lookup is two hashes of the key and one
+ * compare, and what it finds is a pointer into the mapping. The header records the size and modification
+ * time of the strings.json the catalog was compiled from, and the catalog is only used while that file is
+ * still exactly the same; comparing times alone can't tell a package that installs an older file, or an edit
+ * within the same second, from an up to date catalog.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <map>
+#include <string>
+
+struct stat;
+
+// Non-owning: the translation as it lies in a catalog (or in Localization's own tables), NUL terminated.
+// Valid until the locale is loaded again.
+class LocalizedStringRef
+{
+public:
+
+	LocalizedStringRef() : m_data(""), m_length(0) {}
+	LocalizedStringRef(const char* data, uint32_t length) : m_data(data), m_length(length) {}
+
+	const char* data() const { return m_data; }
+	uint32_t length() const { return m_length; }
+	bool isEmpty() const { return m_length == 0; }
+
+	std::string toStdString() const { return std::string(m_data, m_length); }
+
+	bool operator==(const char* str) const { return strlen(str) == m_length && memcmp(m_data, str, m_length) == 0; }
+
+private:
+
+	const char* m_data;
+	uint32_t m_length;
+};
+
+struct LocaleCatalogHeader
+{
+	char magic[4];					// "LLCT"
+	uint32_t version;
+	uint32_t size;					// of the whole file
+	uint32_t entryCount;
+	uint32_t bucketCount;
+	uint32_t bucketsOffset;			// bucketCount uint32_t seeds
+	uint32_t slotCount;
+	uint32_t slotsOffset;			// slotCount LocaleCatalogEntry
+	uint32_t stringsOffset;
+	uint32_t stringsSize;
+	uint32_t sourceSize;			// of the strings.json compiled
+	uint32_t sourceMtime;
+	uint32_t sourceMtimeNsec;
+};
+
+struct LocaleCatalogEntry
+{
+	static const uint32_t kEmpty = 0xffffffff;
+
+	// string table offsets; key is kEmpty for a slot no key hashed to
+	uint32_t key;
+	uint32_t keyLength;
+	uint32_t value;
+	uint32_t valueLength;
+};
+
+class LocaleCatalogWriter
+{
+public:
+
+	// the first value added for a key is kept, like strings.json files layered over each other; empty keys
+	// are never looked up and are dropped
+	bool add(const std::string& key, const std::string& value);
+
+	int count() const { return m_strings.size(); }
+
+	// source is the strings.json the strings came from, as stat() found it before it was parsed
+	bool write(const std::string& path, const struct stat& source);
+
+private:
+
+	std::map<std::string, std::string> m_strings;
+};
+
+class LocaleCatalog
+{
+public:
+
+	LocaleCatalog();
+	~LocaleCatalog();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return m_header != 0; }
+
+	int count() const { return m_header ? m_header->entryCount : 0; }
+
+	// true if the catalog was compiled from a strings.json of exactly this size and modification time
+	bool compiledFrom(const struct stat& source) const;
+
+	bool lookup(const char* key, uint32_t length, LocalizedStringRef* value) const;
+
+	static uint32_t hash(const char* key, uint32_t length, uint32_t seed);
+
+	static const uint32_t kVersion = 2;
+
+private:
+
+	bool validate() const;
+
+	LocaleCatalog(const LocaleCatalog&);
+	LocaleCatalog& operator=(const LocaleCatalog&);
+
+	void* m_map;
+	size_t m_mapSize;
+
+	const LocaleCatalogHeader* m_header;
+	const uint32_t* m_buckets;
+	const LocaleCatalogEntry* m_slots;
+	const char* m_strings;
+};
+
+#endif /*LOCALECATALOG_H_*/
@@ -32,7 +32,36 @@
 #include <QDebug>
 #include <QFile>
 
+#include <sys/stat.h>
+#include <glib.h>
+
 static const char* s_localeFile = "/strings.json";
+static const char* s_catalogFile = "/strings.catalog";
+static const char* s_localeSchema = "/etc/palm/schemas/localization.schema";
+
+static bool parseLocaleFile(const std::string& path, QHash<std::string, std::string>& map)
+{
+	pbnjson::JSchema localeSchema = pbnjson::JSchemaFile(s_localeSchema);
+
+	pbnjson::JDomParser parser;
+	if (!parser.parseFile(path, localeSchema, JFileOptMMap)) {
+		//qWarning() << "Failed to load localization from" << path.c_str();
+		return false;
+	}
+
+	pbnjson::JValue localized = parser.getDom();
+	pbnjson::JValue::ObjectIterator iter;
+	for (iter = localized.begin(); iter != localized.end(); iter++) {
+		pbnjson::JValue::KeyValue pair = (*iter);
+		std::string key = pair.first.asString();
+		std::string value = pair.second.asString();
+
+		if (!map.contains(key))
+			map.insert(key, value);
+	}
+
+	return true;
+}
 
 Localization* Localization::instance()
 {
@@ -56,48 +85,117 @@ Localization::~Localization()
 
 void Localization::loadLocalizedStrings()
 {
-	m_localizationMap.clear();
+	std::string locale = Preferences::instance()->locale();
+	std::string paths[kLayerCount] = {
+		Settings::LunaSettings()->lunaCustomizationLocalePath + "/" + locale,
+		Settings::LunaSettings()->lunaSystemLocalePath + "/" + locale
+	};
 
-	QVector<std::string> translations;
+	for (int i = 0; i < kLayerCount; i++) {
 
-	std::string locale = Preferences::instance()->locale();
-	translations << Settings::LunaSettings()->lunaCustomizationLocalePath + "/" + locale + s_localeFile;
-	translations << Settings::LunaSettings()->lunaSystemLocalePath + "/" + locale + s_localeFile;
+		m_catalogs[i].close();
+		m_localizationMaps[i].clear();
 
-	pbnjson::JSchema localeSchema = pbnjson::JSchemaFile("/etc/palm/schemas/localization.schema");
+		std::string translation = paths[i] + s_localeFile;
+		std::string catalog = paths[i] + s_catalogFile;
 
-	pbnjson::JDomParser parser;
-	Q_FOREACH(std::string translation, translations) {
-		if (!QFile::exists(qFromUtf8Stl(translation))) {
+		struct stat jsonStat, catalogStat;
+		bool haveJson = ::stat(translation.c_str(), &jsonStat) == 0;
+		bool haveCatalog = ::stat(catalog.c_str(), &catalogStat) == 0;
+
+		// only a catalog compiled from the strings.json that is there now, an older or newer one is stale
+		if (haveCatalog && m_catalogs[i].open(catalog)) {
+			if (!haveJson || m_catalogs[i].compiledFrom(jsonStat))
+				continue;
+
+			g_warning("%s: %s wasn't compiled from the current %s, using the JSON", __PRETTY_FUNCTION__,
+					  catalog.c_str(), translation.c_str());
+			m_catalogs[i].close();
+		}
+
+		if (!haveJson) {
 			//qDebug() << "Failed to find localization" << translation.c_str();
 			continue;
 		}
 
-		if (!parser.parseFile(translation, localeSchema, JFileOptMMap)) {
-			//qWarning() << "Failed to load localization from" << translation.c_str();
+		parseLocaleFile(translation, m_localizationMaps[i]);
+	}
+}
+
+std::string Localization::getLocalizedString(const std::string& str) const
+{
+	return localizedString(str.c_str(), str.size()).toStdString();
+}
+
+LocalizedStringRef Localization::localizedString(const char* str, uint32_t length) const
+{
+	LocalizedStringRef value;
+
+	for (int i = 0; i < kLayerCount; i++) {
+
+		if (m_catalogs[i].isOpen()) {
+			if (m_catalogs[i].lookup(str, length, &value))
+				return value;
 			continue;
 		}
 
-		pbnjson::JValue localized = parser.getDom();
-		pbnjson::JValue::ObjectIterator iter;
-		for (iter = localized.begin(); iter != localized.end(); iter++) {
-			pbnjson::JValue::KeyValue pair = (*iter);
-			std::string key = pair.first.asString();
-			std::string value = pair.second.asString();
+		if (m_localizationMaps[i].isEmpty())
+			continue;
 
-			if (!m_localizationMap.contains(key))
-				m_localizationMap.insert(key, value);
-		}
+		LocalizationMap::const_iterator it = m_localizationMaps[i].find(std::string(str, length));
+		if (it != m_localizationMaps[i].end())
+			return LocalizedStringRef(it.value().c_str(), it.value().size());
 	}
+
+	return LocalizedStringRef(str, length);
 }
 
-std::string Localization::getLocalizedString(const std::string& str) const
+bool Localization::compileCatalogs()
 {
-	LocalizationMap::const_iterator it = m_localizationMap.find(str);
-	if (G_UNLIKELY(it == m_localizationMap.end()))
-		return str;
+	std::string roots[kLayerCount] = {
+		Settings::LunaSettings()->lunaCustomizationLocalePath,
+		Settings::LunaSettings()->lunaSystemLocalePath
+	};
+
+	bool ok = true;
+	for (int i = 0; i < kLayerCount; i++) {
+
+		GDir* dir = g_dir_open(roots[i].c_str(), 0, NULL);
+		if (!dir)
+			continue;
 
-	return it.value();
+		const gchar* name;
+		while ((name = g_dir_read_name(dir)) != NULL) {
+
+			std::string translation = roots[i] + "/" + name + s_localeFile;
+			struct stat source;
+			if (::stat(translation.c_str(), &source) != 0 || !S_ISREG(source.st_mode))
+				continue;
+
+			LocalizationMap map;
+			if (!parseLocaleFile(translation, map)) {
+				g_warning("%s: failed to parse %s", __PRETTY_FUNCTION__, translation.c_str());
+				ok = false;
+				continue;
+			}
+
+			LocaleCatalogWriter writer;
+			for (LocalizationMap::const_iterator it = map.constBegin(); it != map.constEnd(); ++it)
+				writer.add(it.key(), it.value());
+
+			std::string catalog = roots[i] + "/" + name + s_catalogFile;
+			if (!writer.write(catalog, source)) {
+				ok = false;
+				continue;
+			}
+
+			g_message("%s: %d strings from %s", catalog.c_str(), writer.count(), translation.c_str());
+		}
+
+		g_dir_close(dir);
+	}
+
+	return ok;
 }
 
 std::string LOCALIZED(const std::string& str)
@@ -105,3 +203,7 @@ std::string LOCALIZED(const std::string& str)
 	return Localization::instance()->getLocalizedString(str);
 }
 
+LocalizedStringRef LOCALIZED_REF(const char* str)
+{
+	return Localization::instance()->localizedString(str, strlen(str));
+}
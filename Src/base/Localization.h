@@ -27,6 +27,8 @@
 #include "QtUtils.h"
 #include <QHash>
 
+#include "LocaleCatalog.h"
+
 class Localization
 {
 public:
@@ -35,9 +37,17 @@ public:
 
 	std::string getLocalizedString(const std::string& str) const;
 
+	// the translation of str, or str itself, without copying either
+	LocalizedStringRef localizedString(const char* str, uint32_t length) const;
+
 	// call if locale changed. Warning! Cached translations will of course not be updated automatically...
+	// and LocalizedStringRefs handed out before are no longer valid
 	void loadLocalizedStrings();
 
+	// compiles the strings.json of every locale under the system and customization locale paths into a
+	// strings.catalog next to it (LunaSysMgr --compile-locale-catalogs)
+	static bool compileCatalogs();
+
 private:
 
 	Localization();
@@ -45,9 +55,17 @@ private:
 
 private:
 	typedef QHash<std::string, std::string> LocalizationMap;
-	LocalizationMap m_localizationMap;
+
+	// customization first, then system: each one a compiled catalog when there is an up to date one,
+	// otherwise its strings.json parsed into a map
+	enum { kLayerCount = 2 };
+	LocaleCatalog m_catalogs[kLayerCount];
+	LocalizationMap m_localizationMaps[kLayerCount];
 };
 
 std::string LOCALIZED(const std::string& str);
 
+// for formats handed straight to sprintf() and friends: nothing is allocated for the key or the translation
+LocalizedStringRef LOCALIZED_REF(const char* str);
+
 #endif /* LOCALIZATION_H */
@@ -66,8 +66,8 @@ ProgressAnimation::ProgressAnimation(Type type)
         normalFile = "/normal-bg.png";
         brightFile = "/glow-bg.png";
         logoFile = "/fsck-usb.png";
-        title = QString::fromUtf8(LOCALIZED("OWWW! That hurts!").c_str());
-        description = QString::fromUtf8(LOCALIZED("Next time, please unmount the drive from the desktop.").c_str());
+        title = QString::fromUtf8(LOCALIZED_REF("OWWW! That hurts!").data());
+        description = QString::fromUtf8(LOCALIZED_REF("Next time, please unmount the drive from the desktop.").data());
         break;
     default:
         Q_ASSERT_X(false, __PRETTY_FUNCTION__, "invalid progress type");
@@ -0,0 +1,360 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include "ScreenCapture.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/prctl.h>
+#include <sys/resource.h>
+
+#include <QPainter>
+#include <QTransform>
+
+#include "FrameTimings.h"
+#include "HostBase.h"
+#include "MutexLocker.h"
+
+static const char kRawMagic[4] = { 'L', 'S', 'C', '1' };
+
+struct ScreenCapture::Job
+{
+	Job() : inFlight(0), pixels(0), capacity(0), appPixels(0), appCapacity(0)
+		, width(0), height(0), bytesPerLine(0), hasApp(false)
+		, format(FormatPng), angle(0), requestedUs(0), grabUs(0)
+		, callback(0), userData(0), ok(false) {}
+
+	volatile gint inFlight;		// set while the saver thread owns the buffers
+
+	uchar* pixels;
+	int capacity;
+	uchar* appPixels;
+	int appCapacity;
+
+	int width;
+	int height;
+	int bytesPerLine;
+	bool hasApp;
+
+	std::string pathPrefix;
+	Format format;
+	int angle;
+	uint64_t requestedUs;
+	uint32_t grabUs;
+
+	// a queued image rather than a framebuffer copy: written to pathPrefix as is, then the job is
+	// handed back to the main loop for the callback and deleted there
+	QImage image;
+	SaveCallback callback;
+	void* userData;
+	bool ok;
+};
+
+// locked so that copying the framebuffer on the UI thread never waits for pages to be faulted in
+static void PrvReservePinned(uchar*& r_buffer, int& r_capacity, int bytes)
+{
+	if (r_capacity >= bytes)
+		return;
+
+	if (r_buffer) {
+		::munlock(r_buffer, r_capacity);
+		::free(r_buffer);
+	}
+
+	r_buffer = (uchar*) ::malloc(bytes);
+	r_capacity = r_buffer ? bytes : 0;
+
+	if (r_buffer && ::mlock(r_buffer, bytes) != 0)
+		g_debug("%s: failed to lock %d bytes, capture buffer stays pageable", __PRETTY_FUNCTION__, bytes);
+}
+
+static std::string PrvUniquePath(const std::string& prefix, const char* extension)
+{
+	std::string path = prefix + extension;
+	for (int i = 2; g_file_test(path.c_str(), G_FILE_TEST_EXISTS); i++) {
+		char suffix[16];
+		snprintf(suffix, sizeof(suffix), "-%d", i);
+		path = prefix + suffix + extension;
+	}
+	return path;
+}
+
+ScreenCapture* ScreenCapture::instance()
+{
+	static ScreenCapture* s_instance = 0;
+	if (G_UNLIKELY(s_instance == 0))
+		s_instance = new ScreenCapture;
+	return s_instance;
+}
+
+ScreenCapture::ScreenCapture()
+{
+	for (int i = 0; i < kNumJobs; i++)
+		m_jobs[i] = new Job;
+
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	m_queue = g_async_queue_new();
+	m_thread = g_thread_create(ScreenCapture::saverThread, this, FALSE, NULL);
+}
+
+ScreenCapture::Job* ScreenCapture::acquireJob(int bytes, int appBytes)
+{
+	for (int i = 0; i < kNumJobs; i++) {
+		Job* job = m_jobs[i];
+		if (g_atomic_int_get(&job->inFlight))
+			continue;
+
+		PrvReservePinned(job->pixels, job->capacity, bytes);
+		if (appBytes)
+			PrvReservePinned(job->appPixels, job->appCapacity, appBytes);
+
+		if (job->capacity < bytes || job->appCapacity < appBytes)
+			return 0;
+
+		return job;
+	}
+
+	return 0;
+}
+
+bool ScreenCapture::captureDisplay(const std::string& pathPrefix, Format format, int angle, uint64_t requestedUs)
+{
+	uint64_t grabStartUs = FrameTimings::nowUs();
+
+	// both of these just wrap the mapped framebuffers
+	QImage fb = HostBase::instance()->takeScreenShot();
+	if (fb.isNull()) {
+		g_warning("Screenshot: no framebuffer to capture");
+		recordCapture(false, 0, requestedUs);
+		return false;
+	}
+
+	QImage appFb = HostBase::instance()->takeAppDirectRenderingScreenShot();
+	bool hasApp = !appFb.isNull() && appFb.size() == fb.size() && appFb.bytesPerLine() == fb.bytesPerLine();
+
+	Job* job = acquireJob(fb.byteCount(), hasApp ? appFb.byteCount() : 0);
+	if (!job) {
+		g_warning("Screenshot: previous captures are still being saved, dropping this one");
+		MutexLocker locker(&m_statsMutex);
+		m_stats.busy++;
+		return false;
+	}
+
+	::memcpy(job->pixels, fb.constBits(), fb.byteCount());
+	if (hasApp)
+		::memcpy(job->appPixels, appFb.constBits(), appFb.byteCount());
+
+	job->width = fb.width();
+	job->height = fb.height();
+	job->bytesPerLine = fb.bytesPerLine();
+	job->hasApp = hasApp;
+	job->pathPrefix = pathPrefix;
+	job->format = format;
+	job->angle = angle;
+	job->requestedUs = requestedUs;
+	job->grabUs = (uint32_t) (FrameTimings::nowUs() - grabStartUs);
+
+	g_atomic_int_set(&job->inFlight, 1);
+	g_async_queue_push(m_queue, job);
+
+	return true;
+}
+
+gpointer ScreenCapture::saverThread(gpointer data)
+{
+	::prctl(PR_SET_NAME, "ScreenShotSaver", 0, 0, 0);
+
+	// Low priority thread
+	::setpriority(PRIO_PROCESS, ::getpid(), 5);
+
+	ScreenCapture* capture = static_cast<ScreenCapture*>(data);
+	while (true) {
+		Job* job = (Job*) g_async_queue_pop(capture->m_queue);
+		if (job->image.isNull())
+			capture->save(job);
+		else
+			capture->saveImage(job);
+	}
+
+	return 0;
+}
+
+void ScreenCapture::save(Job* job)
+{
+	QImage image(job->pixels, job->width, job->height, job->bytesPerLine,
+				 QImage::Format_ARGB32_Premultiplied);
+
+	if (job->hasApp) {
+		// the UI layer goes on top of whatever the app rendered directly, in place in the app buffer
+		QImage app(job->appPixels, job->width, job->height, job->bytesPerLine,
+				   QImage::Format_ARGB32_Premultiplied);
+		QPainter painter(&app);
+		painter.drawImage(0, 0, image);
+		painter.end();
+		image = app;
+	}
+
+	std::string path = PrvUniquePath(job->pathPrefix, extension(job->format));
+	bool ok = writeImage(image, path, job->format, job->angle);
+
+	uint64_t requestedUs = job->requestedUs;
+	uint32_t grabUs = job->grabUs;
+
+	// image points into the job's buffers, let go of it before handing them back
+	image = QImage();
+	g_atomic_int_set(&job->inFlight, 0);
+
+	recordCapture(ok, grabUs, requestedUs);
+
+	if (ok)
+		g_warning("Screenshot: Wrote %s (%u ms after the request, grab took %u us)", path.c_str(),
+				  (uint32_t) ((FrameTimings::nowUs() - requestedUs) / 1000), grabUs);
+	else
+		g_warning("Screenshot: FAILED to write %s", path.c_str());
+}
+
+bool ScreenCapture::queueImage(const QImage& image, const std::string& filePath, Format format, int angle,
+							   uint64_t requestedUs, SaveCallback callback, void* userData)
+{
+	if (image.isNull()) {
+		recordCapture(false, 0, requestedUs);
+		return false;
+	}
+
+	Job* job = new Job;
+	job->image = image;
+	job->pathPrefix = filePath;
+	job->format = format;
+	job->angle = angle;
+	job->requestedUs = requestedUs;
+	job->grabUs = (uint32_t) (FrameTimings::nowUs() - requestedUs);
+	job->callback = callback;
+	job->userData = userData;
+
+	g_async_queue_push(m_queue, job);
+	return true;
+}
+
+void ScreenCapture::saveImage(Job* job)
+{
+	job->ok = writeImage(job->image, job->pathPrefix, job->format, job->angle);
+	recordCapture(job->ok, job->grabUs, job->requestedUs);
+
+	if (job->ok)
+		g_warning("Screenshot: Wrote %s", job->pathPrefix.c_str());
+	else
+		g_warning("Screenshot: FAILED to write %s", job->pathPrefix.c_str());
+
+	// the image was shared with the UI thread, drop this thread's reference before handing the job back
+	job->image = QImage();
+	g_idle_add(ScreenCapture::deliverSaved, job);
+}
+
+gboolean ScreenCapture::deliverSaved(gpointer data)
+{
+	Job* job = static_cast<Job*>(data);
+	if (job->callback)
+		job->callback(job->ok, job->userData);
+
+	delete job;
+	return FALSE;
+}
+
+bool ScreenCapture::writeImage(const QImage& image, const std::string& filePath, Format format, int angle)
+{
+	if (format == FormatPng) {
+
+		// the encoder is picked by the extension, which is .png unless a caller asked for something else
+		if (angle == 0) {
+			QImage saved = image;
+			saved.setDotsPerMeterY(saved.dotsPerMeterX());
+			return saved.save(QString::fromUtf8(filePath.c_str()));
+		}
+
+		QTransform trans;
+		trans.rotate(angle);
+		QImage rotated = image.transformed(trans);
+		rotated.setDotsPerMeterY(rotated.dotsPerMeterX());
+		return rotated.save(QString::fromUtf8(filePath.c_str()));
+	}
+
+	QImage pixels = image;
+	if (pixels.format() != QImage::Format_ARGB32_Premultiplied)
+		pixels = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+
+	FILE* file = fopen(filePath.c_str(), "wb");
+	if (!file) {
+		g_warning("%s: failed to open %s", __PRETTY_FUNCTION__, filePath.c_str());
+		return false;
+	}
+
+	uint32_t header[4];
+	header[0] = pixels.width();
+	header[1] = pixels.height();
+	header[2] = pixels.bytesPerLine();
+	header[3] = (angle % 360 + 360) % 360;
+
+	bool ok = fwrite(kRawMagic, sizeof(kRawMagic), 1, file) == 1 &&
+			  fwrite(header, sizeof(header), 1, file) == 1 &&
+			  fwrite(pixels.constBits(), pixels.byteCount(), 1, file) == 1;
+
+	if (fclose(file) != 0)
+		ok = false;
+
+	return ok;
+}
+
+void ScreenCapture::recordCapture(bool ok, uint32_t grabUs, uint64_t requestedUs)
+{
+	uint32_t latencyMs = (uint32_t) ((FrameTimings::nowUs() - requestedUs) / 1000);
+
+	MutexLocker locker(&m_statsMutex);
+
+	if (!ok) {
+		m_stats.failures++;
+		return;
+	}
+
+	m_stats.captures++;
+	m_stats.lastGrabUs = grabUs;
+	m_stats.maxGrabUs = MAX(m_stats.maxGrabUs, grabUs);
+	m_stats.lastLatencyMs = latencyMs;
+	m_stats.maxLatencyMs = MAX(m_stats.maxLatencyMs, latencyMs);
+	m_stats.totalLatencyMs += latencyMs;
+}
+
+void ScreenCapture::getStats(Stats& r_stats) const
+{
+	MutexLocker locker(&m_statsMutex);
+	r_stats = m_stats;
+}
+
+void ScreenCapture::resetStats()
+{
+	MutexLocker locker(&m_statsMutex);
+	memset(&m_stats, 0, sizeof(m_stats));
+}
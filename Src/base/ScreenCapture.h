@@ -0,0 +1,127 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef SCREENCAPTURE_H
+#define SCREENCAPTURE_H
+
+#include "Common.h"
+
+#include <stdint.h>
+#include <string>
+#include <glib.h>
+
+#include <QImage>
+
+#include "Mutex.h"
+
+/*
+ * Saves screenshots without stalling the UI thread.
+ *
+ * The only work done on the caller's thread is copying the framebuffer (and the app direct rendering
+ * layer, if there is one) into a buffer that was allocated and locked into memory by an earlier capture.
+ * Compositing the two layers, rotating, picking a file name that isn't taken and encoding all happen on a
+ * low priority saver thread. An image the caller has rendered itself is handed over as is and only
+ * encoded and written there.
+ *
+ * FormatRaw skips rotation and encoding altogether, for automated tests that want the pixels rather
+ * than a picture: the file is the 4 byte magic "LSC1", then width, height, bytesPerLine and the rotation
+ * (degrees, clockwise) a viewer should apply as native endian uint32_ts, followed by height * bytesPerLine
+ * bytes of QImage::Format_ARGB32_Premultiplied.
+ */
+class ScreenCapture
+{
+public:
+
+	enum Format {
+		FormatPng = 0,		// encoded according to the file extension, .png for captureDisplay()
+		FormatRaw
+	};
+
+	struct Stats {
+		uint32_t captures;			// files written
+		uint32_t failures;			// grabs or writes that failed
+		uint32_t busy;				// requests turned away while all buffers were in flight
+		uint32_t lastGrabUs;		// time the caller's thread spent copying the framebuffer
+		uint32_t maxGrabUs;
+		uint32_t lastLatencyMs;		// from the request to the file being closed
+		uint32_t maxLatencyMs;
+		uint64_t totalLatencyMs;
+	};
+
+	// called from the default main context with whether the file was written
+	typedef void (*SaveCallback)(bool ok, void* userData);
+
+	static ScreenCapture* instance();
+
+	/**
+	 * Copies what is on the display and queues it up to be saved
+	 *
+	 * @param	pathPrefix		Directory and file name without extension; a suffix is added if the file exists
+	 * @param	format			What to write
+	 * @param	angle			Rotation to apply to the image (or record, for FormatRaw)
+	 * @param	requestedUs		FrameTimings::nowUs() when the screenshot was asked for, for latency stats
+	 * @return					false if there was nothing to grab or no free buffer
+	 */
+	bool captureDisplay(const std::string& pathPrefix, Format format, int angle, uint64_t requestedUs);
+
+	/**
+	 * Queues an image, e.g. a scene rendered on the UI thread, to be written to exactly filePath
+	 *
+	 * @param	callback		Called once the file is written or failed to be, may be 0
+	 * @return					false if there was no image; callback isn't called then
+	 */
+	bool queueImage(const QImage& image, const std::string& filePath, Format format, int angle,
+					uint64_t requestedUs, SaveCallback callback, void* userData);
+
+	void getStats(Stats& r_stats) const;
+	void resetStats();
+
+	static const char* extension(Format format) { return format == FormatRaw ? ".raw" : ".png"; }
+
+private:
+
+	struct Job;
+
+	ScreenCapture();
+
+	Job* acquireJob(int bytes, int appBytes);
+	static gpointer saverThread(gpointer data);
+	void save(Job* job);
+	void saveImage(Job* job);
+	static gboolean deliverSaved(gpointer data);
+
+	bool writeImage(const QImage& image, const std::string& filePath, Format format, int angle);
+	void recordCapture(bool ok, uint32_t grabUs, uint64_t requestedUs);
+
+	static const int kNumJobs = 2;
+
+	Job* m_jobs[kNumJobs];
+	GAsyncQueue* m_queue;
+	GThread* m_thread;
+
+	mutable Mutex m_statsMutex;
+	Stats m_stats;
+
+	ScreenCapture(const ScreenCapture&);
+	ScreenCapture& operator=(const ScreenCapture&);
+};
+
+#endif /* SCREENCAPTURE_H */
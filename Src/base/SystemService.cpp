@@ -38,9 +38,14 @@
 #include "ApplicationDescription.h"
 #include "AnimationSettings.h"
 #include "DisplayManager.h"
+#include "FeedbackMixer.h"
+#include "FrameTimings.h"
 #include "HostBase.h"
+#include "HostWindowDataSoftware.h"
 #include "Logging.h"
+#include "ScreenCapture.h"
 #include "Settings.h"
+#include "SoundPlayerPool.h"
 #include "SystemService.h"
 #include "SystemUiController.h"
 #include "Utils.h"
@@ -84,6 +89,8 @@ bool SystemService::sIsParentPdkApp = false;
 
 static bool cbTakeScreenShot(LSHandle* lshandle, LSMessage *message,
 							 void *user_data);
+static void replyTakeScreenShot(LSHandle* lshandle, LSMessage* message, bool success);
+static void cbScreenShotSaved(bool ok, void* userData);
 static bool cbClearCache(LSHandle* lshandle, LSMessage *message,
 							 void *user_data);
 static bool cbSystemUi(LSHandle* lshandle, LSMessage *message,
@@ -139,12 +146,18 @@ static bool cbMonitorProcessMemory(LSHandle* lsHandle, LSMessage *message,
 static bool cbEnableFpsCounter(LSHandle* lsHandle, LSMessage *message,
 							   void *user_data);
 
+static bool cbGetRenderStats(LSHandle* lsHandle, LSMessage *message,
+							 void *user_data);
+
 bool cbEnableTouchPlot(LSHandle* lsHandle, LSMessage *message,
 								void *user_data);
 
 static bool cbLogTouchEvents(LSHandle* lsHandle, LSMessage *message,
 							   void *user_data);
 
+static bool cbReplayTouches(LSHandle* lsHandle, LSMessage *message,
+							void *user_data);
+
 static bool cbSetBenchmarkFlags(LSHandle* lsHandle, LSMessage *message,
                                 void *user_data);
 
@@ -202,7 +215,9 @@ static LSMethod s_methods[]  = {
 	{ "monitorProcessMemory", cbMonitorProcessMemory},
         { "logTouchEvents", cbLogTouchEvents},
 	{ "enableFpsCounter", cbEnableFpsCounter },
+	{ "getRenderStats", cbGetRenderStats },
 	{ "enableTouchPlot", cbEnableTouchPlot },
+	{ "replayTouches", cbReplayTouches },
 	{ "setBenchmarkFlags", cbSetBenchmarkFlags },
 	{ "systemUiDbg",	   cbSystemUiDbg },
 	{ "dumpRasters", cbDumpRasters },
@@ -1247,7 +1262,7 @@ static bool cbTakeScreenShot(LSHandle* lshandle, LSMessage *message,
 
     VALIDATE_SCHEMA_AND_RETURN(lshandle,
                                message,
-                               SCHEMA_1(REQUIRED(file, string)));
+                               SCHEMA_2(REQUIRED(file, string), OPTIONAL(raw, boolean)));
 
     const char* str = LSMessageGetPayload(message);
 
@@ -1255,6 +1270,7 @@ static bool cbTakeScreenShot(LSHandle* lshandle, LSMessage *message,
 		return false;
 
 	bool success = false;
+	bool raw = false;
 
 	struct json_object* root = json_tokener_parse(str);
 	struct json_object* label = 0;
@@ -1276,6 +1292,11 @@ static bool cbTakeScreenShot(LSHandle* lshandle, LSMessage *message,
 	if (filePath.empty())
 		goto Done;
 
+	// uncompressed pixels, for tests that compare captures rather than look at them
+	label = json_object_object_get(root, "raw");
+	if (label && json_object_is_type(label, json_type_boolean))
+		raw = json_object_get_boolean(label);
+
 	if (filePath[0] == '/') {
 		// absolute path.
 	}
@@ -1290,13 +1311,29 @@ static bool cbTakeScreenShot(LSHandle* lshandle, LSMessage *message,
 		filePath = std::string(homeFolder) + "/" + filePath;
 	}
 
-	success = WindowServer::instance()->takeScreenShot(filePath.c_str());
+	// replied to once the saver thread has written the file
+	LSMessageRef(message);
+	if (WindowServer::instance()->takeScreenShot(filePath.c_str(), raw, cbScreenShotSaved, message)) {
+		json_object_put(root);
+		return true;
+	}
+	LSMessageUnref(message);
 
 Done:
 
 	if (root)
 		json_object_put(root);
 
+	replyTakeScreenShot(lshandle, message, success);
+
+	return true;
+}
+
+static void replyTakeScreenShot(LSHandle* lshandle, LSMessage* message, bool success)
+{
+	LSError lserror;
+	LSErrorInit(&lserror);
+
 	json_object* json = json_object_new_object();
 	json_object_object_add(json, "returnValue", json_object_new_boolean(success));
 
@@ -1305,8 +1342,13 @@ Done:
 	}
 
 	json_object_put(json);
+}
 
-	return true;
+static void cbScreenShotSaved(bool ok, void* userData)
+{
+	LSMessage* message = static_cast<LSMessage*>(userData);
+	replyTakeScreenShot(SystemService::instance()->serviceHandle(), message, ok);
+	LSMessageUnref(message);
 }
 
 static bool cbApplicationHasBeenTerminated(LSHandle* lsHandle, LSMessage *message,
@@ -2273,7 +2315,6 @@ bool cbEnableFpsCounter(LSHandle* lsHandle, LSMessage *message, void *user_data)
 	struct json_object* root = json_tokener_parse(str);
 	struct json_object* label = 0;
 	bool failed = true;
-	int reset = 0;
 
 	if (!root || is_error(root))
 		goto Done;
@@ -2294,16 +2335,16 @@ bool cbEnableFpsCounter(LSHandle* lsHandle, LSMessage *message, void *user_data)
 		}
 		if (strcmp(key, "reset") == 0)
 		{
+			// the frame timing ring has a fixed size now, any value just clears it
 			if (json_object_is_type(val, json_type_int))
 			{
-				reset = json_object_get_int(val);
-				WindowServer::resetFpsBuffer(reset);
+				WindowServer::resetFrameTimings();
 				failed = false;
 			}
 		}
 		if (strcmp(key, "dump") == 0)
 		{
-			WindowServer::dumpFpsHistory();
+			WindowServer::dumpFrameTimings();
 			failed = false;
 		}
 	}
@@ -2326,6 +2367,185 @@ Done:
 	return true;
 }
 
+bool cbGetRenderStats(LSHandle* lsHandle, LSMessage *message, void *user_data)
+{
+    // {"reset":boolean}
+    VALIDATE_SCHEMA_AND_RETURN(lsHandle,
+                               message,
+                               SCHEMA_1(OPTIONAL(reset, boolean)));
+
+	const char* str = LSMessageGetPayload(message);
+	if (!str)
+		return false;
+
+	bool reset = false;
+	struct json_object* root = json_tokener_parse(str);
+	if (root && !is_error(root)) {
+		struct json_object* label = json_object_object_get(root, "reset");
+		if (label && json_object_is_type(label, json_type_boolean))
+			reset = json_object_get_boolean(label);
+		json_object_put(root);
+	}
+
+	pbnjson::JValue replyObj = pbnjson::Object();
+
+	// copies out of the apps' shared window buffers (software and GL texture uploads)
+	const HostWindowDataSoftware::CopyStats& copy = HostWindowDataSoftware::copyStats();
+	pbnjson::JValue copyObj = pbnjson::Object();
+	copyObj.put("uploads", (int64_t) copy.uploads);
+	copyObj.put("fullUploads", (int64_t) copy.fullUploads);
+	copyObj.put("bytesCopied", (int64_t) copy.bytesCopied);
+	copyObj.put("bytesFullEquivalent", (int64_t) copy.bytesFullEquivalent);
+	copyObj.put("avgUploadBytes", (int64_t) (copy.uploads ? copy.bytesCopied / copy.uploads : 0));
+	copyObj.put("lastUploadBytes", (int64_t) copy.lastUploadBytes);
+	copyObj.put("maxUploadBytes", (int64_t) copy.maxUploadBytes);
+	replyObj.put("windowCopy", copyObj);
+
+	// per-phase frame times over the last FrameTimings::kNumSamples frames
+	static const char* const phaseNames[FrameTimings::PhaseCount] = {
+		"frame", "events", "paint", "uploads", "swap"
+	};
+	FrameTimings::Summary frames;
+	FrameTimings::instance()->summarize(frames);
+	pbnjson::JValue framesObj = pbnjson::Object();
+	framesObj.put("frames", (int64_t) frames.frames);
+	framesObj.put("totalFrames", (int64_t) frames.totalFrames);
+	framesObj.put("droppedFrames", (int64_t) frames.droppedFrames);
+	for (int i = 0; i < FrameTimings::PhaseCount; i++) {
+		pbnjson::JValue phaseObj = pbnjson::Object();
+		phaseObj.put("p50Us", (int64_t) frames.phases[i].p50Us);
+		phaseObj.put("p95Us", (int64_t) frames.phases[i].p95Us);
+		phaseObj.put("p99Us", (int64_t) frames.phases[i].p99Us);
+		phaseObj.put("maxUs", (int64_t) frames.phases[i].maxUs);
+		framesObj.put(phaseNames[i], phaseObj);
+	}
+	// from a touch being dispatched to the frame showing it
+	pbnjson::JValue inputObj = pbnjson::Object();
+	inputObj.put("frames", (int64_t) frames.inputFrames);
+	inputObj.put("p50Us", (int64_t) frames.inputLatency.p50Us);
+	inputObj.put("p95Us", (int64_t) frames.inputLatency.p95Us);
+	inputObj.put("p99Us", (int64_t) frames.inputLatency.p99Us);
+	inputObj.put("maxUs", (int64_t) frames.inputLatency.maxUs);
+	framesObj.put("inputLatency", inputObj);
+	replyObj.put("frames", framesObj);
+
+	// screenshots, from the request to the file being written
+	ScreenCapture::Stats capture;
+	ScreenCapture::instance()->getStats(capture);
+	pbnjson::JValue captureObj = pbnjson::Object();
+	captureObj.put("captures", (int64_t) capture.captures);
+	captureObj.put("failures", (int64_t) capture.failures);
+	captureObj.put("busy", (int64_t) capture.busy);
+	captureObj.put("lastGrabUs", (int64_t) capture.lastGrabUs);
+	captureObj.put("maxGrabUs", (int64_t) capture.maxGrabUs);
+	captureObj.put("lastLatencyMs", (int64_t) capture.lastLatencyMs);
+	captureObj.put("maxLatencyMs", (int64_t) capture.maxLatencyMs);
+	captureObj.put("avgLatencyMs", (int64_t) (capture.captures ? capture.totalLatencyMs / capture.captures : 0));
+	replyObj.put("screenCapture", captureObj);
+
+	// feedback sounds played in process, from the request to the first sample reaching the sink
+	FeedbackMixer* mixer = SoundPlayerPool::instance()->feedbackMixer();
+	if (mixer) {
+		FeedbackMixer::Stats feedback;
+		mixer->getStats(feedback);
+		pbnjson::JValue feedbackObj = pbnjson::Object();
+		feedbackObj.put("loaded", mixer->loaded());
+		feedbackObj.put("samples", (int64_t) mixer->sampleCount());
+		feedbackObj.put("played", (int64_t) feedback.played);
+		feedbackObj.put("fallbacks", (int64_t) feedback.fallbacks);
+		feedbackObj.put("dropped", (int64_t) feedback.dropped);
+		feedbackObj.put("lastLatencyUs", (int64_t) feedback.lastLatencyUs);
+		feedbackObj.put("maxLatencyUs", (int64_t) feedback.maxLatencyUs);
+		feedbackObj.put("avgLatencyUs", (int64_t) (feedback.played ? feedback.totalLatencyUs / feedback.played : 0));
+		replyObj.put("feedbackSounds", feedbackObj);
+	}
+
+	if (reset) {
+		HostWindowDataSoftware::resetCopyStats();
+		FrameTimings::instance()->reset();
+		ScreenCapture::instance()->resetStats();
+		if (mixer)
+			mixer->resetStats();
+	}
+
+	replyObj.put("returnValue", true);
+
+	std::string replyStr;
+	pbnjson::JGenerator generator;
+	generator.toString(replyObj, pbnjson::JSchemaFragment("{}"), replyStr);
+
+	LSError err;
+	LSErrorInit(&err);
+	if (!LSMessageReply(lsHandle, message, replyStr.c_str(), &err))
+		LSErrorFree(&err);
+
+	return true;
+}
+
+bool cbReplayTouches(LSHandle* lsHandle, LSMessage *message, void *user_data)
+{
+    // {"path":string, "speed":integer, "resampleMode":string}
+    VALIDATE_SCHEMA_AND_RETURN(lsHandle,
+                               message,
+                               SCHEMA_3(REQUIRED(path, string), OPTIONAL(speed, integer), OPTIONAL(resampleMode, string)));
+
+	const char* str = LSMessageGetPayload(message);
+	if (!str)
+		return false;
+
+	struct json_object* root = json_tokener_parse(str);
+	if (!root || is_error(root))
+		return false;
+
+	std::string path;
+	std::string resampleMode;
+	int speed = 100;
+
+	struct json_object* label = json_object_object_get(root, "path");
+	if (label && json_object_is_type(label, json_type_string))
+		path = json_object_get_string(label);
+	label = json_object_object_get(root, "speed");
+	if (label && json_object_is_type(label, json_type_int))
+		speed = json_object_get_int(label);
+	label = json_object_object_get(root, "resampleMode");
+	if (label && json_object_is_type(label, json_type_string))
+		resampleMode = json_object_get_string(label);
+	json_object_put(root);
+
+	// measured from a clean slate, so the reply is the replay's input to photon latency alone
+	FrameTimings::instance()->reset();
+	int scans = WindowServer::replayTouches(path.c_str(), speed, resampleMode.empty() ? 0 : resampleMode.c_str());
+
+	FrameTimings::Summary frames;
+	FrameTimings::instance()->summarize(frames);
+
+	pbnjson::JValue replyObj = pbnjson::Object();
+	replyObj.put("returnValue", scans >= 0);
+	if (scans >= 0) {
+		replyObj.put("scans", (int64_t) scans);
+		replyObj.put("frames", (int64_t) frames.frames);
+		replyObj.put("droppedFrames", (int64_t) frames.droppedFrames);
+		pbnjson::JValue inputObj = pbnjson::Object();
+		inputObj.put("frames", (int64_t) frames.inputFrames);
+		inputObj.put("p50Us", (int64_t) frames.inputLatency.p50Us);
+		inputObj.put("p95Us", (int64_t) frames.inputLatency.p95Us);
+		inputObj.put("p99Us", (int64_t) frames.inputLatency.p99Us);
+		inputObj.put("maxUs", (int64_t) frames.inputLatency.maxUs);
+		replyObj.put("inputLatency", inputObj);
+	}
+
+	std::string replyStr;
+	pbnjson::JGenerator generator;
+	generator.toString(replyObj, pbnjson::JSchemaFragment("{}"), replyStr);
+
+	LSError err;
+	LSErrorInit(&err);
+	if (!LSMessageReply(lsHandle, message, replyStr.c_str(), &err))
+		LSErrorFree(&err);
+
+	return true;
+}
+
 bool cbEnableTouchPlot(LSHandle* lsHandle, LSMessage *message, void *user_data)
 {
     // {"collection":true} or {"trails":true} or {"crosshairs":false}
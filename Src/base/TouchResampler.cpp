@@ -0,0 +1,184 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include "TouchResampler.h"
+
+#include <glib.h>
+
+#include "Settings.h"
+
+static TouchResampler::ModeProvider s_modeProvider = 0;
+
+static inline int PrvLerp(int a, int b, int64_t num, int64_t den)
+{
+	return a + (int) ((int64_t) (b - a) * num / den);
+}
+
+TouchResampler::TouchResampler()
+	: m_maxPredictionUs(Settings::LunaSettings()->touchMaxPredictionMs * 1000)
+{
+}
+
+void TouchResampler::addSample(int id, uint64_t timeUs, int x, int y)
+{
+	History* history = 0;
+	for (std::vector<History>::iterator it = m_touches.begin(); it != m_touches.end(); ++it) {
+		if (it->id == id) {
+			history = &(*it);
+			break;
+		}
+	}
+
+	if (!history) {
+		History fresh;
+		fresh.id = id;
+		fresh.count = 0;
+		m_touches.push_back(fresh);
+		history = &m_touches.back();
+	}
+
+	int count = MIN(history->count + 1, kHistorySize);
+	for (int i = count - 1; i > 0; i--) {
+		history->timeUs[i] = history->timeUs[i - 1];
+		history->x[i] = history->x[i - 1];
+		history->y[i] = history->y[i - 1];
+	}
+
+	history->timeUs[0] = timeUs;
+	history->x[0] = x;
+	history->y[0] = y;
+	history->count = count;
+}
+
+void TouchResampler::removeTouch(int id)
+{
+	for (std::vector<History>::iterator it = m_touches.begin(); it != m_touches.end(); ++it) {
+		if (it->id == id) {
+			m_touches.erase(it);
+			return;
+		}
+	}
+}
+
+const TouchResampler::History* TouchResampler::find(int id) const
+{
+	for (std::vector<History>::const_iterator it = m_touches.begin(); it != m_touches.end(); ++it) {
+		if (it->id == id)
+			return &(*it);
+	}
+	return 0;
+}
+
+bool TouchResampler::resample(int id, uint64_t frameUs, Mode mode, int& r_x, int& r_y) const
+{
+	if (mode == ModeOff)
+		return false;
+
+	const History* h = find(id);
+	if (!h || h->count < 2)
+		return false;
+
+	if (mode == ModeInterpolate) {
+
+		uint64_t targetUs = frameUs > kInterpolationDelayUs ? frameUs - kInterpolationDelayUs : 0;
+
+		// never past the newest position, that would be predicting
+		if (targetUs >= h->timeUs[0]) {
+			r_x = h->x[0];
+			r_y = h->y[0];
+			return true;
+		}
+
+		for (int i = 1; i < h->count; i++) {
+			if (h->timeUs[i] > targetUs)
+				continue;
+
+			int64_t span = h->timeUs[i - 1] - h->timeUs[i];
+			if (span <= 0) {
+				r_x = h->x[i - 1];
+				r_y = h->y[i - 1];
+			}
+			else {
+				int64_t into = targetUs - h->timeUs[i];
+				r_x = PrvLerp(h->x[i], h->x[i - 1], into, span);
+				r_y = PrvLerp(h->y[i], h->y[i - 1], into, span);
+			}
+			return true;
+		}
+
+		r_x = h->x[h->count - 1];
+		r_y = h->y[h->count - 1];
+		return true;
+	}
+
+	uint64_t newestUs = h->timeUs[0];
+
+	// the finger paused, there is no velocity to go on
+	if (newestUs - h->timeUs[1] > kVelocityWindowUs) {
+		r_x = h->x[0];
+		r_y = h->y[0];
+		return true;
+	}
+
+	// velocity over as many positions as fit in the window, to smooth out scan noise
+	int oldest = 1;
+	while (oldest + 1 < h->count && newestUs - h->timeUs[oldest + 1] <= kVelocityWindowUs)
+		oldest++;
+
+	int64_t span = newestUs - h->timeUs[oldest];
+	int64_t ahead = frameUs > newestUs ? MIN(frameUs - newestUs, (uint64_t) m_maxPredictionUs) : 0;
+	if (span <= 0 || ahead == 0) {
+		r_x = h->x[0];
+		r_y = h->y[0];
+		return true;
+	}
+
+	r_x = h->x[0] + (int) ((int64_t) (h->x[0] - h->x[oldest]) * ahead / span);
+	r_y = h->y[0] + (int) ((int64_t) (h->y[0] - h->y[oldest]) * ahead / span);
+	return true;
+}
+
+TouchResampler::Mode TouchResampler::currentMode()
+{
+	if (s_modeProvider)
+		return s_modeProvider();
+
+	return modeFromString(Settings::LunaSettings()->touchResampleMode, ModeOff);
+}
+
+void TouchResampler::setModeProvider(ModeProvider provider)
+{
+	s_modeProvider = provider;
+}
+
+TouchResampler::Mode TouchResampler::modeFromString(const std::string& str, Mode fallback)
+{
+	if (str == "off")
+		return ModeOff;
+	if (str == "interpolate")
+		return ModeInterpolate;
+	if (str == "predict")
+		return ModePredict;
+
+	return fallback;
+}
@@ -0,0 +1,89 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef TOUCHRESAMPLER_H
+#define TOUCHRESAMPLER_H
+
+#include "Common.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/*
+ * Moves touch positions to the time the frame showing them will be on screen.
+ *
+ * The touchpanel scans at its own rate, unrelated to the display's, so drawing the newest raw position
+ * shows where the finger was anywhere from one to two scan periods plus a frame ago, and how far behind
+ * changes from frame to frame. ModeInterpolate samples the finger's path a fixed kInterpolationDelayUs
+ * before the frame time, between two real positions, which takes out the judder but not the lag.
+ * ModePredict extrapolates the recent velocity to the frame time itself, at most maxPredictionUs past the
+ * newest position, which takes out most of the lag at the risk of overshooting when the finger stops.
+ */
+class TouchResampler
+{
+public:
+
+	enum Mode {
+		ModeOff = 0,
+		ModeInterpolate,
+		ModePredict
+	};
+
+	typedef Mode (*ModeProvider)();
+
+	TouchResampler();
+
+	void addSample(int id, uint64_t timeUs, int x, int y);
+	void removeTouch(int id);
+	void clear() { m_touches.clear(); }
+
+	// false if mode is ModeOff or there isn't enough history for id; r_x and r_y are left alone then
+	bool resample(int id, uint64_t frameUs, Mode mode, int& r_x, int& r_y) const;
+
+	void setMaxPredictionUs(uint32_t us) { m_maxPredictionUs = us; }
+
+	// the mode for a touch that was just pressed, decided by whatever took the press
+	static Mode currentMode();
+	static void setModeProvider(ModeProvider provider);
+	static Mode modeFromString(const std::string& str, Mode fallback);
+
+	static const int kHistorySize = 4;
+	static const uint32_t kInterpolationDelayUs = 8000;		// about one scan at 120Hz
+	static const uint32_t kVelocityWindowUs = 40000;		// older positions don't say much about where it's going
+
+private:
+
+	struct History {
+		int id;
+		int count;			// newest first
+		uint64_t timeUs[kHistorySize];
+		int x[kHistorySize];
+		int y[kHistorySize];
+	};
+
+	const History* find(int id) const;
+
+	std::vector<History> m_touches;
+	uint32_t m_maxPredictionUs;
+};
+
+#endif /* TOUCHRESAMPLER_H */
@@ -23,10 +23,13 @@
 
 #include "WindowManagerBase.h"
 
+#include "Settings.h"
 #include "Window.h"
 #include <QGraphicsScene>
+#include <QStringList>
 
 WindowManagerBase::WindowManagerBase(int maxWidth, int maxHeight)
+	: m_touchResampleMode(-1)
 {
 	m_boundingRect = QRectF(-maxWidth/2, -maxHeight/2, maxWidth, maxHeight);
 
@@ -56,6 +59,27 @@ QRectF WindowManagerBase::boundingRect() const
 	return m_boundingRect;
 }
 
+TouchResampler::Mode WindowManagerBase::touchResampleMode() const
+{
+	if (m_touchResampleMode >= 0)
+		return (TouchResampler::Mode) m_touchResampleMode;
+
+	// the class name is only final once construction is done, so this can't be done up front
+	const Settings* settings = Settings::LunaSettings();
+	TouchResampler::Mode mode = TouchResampler::modeFromString(settings->touchResampleMode, TouchResampler::ModeOff);
+
+	QString className = metaObject()->className();
+	QStringList overrides = QString::fromUtf8(settings->touchResampleWindowManagers.c_str()).split(',', QString::SkipEmptyParts);
+	Q_FOREACH(const QString& entry, overrides) {
+		QStringList pair = entry.trimmed().split('=');
+		if (pair.size() == 2 && pair[0].trimmed() == className)
+			mode = TouchResampler::modeFromString(pair[1].trimmed().toStdString(), mode);
+	}
+
+	m_touchResampleMode = mode;
+	return mode;
+}
+
 bool WindowManagerBase::handleNavigationEvent(QKeyEvent* keyEvent, bool& propogate)
 {
     propogate = true;
@@ -26,6 +26,7 @@
 
 #include <QGraphicsItem>
 #include <QPainter>
+#include "TouchResampler.h"
 #include "UiNavigationController.h"
 
 class Window;
@@ -59,9 +60,15 @@ public:
 
     virtual bool handleNavigationEvent(QKeyEvent* keyEvent, bool& propogate);
 
+	// how positions of touches that started over this window manager are moved to the frame time
+	TouchResampler::Mode touchResampleMode() const;
+
 protected:
 	void raiseChild(QGraphicsItem* child);
 	QRectF m_boundingRect;
+
+private:
+	mutable int m_touchResampleMode;		// -1 until looked up in the settings
 };
 
 #endif /* WINDOWMANAGERBASE_H */
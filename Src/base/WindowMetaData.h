@@ -30,6 +30,7 @@ struct WindowMetaData
 		directRenderingScreenX = 0;
 		directRenderingScreenY = 0;
 		directRenderingOrientation = 0;
+		onScreen = false;
 	}
 	
 	void reset() {
@@ -38,6 +39,7 @@ struct WindowMetaData
 		directRenderingScreenX = 0;
 		directRenderingScreenY = 0;
 		directRenderingOrientation = 0;
+		onScreen = false;
 	}
 	
 	int transitionBufferKey;
@@ -45,6 +47,7 @@ struct WindowMetaData
 	int directRenderingScreenX;
 	int directRenderingScreenY;
 	int directRenderingOrientation;
+	bool onScreen;					// written by the HostWindow whenever it comes on or goes off the screen
 };
 
 #endif /* WINDOWMETADATA_H */
@@ -33,7 +33,6 @@
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <sys/prctl.h>
-#include <cmath>
 
 #include <string>
 #include <tr1/unordered_set>
@@ -104,7 +103,9 @@
 #endif
 
 #include <vector>
-#include "FpsHistory.h"
+#include "FrameTimings.h"
+#include "HostWindow.h"
+#include "ScreenCapture.h"
 
 #include "TouchPlot.h"
 
@@ -117,6 +118,8 @@ static const int kMaxPaintFPS = 120;
 static const int kMinPaintInterval = 1000 / kMaxPaintFPS;
 static const unsigned int kResizePendingTickIntervalInMS    = 100;
 static const int kDeferredNewOrientationIntervalMs = 200;
+// how long a screenshot waits for the frame it asked for before grabbing what is on the display
+static const int kScreenShotFrameTimeoutMs = 250;
 
 // ------------------------------------------------------------------
 
@@ -139,7 +142,7 @@ public:
 		m_performance = FPSOk;
 
 		m_elapsed.start();
-		setFPS(0,0,0);
+		setFPS(0,0);
 	}
 
 	virtual QRectF boundingRect () const  {
@@ -157,31 +160,10 @@ public:
 		painter->drawText(rect, Qt::AlignRight, m_stdDevString);
 	}
 
-	virtual void setFPS(int fps, int std_dev, uint32_t timeMs)
+	virtual void setFPS(int fps, uint32_t p95FrameMs)
 	{
-		FpsHistoryElem elem;
-
-		elem.Fps = fps;
-		elem.Standard_Deviation = std_dev;
-
-		m_fpsString = QString::fromLatin1("%03 FPS").arg(fps);
-		m_stdDevString = QString::fromLatin1("%03 ms").arg(std_dev);
-
-		//Add the passed in fps/std_dev value to the circular buffer
-		m_fpsHistory.AddSample(elem, timeMs);
-	
-	}
-
-	virtual void dumpFPS()
-	{
-		//Dump the FPS and std_dev from the circular buffer
-		m_fpsHistory.Dump();
-	}
-
-	virtual void resetFpsBuffer(int newBufSize)
-	{
-		//Reset the circular buffer to the requesetd size
-		m_fpsHistory.Reset(newBufSize);
+		m_fpsString = QString::fromLatin1("%1 FPS").arg(fps, 3, 10, QLatin1Char('0'));
+		m_stdDevString = QString::fromLatin1("p95 %1 ms").arg(p95FrameMs);
 	}
 
 private:
@@ -202,12 +184,11 @@ private:
 	FPSState m_nextPerformance;
 
 	QTime m_elapsed;
-
-	FpsHistory m_fpsHistory;
 };
 
 static FpsCounter* s_fpsCounter = 0;
 static TouchPlot *s_TouchPlot = 0;
+static int s_replayResampleMode = -1;
 
 // ------------------------------------------------------------------
 
@@ -289,7 +270,10 @@ void Runtime::slotTimeFormatChanged (const char* format)
 
 QString Runtime::getLocalizedString(QString text)
  {
-	 return QString::fromUtf8(LOCALIZED(text.toStdString()).c_str());
+	 // looked up as UTF-8 in place, with no std::string made of either the key or the translation
+	 QByteArray key = text.toUtf8();
+	 LocalizedStringRef localized = Localization::instance()->localizedString(key.constData(), key.size());
+	 return QString::fromUtf8(localized.data(), localized.length());
  }
 
 QString Runtime::getLocalizedDay()
@@ -339,10 +323,6 @@ WindowServer* WindowServer::instance()
 	return s_instance;
 }
 
-#ifdef DEBUG_RECORD_PAINT
-static bool vsyncDisabled;
-#endif
-
 WindowServer::WindowServer()
 	: m_displayMgr(0)
 	, m_inputMgr(0)
@@ -361,6 +341,8 @@ WindowServer::WindowServer()
     , m_currentUiOrientation(OrientationEvent::Orientation_Up)
     , m_pendingOrientation(OrientationEvent::Orientation_Up)
 	, m_pendingRotationType(Rotation_RotateAndCrossFade)
+	, m_screenShotPending(false)
+	, m_screenShotRequestedUs(0)
 	, m_screenShotImagesValid(false)
 	, m_beforePixItem(0)
 	, m_afterPixItem(0)
@@ -370,13 +352,11 @@ WindowServer::WindowServer()
     , m_cachedFocusedItem(0)
 	, m_inRotationAnimation(Rotation_NoAnimation)
 	, m_fingerDownOnScreen(false)
-#ifdef DEBUG_RECORD_PAINT
-	, m_paintTrace(NULL)
-	, m_paintTraceFile(QLatin1String("/media/internal/lsm_paint_trace.csv"))
-#endif
 {
 	s_instance = this;
 
+	TouchResampler::setModeProvider(&WindowServer::touchResampleModeForGrabber);
+
 	std::string imagePath = Settings::LunaSettings()->lunaSystemResourcesPath;
 	imagePath += "/hp-logo.png";
 	m_bootupScreen = QPixmap(qFromUtf8Stl(imagePath));
@@ -497,6 +477,10 @@ WindowServer::WindowServer()
 	connect(&m_deferredNewOrientationTimer, SIGNAL(timeout()),
 			SLOT(slotDeferredNewOrientation()));
 
+	m_screenShotTimer.setInterval(kScreenShotFrameTimeoutMs);
+	m_screenShotTimer.setSingleShot(true);
+	connect(&m_screenShotTimer, SIGNAL(timeout()), SLOT(slotScreenShotFrameTimeout()));
+
     connect(Preferences::instance(),SIGNAL(signalRotationLockChanged(OrientationEvent::Orientation)), SLOT(slotRotationLockChanged(OrientationEvent::Orientation)));
 
 
@@ -506,67 +490,8 @@ WindowServer::WindowServer()
 	s_globalPropsBuffer = PIpcBuffer::create(sizeof(SharedGlobalProperties));
 	::memset(s_globalPropsBuffer->data(), 0, sizeof(SharedGlobalProperties));
 	WebAppMgrProxy::instance()->setGlobalProperties(s_globalPropsBuffer->key());
-
-#ifdef DEBUG_RECORD_PAINT
-#if 0
-	initBaseLineTimespec();
-#endif
-
-	if (m_paintTraceFile.exists())
-		m_paintTraceFile.remove();
-
-	if (m_paintTraceFile.open(QIODevice::WriteOnly)) {
-		m_paintTrace = new QTextStream(&m_paintTraceFile);
-		vsyncDisabled = DisplayManager::isVsyncOff();
-		*m_paintTrace << "vsync " << (vsyncDisabled ? "disabled" : "enabled") << "\n";
-	}
-#endif
-}
-
-#ifdef DEBUG_RECORD_PAINT
-static qreal now()
-{
-	struct timespec tp;
-#if 0
-	clock_gettime(CLOCK_REALTIME, &tp);
-	return (tp.tv_sec - baseLineTimespec().tv_sec) * 1000 + (tp.tv_nsec - baseLineTimespec().tv_nsec) / 1000000.0;
-#else
-	clock_gettime(CLOCK_MONOTONIC, &tp);
-	return tp.tv_sec * 1000 + tp.tv_nsec / 1000000.0;
-#endif
-}
-
-static void mark(struct timespec& ts)
-{
-	clock_gettime(CLOCK_MONOTONIC, &ts);
 }
 
-static qreal elapsedMS(const struct timespec& ts)
-{
-	struct timespec ts_now;
-	mark(ts_now);
-	return (ts_now.tv_sec - ts.tv_sec) * 1000 + (ts_now.tv_nsec - ts.tv_nsec) / 1000000.0;
-}
-
-void WindowServer::tracePaint(qreal durationMs)
-{
-	if (m_paintTrace) {
-		static int frames = 0;
-		if (vsyncDisabled != DisplayManager::isVsyncOff()) {
-			vsyncDisabled = DisplayManager::isVsyncOff();
-			*m_paintTrace << "vsync " << (vsyncDisabled ? "disabled" : "enabled") << "\n";
-		}
-
-		qreal timestamp = now();
-		*m_paintTrace << timestamp << "," << durationMs << "\n";
-		if (frames++ == 60) {
-			m_paintTrace->flush();
-			frames = 0;
-		}
-	}
-}
-#endif
-
 WindowServer::~WindowServer()
 {
 	delete m_displayMgr;
@@ -793,6 +718,7 @@ bool WindowServer::eventFilter(QObject *obj, QEvent *event)
 	// Key events are filtered here. Mouse events are filtered by viewportEvent
 	if (this == obj && (event->type() == QEvent::KeyPress || event->type() == QEvent::KeyRelease ||
 			event->type() > QEvent::User)) {
+		FrameTimings::Scope eventTime(&FrameTimings::addEventTime);
 		return sysmgrEventFilters(event);
 	}
 	return false;
@@ -801,9 +727,9 @@ bool WindowServer::eventFilter(QObject *obj, QEvent *event)
 bool WindowServer::viewportEvent(QEvent* event)
 {
 //	QTime paintEventDuration;
-#ifdef DEBUG_RECORD_PAINT
-	struct timespec paintStart;
-#endif
+
+	// everything but painting counts towards the next frame's event dispatch time
+	FrameTimings::Scope eventTime(&FrameTimings::addEventTime, event->type() != QEvent::Paint);
 
 	if(event->type() == QEvent::TouchBegin) {
 		m_fingerDownOnScreen = true;
@@ -867,11 +793,6 @@ bool WindowServer::viewportEvent(QEvent* event)
 	}
 	case QEvent::Paint: {
 
-#ifdef DEBUG_RECORD_PAINT
-		if (m_paintTrace)
-			mark(paintStart);
-#endif
-
 		if (G_UNLIKELY(m_bootingUp)) {
 #if !defined(TARGET_DEVICE)
 			paintBootupScreen();
@@ -879,6 +800,10 @@ bool WindowServer::viewportEvent(QEvent* event)
 			return true;
 		}
 
+		FrameTimings::instance()->beginPaint();
+
+		HostWindow::updateAllOnScreen();
+
 #if false && defined(HAVE_OPENGL)
 		if (m_timeSinceLastPaint.isNull()) {
 			connect(&m_unaliasPaintEvent, SIGNAL(timeout()), SLOT(repaint()));
@@ -895,7 +820,6 @@ bool WindowServer::viewportEvent(QEvent* event)
 		if (G_UNLIKELY(s_fpsCounter)) {
 
 			static uint32_t startTime = Time::curTimeMs();
-			static std::vector<int> frameInterval;
 			static int frameCount = 0;
 			const uint32_t interval = 100;
 
@@ -904,28 +828,16 @@ bool WindowServer::viewportEvent(QEvent* event)
 			if ((currTime - startTime) > interval) {
 				if (frameCount > 0) {
 					int fps = (frameCount * 1000.0) / (currTime - startTime);
-				    	int std_deviation = 0;
-
-				    	if ( fps > 0 && frameInterval.size() > 1 ) {
-						int ideal_ms = 1000 / fps;
-						int sum = 0;
-
-						for (size_t i = 1; i < frameInterval.size(); i++) {
-					    		int part = (int)(frameInterval[i] - frameInterval[i-1]) - ideal_ms;
-					    		sum += part*part;
-						}
 
-						std_deviation = (int)(::sqrt( sum / (frameInterval.size() - 1)));
-				    	}
-					frameInterval.clear();
-					s_fpsCounter->setFPS(fps, std_deviation, currTime);
+					FrameTimings::Summary summary;
+					FrameTimings::instance()->summarize(summary);
+					s_fpsCounter->setFPS(fps, summary.phases[FrameTimings::PhaseFrame].p95Us / 1000);
 				}
 
 				startTime = currTime;
 				frameCount = 0;
 			}
 			else {
-				frameInterval.push_back(currTime);
 				frameCount++;
 			}
 
@@ -940,13 +852,15 @@ bool WindowServer::viewportEvent(QEvent* event)
 
 	switch (event->type()) {
 		case QEvent::Paint: {
-#ifdef DEBUG_RECORD_PAINT
-			if (m_paintTrace)
-				tracePaint(elapsedMS(paintStart));
-#endif
+			FrameTimings::instance()->endPaint();
 
 			HostBase::instance()->flip();
 
+			FrameTimings::instance()->endFrame();
+
+			if (G_UNLIKELY(m_screenShotPending))
+				grabScreenShot();
+
 			break;
 		}
 		case QEvent::TouchBegin:
@@ -1106,18 +1020,14 @@ void WindowServer::unfocusWindow(Window* win)
 #define GL_BGRA	0x80E1
 #endif
 
-bool WindowServer::takeScreenShot(const char* filePath)
+bool WindowServer::takeScreenShot(const char* filePath, bool raw, ScreenCapture::SaveCallback callback,
+								  void* userData)
 {
+	// the scene has to be rendered here, the encoding and writing is left to the saver thread
+	uint64_t requestedUs = FrameTimings::nowUs();
 	QImage screenShot(getScreenShotImage());
-	screenShot.setDotsPerMeterY(screenShot.dotsPerMeterX());
-	bool ret = screenShot.save(filePath);
-	
-	if (ret)
-		g_warning("Screenshot: Wrote %s", filePath);
-	else
-		g_warning("Screenshot: FAILED to write %s", filePath);
-
-	return ret;
+	return ScreenCapture::instance()->queueImage(screenShot, filePath,
+			raw ? ScreenCapture::FormatRaw : ScreenCapture::FormatPng, 0, requestedUs, callback, userData);
 }
 
 QPixmap* WindowServer::takeScreenShot()
@@ -1453,20 +1363,60 @@ void WindowServer::enableFpsCounter(bool enable)
 	}
 }
 
-void WindowServer::dumpFpsHistory()
+void WindowServer::dumpFrameTimings()
 {
-	if (s_fpsCounter){
-		s_fpsCounter->dumpFPS();
-	}
+	FrameTimings::instance()->dump("/tmp/luna-frames.bin");
+}
+
+void WindowServer::resetFrameTimings()
+{
+	FrameTimings::instance()->reset();
 }
 
-void WindowServer::resetFpsBuffer(int newBufSize)
+int WindowServer::replayTouches(const char* path, int speedPercent, const char* resampleMode)
 {
+#if defined(TARGET_DEVICE) && !defined(HAVE_QPA)
+	// the replay runs a nested event loop, don't let another request start one inside it
+	static bool replaying = false;
+	if (replaying)
+		return -1;
+
+	TouchRecording recording;
+	if (!recording.load(path))
+		return -1;
+
+	replaying = true;
+	if (resampleMode)
+		s_replayResampleMode = TouchResampler::modeFromString(resampleMode, TouchResampler::ModeOff);
+
+	QWSHiddTpHandler* handler = static_cast<QWSHiddTpHandler*>(QWSServer::mouseHandler());
+	int scans = handler->replay(recording, speedPercent);
+
+	s_replayResampleMode = -1;
+	replaying = false;
+	return scans;
+#else
+	return -1;
+#endif
+}
 
-	if (s_fpsCounter){
-		s_fpsCounter->resetFpsBuffer(newBufSize);
+TouchResampler::Mode WindowServer::touchResampleModeForGrabber()
+{
+	if (s_replayResampleMode >= 0)
+		return (TouchResampler::Mode) s_replayResampleMode;
+
+	// asked right after a press went out, so whatever took it now has the mouse grab
+	QGraphicsItem* grabber = 0;
+	if (s_instance && s_instance->scene())
+		grabber = s_instance->scene()->mouseGrabberItem();
+
+	for (QGraphicsItem* item = grabber; item; item = item->parentItem()) {
+		WindowManagerBase* wm = qobject_cast<WindowManagerBase*>(item->toGraphicsObject());
+		if (wm)
+			return wm->touchResampleMode();
 	}
 
+	return TouchResampler::modeFromString(Settings::LunaSettings()->touchResampleMode, TouchResampler::ModeOff);
 }
 
 void WindowServer::enableTouchPlotOption(TouchPlot::TouchPlotOption_t type, bool enable)
@@ -1534,61 +1484,56 @@ void WindowServer::disableOverlay()
     s_overlay = 0;
 }
 
-struct ScreenShotParameter
+static int PrvScreenShotAngle(OrientationEvent::Orientation orientation)
 {
-	QImage image;
-	std::string filePath;
-    OrientationEvent::Orientation orientation;
-};
-
-static gpointer PrvSaveScreenShot(gpointer data)
-{
-	if (!data)
-		return 0;
-
-	::prctl(PR_SET_NAME, "ScreenShotSaver", 0, 0, 0);
-	
-	// Low priority thread
-	::setpriority(PRIO_PROCESS, ::getpid(), 5);
-	
-	ScreenShotParameter* param = (ScreenShotParameter*) data;
-
-	int angle = 0;
-	
-	switch (param->orientation) {
+	switch (orientation) {
     case OrientationEvent::Orientation_Down:
-		angle = 180;
-		break;				
+		return 180;
     case OrientationEvent::Orientation_Right:
-		angle = 90;
-		break;
+		return 90;
     case OrientationEvent::Orientation_Left:
-		angle = -90;
-		break;
+		return -90;
     case OrientationEvent::Orientation_Up:
 	default:
-		angle = 0;
-		break;
+		return 0;
 	}
+}
 
-	if (angle != 0) {
-		QTransform trans;
-		trans.rotate(angle);
-		param->image = param->image.transformed(trans);
-	}
+void WindowServer::takeAndSaveScreenShot()
+{
+	// the key combo can't be pressed faster than a frame is painted, one at a time is plenty
+	if (m_screenShotPending)
+		return;
 
-	param->image.setDotsPerMeterY(param->image.dotsPerMeterX());
-	param->image.save(param->filePath.c_str());
-	delete param;
+	m_screenShotRequestedUs = FrameTimings::nowUs();
+	m_screenShotPending = true;
 
-	return 0;
+	// hides the flash of the previous screenshot; grab once the frame without it is on the display
+	Q_EMIT signalAboutToTakeScreenShot();
+
+	if (G_UNLIKELY(m_bootingUp || !viewport()->updatesEnabled())) {
+		// no frame is coming, take what's there
+		grabScreenShot();
+		return;
+	}
+
+	// nor is one when the window isn't exposed, e.g. with the display off
+	m_screenShotTimer.start();
+	viewport()->update();
 }
 
-void WindowServer::takeAndSaveScreenShot()
+void WindowServer::slotScreenShotFrameTimeout()
 {
-	Q_EMIT signalAboutToTakeScreenShot();
+	if (m_screenShotPending) {
+		g_debug("Screenshot: no frame within %d ms, grabbing what is on the display", kScreenShotFrameTimeoutMs);
+		grabScreenShot();
+	}
+}
 
-	viewport()->repaint();
+void WindowServer::grabScreenShot()
+{
+	m_screenShotPending = false;
+	m_screenShotTimer.stop();
 
 #if defined(TARGET_DESKTOP)
 	std::string kScreenCapturesPathBase = "/tmp/captures/";
@@ -1598,37 +1543,27 @@ void WindowServer::takeAndSaveScreenShot()
 	mkdir(kScreenCapturesPathBase.c_str(), 666);
 #endif
 
-	std::string fullPath;
-	while (1) {
-		std::string appName = SystemUiController::instance()->activeApplicationName();
-		size_t i = appName.rfind('.');
-		if (i > 0)
-			appName = appName.substr(i+1);
-
-		time_t result = time(NULL);
-		struct tm* t = localtime(&result);
-		char buffer[64];
-		sprintf(buffer, "_%04d-%02d-%02d_%02d%02d%02d",
-				t->tm_year + 1900, t->tm_mday, t->tm_mon+1,
-				t->tm_hour, t->tm_min, t->tm_sec);
-
-		fullPath = kScreenCapturesPathBase + appName + std::string(buffer) + ".png";
-		if (!g_file_test(fullPath.c_str(), G_FILE_TEST_EXISTS)) {
-			break;
-		}
-	}
+	std::string appName = SystemUiController::instance()->activeApplicationName();
+	size_t i = appName.rfind('.');
+	if (i != std::string::npos)
+		appName = appName.substr(i+1);
+
+	time_t result = time(NULL);
+	struct tm* t = localtime(&result);
+	char buffer[64];
+	sprintf(buffer, "_%04d-%02d-%02d_%02d%02d%02d",
+			t->tm_year + 1900, t->tm_mday, t->tm_mon+1,
+			t->tm_hour, t->tm_min, t->tm_sec);
 
 	SoundPlayerPool::instance()->playFeedback(Settings::LunaSettings()->lunaSystemSoundScreenCapture);
-	QImage image(getScreenShotImageFromFb());
+
+	// copies the framebuffers and returns, the saver thread takes it from there
+	ScreenCapture::instance()->captureDisplay(kScreenCapturesPathBase + appName + buffer,
+											  ScreenCapture::FormatPng,
+											  PrvScreenShotAngle(getUiOrientation()),
+											  m_screenShotRequestedUs);
 
 	Q_EMIT signalTookScreenShot();
-	
-	ScreenShotParameter* param = new ScreenShotParameter;
-	param->image = image;
-	param->filePath = fullPath;
-	param->orientation = getUiOrientation();
-	
-	g_thread_create(PrvSaveScreenShot, param, FALSE, NULL);
 }
 
 QImage WindowServer::getScreenShotImage()
@@ -1671,22 +1606,6 @@ QImage WindowServer::getScreenShotImage()
 	return screenShot;
 }
 
-QImage WindowServer::getScreenShotImageFromFb()
-{
-	QImage screenShot = HostBase::instance()->takeScreenShot();
-	QImage appScreenShot = HostBase::instance()->takeAppDirectRenderingScreenShot();
-
-	if (!appScreenShot.isNull()) {
-
-		QPainter painter(&appScreenShot);
-		painter.drawImage(0, 0, screenShot);
-		painter.end();
-		screenShot = appScreenShot;
-	}
-
-	return screenShot;	
-}
-
 int WindowServer::angleForOrientation(OrientationEvent::Orientation orient)
 {
 	switch(orient) {
@@ -34,6 +34,8 @@
 #include "HostWindow.h"
 #include "ProgressAnimation.h"
 #include "TouchPlot.h"
+#include "TouchResampler.h"
+#include "ScreenCapture.h"
 
 #include <QGraphicsView>
 #include <QGraphicsObject>
@@ -43,10 +45,6 @@
 #include <QTime>
 #include <QTimer>
 #include <QPixmap>
-#ifdef DEBUG_RECORD_PAINT
-#include <QTextStream>
-#include <QFile>
-#endif
 
 #include <QMultiMap>
 #include <QPointer>
@@ -183,7 +181,8 @@ public:
 	MetaKeyManager* metaKeyManager() const { return m_metaKeyMgr; }
 	CoreNaviManager* coreNaviManager() const { return m_coreNaviMgr; }
 
-	bool takeScreenShot(const char* path);
+	// false if the screenshot couldn't be queued, otherwise callback is called from the main loop once it's written
+	bool takeScreenShot(const char* path, bool raw, ScreenCapture::SaveCallback callback, void* userData);
 	virtual QPixmap* takeScreenShot();
 
     OrientationEvent::Orientation getOrientation() const { return m_orientation; }
@@ -209,8 +208,12 @@ public:
 	virtual WindowManagerBase* windowManagerForWindow(Window* wm) const = 0;
 
 	static void enableFpsCounter(bool enable);
-	static void dumpFpsHistory();
-	static void resetFpsBuffer(int newBufSize);
+	static void dumpFrameTimings();
+	static void resetFrameTimings();
+
+	// replays a touch recording through the touchpanel driver, optionally forcing a resampling mode
+	// (off, interpolate or predict) for its duration; returns the scans replayed or -1
+	static int replayTouches(const char* path, int speedPercent, const char* resampleMode);
 
 	static void enableTouchPlotOption(TouchPlot::TouchPlotOption_t type, bool enable);
 
@@ -340,19 +343,24 @@ private Q_SLOTS:
 	void slotRotationAnimFinished();
 	void rotationValueChanged(const QVariant& value);
 	void slotDeferredNewOrientation();
+	void slotScreenShotFrameTimeout();
 
 private:
 
+	static TouchResampler::Mode touchResampleModeForGrabber();
+
 	void showReticle(const QPoint& pos);
 	void gestureEvent(QGestureEvent* event);
 	void paintBootupScreen();
 	void enableOverlay(const QString& str);
 	void disableOverlay();
 	void takeAndSaveScreenShot();
+	void grabScreenShot();
 	QImage getScreenShotImage();
-	QImage getScreenShotImageFromFb();
     OrientationEvent::Orientation getInitialDeviceOrientation();
 
+	bool m_screenShotPending;
+	uint64_t m_screenShotRequestedUs;
 	bool m_screenShotImagesValid;
 	QGraphicsPixmapObject *m_beforePixItem, *m_afterPixItem;
 	QPixmap *m_rotationImageBeforePtr, *m_rotationImageAfterPtr;
@@ -366,13 +374,7 @@ private:
 
     OrientationEvent::Orientation m_deferredNewOrientation;
 	QTimer m_deferredNewOrientationTimer;
-	
-#ifdef DEBUG_RECORD_PAINT
-	void tracePaint(qreal durationMs);
-
-	QTextStream *m_paintTrace;
-	QFile m_paintTraceFile;
-#endif
+	QTimer m_screenShotTimer;
 };
 
 
@@ -0,0 +1,402 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include "AppRegistrySnapshot.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <algorithm>
+
+#include <glib.h>
+
+// tmpfs, so a mapping of it is plain shared memory
+const char* const AppRegistrySnapshot::kDefaultPath = "/tmp/.app-registry";
+
+static const char kRegistryMagic[4] = { 'L', 'A', 'R', 'S' };
+
+// anyone can create files in /tmp: only a regular file that root or this process' user owns, and that
+// nobody else can write to, describes the apps that are actually installed
+static bool PrvIsTrusted(const struct stat& st)
+{
+	if (!S_ISREG(st.st_mode))
+		return false;
+	if (st.st_uid != 0 && st.st_uid != ::geteuid())
+		return false;
+	return (st.st_mode & (S_IWGRP | S_IWOTH)) == 0;
+}
+
+namespace {
+
+struct AppIdLess {
+	AppIdLess(const std::vector<std::string>& ids) : m_ids(ids) {}
+	bool operator()(uint32_t a, uint32_t b) const { return m_ids[a] < m_ids[b]; }
+	const std::vector<std::string>& m_ids;
+};
+
+struct LaunchPointIdLess {
+	LaunchPointIdLess(const std::vector<AppRegistryLaunchPoint>& lps, const std::string& strings)
+		: m_lps(lps), m_strings(strings.c_str()) {}
+	bool operator()(uint32_t a, uint32_t b) const {
+		return strcmp(m_strings + m_lps[a].launchPointId, m_strings + m_lps[b].launchPointId) < 0;
+	}
+	const std::vector<AppRegistryLaunchPoint>& m_lps;
+	const char* m_strings;
+};
+
+}
+
+AppRegistrySnapshotWriter::AppRegistrySnapshotWriter()
+{
+	// offset 0 is the empty string
+	m_strings.push_back('\0');
+	m_stringOffsets[std::string()] = 0;
+}
+
+uint32_t AppRegistrySnapshotWriter::addString(const std::string& str)
+{
+	// titles, icons, categories... repeat a lot across launch points, store each once
+	std::map<std::string, uint32_t>::const_iterator it = m_stringOffsets.find(str);
+	if (it != m_stringOffsets.end())
+		return it->second;
+
+	uint32_t offset = m_strings.size();
+	m_strings.append(str.c_str(), str.size() + 1);
+	m_stringOffsets[str] = offset;
+	return offset;
+}
+
+void AppRegistrySnapshotWriter::addApp(const std::string& id, const std::string& title, const std::string& version,
+									   const std::string& folderPath, const std::string& entryPoint,
+									   const std::string& category, const std::string& miniIcon,
+									   uint32_t type, uint32_t status, uint32_t flags)
+{
+	PendingApp app;
+	app.id = id;
+	memset(&app.record, 0, sizeof(app.record));
+	app.record.id = addString(id);
+	app.record.title = addString(title);
+	app.record.version = addString(version);
+	app.record.folderPath = addString(folderPath);
+	app.record.entryPoint = addString(entryPoint);
+	app.record.category = addString(category);
+	app.record.miniIcon = addString(miniIcon);
+	app.record.type = type;
+	app.record.status = status;
+	app.record.flags = flags;
+	m_apps.push_back(app);
+}
+
+void AppRegistrySnapshotWriter::addLaunchPoint(const std::string& launchPointId, const std::string& title,
+											   const std::string& menuName, const std::string& iconPath,
+											   const std::string& params, uint32_t flags)
+{
+	if (m_apps.empty()) {
+		g_warning("%s: launch point %s added before any app", __PRETTY_FUNCTION__, launchPointId.c_str());
+		return;
+	}
+
+	AppRegistryLaunchPoint lp;
+	memset(&lp, 0, sizeof(lp));
+	lp.launchPointId = addString(launchPointId);
+	lp.title = addString(title);
+	lp.menuName = addString(menuName);
+	lp.iconPath = addString(iconPath);
+	lp.params = addString(params);
+	lp.flags = flags;
+	m_apps.back().launchPoints.push_back(lp);
+}
+
+bool AppRegistrySnapshotWriter::write(const std::string& path, uint32_t generation)
+{
+	std::vector<std::string> ids;
+	std::vector<uint32_t> order;
+	for (uint32_t i = 0; i < m_apps.size(); i++) {
+		ids.push_back(m_apps[i].id);
+		order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), AppIdLess(ids));
+
+	std::vector<AppRegistryApp> apps;
+	std::vector<AppRegistryLaunchPoint> launchPoints;
+	for (uint32_t i = 0; i < order.size(); i++) {
+		const PendingApp& pending = m_apps[order[i]];
+		AppRegistryApp app = pending.record;
+		app.firstLaunchPoint = launchPoints.size();
+		app.launchPointCount = pending.launchPoints.size();
+		for (std::vector<AppRegistryLaunchPoint>::const_iterator it = pending.launchPoints.begin();
+			 it != pending.launchPoints.end(); ++it) {
+			launchPoints.push_back(*it);
+			launchPoints.back().app = i;
+		}
+		apps.push_back(app);
+	}
+
+	std::vector<uint32_t> launchPointIndex;
+	for (uint32_t i = 0; i < launchPoints.size(); i++)
+		launchPointIndex.push_back(i);
+	std::sort(launchPointIndex.begin(), launchPointIndex.end(), LaunchPointIdLess(launchPoints, m_strings));
+
+	// every section is a multiple of 4 bytes, except the strings which go last
+	AppRegistryHeader header;
+	memcpy(header.magic, kRegistryMagic, sizeof(header.magic));
+	header.version = AppRegistrySnapshot::kVersion;
+	header.generation = generation;
+	header.appCount = apps.size();
+	header.appsOffset = sizeof(header);
+	header.launchPointCount = launchPoints.size();
+	header.launchPointsOffset = header.appsOffset + apps.size() * sizeof(AppRegistryApp);
+	header.launchPointIndexOffset = header.launchPointsOffset + launchPoints.size() * sizeof(AppRegistryLaunchPoint);
+	header.stringsOffset = header.launchPointIndexOffset + launchPointIndex.size() * sizeof(uint32_t);
+	header.stringsSize = m_strings.size();
+	header.size = header.stringsOffset + header.stringsSize;
+
+	// to the side and renamed over the old one: readers keep their mapping of the old file intact. The
+	// directory can be world writable (/tmp), so the temporary file gets a fresh name that is created
+	// exclusively, never one somebody else could have put a symlink or their own file at
+	std::string tmpPath = path + ".XXXXXX";
+	int fd = ::mkstemp(&tmpPath[0]);
+	if (fd < 0) {
+		g_warning("%s: unable to write %s: %s", __PRETTY_FUNCTION__, path.c_str(), strerror(errno));
+		return false;
+	}
+
+	// mkstemp() creates it 0600, readers in other processes need to map it
+	FILE* f = 0;
+	if (::fchmod(fd, 0644) != 0 || !(f = ::fdopen(fd, "wb"))) {
+		g_warning("%s: unable to write %s: %s", __PRETTY_FUNCTION__, tmpPath.c_str(), strerror(errno));
+		::close(fd);
+		::unlink(tmpPath.c_str());
+		return false;
+	}
+
+	bool ok = fwrite(&header, sizeof(header), 1, f) == 1;
+	if (ok && !apps.empty())
+		ok = fwrite(&apps[0], sizeof(AppRegistryApp), apps.size(), f) == apps.size();
+	if (ok && !launchPoints.empty())
+		ok = fwrite(&launchPoints[0], sizeof(AppRegistryLaunchPoint), launchPoints.size(), f) == launchPoints.size();
+	if (ok && !launchPointIndex.empty())
+		ok = fwrite(&launchPointIndex[0], sizeof(uint32_t), launchPointIndex.size(), f) == launchPointIndex.size();
+	if (ok)
+		ok = fwrite(m_strings.data(), 1, m_strings.size(), f) == m_strings.size();
+
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (!ok || ::rename(tmpPath.c_str(), path.c_str()) != 0) {
+		g_warning("%s: failed to write %s", __PRETTY_FUNCTION__, path.c_str());
+		::unlink(tmpPath.c_str());
+		return false;
+	}
+
+	return true;
+}
+
+AppRegistrySnapshot::AppRegistrySnapshot()
+	: m_map(0)
+	, m_mapSize(0)
+	, m_ino(0)
+	, m_mtime(0)
+	, m_header(0)
+	, m_apps(0)
+	, m_launchPoints(0)
+	, m_launchPointIndex(0)
+	, m_strings(0)
+{
+}
+
+AppRegistrySnapshot::~AppRegistrySnapshot()
+{
+	close();
+}
+
+bool AppRegistrySnapshot::open(const std::string& path)
+{
+	close();
+	m_path = path;
+
+	int fd = ::open(path.c_str(), O_RDONLY | O_NOFOLLOW);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0 || st.st_size < (off_t) sizeof(AppRegistryHeader)) {
+		::close(fd);
+		return false;
+	}
+
+	if (!PrvIsTrusted(st)) {
+		g_warning("%s: ignoring %s, it isn't a file only sysmgr can have written", __PRETTY_FUNCTION__, path.c_str());
+		::close(fd);
+		return false;
+	}
+
+	void* map = ::mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	::close(fd);
+	if (map == MAP_FAILED)
+		return false;
+
+	m_map = map;
+	m_mapSize = st.st_size;
+	m_ino = st.st_ino;
+	m_mtime = st.st_mtime;
+
+	const char* base = (const char*) m_map;
+	m_header = (const AppRegistryHeader*) base;
+	if (!validate()) {
+		g_warning("%s: %s is not a valid app registry snapshot", __PRETTY_FUNCTION__, path.c_str());
+		close();
+		m_path = path;
+		return false;
+	}
+
+	m_apps = (const AppRegistryApp*) (base + m_header->appsOffset);
+	m_launchPoints = (const AppRegistryLaunchPoint*) (base + m_header->launchPointsOffset);
+	m_launchPointIndex = (const uint32_t*) (base + m_header->launchPointIndexOffset);
+	m_strings = base + m_header->stringsOffset;
+	return true;
+}
+
+void AppRegistrySnapshot::close()
+{
+	if (m_map)
+		::munmap(m_map, m_mapSize);
+
+	m_map = 0;
+	m_mapSize = 0;
+	m_ino = 0;
+	m_mtime = 0;
+	m_header = 0;
+	m_apps = 0;
+	m_launchPoints = 0;
+	m_launchPointIndex = 0;
+	m_strings = 0;
+}
+
+bool AppRegistrySnapshot::refresh()
+{
+	if (m_path.empty())
+		return false;
+
+	// the mapping keeps the old file alive, so a replaced file always has a different inode
+	struct stat st;
+	if (::lstat(m_path.c_str(), &st) != 0)
+		return false;
+	if (m_header && st.st_ino == m_ino && st.st_mtime == m_mtime)
+		return false;
+
+	uint32_t oldGeneration = generation();
+	bool wasOpen = isOpen();
+	std::string path = m_path;
+	if (!open(path))
+		return wasOpen;
+
+	return !wasOpen || generation() != oldGeneration;
+}
+
+int AppRegistrySnapshot::findApp(const char* id) const
+{
+	int lo = 0;
+	int hi = appCount() - 1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		int cmp = strcmp(string(m_apps[mid].id), id);
+		if (cmp == 0)
+			return mid;
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return -1;
+}
+
+int AppRegistrySnapshot::findLaunchPoint(const char* launchPointId) const
+{
+	int lo = 0;
+	int hi = launchPointCount() - 1;
+	while (lo <= hi) {
+		int mid = (lo + hi) / 2;
+		uint32_t index = m_launchPointIndex[mid];
+		int cmp = strcmp(string(m_launchPoints[index].launchPointId), launchPointId);
+		if (cmp == 0)
+			return index;
+		if (cmp < 0)
+			lo = mid + 1;
+		else
+			hi = mid - 1;
+	}
+	return -1;
+}
+
+// the file comes from another process, so nothing in it is trusted before it's been bounds checked once
+bool AppRegistrySnapshot::validate() const
+{
+	const AppRegistryHeader* h = m_header;
+	if (memcmp(h->magic, kRegistryMagic, sizeof(h->magic)) != 0 || h->version != kVersion || h->size != m_mapSize)
+		return false;
+
+	uint64_t appsEnd = (uint64_t) h->appsOffset + (uint64_t) h->appCount * sizeof(AppRegistryApp);
+	uint64_t launchPointsEnd = (uint64_t) h->launchPointsOffset + (uint64_t) h->launchPointCount * sizeof(AppRegistryLaunchPoint);
+	uint64_t indexEnd = (uint64_t) h->launchPointIndexOffset + (uint64_t) h->launchPointCount * sizeof(uint32_t);
+	uint64_t stringsEnd = (uint64_t) h->stringsOffset + h->stringsSize;
+
+	if ((h->appsOffset | h->launchPointsOffset | h->launchPointIndexOffset) & 3)
+		return false;
+	if (h->appsOffset < sizeof(AppRegistryHeader) || appsEnd > h->size || launchPointsEnd > h->size ||
+		indexEnd > h->size || stringsEnd > h->size || h->stringsSize == 0)
+		return false;
+
+	const char* base = (const char*) m_map;
+	const char* strings = base + h->stringsOffset;
+	if (strings[h->stringsSize - 1] != '\0')
+		return false;
+
+	const AppRegistryApp* apps = (const AppRegistryApp*) (base + h->appsOffset);
+	for (uint32_t i = 0; i < h->appCount; i++) {
+		const AppRegistryApp& a = apps[i];
+		if (a.id >= h->stringsSize || a.title >= h->stringsSize || a.version >= h->stringsSize ||
+			a.folderPath >= h->stringsSize || a.entryPoint >= h->stringsSize || a.category >= h->stringsSize ||
+			a.miniIcon >= h->stringsSize)
+			return false;
+		if ((uint64_t) a.firstLaunchPoint + a.launchPointCount > h->launchPointCount)
+			return false;
+	}
+
+	const AppRegistryLaunchPoint* lps = (const AppRegistryLaunchPoint*) (base + h->launchPointsOffset);
+	const uint32_t* index = (const uint32_t*) (base + h->launchPointIndexOffset);
+	for (uint32_t i = 0; i < h->launchPointCount; i++) {
+		const AppRegistryLaunchPoint& lp = lps[i];
+		if (lp.app >= h->appCount || lp.launchPointId >= h->stringsSize || lp.title >= h->stringsSize ||
+			lp.menuName >= h->stringsSize || lp.iconPath >= h->stringsSize || lp.params >= h->stringsSize)
+			return false;
+		if (index[i] >= h->launchPointCount)
+			return false;
+	}
+
+	return true;
+}
@@ -0,0 +1,186 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef APPREGISTRYSNAPSHOT_H_
+#define APPREGISTRYSNAPSHOT_H_
+
+#include "Common.h"
+
+/*
+ * A read-only binary copy of ApplicationManager's registered apps and their launch points, for other
+ * processes (WebAppMgr, local services) to mmap() and look things up in directly instead of asking
+ * com.palm.applicationManager for JSON.
+ *
+ * The file is an AppRegistryHeader, the AppRegistryApp records sorted by app id, the AppRegistryLaunchPoint
+ * records grouped by app in the same order, an index of the launch points sorted by launch point id, and a
+ * string table of NUL terminated UTF-8 that every string field is an offset into. ApplicationManager writes
+ * a new file to the side and renames it over the old one, so a mapping is never modified under a reader; a
+ * reader calls refresh() to pick up a newer file, which only costs a stat() when nothing was installed or
+ * removed. The header's generation goes up by one with every file written, across sysmgr restarts too.
+ * Since the file lives in /tmp, a reader only maps a regular file (not a symlink) owned by root or by its own
+ * user that nobody else can write to.
+ */
+
+#include <stdint.h>
+#include <sys/types.h>
+#include <map>
+#include <string>
+#include <vector>
+
+struct AppRegistryHeader
+{
+	char magic[4];					// "LARS"
+	uint32_t version;
+	uint32_t generation;
+	uint32_t size;					// of the whole file
+	uint32_t appCount;
+	uint32_t appsOffset;
+	uint32_t launchPointCount;
+	uint32_t launchPointsOffset;
+	uint32_t launchPointIndexOffset;	// launchPointCount uint32_t indices, sorted by launchPointId
+	uint32_t stringsOffset;
+	uint32_t stringsSize;
+};
+
+struct AppRegistryApp
+{
+	enum Flags {
+		Removable		= 1 << 0,
+		Visible			= 1 << 1,
+		HeadLess		= 1 << 2,
+		UserHideable	= 1 << 3
+	};
+
+	// string table offsets
+	uint32_t id;
+	uint32_t title;
+	uint32_t version;
+	uint32_t folderPath;
+	uint32_t entryPoint;
+	uint32_t category;
+	uint32_t miniIcon;
+
+	uint32_t type;					// ApplicationDescription::Type
+	uint32_t status;				// ApplicationDescription::Status
+	uint32_t flags;
+	uint32_t firstLaunchPoint;
+	uint32_t launchPointCount;
+};
+
+struct AppRegistryLaunchPoint
+{
+	enum Flags {
+		Default			= 1 << 0,
+		Removable		= 1 << 1
+	};
+
+	uint32_t app;					// index of the owning AppRegistryApp
+
+	// string table offsets
+	uint32_t launchPointId;
+	uint32_t title;
+	uint32_t menuName;
+	uint32_t iconPath;
+	uint32_t params;
+
+	uint32_t flags;
+};
+
+class AppRegistrySnapshotWriter
+{
+public:
+
+	AppRegistrySnapshotWriter();
+
+	// launch points belong to the app added last; apps can be added in any order
+	void addApp(const std::string& id, const std::string& title, const std::string& version,
+				const std::string& folderPath, const std::string& entryPoint, const std::string& category,
+				const std::string& miniIcon, uint32_t type, uint32_t status, uint32_t flags);
+	void addLaunchPoint(const std::string& launchPointId, const std::string& title, const std::string& menuName,
+						const std::string& iconPath, const std::string& params, uint32_t flags);
+
+	bool write(const std::string& path, uint32_t generation);
+
+private:
+
+	uint32_t addString(const std::string& str);
+
+	struct PendingApp {
+		std::string id;
+		AppRegistryApp record;
+		std::vector<AppRegistryLaunchPoint> launchPoints;
+	};
+
+	std::vector<PendingApp> m_apps;
+	std::string m_strings;
+	std::map<std::string, uint32_t> m_stringOffsets;
+};
+
+class AppRegistrySnapshot
+{
+public:
+
+	AppRegistrySnapshot();
+	~AppRegistrySnapshot();
+
+	bool open(const std::string& path);
+	void close();
+	bool isOpen() const { return m_header != 0; }
+
+	// maps the file again if it was replaced since it was opened; true if the generation changed
+	bool refresh();
+
+	uint32_t generation() const { return m_header ? m_header->generation : 0; }
+
+	int appCount() const { return m_header ? m_header->appCount : 0; }
+	const AppRegistryApp& app(int index) const { return m_apps[index]; }
+	int findApp(const char* id) const;
+
+	int launchPointCount() const { return m_header ? m_header->launchPointCount : 0; }
+	const AppRegistryLaunchPoint& launchPoint(int index) const { return m_launchPoints[index]; }
+	int findLaunchPoint(const char* launchPointId) const;
+
+	const char* string(uint32_t offset) const { return m_strings + offset; }
+
+	static const char* const kDefaultPath;
+	static const uint32_t kVersion = 1;
+
+private:
+
+	bool validate() const;
+
+	AppRegistrySnapshot(const AppRegistrySnapshot&);
+	AppRegistrySnapshot& operator=(const AppRegistrySnapshot&);
+
+	std::string m_path;
+	void* m_map;
+	size_t m_mapSize;
+	ino_t m_ino;
+	time_t m_mtime;
+
+	const AppRegistryHeader* m_header;
+	const AppRegistryApp* m_apps;
+	const AppRegistryLaunchPoint* m_launchPoints;
+	const uint32_t* m_launchPointIndex;
+	const char* m_strings;
+};
+
+#endif /*APPREGISTRYSNAPSHOT_H_*/
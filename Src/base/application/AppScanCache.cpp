@@ -0,0 +1,441 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <cjson/json.h>
+
+#include "AppScanCache.h"
+#include "Utils.h"
+
+static const uint32_t s_cacheMagic = 0x41534331;	// "ASC1"; bump when the layout below changes
+static const int s_maxPoolThreads = 4;
+
+/*
+ * On-disk layout (host byte order, it never leaves the device):
+ *
+ * 	uint32 magic, string locale, uint32 count, then count times:
+ * 		string folderPath, uint64 dirIno, int64 dirMtime, string appInfoPath,
+ * 		uint64 fileIno, int64 fileMtime, int64 fileSize, string text
+ *
+ * 	where a string is a uint32 length followed by that many bytes
+ */
+
+static void writeBytes(FILE* f, const void* data, size_t size, bool& ok)
+{
+	if (ok && size && fwrite(data, size, 1, f) != 1)
+		ok = false;
+}
+
+static void writeString(FILE* f, const std::string& s, bool& ok)
+{
+	uint32_t len = s.size();
+	writeBytes(f, &len, sizeof(len), ok);
+	writeBytes(f, s.data(), len, ok);
+}
+
+static bool readBytes(const gchar*& cur, const gchar* end, void* data, size_t size)
+{
+	if ((size_t)(end - cur) < size)
+		return false;
+	memcpy(data, cur, size);
+	cur += size;
+	return true;
+}
+
+static bool readString(const gchar*& cur, const gchar* end, std::string& s)
+{
+	uint32_t len;
+	if (!readBytes(cur, end, &len, sizeof(len)) || (size_t)(end - cur) < len)
+		return false;
+	s.assign(cur, len);
+	cur += len;
+	return true;
+}
+
+/// ------------------------------------ public: -----------------------------------------------------------------------
+
+AppScanCache::AppScanCache(const std::string& cacheFilePath, const std::string& locale)
+	: m_cacheFilePath(cacheFilePath)
+	, m_locale(locale)
+	, m_pool(0)
+	, m_hits(0)
+	, m_misses(0)
+{
+	m_jobMutex = g_mutex_new();
+
+	load();
+}
+
+AppScanCache::~AppScanCache()
+{
+	finish();
+
+	g_mutex_free(m_jobMutex);
+}
+
+void AppScanCache::prefetch(const std::vector<std::string>& appFolderPaths)
+{
+	if (!m_pool) {
+		// this is mostly waiting on flash, so use a couple of threads even on a single core
+		int threads = sysconf(_SC_NPROCESSORS_ONLN);
+		threads = CLAMP(threads, 2, s_maxPoolThreads);
+
+		GError* error = 0;
+		m_pool = g_thread_pool_new(AppScanCache::poolFunc, this, threads, FALSE, &error);
+		if (!m_pool) {
+			g_warning("%s: failed to create the scan pool: %s", __PRETTY_FUNCTION__, error ? error->message : "?");
+			if (error)
+				g_error_free(error);
+			return;
+		}
+	}
+
+	for (std::vector<std::string>::const_iterator it = appFolderPaths.begin(); it != appFolderPaths.end(); ++it) {
+
+		if (m_jobs.find(*it) != m_jobs.end())
+			continue;
+
+		Job* job = new Job;
+		job->folderPath = *it;
+		job->state = JobQueued;
+		job->cached = false;
+		job->found = false;
+		job->root = 0;
+
+		g_mutex_lock(m_jobMutex);
+		m_jobs[*it] = job;
+		g_mutex_unlock(m_jobMutex);
+
+		g_thread_pool_push(m_pool, job, NULL);
+	}
+}
+
+struct json_object* AppScanCache::take(const std::string& appFolderPath, std::string& r_appInfoPath)
+{
+	struct json_object* root = 0;
+
+	g_mutex_lock(m_jobMutex);
+
+	std::map<std::string, Job*>::iterator it = m_jobs.find(appFolderPath);
+	if (it == m_jobs.end()) {
+		g_mutex_unlock(m_jobMutex);
+		return 0;
+	}
+
+	Job* job = it->second;
+	JobState state = job->state;
+
+	// not started yet: do it here rather than wait for a thread to get to it
+	if (state == JobQueued)
+		job->state = JobRunning;
+
+	g_mutex_unlock(m_jobMutex);
+
+	if (state == JobQueued) {
+		parse(job);
+		complete(job);
+	}
+	else if (state == JobRunning) {
+		// the pool is reading it; the caller's own lookup is quicker than waiting, and the pool's result still
+		// goes into the cache
+		return 0;
+	}
+
+	// the job is done and nothing but take() touches its root from here on. Only handed out once; a second scan
+	// of the same folder goes to the disk like it always did
+	root = job->root;
+	job->root = 0;
+	if (root)
+		r_appInfoPath = job->entry.appInfoPath;
+
+	return root;
+}
+
+void AppScanCache::finish()
+{
+	if (m_pool) {
+		g_thread_pool_free(m_pool, FALSE, TRUE);
+		m_pool = 0;
+	}
+
+	if (m_jobs.empty())
+		return;
+
+	bool changed = false;
+	std::map<std::string, Entry> entries;
+
+	for (std::map<std::string, Job*>::iterator it = m_jobs.begin(); it != m_jobs.end(); ++it) {
+
+		Job* job = it->second;
+		if (job->root)
+			json_object_put(job->root);
+
+		if (job->found) {
+			entries[job->folderPath] = job->entry;
+			if (!job->cached)
+				changed = true;
+		}
+		delete job;
+	}
+	m_jobs.clear();
+
+	// apps that went away since the last boot are dropped as well
+	if (entries.size() != m_entries.size())
+		changed = true;
+
+	m_entries.swap(entries);
+
+	g_message("%s: %u cached, %u parsed", __PRETTY_FUNCTION__, m_hits, m_misses);
+
+	if (changed)
+		save();
+}
+
+//static
+void AppScanCache::appInfoPaths(const std::string& appFolderPath, const std::string& locale, std::vector<std::string>& r_paths)
+{
+	std::string language, region;
+	std::size_t underscorePos = locale.find("_");
+	if (underscorePos != std::string::npos) {
+		language = locale.substr(0, underscorePos);
+		region = locale.substr(underscorePos+1);
+	}
+
+	r_paths.clear();
+	if (!language.empty() && !region.empty())
+		r_paths.push_back(appFolderPath + "/resources/" + language + "/" + region + "/appinfo.json");
+	r_paths.push_back(appFolderPath + "/resources/" + language + "/appinfo.json");
+	r_paths.push_back(appFolderPath + "/resources/" + locale + "/appinfo.json");
+	r_paths.push_back(appFolderPath + "/appinfo.json");
+}
+
+/// ------------------------------------ private: ----------------------------------------------------------------------
+
+//static
+void AppScanCache::poolFunc(gpointer data, gpointer userData)
+{
+	static_cast<AppScanCache*>(userData)->process(static_cast<Job*>(data));
+}
+
+// runs on the pool, unless take() got to the job first
+void AppScanCache::process(Job* job)
+{
+	g_mutex_lock(m_jobMutex);
+	bool claimed = (job->state == JobQueued);
+	if (claimed)
+		job->state = JobRunning;
+	g_mutex_unlock(m_jobMutex);
+
+	if (!claimed)
+		return;
+
+	parse(job);
+	complete(job);
+}
+
+// must not touch anything but the job and the (read-only) loaded entries
+void AppScanCache::parse(Job* job)
+{
+	struct stat st;
+	if (::stat(job->folderPath.c_str(), &st) == 0) {
+
+		Entry probe;
+		probe.dirIno = st.st_ino;
+		probe.dirMtime = st.st_mtime;
+
+		if (lookup(job->folderPath, probe, job->entry)) {
+			job->cached = true;
+			job->found = true;
+		}
+		else {
+			std::vector<std::string> paths;
+			appInfoPaths(job->folderPath, m_locale, paths);
+
+			for (std::vector<std::string>::const_iterator it = paths.begin(); it != paths.end(); ++it) {
+
+				char* text = readFile(it->c_str());
+				if (!text)
+					continue;
+
+				struct json_object* root = 0;
+				if (g_utf8_validate(text, -1, NULL)) {
+					root = json_tokener_parse(text);
+					if (root && is_error(root))
+						root = 0;
+				}
+
+				if (root && ::stat(it->c_str(), &st) == 0) {
+					job->entry = probe;
+					job->entry.appInfoPath = *it;
+					job->entry.fileIno = st.st_ino;
+					job->entry.fileMtime = st.st_mtime;
+					job->entry.fileSize = st.st_size;
+					job->entry.text = text;
+					job->root = root;
+					job->found = true;
+				}
+				else if (root) {
+					json_object_put(root);
+				}
+
+				delete [] text;
+
+				if (job->found)
+					break;
+			}
+		}
+
+		// the cache saves finding and reading the file, not tokenizing it
+		if (job->cached) {
+			job->root = json_tokener_parse(job->entry.text.c_str());
+			if (!job->root || is_error(job->root)) {
+				job->root = 0;
+				job->found = false;
+			}
+		}
+	}
+}
+
+void AppScanCache::complete(Job* job)
+{
+	g_mutex_lock(m_jobMutex);
+	if (job->cached)
+		m_hits++;
+	else
+		m_misses++;
+	job->state = JobDone;
+	g_mutex_unlock(m_jobMutex);
+}
+
+bool AppScanCache::lookup(const std::string& folderPath, const Entry& probe, Entry& r_entry) const
+{
+	std::map<std::string, Entry>::const_iterator it = m_entries.find(folderPath);
+	if (it == m_entries.end())
+		return false;
+
+	const Entry& e = it->second;
+	if (e.dirIno != probe.dirIno || e.dirMtime != probe.dirMtime)
+		return false;
+
+	// an appinfo.json rewritten in place doesn't touch the folder's mtime
+	struct stat st;
+	if (::stat(e.appInfoPath.c_str(), &st) != 0)
+		return false;
+	if (e.fileIno != (uint64_t) st.st_ino || e.fileMtime != (int64_t) st.st_mtime || e.fileSize != (int64_t) st.st_size)
+		return false;
+
+	// nor does adding a more specific resources/<language>[/<region>]/appinfo.json, which would win the lookup
+	std::vector<std::string> paths;
+	appInfoPaths(folderPath, m_locale, paths);
+	for (std::vector<std::string>::const_iterator path = paths.begin(); path != paths.end() && *path != e.appInfoPath; ++path) {
+		if (::stat(path->c_str(), &st) == 0)
+			return false;
+	}
+
+	r_entry = e;
+	return true;
+}
+
+void AppScanCache::load()
+{
+	gchar* contents = 0;
+	gsize length = 0;
+	if (!g_file_get_contents(m_cacheFilePath.c_str(), &contents, &length, NULL))
+		return;
+
+	const gchar* cur = contents;
+	const gchar* end = contents + length;
+
+	uint32_t magic = 0, count = 0;
+	std::string locale;
+	if (!readBytes(cur, end, &magic, sizeof(magic)) || magic != s_cacheMagic ||
+		!readString(cur, end, locale) || locale != m_locale ||
+		!readBytes(cur, end, &count, sizeof(count))) {
+		g_message("%s: discarding %s", __PRETTY_FUNCTION__, m_cacheFilePath.c_str());
+		g_free(contents);
+		return;
+	}
+
+	for (uint32_t i = 0; i < count; i++) {
+
+		std::string folderPath;
+		Entry e;
+		if (!readString(cur, end, folderPath) ||
+			!readBytes(cur, end, &e.dirIno, sizeof(e.dirIno)) ||
+			!readBytes(cur, end, &e.dirMtime, sizeof(e.dirMtime)) ||
+			!readString(cur, end, e.appInfoPath) ||
+			!readBytes(cur, end, &e.fileIno, sizeof(e.fileIno)) ||
+			!readBytes(cur, end, &e.fileMtime, sizeof(e.fileMtime)) ||
+			!readBytes(cur, end, &e.fileSize, sizeof(e.fileSize)) ||
+			!readString(cur, end, e.text)) {
+			g_warning("%s: %s is truncated, ignoring it", __PRETTY_FUNCTION__, m_cacheFilePath.c_str());
+			m_entries.clear();
+			break;
+		}
+		m_entries[folderPath] = e;
+	}
+
+	g_free(contents);
+}
+
+void AppScanCache::save()
+{
+	// write to the side and rename, so a crash half way through never leaves a torn cache behind
+	std::string tmpPath = m_cacheFilePath + ".tmp";
+	FILE* f = fopen(tmpPath.c_str(), "wb");
+	if (!f) {
+		g_warning("%s: unable to write %s", __PRETTY_FUNCTION__, tmpPath.c_str());
+		return;
+	}
+
+	bool ok = true;
+	uint32_t count = m_entries.size();
+	writeBytes(f, &s_cacheMagic, sizeof(s_cacheMagic), ok);
+	writeString(f, m_locale, ok);
+	writeBytes(f, &count, sizeof(count), ok);
+
+	for (std::map<std::string, Entry>::const_iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+		const Entry& e = it->second;
+		writeString(f, it->first, ok);
+		writeBytes(f, &e.dirIno, sizeof(e.dirIno), ok);
+		writeBytes(f, &e.dirMtime, sizeof(e.dirMtime), ok);
+		writeString(f, e.appInfoPath, ok);
+		writeBytes(f, &e.fileIno, sizeof(e.fileIno), ok);
+		writeBytes(f, &e.fileMtime, sizeof(e.fileMtime), ok);
+		writeBytes(f, &e.fileSize, sizeof(e.fileSize), ok);
+		writeString(f, e.text, ok);
+	}
+
+	if (fclose(f) != 0)
+		ok = false;
+
+	if (!ok || ::rename(tmpPath.c_str(), m_cacheFilePath.c_str()) != 0) {
+		g_warning("%s: failed to save %s", __PRETTY_FUNCTION__, m_cacheFilePath.c_str());
+		::unlink(tmpPath.c_str());
+	}
+}
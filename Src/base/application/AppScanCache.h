@@ -0,0 +1,130 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef APPSCANCACHE_H_
+#define APPSCANCACHE_H_
+
+#include "Common.h"
+
+/*
+ * Used by ApplicationManager for the initial (boot) scan of the application folders.
+ *
+ * prefetch() is handed every app folder the boot scan is going to visit. A small thread pool then locates
+ * the appinfo.json of each folder (same locale lookup order as ApplicationManager::scanOneApplicationFolder),
+ * reads and parses it. The scan itself still runs on the main thread in its usual order; when it gets to a
+ * folder it take()s the parsed appinfo. The main thread never waits on the pool: a folder the pool hasn't
+ * started on is parsed right there, and one it is busy with is left to the scan's own synchronous lookup.
+ * Creating the ApplicationDescription (which registers mime/redirect handlers, sysmgr builtins...) stays on
+ * the main thread.
+ *
+ * The appinfo.json text is also persisted between boots, keyed on the inode and mtime of the app folder and
+ * of the appinfo.json itself. Installing a localized appinfo.json under resources/ doesn't touch the app
+ * folder's mtime, so the locations more specific than the cached one are checked to still be missing. An
+ * unchanged app costs a few stat()s instead of probing every location and reading the file; its cached text
+ * is still tokenized, on the pool like a miss (there is no serialized form of what fromAppInfo() builds). The
+ * whole cache is dropped when the locale changes.
+ */
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+#include <glib.h>
+
+struct json_object;
+
+class AppScanCache
+{
+public:
+
+	AppScanCache(const std::string& cacheFilePath, const std::string& locale);
+	~AppScanCache();
+
+	// queues appFolderPaths for the worker pool
+	void prefetch(const std::vector<std::string>& appFolderPaths);
+
+	// returns the parsed appinfo.json for appFolderPath (the caller owns it: json_object_put() it), or 0 if the folder wasn't
+	// prefetched, has no valid appinfo.json or is being parsed on the pool right now; the caller then looks it up itself
+	struct json_object* take(const std::string& appFolderPath, std::string& r_appInfoPath);
+
+	// waits for the pool, discards whatever wasn't taken and writes the cache back out if anything changed
+	void finish();
+
+	uint32_t hits() const { return m_hits; }
+	uint32_t misses() const { return m_misses; }
+
+	// the appinfo.json locations tried for an app folder, most specific first
+	static void appInfoPaths(const std::string& appFolderPath, const std::string& locale, std::vector<std::string>& r_paths);
+
+private:
+
+	struct Entry {
+		uint64_t dirIno;
+		int64_t dirMtime;
+		std::string appInfoPath;
+		uint64_t fileIno;
+		int64_t fileMtime;
+		int64_t fileSize;
+		std::string text;
+	};
+
+	enum JobState {
+		JobQueued,
+		JobRunning,
+		JobDone
+	};
+
+	struct Job {
+		std::string folderPath;
+		JobState state;
+		bool cached;
+		bool found;
+		Entry entry;
+		struct json_object* root;
+	};
+
+	static void poolFunc(gpointer data, gpointer userData);
+	void process(Job* job);
+	void parse(Job* job);
+	void complete(Job* job);
+
+	bool lookup(const std::string& folderPath, const Entry& probe, Entry& r_entry) const;
+	void load();
+	void save();
+
+	AppScanCache(const AppScanCache&);
+	AppScanCache& operator=(const AppScanCache&);
+
+	std::string m_cacheFilePath;
+	std::string m_locale;
+
+	std::map<std::string, Entry> m_entries;		// as loaded from disk; read-only while the pool runs
+	std::map<std::string, Job*> m_jobs;
+
+	GThreadPool* m_pool;
+	GMutex* m_jobMutex;
+
+	uint32_t m_hits;
+	uint32_t m_misses;
+};
+
+#endif /*APPSCANCACHE_H_*/
@@ -81,10 +81,33 @@ ApplicationDescription::~ApplicationDescription()
 }
 
 ApplicationDescription* ApplicationDescription::fromFile(const std::string& filePath, const std::string& folderPath)
+{
+	char* jsonStr = readFile(filePath.c_str());
+	if (!jsonStr || !g_utf8_validate(jsonStr, -1, NULL))
+	{
+		delete [] jsonStr;
+		return 0;
+	}
+
+	struct json_object* root = json_tokener_parse( jsonStr );
+	delete [] jsonStr;
+
+	if( !root || is_error( root ) )
+	{
+		g_warning("%s: Failed to parse '%s' into a JSON string", __FUNCTION__, filePath.c_str() );
+		return 0;
+	}
+
+	ApplicationDescription* appDesc = fromAppInfo(root, filePath, folderPath);
+	json_object_put(root);
+
+	return appDesc;
+}
+
+ApplicationDescription* ApplicationDescription::fromAppInfo(struct json_object* root, const std::string& filePath, const std::string& folderPath)
 {
 	bool success = false;
 	ApplicationDescription* appDesc = 0;
-	char* jsonStr = 0;
 	const gchar* palmAppDirPrefix = "/usr/palm/applications/";
 	std::vector<MimeRegInfo> extractedMimeTypes;
 	std::string launchParams;
@@ -92,13 +115,6 @@ ApplicationDescription* ApplicationDescription::fromFile(const std::string& file
 	std::string builtinEntrypt;
 	std::string builtinArgs;
 
-	jsonStr = readFile(filePath.c_str());
-	if (!jsonStr || !g_utf8_validate(jsonStr, -1, NULL))
-	{
-		return 0;
-	}
-
-	struct json_object* root=0;
 	struct json_object* label=0;
 	
 	std::string title, icon, dirPath;
@@ -109,13 +125,6 @@ ApplicationDescription* ApplicationDescription::fromFile(const std::string& file
 	dirPath += "/";
 	g_free(dirPathCStr);
 	
-	root = json_tokener_parse( jsonStr );
-	if( !root || is_error( root ) )
-	{
-		g_warning("%s: Failed to parse '%s' into a JSON string", __FUNCTION__, filePath.c_str() );
-		goto Done;
-	}
-	
 	appDesc = new ApplicationDescription();
 
 	appDesc->m_folderPath = folderPath;
@@ -512,10 +521,6 @@ ApplicationDescription* ApplicationDescription::fromFile(const std::string& file
 	}
 Done:
 
-	if( root && !is_error(root) )json_object_put(root);
-
-	delete [] jsonStr;
-
 	if (!success) {
 		delete appDesc;
 		return 0;
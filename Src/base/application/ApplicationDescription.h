@@ -97,6 +97,8 @@ public:
 	~ApplicationDescription();
 
 	static ApplicationDescription* fromFile(const std::string& filePath, const std::string& folderPath);
+	// same as fromFile, for an appinfo.json that has already been parsed (root is not consumed)
+	static ApplicationDescription* fromAppInfo(struct json_object* root, const std::string& filePath, const std::string& folderPath);
 	static ApplicationDescription* fromJsonString(const char* jsonStr);
 	static ApplicationDescription* fromApplicationStatus(const ApplicationStatus& appStatus, bool isUpdating);
 	static ApplicationDescription* fromNativeDockApp(const std::string& id, const std::string& title, 
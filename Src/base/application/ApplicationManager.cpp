@@ -27,6 +27,8 @@
 //MDK-LAUNCHER #include "DockPositionManager.h"
 #include "ApplicationDescription.h"
 #include "ApplicationStatus.h"
+#include "AppRegistrySnapshot.h"
+#include "AppScanCache.h"
 #include "PackageDescription.h"
 #include "ServiceDescription.h"
 #include "DeviceInfo.h"
@@ -60,6 +62,7 @@
 #include <string>
 
 #include <QUrl>
+#include <QTimer>
 #include <openssl/blowfish.h>
 
 #include <QBitArray>
@@ -129,6 +132,9 @@ ApplicationManager::ApplicationManager()
 	m_serviceHandlePublic = 0;
 	m_serviceHandlePrivate = 0;
 	m_initialScan = true;
+	m_bootScanCache = 0;
+	m_registryGeneration = 0;
+	m_registrySnapshotPending = false;
 
 	////hmmm, maybe better to load these in init()? need to consider race based on request-before-init...
 	if (doesExistOnFilesystem(Settings::LunaSettings()->lunaCmdHandlerSavedPath.c_str()))
@@ -156,6 +162,7 @@ void ApplicationManager::clear()
 	}
 
 	m_registeredApps.clear();
+	m_searchIndex.clear();
 	m_initialScan = true;
 
 	for (unsigned int i=0; i < m_systemApps.size(); ++i) {
@@ -166,6 +173,7 @@ void ApplicationManager::clear()
 }
 
 static const char* s_hiddenAppsPath = "/var/luna/data/.hidden-apps.json";
+static const char* s_appScanCachePath = "/var/luna/data/.app-scan-cache";
 
 bool ApplicationManager::init(  )
 {
@@ -193,6 +201,13 @@ bool ApplicationManager::init(  )
 	scan();
 	Q_EMIT signalInitialScanEnd();
 
+	// carry on from a previous run's generation, so clients that outlive sysmgr never see it go backwards
+	AppRegistrySnapshot previous;
+	if (previous.open(AppRegistrySnapshot::kDefaultPath))
+		m_registryGeneration = previous.generation();
+	previous.close();
+	registryChanged();
+
 	connect(Preferences::instance(),SIGNAL(signalVoiceDialSettingChanged(bool)),this,SLOT(slotVoiceDialAllowSettingChanged(bool)));
 	return true;
 }
@@ -340,6 +355,12 @@ void ApplicationManager::scan()
 
 	if (m_initialScan) {
 		m_initialScan=false;				//TODO: reset this if scans fail
+
+		// the appinfo.json files get read and parsed on a thread pool while the scans below
+		// run; scanOneApplicationFolder() picks them up from there
+		m_bootScanCache = new AppScanCache(s_appScanCachePath, Preferences::instance()->locale());
+		prefetchApplicationFolders();
+
 		scanForSystemApplications();
 		scanForApplications();
 		scanForPackages();
@@ -347,8 +368,15 @@ void ApplicationManager::scan()
 		scanForServices();
 		scanForPendingApplications();
 
+		m_bootScanCache->finish();
+		delete m_bootScanCache;
+		m_bootScanCache = 0;
+
 		scanForLaunchPoints(Settings::LunaSettings()->lunaPresetLaunchPointsPath);
 		scanForLaunchPoints(Settings::LunaSettings()->lunaLaunchPointsPath);
+
+		// from here on the index is kept up to date by postLaunchPointChange()
+		m_searchIndex.rebuild(m_registeredApps);
 		return;
 	}
 
@@ -853,6 +881,58 @@ std::vector<ApplicationDescription*> ApplicationManager::allApps()
 	return allApps;
 }
 
+void ApplicationManager::registryChanged()
+{
+	// an install or a rescan changes many launch points in one go, write the result once
+	if (m_registrySnapshotPending)
+		return;
+
+	m_registrySnapshotPending = true;
+	QTimer::singleShot(0, this, SLOT(slotWriteRegistrySnapshot()));
+}
+
+void ApplicationManager::slotWriteRegistrySnapshot()
+{
+	MutexLocker locker(&m_mutex);
+
+	m_registrySnapshotPending = false;
+
+	AppRegistrySnapshotWriter writer;
+	for (std::vector<ApplicationDescription*>::const_iterator it = m_registeredApps.begin();
+		 it != m_registeredApps.end(); ++it) {
+
+		const ApplicationDescription* appDesc = *it;
+		uint32_t appFlags = 0;
+		if (appDesc->isRemovable())
+			appFlags |= AppRegistryApp::Removable;
+		if (appDesc->isVisible())
+			appFlags |= AppRegistryApp::Visible;
+		if (appDesc->isHeadLess())
+			appFlags |= AppRegistryApp::HeadLess;
+		if (appDesc->isUserHideable())
+			appFlags |= AppRegistryApp::UserHideable;
+
+		writer.addApp(appDesc->id(), appDesc->title(), appDesc->version(), appDesc->folderPath(),
+					  appDesc->entryPoint(), appDesc->category(), appDesc->miniIconUrl(),
+					  appDesc->type(), appDesc->status(), appFlags);
+
+		const LaunchPointList& launchPoints = appDesc->launchPoints();
+		for (LaunchPointList::const_iterator lpIt = launchPoints.begin(); lpIt != launchPoints.end(); ++lpIt) {
+			const LaunchPoint* lp = *lpIt;
+			uint32_t lpFlags = 0;
+			if (lp->isDefault())
+				lpFlags |= AppRegistryLaunchPoint::Default;
+			if (lp->isRemovable())
+				lpFlags |= AppRegistryLaunchPoint::Removable;
+			writer.addLaunchPoint(lp->launchPointId(), lp->title(), lp->menuName(), lp->iconPath(),
+								  lp->params(), lpFlags);
+		}
+	}
+
+	if (writer.write(AppRegistrySnapshot::kDefaultPath, m_registryGeneration + 1))
+		m_registryGeneration++;
+}
+
 std::map<std::string, PackageDescription*> ApplicationManager::allPackages()
 {
 	return m_registeredPackages;
@@ -1293,11 +1373,8 @@ void ApplicationManager::scanForServices()
 		free(list);
 }
 
-void ApplicationManager::scanForSystemApplications()
+void ApplicationManager::systemApplicationFolders(std::vector<std::string>& systemPaths)
 {
-	MutexLocker locker(&m_mutex);
-
-	std::vector<std::string> systemPaths;
 	std::string folder = Settings::LunaSettings()->lunaAppLauncherPath;
 	if (folder[folder.size() - 1] != '/')
 		folder += '/';
@@ -1310,6 +1387,46 @@ void ApplicationManager::scanForSystemApplications()
 
 	const char* lowMemoryFolder = "/usr/palm/sysmgr/low-memory";
 	systemPaths.push_back(lowMemoryFolder);
+}
+
+// NOTE: the paths need to be spelled exactly the way the scanFor* functions will hand them to scanOneApplicationFolder()
+void ApplicationManager::prefetchApplicationFolders()
+{
+	std::vector<std::string> folders;
+	systemApplicationFolders(folders);
+
+	std::vector<std::string> parents(Settings::LunaSettings()->lunaAppsPaths);
+	parents.push_back(Settings::LunaSettings()->pendingAppsPath);
+
+	for (std::vector<std::string>::iterator it = parents.begin(); it != parents.end(); ++it) {
+
+		std::string parent = *it;
+		if (parent.empty())
+			continue;
+		if (parent[parent.size() - 1] != '/')
+			parent += '/';
+
+		GDir* dir = g_dir_open(parent.c_str(), 0, 0);
+		if (!dir)
+			continue;
+
+		const gchar* name = 0;
+		while ((name = g_dir_read_name(dir)) != NULL) {
+			if (name[0] != '.')
+				folders.push_back(parent + name);
+		}
+		g_dir_close(dir);
+	}
+
+	m_bootScanCache->prefetch(folders);
+}
+
+void ApplicationManager::scanForSystemApplications()
+{
+	MutexLocker locker(&m_mutex);
+
+	std::vector<std::string> systemPaths;
+	systemApplicationFolders(systemPaths);
 
 	std::string platformVersion = DeviceInfo::instance()->platformVersion();
 
@@ -1594,7 +1711,15 @@ ApplicationDescription* ApplicationManager::scanOneApplicationFolder(const std::
 	std::string appJsonPath;
 	ApplicationDescription* appDesc = 0;
 
-	if (!language.empty() && !region.empty()) {
+	if (m_bootScanCache) {
+		struct json_object* root = m_bootScanCache->take(appFolderPath, appJsonPath);
+		if (root) {
+			appDesc = ApplicationDescription::fromAppInfo(root, appJsonPath, appFolderPath);
+			json_object_put(root);
+		}
+	}
+
+	if (!appDesc && !language.empty() && !region.empty()) {
 		appJsonPath = appFolderPath + "/resources/" + language + "/" + region +"/appinfo.json";
 		appDesc = ApplicationDescription::fromFile(appJsonPath, appFolderPath);
 	}
@@ -2274,62 +2399,50 @@ void ApplicationManager::searchLaunchPoints(SearchSet& matchedByTitle, SearchSet
 	matchedByTitle.clear();
 	matchedByKeyword.clear();
 
-	std::vector<ApplicationDescription*>::const_iterator appDescIt = m_registeredApps.begin();
-	std::vector<ApplicationDescription*>::const_iterator appDescEndIt = m_registeredApps.end();
-
 	gchar* lcSearchTerm = g_utf8_strdown(searchTerm.c_str(), -1);
+	if (!lcSearchTerm)
+		return;
 
-	for (; appDescIt != appDescEndIt; ++appDescIt) {
+	// whole/partial keyword starts with search term?
+	bool partialKeywords = searchTerm.size() >= 3 && Settings::LunaSettings()->usePartialKeywordAppSearch;
 
-		ApplicationDescription* appDesc = *appDescIt;
-		if (!appDesc)
-			continue;
+	std::set<const LaunchPoint*> titleHits;
+	std::set<const LaunchPoint*> keywordHits;
+	m_searchIndex.search(lcSearchTerm, partialKeywords, titleHits, keywordHits);
 
-		if (!appDesc->isVisible() || appDesc->isRemoveFlagged())
-			continue;
+	std::set<const LaunchPoint*>::const_iterator it, itEnd;
+	for (it = titleHits.begin(), itEnd = titleHits.end(); it != itEnd; ++it) {
 
-		if (!hardwareFeaturesRequirementSatisfied(appDesc->hardwareFeaturesNeeded()))
+		const LaunchPoint* lp = *it;
+		if (!isSearchable(lp->appDesc()))
 			continue;
 
-		LaunchPointList::const_iterator lpIt = appDesc->launchPoints().begin();
-		LaunchPointList::const_iterator lpEndIt = appDesc->launchPoints().end();
-
-		for (; lpIt != lpEndIt; ++lpIt) {
+		g_message("found match by title: %s", lp->title().c_str());
+		matchedByTitle.insert(lp);
+	}
 
-			bool foundMatch = false;
-			const LaunchPoint* lp = *lpIt;
-			if (!lp)
-				continue;
+	for (it = keywordHits.begin(), itEnd = keywordHits.end(); it != itEnd; ++it) {
 
-			if (lp->matchesTitle(lcSearchTerm)) {
-				g_message("found match by title: %s", lp->title().c_str());
-				matchedByTitle.insert(lp);
-			}
-			else if (lp->isDefault() && !foundMatch) {
-				// whole/partial keyword starts with search term?
-				if (searchTerm.size() >= 3 && Settings::LunaSettings()->usePartialKeywordAppSearch) {
-					foundMatch = appDesc->doesMatchKeywordPartial(lcSearchTerm);
-				}
-				else {
-					foundMatch  = appDesc->doesMatchKeywordExact(lcSearchTerm);
-				}
-				// menu name starts with search term?
-				if (!foundMatch) {
-					gchar* lcMenuName = g_utf8_strdown(appDesc->menuName().c_str(), -1);
-					foundMatch = g_str_has_prefix(lcMenuName, lcSearchTerm);
-					g_free(lcMenuName);
-				}
+		const LaunchPoint* lp = *it;
+		if (!isSearchable(lp->appDesc()))
+			continue;
 
-				if (foundMatch) {
-					g_message("found match by keyword/appmenu: %s", lp->title().c_str());
-					matchedByKeyword.insert(lp);
-				}
-			}
-		}
+		g_message("found match by keyword/appmenu: %s", lp->title().c_str());
+		matchedByKeyword.insert(lp);
 	}
 
-	if (lcSearchTerm)
-		g_free(lcSearchTerm);
+	g_free(lcSearchTerm);
+}
+
+bool ApplicationManager::isSearchable(const ApplicationDescription* appDesc) const
+{
+	if (!appDesc)
+		return false;
+
+	if (!appDesc->isVisible() || appDesc->isRemoveFlagged())
+		return false;
+
+	return hardwareFeaturesRequirementSatisfied(appDesc->hardwareFeaturesNeeded());
 }
 
 std::string	ApplicationManager::mimeTableAsJsonString()
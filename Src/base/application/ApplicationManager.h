@@ -33,6 +33,7 @@
 #include "lunaservice.h"
 #include "Mutex.h"
 #include "MimeSystem.h"
+#include "LaunchPointSearchIndex.h"
 
 #include <QObject>
 #include <QBitArray>
@@ -44,6 +45,7 @@ class LaunchPoint;
 class CommandHandler;
 class ResourceHandler;
 class RedirectHandler;
+class AppScanCache;
 
 //LAUNCHER3-ADDED:
 namespace LaunchPointUpdatedReason
@@ -238,6 +240,10 @@ public Q_SLOTS:
 
 	void slotBuiltInAppEntryPoint_Launchermode0(const std::string& argsAsStringEncodedJson);
 
+private Q_SLOTS:
+
+	void slotWriteRegistrySnapshot();
+
 private:
 
 	void scanForApplications();
@@ -245,6 +251,8 @@ private:
 	void createPackageDescriptionForOldApps();
 	void scanForServices();
 	void scanForSystemApplications();
+	static void systemApplicationFolders(std::vector<std::string>& systemPaths);
+	void prefetchApplicationFolders();
 	void scanForPendingApplications();
 	void scanForLaunchPoints(std::string launchPointFolder);
 	void scanApplicationsFolders(const std::string& appFolders);
@@ -284,6 +292,7 @@ private:
 	void hideApp(const std::string& appId);
 	bool isAppHidden(const std::string& appId) const;
 	bool isSysappAllowed(const std::string& sysappId,const std::string& sourcePath);
+	bool isSearchable(const ApplicationDescription* appDesc) const;
 
 	void executeLockAppLoaded(const std::string& appId,ExecuteLockOperation op);
 	static std::set<std::string> s_appExeclockSet;
@@ -294,8 +303,20 @@ private:
 	std::vector<ApplicationDescription*> m_systemApps;
 	std::vector<ApplicationDescription*> m_pendingApps;
 
+	// only set for the duration of the initial scan
+	AppScanCache* m_bootScanCache;
+
 	std::set<const LaunchPoint*> m_dockModeLaunchPoints;
 
+	// the AppRegistrySnapshot other processes map; rewritten on the next main loop iteration after a
+	// launch point is added, updated or removed (which covers app installs and removals)
+	void registryChanged();
+	uint32_t m_registryGeneration;
+	bool m_registrySnapshotPending;
+
+	// searchLaunchPoints() remembers its previous results here, hence mutable
+	mutable LaunchPointSearchIndex m_searchIndex;
+
 	std::map<std::string, PackageDescription*> m_registeredPackages;
 	std::map<std::string, ServiceDescription*> m_registeredServices;
 
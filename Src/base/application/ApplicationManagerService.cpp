@@ -3838,6 +3838,13 @@ void ApplicationManager::postLaunchPointChange(const LaunchPoint* lp, const std:
 	LSErrorInit(&lsError);
 	json_object* json = 0;
 
+	// every add/update/remove of a launch point funnels through here, so this is where
+	// the search index is kept in step (NOTE: "removed" is posted before the launch point is deleted)
+	if (change == "removed")
+		m_searchIndex.removeLaunchPoint(lp);
+	else
+		m_searchIndex.updateApp(lp->appDesc());
+	registryChanged();
 
 	if (change == "removed") {
 		Q_EMIT signalLaunchPointRemoved(lp);
@@ -0,0 +1,289 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include <string.h>
+#include <algorithm>
+
+#include "LaunchPointSearchIndex.h"
+#include "ApplicationDescription.h"
+#include "LaunchPoint.h"
+
+// must match the delimiter set used by LaunchPoint::matchesTitle
+static const gchar* s_titleDelimiters = " ,._-:;()\\[]{}\"/";
+
+/// ------------------------------------ public: -----------------------------------------------------------------------
+
+LaunchPointSearchIndex::LaunchPointSearchIndex()
+{
+}
+
+LaunchPointSearchIndex::~LaunchPointSearchIndex()
+{
+	clear();
+}
+
+void LaunchPointSearchIndex::clear()
+{
+	m_entries.clear();
+	m_lcMenuNames.clear();
+	invalidateLastSearch();
+}
+
+void LaunchPointSearchIndex::rebuild(const std::vector<ApplicationDescription*>& apps)
+{
+	clear();
+
+	std::vector<ApplicationDescription*>::const_iterator appIt, appEndIt;
+	for (appIt = apps.begin(), appEndIt = apps.end(); appIt != appEndIt; ++appIt) {
+
+		const ApplicationDescription* appDesc = *appIt;
+		if (!appDesc)
+			continue;
+
+		LaunchPointList::const_iterator lpIt, lpEndIt;
+		for (lpIt = appDesc->launchPoints().begin(), lpEndIt = appDesc->launchPoints().end(); lpIt != lpEndIt; ++lpIt)
+			addLaunchPoint(appDesc, *lpIt, m_entries);
+	}
+
+	// entries were appended unsorted above; sort once rather than per insert
+	std::sort(m_entries.begin(), m_entries.end());
+
+	g_message("%s: %d entries for %d apps", __PRETTY_FUNCTION__, (int) m_entries.size(), (int) apps.size());
+}
+
+void LaunchPointSearchIndex::updateApp(const ApplicationDescription* appDesc)
+{
+	if (!appDesc)
+		return;
+
+	removeApp(appDesc);
+
+	LaunchPointList::const_iterator lpIt, lpEndIt;
+	for (lpIt = appDesc->launchPoints().begin(), lpEndIt = appDesc->launchPoints().end(); lpIt != lpEndIt; ++lpIt) {
+
+		const LaunchPoint* lp = *lpIt;
+		if (!lp)
+			continue;
+
+		std::vector<Entry> entries;
+		addLaunchPoint(appDesc, lp, entries);
+
+		for (std::vector<Entry>::const_iterator it = entries.begin(); it != entries.end(); ++it)
+			insertEntry(*it);
+	}
+}
+
+void LaunchPointSearchIndex::removeApp(const ApplicationDescription* appDesc)
+{
+	invalidateLastSearch();
+
+	std::vector<Entry>::iterator dst = m_entries.begin();
+	for (std::vector<Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+		if (it->appDesc == appDesc) {
+			m_lcMenuNames.erase(it->lp);
+			continue;
+		}
+		if (dst != it)
+			*dst = *it;
+		++dst;
+	}
+	m_entries.erase(dst, m_entries.end());
+}
+
+void LaunchPointSearchIndex::removeLaunchPoint(const LaunchPoint* lp)
+{
+	invalidateLastSearch();
+
+	m_lcMenuNames.erase(lp);
+
+	std::vector<Entry>::iterator dst = m_entries.begin();
+	for (std::vector<Entry>::iterator it = m_entries.begin(); it != m_entries.end(); ++it) {
+		if (it->lp == lp)
+			continue;
+		if (dst != it)
+			*dst = *it;
+		++dst;
+	}
+	m_entries.erase(dst, m_entries.end());
+}
+
+void LaunchPointSearchIndex::search(const gchar* lcSearchTerm, bool partialKeywords,
+									std::set<const LaunchPoint*>& matchedByTitle,
+									std::set<const LaunchPoint*>& matchedByKeyword)
+{
+	if (!lcSearchTerm || !lcSearchTerm[0])
+		return;
+
+	const std::string term(lcSearchTerm);
+	std::vector<Hit> hits;
+
+	Entry probe;
+	probe.key = term;
+	probe.lp = 0;
+	probe.appDesc = 0;
+	probe.field = Field_Title;
+
+	if (!m_lastSearchTerm.empty() && term.compare(0, m_lastSearchTerm.size(), m_lastSearchTerm) == 0) {
+
+		// the term only got longer: anything matching now by title or menu name must have
+		// matched the previous term as well, so just narrow the previous hits
+		for (std::vector<Hit>::const_iterator it = m_lastHits.begin(); it != m_lastHits.end(); ++it) {
+
+			Hit hit = *it;
+			hit.byTitle = hit.lp->matchesTitle(lcSearchTerm);
+			if (hit.byTitle || menuNameHasPrefix(hit.lp, lcSearchTerm))
+				hits.push_back(hit);
+		}
+	}
+	else {
+
+		std::set<const LaunchPoint*> titleHits;
+		std::set<const LaunchPoint*> menuNameHits;
+
+		std::vector<Entry>::const_iterator it = std::lower_bound(m_entries.begin(), m_entries.end(), probe);
+		for (; it != m_entries.end() && it->key.compare(0, term.size(), term) == 0; ++it) {
+			if (it->field == Field_Title)
+				titleHits.insert(it->lp);
+			else if (it->field == Field_MenuName)
+				menuNameHits.insert(it->lp);
+		}
+
+		Hit hit;
+		hit.byTitle = true;
+		for (std::set<const LaunchPoint*>::const_iterator lpIt = titleHits.begin(); lpIt != titleHits.end(); ++lpIt) {
+			hit.lp = *lpIt;
+			hits.push_back(hit);
+		}
+
+		hit.byTitle = false;
+		for (std::set<const LaunchPoint*>::const_iterator lpIt = menuNameHits.begin(); lpIt != menuNameHits.end(); ++lpIt) {
+			if (titleHits.find(*lpIt) != titleHits.end())
+				continue;
+			hit.lp = *lpIt;
+			hits.push_back(hit);
+		}
+	}
+
+	for (std::vector<Hit>::const_iterator it = hits.begin(); it != hits.end(); ++it) {
+		if (it->byTitle)
+			matchedByTitle.insert(it->lp);
+		else
+			matchedByKeyword.insert(it->lp);
+	}
+
+	m_lastSearchTerm = term;
+	m_lastHits.swap(hits);
+
+	// keywords aren't narrowed: exact keyword matches aren't monotonic as the term grows, and the
+	// lookup is a single binary search anyway
+	std::vector<Entry>::const_iterator it = std::lower_bound(m_entries.begin(), m_entries.end(), probe);
+	for (; it != m_entries.end() && it->key.compare(0, term.size(), term) == 0; ++it) {
+
+		if (it->field != Field_Keyword)
+			continue;
+		if (!partialKeywords && it->key.size() != term.size())
+			continue;
+		if (matchedByTitle.find(it->lp) != matchedByTitle.end())
+			continue;
+
+		matchedByKeyword.insert(it->lp);
+	}
+}
+
+/// ------------------------------------ private: ----------------------------------------------------------------------
+
+void LaunchPointSearchIndex::addLaunchPoint(const ApplicationDescription* appDesc, const LaunchPoint* lp,
+											std::vector<Entry>& entries)
+{
+	if (!lp)
+		return;
+
+	// title: one key per word, so that a prefix search over the keys is equivalent
+	// to LaunchPoint::matchesTitle
+	gchar* lcTitle = g_utf8_strdown(lp->title().c_str(), -1);
+	if (lcTitle) {
+		size_t len = strlen(lcTitle);
+		for (size_t i = 0; i < len; i++) {
+			if (i > 0 && !strchr(s_titleDelimiters, lcTitle[i-1]))
+				continue;
+
+			Entry e;
+			e.key = lcTitle + i;
+			e.lp = lp;
+			e.appDesc = appDesc;
+			e.field = Field_Title;
+			entries.push_back(e);
+		}
+		g_free(lcTitle);
+	}
+
+	// keywords and the app menu name only ever match the default launch point of an app
+	if (!appDesc || !lp->isDefault())
+		return;
+
+	gchar* lcMenuName = g_utf8_strdown(appDesc->menuName().c_str(), -1);
+	if (lcMenuName) {
+		m_lcMenuNames[lp] = lcMenuName;
+
+		Entry e;
+		e.key = lcMenuName;
+		e.lp = lp;
+		e.appDesc = appDesc;
+		e.field = Field_MenuName;
+		entries.push_back(e);
+
+		g_free(lcMenuName);
+	}
+
+	// KeywordMap already stores its keywords lowercased
+	std::list<std::string> keywords = appDesc->keywords();
+	for (std::list<std::string>::const_iterator it = keywords.begin(); it != keywords.end(); ++it) {
+
+		Entry e;
+		e.key = *it;
+		e.lp = lp;
+		e.appDesc = appDesc;
+		e.field = Field_Keyword;
+		entries.push_back(e);
+	}
+}
+
+void LaunchPointSearchIndex::insertEntry(const Entry& e)
+{
+	m_entries.insert(std::upper_bound(m_entries.begin(), m_entries.end(), e), e);
+}
+
+void LaunchPointSearchIndex::invalidateLastSearch()
+{
+	m_lastSearchTerm.clear();
+	m_lastHits.clear();
+}
+
+bool LaunchPointSearchIndex::menuNameHasPrefix(const LaunchPoint* lp, const gchar* lcSearchTerm) const
+{
+	std::map<const LaunchPoint*, std::string>::const_iterator it = m_lcMenuNames.find(lp);
+	if (it == m_lcMenuNames.end())
+		return false;
+
+	return g_str_has_prefix(it->second.c_str(), lcSearchTerm);
+}
@@ -0,0 +1,116 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef LAUNCHPOINTSEARCHINDEX_H
+#define LAUNCHPOINTSEARCHINDEX_H
+
+#include "Common.h"
+
+/*
+ * Prefix index over the searchable strings of the registered launch points. Used by
+ * ApplicationManager::searchLaunchPoints so that a keystroke in universal search doesn't have to
+ * walk (and lowercase) every application description.
+ *
+ * All strings are lowercased once, when the launch point is indexed, and kept in a single table
+ * sorted by key; a search is a binary search for the first key starting with the term followed by a
+ * walk over the matching range. Titles are indexed once per word (mirroring LaunchPoint::matchesTitle),
+ * keywords and the app menu name only for the default launch point of an app.
+ *
+ * The index also remembers the title/menu name hits of the previous search; when the new term
+ * extends the previous one (the common case of typing another character) those are narrowed
+ * instead of searching the table again.
+ *
+ * NOTE: visibility, removal and hardware-feature filtering is left to the caller, since those can
+ * change without the launch point itself changing
+ */
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+
+#include <glib.h>
+
+class ApplicationDescription;
+class LaunchPoint;
+
+class LaunchPointSearchIndex
+{
+public:
+
+	LaunchPointSearchIndex();
+	~LaunchPointSearchIndex();
+
+	void clear();
+	void rebuild(const std::vector<ApplicationDescription*>& apps);
+
+	// (re)index all the launch points currently owned by appDesc
+	void updateApp(const ApplicationDescription* appDesc);
+	void removeApp(const ApplicationDescription* appDesc);
+	void removeLaunchPoint(const LaunchPoint* lp);
+
+	// NOTE: assumes lcSearchTerm has already been lowercase'd via g_utf8_strdown
+	void search(const gchar* lcSearchTerm, bool partialKeywords,
+				std::set<const LaunchPoint*>& matchedByTitle,
+				std::set<const LaunchPoint*>& matchedByKeyword);
+
+	unsigned int size() const { return m_entries.size(); }
+
+private:
+
+	enum Field {
+		Field_Title = 0,
+		Field_MenuName,
+		Field_Keyword
+	};
+
+	struct Entry {
+		std::string key;
+		const LaunchPoint* lp;
+		const ApplicationDescription* appDesc;
+		Field field;
+
+		bool operator<(const Entry& e) const { return key < e.key; }
+	};
+
+	struct Hit {
+		const LaunchPoint* lp;
+		bool byTitle;
+	};
+
+	void addLaunchPoint(const ApplicationDescription* appDesc, const LaunchPoint* lp,
+						std::vector<Entry>& entries);
+	void insertEntry(const Entry& e);
+	void invalidateLastSearch();
+
+	bool menuNameHasPrefix(const LaunchPoint* lp, const gchar* lcSearchTerm) const;
+
+	LaunchPointSearchIndex(const LaunchPointSearchIndex&);
+	LaunchPointSearchIndex& operator=(const LaunchPointSearchIndex&);
+
+	std::vector<Entry> m_entries;						// sorted by key
+	std::map<const LaunchPoint*, std::string> m_lcMenuNames;	// default launch points only
+
+	std::string m_lastSearchTerm;
+	std::vector<Hit> m_lastHits;						// title/menu name hits for m_lastSearchTerm
+};
+
+#endif /* LAUNCHPOINTSEARCHINDEX_H */
@@ -999,12 +999,14 @@ std::string	MimeSystem::getActiveAppIdForRedirect(const std::string& url,bool do
 		}
 	}
 	else {
-		for (it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
-			if ((disallowSchemeForms) && (it->second->m_redirectHandler.isSchemeForm()))
+		std::vector<RedirectHandlerNode *> candidates;
+		getRedirectCandidates(url,candidates);
+		for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
+			if ((disallowSchemeForms) && ((*cand_it)->m_redirectHandler.isSchemeForm()))
 				continue;
 			//try and match against it
-			if (it->second->m_redirectHandler.matches(url))
-				return it->second->m_redirectHandler.appId();
+			if ((*cand_it)->m_redirectHandler.matches(url))
+				return (*cand_it)->m_redirectHandler.appId();
 		}
 	}
 	return "";
@@ -1037,13 +1039,15 @@ int	MimeSystem::getAllAppIdForRedirect(const std::string& url,bool doNotUseRegex
 	}
 	
 	//else, do a regexp match
-	for (it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
+	std::vector<RedirectHandlerNode *> candidates;
+	getRedirectCandidates(url,candidates);
+	for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
 		//try and match against it
-		if (it->second->m_redirectHandler.matches(url) == false)
+		if ((*cand_it)->m_redirectHandler.matches(url) == false)
 			continue;
 		
 		//found a node that matches the url
-		RedirectHandlerNode * p_rhn = it->second;
+		RedirectHandlerNode * p_rhn = *cand_it;
 		//Active is a litte bit ambiguous here since there may be multiple nodes that match the url (regexps can overlap, and also scheme and "redirect" forms can refer to the same url patterns)
 		//But we want an "active" to keep the API somewhat consistent...so just set the "active" as the primary handler of the first node that's found
 		if (rc == 0) {
@@ -1080,12 +1084,14 @@ RedirectHandler	MimeSystem::getActiveHandlerForRedirect(const std::string& url,b
 		}
 	}
 	else {
-		for (it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
-			if ((disallowSchemeForms) && (it->second->m_redirectHandler.isSchemeForm()))
+		std::vector<RedirectHandlerNode *> candidates;
+		getRedirectCandidates(url,candidates);
+		for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
+			if ((disallowSchemeForms) && ((*cand_it)->m_redirectHandler.isSchemeForm()))
 				continue;
 			//try and match against it
-			if (it->second->m_redirectHandler.matches(url))
-				return it->second->m_redirectHandler;
+			if ((*cand_it)->m_redirectHandler.matches(url))
+				return (*cand_it)->m_redirectHandler;
 		}
 	}
 	return RedirectHandler();
@@ -1121,13 +1127,15 @@ int	MimeSystem::getAllHandlersForRedirect(const std::string& url,bool doNotUseRe
 
 	//else, do a regexp match
 
-	for (RedirectMapIterType it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
+	std::vector<RedirectHandlerNode *> candidates;
+	getRedirectCandidates(url,candidates);
+	for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
 		//try and match against it
-		if (it->second->m_redirectHandler.matches(url) == false)
+		if ((*cand_it)->m_redirectHandler.matches(url) == false)
 			continue;
 
 		//found a node that matches the url
-		RedirectHandlerNode * p_rhn = it->second;
+		RedirectHandlerNode * p_rhn = *cand_it;
 		//Active is a litte bit ambiguous here since there may be multiple nodes that match the url (regexps can overlap, and also scheme and "redirect" forms can refer to the same url patterns)
 		//But we want an "active" to keep the API somewhat consistent...so just set the "active" as the primary handler of the first node that's found
 		
@@ -1297,12 +1305,14 @@ std::string	MimeSystem::getAppIdByVerbForRedirect(const std::string& url,bool di
 {
 	MutexLocker lock(&m_mutex);
 	RedirectHandlerNode * p_rhn = NULL;
-	for (RedirectMapIterType it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
-		if ((disallowSchemeForms) && (it->second->m_redirectHandler.isSchemeForm()))
+	std::vector<RedirectHandlerNode *> candidates;
+	getRedirectCandidates(url,candidates);
+	for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
+		if ((disallowSchemeForms) && ((*cand_it)->m_redirectHandler.isSchemeForm()))
 			continue;
 		//try and match against it
-		if (it->second->m_redirectHandler.matches(url)) {
-			p_rhn = it->second;
+		if ((*cand_it)->m_redirectHandler.matches(url)) {
+			p_rhn = *cand_it;
 			break;
 		}
 	}
@@ -1336,12 +1346,14 @@ RedirectHandler	MimeSystem::getHandlerByVerbForRedirect(const std::string& url,b
 {
 	MutexLocker lock(&m_mutex);
 	RedirectHandlerNode * p_rhn = NULL;
-	for (RedirectMapIterType it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
-		if ((disallowSchemeForms) && (it->second->m_redirectHandler.isSchemeForm()))
+	std::vector<RedirectHandlerNode *> candidates;
+	getRedirectCandidates(url,candidates);
+	for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
+		if ((disallowSchemeForms) && ((*cand_it)->m_redirectHandler.isSchemeForm()))
 			continue;
 		//try and match against it
-		if (it->second->m_redirectHandler.matches(url)) {
-			p_rhn = it->second;
+		if ((*cand_it)->m_redirectHandler.matches(url)) {
+			p_rhn = *cand_it;
 			break;
 		}
 	}
@@ -1370,11 +1382,13 @@ int MimeSystem::getAllHandlersByVerbForRedirect(const std::string& url,const std
 	MutexLocker lock(&m_mutex);
 	RedirectHandlerNode * p_rhn = NULL;
 	int rc = 0;
-	for (RedirectMapIterType it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
-		if (it->second->m_redirectHandler.matches(url) == false)
+	std::vector<RedirectHandlerNode *> candidates;
+	getRedirectCandidates(url,candidates);
+	for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
+		if ((*cand_it)->m_redirectHandler.matches(url) == false)
 			continue;
 
-		p_rhn = it->second;
+		p_rhn = *cand_it;
 
 		//found...
 
@@ -1412,11 +1426,13 @@ int MimeSystem::getAllAppIdByVerbForRedirect(const std::string& url,const std::s
 	MutexLocker lock(&m_mutex);
 	RedirectHandlerNode * p_rhn = NULL;
 	int rc = 0;
-	for (RedirectMapIterType it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
-		if (it->second->m_redirectHandler.matches(url) == false)
+	std::vector<RedirectHandlerNode *> candidates;
+	getRedirectCandidates(url,candidates);
+	for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
+		if ((*cand_it)->m_redirectHandler.matches(url) == false)
 			continue;
 
-		p_rhn = it->second;
+		p_rhn = *cand_it;
 
 		//found...
 
@@ -1493,6 +1509,7 @@ int MimeSystem::removeAllForAppId(const std::string& appId)
 		MimeSystem::reclaimIndex(found_it->second->m_redirectHandler.index());
 		delete (found_it->second);
 		m_redirectHandlerMap.erase(*it);
+		m_redirectMatcherDirty = true;
 	}
 	keys.clear();
 	// and do the same for the Resources...
@@ -1541,6 +1558,7 @@ int	MimeSystem::removeAllForUrl(const std::string& url)
 		return 0;
 	delete (it->second);
 	m_redirectHandlerMap.erase(it);
+	m_redirectMatcherDirty = true;
 	return 1;
 }
 
@@ -1652,6 +1670,7 @@ int	MimeSystem::addRedirectHandler(const std::string& url,const std::string appI
 		if (sysDefault)
 			p_rhn->m_redirectHandler.setTag("system-default");	//also tag as a system default
 		m_redirectHandlerMap[url] = p_rhn;
+		m_redirectMatcherDirty = true;
 		return 1;
 	}
 
@@ -2099,6 +2118,7 @@ bool MimeSystem::restoreMimeTable(json_object * root,std::string& r_err)
 				if (p_rhn != NULL) {
 					//add...
 					m_redirectHandlerMap[p_rhn->m_redirectHandler.urlRe()] = p_rhn;
+					m_redirectMatcherDirty = true;
 				}
 			}
 		}
@@ -2283,7 +2303,7 @@ void MimeSystem::dbg_printRedirectHandlerNode(const RedirectHandlerNode * p_redi
 // --------------------------------------------------- private ---------------------------------------------------------
 // ---------------------------------------------------------------------------------------------------------------------
 
-MimeSystem::MimeSystem() 
+MimeSystem::MimeSystem() : m_redirectMatcherDirty(true)
 {
 	
 }
@@ -2302,6 +2322,9 @@ void MimeSystem::destroy()
 		it != m_redirectHandlerMap.end();++it) 
 		delete it->second;
 	m_redirectHandlerMap.clear();
+	m_redirectMatcher.clear();
+	m_redirectMatcherNodes.clear();
+	m_redirectMatcherDirty = true;
 	
 	for (ResourceMapIterType it = m_resourceHandlerMap.begin();
 		it != m_resourceHandlerMap.end();++it) 
@@ -2470,12 +2493,14 @@ MimeSystem::ResourceHandlerNode * MimeSystem::getResourceHandlerNode(const std::
 MimeSystem::RedirectHandlerNode * MimeSystem::getRedirectHandlerNode(const std::string& url)
 {
 	MutexLocker lock(&m_mutex);
-	for (RedirectMapIterType it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
-		if (it->second->m_redirectHandler.isSchemeForm())
+	std::vector<RedirectHandlerNode *> candidates;
+	getRedirectCandidates(url,candidates);
+	for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
+		if ((*cand_it)->m_redirectHandler.isSchemeForm())
 			continue;
 		//try and match against it
-		if (it->second->m_redirectHandler.matches(url))
-			return it->second;
+		if ((*cand_it)->m_redirectHandler.matches(url))
+			return *cand_it;
 	}
 	return NULL;
 		
@@ -2484,13 +2509,47 @@ MimeSystem::RedirectHandlerNode * MimeSystem::getRedirectHandlerNode(const std::
 MimeSystem::RedirectHandlerNode * MimeSystem::getSchemeHandlerNode(const std::string& url)
 {
 	MutexLocker lock(&m_mutex);
-	for (RedirectMapIterType it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
-		if (it->second->m_redirectHandler.isSchemeForm() == false)
+	std::vector<RedirectHandlerNode *> candidates;
+	getRedirectCandidates(url,candidates);
+	for (std::vector<RedirectHandlerNode *>::iterator cand_it = candidates.begin();cand_it != candidates.end();++cand_it) {
+		if ((*cand_it)->m_redirectHandler.isSchemeForm() == false)
 			continue;
 		//try and match against it
-		if (it->second->m_redirectHandler.matches(url))
-			return it->second;
+		if ((*cand_it)->m_redirectHandler.matches(url))
+			return *cand_it;
 	}
 	return NULL;
 }
 
+/*
+ * Fills r_nodes with the nodes of m_redirectHandlerMap that could match url, in map order. Only these need
+ * to be tried with RedirectHandler::matches(). The prefix trie is rebuilt here on first use after the table
+ * changed, not on every add/remove, since the table gets populated a handler at a time at boot and on app install.
+ *
+ * Caller must hold m_mutex
+ */
+void MimeSystem::getRedirectCandidates(const std::string& url,std::vector<RedirectHandlerNode *>& r_nodes)
+{
+	r_nodes.clear();
+	if (url.empty())
+		return;
+
+	if (m_redirectMatcherDirty) {
+		std::vector<std::string> urlRes;
+		m_redirectMatcherNodes.clear();
+		for (RedirectMapIterType it = m_redirectHandlerMap.begin();it != m_redirectHandlerMap.end();++it) {
+			urlRes.push_back(it->first);
+			m_redirectMatcherNodes.push_back(it->second);
+		}
+		m_redirectMatcher.build(urlRes);
+		m_redirectMatcherDirty = false;
+		g_debug("%s: rebuilt for %u redirect handlers (%u unprunable)",__FUNCTION__,
+				m_redirectMatcher.patternCount(),m_redirectMatcher.unprunableCount());
+	}
+
+	std::vector<uint32_t> indices;
+	m_redirectMatcher.candidates(url,indices);
+	for (std::vector<uint32_t>::const_iterator it = indices.begin();it != indices.end();++it)
+		r_nodes.push_back(m_redirectMatcherNodes[*it]);
+}
+
@@ -32,6 +32,7 @@
 
 #include "Mutex.h"
 #include "CmdResourceHandlers.h"
+#include "RedirectMatcher.h"
 
 class MimeSystem
 {
@@ -300,6 +301,7 @@ private:
 	ResourceHandlerNode *	getResourceHandlerNode(const std::string& mimeType);
 	RedirectHandlerNode *	getRedirectHandlerNode(const std::string& url);
 	RedirectHandlerNode *	getSchemeHandlerNode(const std::string& url);
+	void					getRedirectCandidates(const std::string& url,std::vector<RedirectHandlerNode *>& r_nodes);
 	
 /// ------------------------------------------- vars -------------------------------------------------------------------
 	
@@ -310,6 +312,10 @@ private:
 	
 	std::map<std::string,MimeSystem::ResourceHandlerNode *> m_resourceHandlerMap;
 	std::map<std::string,MimeSystem::RedirectHandlerNode *> m_redirectHandlerMap;
+
+	RedirectMatcher			m_redirectMatcher;
+	std::vector<MimeSystem::RedirectHandlerNode *> m_redirectMatcherNodes;		//m_redirectHandlerMap, in order, as of the last build of m_redirectMatcher
+	bool					m_redirectMatcherDirty;
 	
 	std::map<std::string,std::string>						m_extensionToMimeMap;
 	static uint32_t 	s_genIndex;
@@ -0,0 +1,158 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include <ctype.h>
+#include <string.h>
+#include <algorithm>
+
+#include "RedirectMatcher.h"
+
+RedirectMatcher::RedirectMatcher() : m_patternCount(0)
+{
+}
+
+RedirectMatcher::~RedirectMatcher()
+{
+}
+
+void RedirectMatcher::clear()
+{
+	m_nodes.clear();
+	m_patternCount = 0;
+}
+
+void RedirectMatcher::build(const std::vector<std::string>& urlRes)
+{
+	clear();
+	m_nodes.push_back(TrieNode());
+
+	for (uint32_t i=0;i<urlRes.size();++i) {
+
+		std::string prefix = literalPrefix(urlRes[i]);
+
+		uint32_t node = 0;
+		for (std::string::const_iterator c = prefix.begin();c != prefix.end();++c) {
+			std::map<char,uint32_t>::const_iterator child = m_nodes[node].children.find(*c);
+			if (child != m_nodes[node].children.end()) {
+				node = child->second;
+				continue;
+			}
+			m_nodes.push_back(TrieNode());
+			uint32_t newNode = m_nodes.size()-1;
+			m_nodes[node].children[*c] = newNode;
+			node = newNode;
+		}
+		m_nodes[node].patterns.push_back(i);
+	}
+	m_patternCount = urlRes.size();
+}
+
+void RedirectMatcher::candidates(const std::string& url,std::vector<uint32_t>& r_indices) const
+{
+	r_indices.clear();
+	if (m_nodes.empty())
+		return;
+
+	uint32_t node = 0;
+	std::string::const_iterator c = url.begin();
+	while (true) {
+		const TrieNode& n = m_nodes[node];
+		r_indices.insert(r_indices.end(),n.patterns.begin(),n.patterns.end());
+
+		if (c == url.end())
+			break;
+		std::map<char,uint32_t>::const_iterator child = n.children.find(tolower((unsigned char) *c));
+		if (child == n.children.end())
+			break;
+		node = child->second;
+		++c;
+	}
+
+	//callers rely on getting them back in table order (first match wins)
+	std::sort(r_indices.begin(),r_indices.end());
+}
+
+//static
+std::string RedirectMatcher::literalPrefix(const std::string& urlRe)
+{
+	if (urlRe.empty() || urlRe[0] != '^')
+		return "";
+
+	//an alternation at the top level means the anchor (and so the prefix) only applies to the first branch
+	int depth = 0;
+	bool inBracket = false;
+	for (uint32_t i=1;i<urlRe.size();++i) {
+		char c = urlRe[i];
+		if (inBracket) {
+			if (c == ']')
+				inBracket = false;
+			continue;
+		}
+		if (c == '\\')
+			++i;
+		else if (c == '[') {
+			inBracket = true;
+			//a ']' right after the opening (or after the negation) is a literal member
+			if (i+1 < urlRe.size() && urlRe[i+1] == '^')
+				++i;
+			if (i+1 < urlRe.size() && urlRe[i+1] == ']')
+				++i;
+		}
+		else if (c == '(')
+			++depth;
+		else if (c == ')')
+			--depth;
+		else if (c == '|' && depth == 0)
+			return "";
+	}
+
+	std::string prefix;
+	for (uint32_t i=1;i<urlRe.size();++i) {
+		char c = urlRe[i];
+		char literal;
+		if (c == '\\') {
+			//escaped alphanumerics aren't literals (\w, \1...)
+			if (i+1 >= urlRe.size() || isalnum((unsigned char) urlRe[i+1]))
+				break;
+			literal = urlRe[++i];
+		}
+		else if (strchr(".[]()*+?{}|$^",c))
+			break;
+		else
+			literal = c;
+
+		if (i+1 < urlRe.size()) {
+			char next = urlRe[i+1];
+			//the character can be absent altogether
+			if (next == '*' || next == '?' || next == '{')
+				break;
+			//must be there at least once, but nothing after it is fixed
+			if (next == '+') {
+				prefix += tolower((unsigned char) literal);
+				break;
+			}
+		}
+		prefix += tolower((unsigned char) literal);
+	}
+	return prefix;
+}
@@ -0,0 +1,74 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef REDIRECTMATCHER_H_
+#define REDIRECTMATCHER_H_
+
+#include "Common.h"
+
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <map>
+
+/*
+ * Pre-filter for the redirect handler table in MimeSystem.
+ *
+ * Almost every redirect/scheme pattern is anchored and starts with a literal scheme and often host
+ * ("^mailto:", "^https?://www\.youtube\.com/watch\?"...). Those literal prefixes are kept in a trie,
+ * so that for a given url only the patterns whose prefix the url actually starts with need to be run
+ * through regexec. Patterns with no usable prefix (unanchored, top-level alternation...) are kept at
+ * the root of the trie and are always candidates.
+ *
+ * Matching is case insensitive, same as the REG_ICASE that RedirectHandler compiles with.
+ */
+class RedirectMatcher
+{
+public:
+
+	RedirectMatcher();
+	~RedirectMatcher();
+
+	void clear();
+	void build(const std::vector<std::string>& urlRes);
+
+	// fills r_indices with the indices (into the vector given to build()) of the patterns that
+	// could match url, in ascending order. Any pattern not returned can't match.
+	void candidates(const std::string& url,std::vector<uint32_t>& r_indices) const;
+
+	uint32_t patternCount() const { return m_patternCount; }
+	uint32_t unprunableCount() const { return m_nodes.empty() ? 0 : m_nodes[0].patterns.size(); }
+
+	// the lowercased literal text every match of urlRe must start with; empty if there is none
+	static std::string literalPrefix(const std::string& urlRe);
+
+private:
+
+	struct TrieNode {
+		std::map<char,uint32_t> children;
+		std::vector<uint32_t> patterns;			// patterns whose literal prefix ends at this node
+	};
+
+	std::vector<TrieNode> m_nodes;				// m_nodes[0] is the root
+	uint32_t m_patternCount;
+};
+
+#endif /*REDIRECTMATCHER_H_*/
@@ -108,6 +108,9 @@ Settings::Settings()
 	, lunaDefaultRingtoneSound("phone.wav")
 	, lunaSystemSoundAppClose("appclose")
 	, lunaSystemSoundScreenCapture("shutter")
+	, feedbackMixerEnabled(false)
+	, feedbackSoundsPath("/usr/share/systemsounds")
+	, feedbackMixerSink("pulse")
 	, notificationSoundDuration(5000)
 	, lightbarEnabled (false)
 	, coreNaviScaler (75)
@@ -123,10 +126,17 @@ Settings::Settings()
 	, enableAls(true)
 	, disableLocking(false)
 	, lockScreenTimeout(5000)
+	, timerSlackDisplayOffMs(250)
 	, maxPenMoveFreq(30)
 	, maxPaintLoad(6)				       // number of ms for paint routine
 	, maxGestureChangeFreq(30)
 	, maxTouchChangeFreq(30)
+	, touchResampleMode("off")
+	, touchResampleWindowManagers("")
+	, touchMaxPredictionMs(12)
+	, dashboardCompositeCache(true)
+	, sensorBatchIntervalMs(16)
+	, sensorSyntheticRate(0)
 	, debug_trackInputEvents(false)
 	, debug_enabled(false)
 	, debug_piranhaDrawColoredOutlines(false)
@@ -193,6 +203,8 @@ Settings::Settings()
 	, virtualKeyboardEnabled(false)
 	, virtualCoreNaviEnabled(false)
 	, virtualCoreNaviHeight(0)
+	, maxNumParkedApps(4)
+	, maxParkedAppsMemoryKB(16 * 1024)
 	, uiType(UI_LUNA)
 	, fontBanner("Prelude")
 	, fontActiveBanner("Prelude")
@@ -408,6 +420,9 @@ void Settings::load(const char* settingsFile)
 	KEY_BOOLEAN("General", "ShowReticle", showReticle);
 
 	KEY_INTEGER("General", "NotificationSoundDuration", notificationSoundDuration);
+	KEY_BOOLEAN("General", "FeedbackMixerEnabled", feedbackMixerEnabled);
+	KEY_STRING("General", "FeedbackSoundsPath", feedbackSoundsPath);
+	KEY_STRING("General", "FeedbackMixerSink", feedbackMixerSink);
 
 	KEY_INTEGER( "CoreNavi", "ThrobberBrightnessInLight", ledPulseMaxBrightness);
 	KEY_INTEGER( "CoreNavi", "ThrobberBrightnessInDark", ledPulseDarkBrightness);
@@ -424,6 +439,7 @@ void Settings::load(const char* settingsFile)
 	KEY_BOOLEAN( "Display", "TurnOffAccelerometerWhenDimmed", turnOffAccelWhenDimmed);
 	KEY_BOOLEAN( "Display", "DisableLocking", disableLocking);
 	KEY_INTEGER( "Display", "LockScreenTimeoutMs", lockScreenTimeout);
+	KEY_INTEGER( "Display", "TimerSlackWhenOffMs", timerSlackDisplayOffMs);
 
 	KEY_INTEGER( "Memory", "CardLimit", cardLimit );
 	KEY_INTEGER( "General","DisplayWidth",displayWidth);
@@ -433,6 +449,12 @@ void Settings::load(const char* settingsFile)
 	KEY_INTEGER("General",  "MaxPaintLoad", maxPaintLoad);
 	KEY_INTEGER("General", "MaxGestureChangeFreq", maxGestureChangeFreq);
 	KEY_INTEGER("General", "MaxTouchChangeFreq", maxTouchChangeFreq);
+	KEY_STRING("General", "TouchResampleMode", touchResampleMode);
+	KEY_STRING("General", "TouchResampleWindowManagers", touchResampleWindowManagers);
+	KEY_INTEGER("General", "TouchMaxPredictionMs", touchMaxPredictionMs);
+	KEY_BOOLEAN("General", "DashboardCompositeCache", dashboardCompositeCache);
+	KEY_INTEGER("General", "SensorBatchIntervalMs", sensorBatchIntervalMs);
+	KEY_INTEGER("General", "SensorSyntheticRate", sensorSyntheticRate);
 	KEY_BOOLEAN( "Debug", "WatchPenEvents", debug_trackInputEvents );
 	KEY_BOOLEAN( "Debug", "EnableDebugModeByDefault", debug_enabled );
 	KEY_BOOLEAN( "Debug", "PiranhaDrawColoredOutlines", debug_piranhaDrawColoredOutlines);
@@ -567,6 +589,7 @@ void Settings::load(const char* settingsFile)
 	KEY_BOOLEAN( "General" , "ScanCalculatesAppSizes",scanCalculatesAppSizes);
 
 	KEY_INTEGER("KeepAlive", "MaxParked", maxNumParkedApps );
+	KEY_INTEGER("KeepAlive", "MaxParkedMemoryKB", maxParkedAppsMemoryKB );
 
 	KEY_INTEGER("CpuShare", "UiMainLow", uiMainCpuShareLow);
 	KEY_INTEGER("CpuShare", "UiOtherLow", uiOtherCpuShareLow);
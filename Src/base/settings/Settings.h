@@ -81,6 +81,10 @@ public:
 	std::string         lunaSystemSoundScreenUnlock;
 	std::string			lunaSystemSoundScreenCapture;
 
+	bool				feedbackMixerEnabled;		// play preloaded feedback sounds in process instead of through audiod
+	std::string			feedbackSoundsPath;			// <name>.wav files the mixer preloads
+	std::string			feedbackMixerSink;			// "pulse[:<sink>]", "null" or a file to write raw frames to
+
 	int					notificationSoundDuration;
 
 	int                 lightbarEnabled;
@@ -103,6 +107,7 @@ public:
 	bool            enableAls;
 	bool		disableLocking;
 	int		lockScreenTimeout;
+	int		timerSlackDisplayOffMs;
 
     // Parameters to control pen event throttling
     int maxPenMoveFreq;
@@ -114,6 +119,20 @@ public:
 	// Parameters to control touch event throttling
 	int maxTouchChangeFreq;
 
+	// Moving touch positions to the frame time: "off", "interpolate" or "predict", overridden per window
+	// manager by "<class name>=<mode>" pairs separated by commas
+	std::string touchResampleMode;
+	std::string touchResampleWindowManagers;
+	int touchMaxPredictionMs;
+
+	// Keep the dashboards that haven't changed in one pre-composited pixmap between frames
+	bool dashboardCompositeCache;
+
+	// Sensor data for web content goes out at most once per this many ms (0: every sample), and
+	// comes from made up readings at this many samples per second instead of the hardware (0: off)
+	int sensorBatchIntervalMs;
+	int sensorSyntheticRate;
+
 
 	bool				debug_trackInputEvents;
 	bool				debug_enabled;
@@ -199,6 +218,7 @@ public:
 	std::set<std::string> appsToKeepAliveUntilMemPressure;
 	std::set<std::string> appsToDisableAccelCompositing;
 	int					maxNumParkedApps;
+	int					maxParkedAppsMemoryKB;
 
 	std::set<std::string> sucApps;
 
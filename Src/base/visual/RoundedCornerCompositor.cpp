@@ -0,0 +1,128 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include "RoundedCornerCompositor.h"
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QTransform>
+#include <QtCore/qmath.h>
+
+// a card scaling through card view wants a new size every few frames; the masks are tiny, but don't
+// let them pile up forever
+static const int kMaxCachedMasks = 128;
+
+QHash<quint32, QImage> RoundedCornerCompositor::s_masks;
+QImage RoundedCornerCompositor::s_scratch;
+
+void RoundedCornerCompositor::draw(QPainter* painter, const QRectF& rect, qreal xRadius, qreal yRadius,
+								   const QPixmap& pix, const QPointF& origin)
+{
+	xRadius = qMin(xRadius, rect.width() / 2);
+	yRadius = qMin(yRadius, rect.height() / 2);
+
+	// the length of the unit vectors after the transform: how big a corner is on screen, rotated or not
+	const QTransform& t = painter->worldTransform();
+	qreal xScale = qSqrt(t.m11() * t.m11() + t.m12() * t.m12());
+	qreal yScale = qSqrt(t.m21() * t.m21() + t.m22() * t.m22());
+	int maskWidth = qRound(xRadius * xScale);
+	int maskHeight = qRound(yRadius * yScale);
+
+	if (maskWidth < 1 || maskHeight < 1) {
+		blit(painter, rect, pix, origin);
+		return;
+	}
+
+	// the cross shaped interior, as plain blits in whatever composition mode the caller set up
+	blit(painter, QRectF(rect.left() + xRadius, rect.top(), rect.width() - 2 * xRadius, rect.height()), pix, origin);
+	blit(painter, QRectF(rect.left(), rect.top() + yRadius, xRadius, rect.height() - 2 * yRadius), pix, origin);
+	blit(painter, QRectF(rect.right() - xRadius, rect.top() + yRadius, xRadius, rect.height() - 2 * yRadius), pix, origin);
+
+	if (s_scratch.width() != maskWidth || s_scratch.height() != maskHeight)
+		s_scratch = QImage(maskWidth, maskHeight, QImage::Format_ARGB32_Premultiplied);
+
+	const QRectF corners[4] = {
+		QRectF(rect.left(), rect.top(), xRadius, yRadius),
+		QRectF(rect.right() - xRadius, rect.top(), xRadius, yRadius),
+		QRectF(rect.left(), rect.bottom() - yRadius, xRadius, yRadius),
+		QRectF(rect.right() - xRadius, rect.bottom() - yRadius, xRadius, yRadius)
+	};
+
+	// the corners have transparent pixels, which only blend right over what's behind the card
+	QPainter::CompositionMode previous = painter->compositionMode();
+	painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
+
+	for (int i = 0; i < 4; i++) {
+
+		QPainter p(&s_scratch);
+		p.setCompositionMode(QPainter::CompositionMode_Source);
+		p.fillRect(s_scratch.rect(), Qt::transparent);
+		p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+		p.drawPixmap(QRectF(0, 0, maskWidth, maskHeight), pix, corners[i].translated(-origin));
+		p.setCompositionMode(QPainter::CompositionMode_DestinationIn);
+		p.drawImage(0, 0, cornerMask(maskWidth, maskHeight, (Corner) i));
+		p.end();
+
+		painter->drawImage(corners[i], s_scratch);
+	}
+
+	painter->setCompositionMode(previous);
+}
+
+const QImage& RoundedCornerCompositor::cornerMask(int width, int height, Corner corner)
+{
+	quint32 key = ((quint32) (width & 0x3fff) << 16) | ((quint32) (height & 0x3fff) << 2) | corner;
+
+	QHash<quint32, QImage>::const_iterator it = s_masks.constFind(key);
+	if (it != s_masks.constEnd())
+		return it.value();
+
+	if (s_masks.size() >= kMaxCachedMasks)
+		s_masks.clear();
+
+	QImage mask(width, height, QImage::Format_ARGB32_Premultiplied);
+	mask.fill(0);
+
+	// a rounded rect three corners wide, placed so only the wanted corner falls inside the mask
+	qreal x = (corner == TopLeft || corner == BottomLeft) ? 0 : -2 * width;
+	qreal y = (corner == TopLeft || corner == TopRight) ? 0 : -2 * height;
+	QPainterPath path;
+	path.addRoundedRect(QRectF(x, y, 3 * width, 3 * height), width, height);
+
+	QPainter p(&mask);
+	p.setRenderHint(QPainter::Antialiasing, true);
+	p.fillPath(path, Qt::white);
+	p.end();
+
+	return s_masks.insert(key, mask).value();
+}
+
+void RoundedCornerCompositor::blit(QPainter* painter, const QRectF& target, const QPixmap& pix, const QPointF& origin)
+{
+	// only what the pixmap covers; a pixmap brush would have tiled, but the cards always cover their rect
+	QRectF source = target.translated(-origin) & QRectF(pix.rect());
+	if (source.isEmpty())
+		return;
+
+	painter->drawPixmap(source.translated(origin), pix, source);
+}
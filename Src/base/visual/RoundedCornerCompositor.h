@@ -0,0 +1,73 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef ROUNDEDCORNERCOMPOSITOR_H
+#define ROUNDEDCORNERCOMPOSITOR_H
+
+#include "Common.h"
+
+#include <QHash>
+#include <QImage>
+#include <QPixmap>
+#include <QPointF>
+#include <QRectF>
+
+class QPainter;
+
+/*
+ * Draws a pixmap clipped to a rounded rect without an anti-aliased path fill.
+ *
+ * Filling a QPainterPath with a pixmap brush rasterizes and blends the whole rect through the path filler.
+ * Here everything but the four corners is drawn as three plain pixmap blits, and each corner is composited
+ * from the pixmap and an alpha mask of the corner. The masks are made at the size the corner ends up on
+ * screen, from the radius and the painter's current scale, and kept for the next frame; unlike
+ * RoundedCorners' pixmaps (the screen's fixed corners) they come in whatever size the card animation needs.
+ */
+class RoundedCornerCompositor
+{
+public:
+
+	enum Corner {
+		TopLeft = 0,
+		TopRight,
+		BottomLeft,
+		BottomRight
+	};
+
+	// draws the part of pix under rect, pix's top-left being at origin in the painter's coordinates
+	static void draw(QPainter* painter, const QRectF& rect, qreal xRadius, qreal yRadius,
+					 const QPixmap& pix, const QPointF& origin);
+
+	// white, with the corner's coverage as alpha; width and height are in device pixels
+	static const QImage& cornerMask(int width, int height, Corner corner);
+
+	static int cachedMasks() { return s_masks.size(); }
+	static void clearMasks() { s_masks.clear(); }
+
+private:
+
+	static void blit(QPainter* painter, const QRectF& target, const QPixmap& pix, const QPointF& origin);
+
+	static QHash<quint32, QImage> s_masks;
+	static QImage s_scratch;
+};
+
+#endif /* ROUNDEDCORNERCOMPOSITOR_H */
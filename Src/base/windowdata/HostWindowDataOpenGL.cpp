@@ -25,6 +25,10 @@
 
 #include <QGLContext>
 #include <QPainter>
+#include <QVector>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #if defined(TARGET_DESKTOP)
 #include <GL/gl.h>
@@ -48,9 +52,14 @@ static const int kGLInternalFormat = GL_BGRA;
 static const int kGLExternalFormat = GL_BGRA;
 #endif
 
+// partial uploads cover whole rows (GLES2 has no GL_UNPACK_ROW_LENGTH); past this share of the window
+// one glTexImage2D is cheaper than several glTexSubImage2Ds
+static const int kMaxPartialUploadPercent = 60;
+
 HostWindowDataOpenGL::HostWindowDataOpenGL(int key, int metaDataKey, int width, int height, bool hasAlpha)
 	: HostWindowDataSoftware(key, metaDataKey, width, height, hasAlpha)
 	, m_textureId(0)
+	, m_uploadedTextureId(0)
 {
 }
 
@@ -75,6 +84,7 @@ void HostWindowDataOpenGL::initializePixmap(QPixmap& screenPixmap)
 									  QGLContext::PremultipliedAlphaBindOption);
 		gc->setTextureOptions(screenPixmap, QGLContext::PremultipliedAlphaBindOption);
 	}
+	m_uploadedTextureId = 0;
 	m_dirty = true;
 }
 
@@ -87,34 +97,85 @@ void HostWindowDataOpenGL::flip()
 
 void HostWindowDataOpenGL::onUpdateRegion(QPixmap& screenPixmap, int x, int y, int w, int h)
 {
-	m_dirty = true;
+	HostWindowDataSoftware::onUpdateRegion(screenPixmap, x, y, w, h);
 }
 
 QPixmap* HostWindowDataOpenGL::acquirePixmap(QPixmap& screenPixmap)
 {
-	if (m_dirty) {
-		m_dirty = false;
-    
-		m_ipcBuffer->lock();
+	if (!m_dirty && m_dirtyRegion.isEmpty())
+		return &screenPixmap;
+
+	const uint32_t rowBytes = m_width * 4;
+	const uint32_t windowBytes = rowBytes * m_height;
+
+	// merge the dirty rectangles into runs of whole rows
+	std::vector<std::pair<int, int> > rows;
+	int dirtyRows = 0;
+	if (!m_dirty) {
+		const QVector<QRect> rects = m_dirtyRegion.rects();
+		for (int i = 0; i < rects.size(); i++)
+			rows.push_back(std::make_pair(rects[i].top(), rects[i].bottom() + 1));
+		std::sort(rows.begin(), rows.end());
+
+		unsigned int merged = 0;
+		for (unsigned int i = 1; i < rows.size(); i++) {
+			if (rows[i].first <= rows[merged].second)
+				rows[merged].second = std::max(rows[merged].second, rows[i].second);
+			else
+				rows[++merged] = rows[i];
+		}
+		rows.resize(merged + 1);
+
+		for (unsigned int i = 0; i < rows.size(); i++)
+			dirtyRows += rows[i].second - rows[i].first;
+	}
 
-		QGLContext* gc = (QGLContext*) QGLContext::currentContext();
-		if (gc) {
+	bool full = m_dirty || dirtyRows * 100 > m_height * kMaxPartialUploadPercent;
+	uint32_t bytes = 0;
 
-			m_textureId = gc->bindTexture(screenPixmap, GL_TEXTURE_2D, kGLInternalFormat,
-										  QGLContext::PremultipliedAlphaBindOption);
-			if (m_textureId) {
+	m_dirty = false;
+	m_dirtyRegion = QRegion();
+
+	m_ipcBuffer->lock();
+
+	QGLContext* gc = (QGLContext*) QGLContext::currentContext();
+	if (gc) {
 
-				gc->setTextureOptions(screenPixmap, QGLContext::PremultipliedAlphaBindOption);
-				
+		m_textureId = gc->bindTexture(screenPixmap, GL_TEXTURE_2D, kGLInternalFormat,
+									  QGLContext::PremultipliedAlphaBindOption);
+		if (m_textureId) {
+
+			gc->setTextureOptions(screenPixmap, QGLContext::PremultipliedAlphaBindOption);
+
+			// a texture bindTexture() just made (its cache dropped ours, or the pixmap changed) holds none of
+			// the window yet, so the dirty rows alone would leave the rest of it undefined
+			if (m_textureId != m_uploadedTextureId)
+				full = true;
+			
+			if (full) {
 			  	glTexImage2D(GL_TEXTURE_2D, 0, kGLInternalFormat,
 							 m_width, m_height, 0,
 							 kGLExternalFormat, GL_UNSIGNED_BYTE, m_ipcBuffer->data());
+				bytes = windowBytes;
+				m_uploadedTextureId = m_textureId;
+			}
+			else {
+				const char* data = (const char*) m_ipcBuffer->data();
+				for (unsigned int i = 0; i < rows.size(); i++) {
+					int height = rows[i].second - rows[i].first;
+					glTexSubImage2D(GL_TEXTURE_2D, 0, 0, rows[i].first,
+									m_width, height,
+									kGLExternalFormat, GL_UNSIGNED_BYTE, data + rows[i].first * rowBytes);
+					bytes += height * rowBytes;
+				}
 			}
 		}
-
-		m_ipcBuffer->unlock();
 	}
 
+	m_ipcBuffer->unlock();
+
+	recordUpload(bytes, windowBytes, full);
+
 	return &screenPixmap;
 }
 
@@ -43,6 +43,7 @@ public:
 private:
 
 	unsigned int m_textureId;
+	unsigned int m_uploadedTextureId;	// texture holding the whole window as of the last upload, 0 if none
 
 	HostWindowDataOpenGL(const HostWindowDataOpenGL&);
 	HostWindowDataOpenGL& operator=(const HostWindowDataOpenGL&);
@@ -23,7 +23,11 @@
 
 #include "HostWindowDataSoftware.h"
 
+#include <string.h>
+
 #include <QImage>
+#include <QPainter>
+#include <QVector>
 #include <PIpcBuffer.h>
 
 #define MESSAGES_INTERNAL_FILE "SysMgrMessagesInternal.h"
@@ -33,6 +37,12 @@
 #include "WindowMetaData.h"
 #include "WebAppMgrProxy.h"
 
+// past this many rectangles, or this share of the window, just copy all of it
+static const int kMaxPartialUploadRects = 16;
+static const int kMaxPartialUploadPercent = 60;
+
+HostWindowDataSoftware::CopyStats HostWindowDataSoftware::s_copyStats = { 0, 0, 0, 0, 0, 0 };
+
 HostWindowDataSoftware::HostWindowDataSoftware(int key, int metaDataKey, int width, int height, bool hasAlpha)
 	: m_ipcBuffer(0)
 	, m_metaDataBuffer(0)
@@ -75,31 +85,82 @@ void HostWindowDataSoftware::flip()
 		QImage img = QImage((const uchar*) m_transitionBuffer->data(), m_width, m_height, QImage::Format_ARGB32_Premultiplied);
 		m_transitionPixmap = new QPixmap(QPixmap::fromImage(img));
 	}
+
+	m_dirty = true;
 }
 
 void HostWindowDataSoftware::onUpdateRegion(QPixmap& screenPixmap, int x, int y, int w, int h)
 {
-	m_dirty = true;
+	m_dirtyRegion += QRect(x, y, w, h) & QRect(0, 0, m_width, m_height);
 }
 
 QPixmap* HostWindowDataSoftware::acquirePixmap(QPixmap& screenPixmap)
 {
-	if (m_dirty) {
+	if (!m_dirty && m_dirtyRegion.isEmpty())
+		return &screenPixmap;
 
-	    if (G_UNLIKELY(!m_ipcBuffer))
+	if (G_UNLIKELY(!m_ipcBuffer))
 		return &screenPixmap;
 
-		m_ipcBuffer->lock();
-	    QImage sharedImage = QImage((const uchar*) m_ipcBuffer->data(), m_width, m_height,
-					QImage::Format_ARGB32_Premultiplied);
-	    sharedImage.detach();
-	    screenPixmap = QPixmap::fromImage(sharedImage);
-		m_ipcBuffer->unlock();
+	const QVector<QRect> rects = m_dirtyRegion.rects();
+	const uint32_t windowBytes = m_width * m_height * 4;
+
+	int dirtyArea = 0;
+	for (int i = 0; i < rects.size(); i++)
+		dirtyArea += rects[i].width() * rects[i].height();
+
+	// a fresh (or flipped) pixmap has nothing to patch up
+	bool full = m_dirty || screenPixmap.isNull() ||
+				screenPixmap.width() != m_width || screenPixmap.height() != m_height ||
+				rects.size() > kMaxPartialUploadRects ||
+				dirtyArea * 100 > m_width * m_height * kMaxPartialUploadPercent;
+
+	uint32_t bytes = 0;
+
+	m_ipcBuffer->lock();
+	QImage sharedImage = QImage((const uchar*) m_ipcBuffer->data(), m_width, m_height,
+								QImage::Format_ARGB32_Premultiplied);
+	if (full) {
+		sharedImage.detach();
+		screenPixmap = QPixmap::fromImage(sharedImage);
+		bytes = windowBytes;
+	}
+	else {
+		// only copy what the app said changed, straight out of the shared buffer
+		QPainter painter(&screenPixmap);
+		painter.setCompositionMode(QPainter::CompositionMode_Source);
+		for (int i = 0; i < rects.size(); i++)
+			painter.drawImage(rects[i].topLeft(), sharedImage, rects[i]);
+		painter.end();
+		bytes = dirtyArea * 4;
 	}
+	m_ipcBuffer->unlock();
+
+	m_dirty = false;
+	m_dirtyRegion = QRegion();
+
+	recordUpload(bytes, windowBytes, full);
 
 	return &screenPixmap;
 }
 
+void HostWindowDataSoftware::recordUpload(uint32_t bytes, uint32_t windowBytes, bool full)
+{
+	s_copyStats.uploads++;
+	if (full)
+		s_copyStats.fullUploads++;
+	s_copyStats.bytesCopied += bytes;
+	s_copyStats.bytesFullEquivalent += windowBytes;
+	s_copyStats.lastUploadBytes = bytes;
+	if (bytes > s_copyStats.maxUploadBytes)
+		s_copyStats.maxUploadBytes = bytes;
+}
+
+void HostWindowDataSoftware::resetCopyStats()
+{
+	memset(&s_copyStats, 0, sizeof(s_copyStats));
+}
+
 void HostWindowDataSoftware::onUpdateWindowRequest()
 {
 	// NO-OP    
@@ -27,7 +27,9 @@
 #include "HostWindowData.h"
 
 #include <QPixmap>
+#include <QRegion>
 #include <PIpcBuffer.h>
+#include <stdint.h>
 
 class HostWindowDataSoftware : public HostWindowData
 {
@@ -54,6 +56,19 @@ public:
 	virtual void updateFromAppDirectRenderingLayer(int screenX, int screenY, int screenOrientation);
 	virtual void onAboutToSendSyncMessage() {}
 
+	// totals over all software windows, for seeing what partial updates save
+	struct CopyStats {
+		uint32_t uploads;			// acquirePixmap()s that had something to copy
+		uint32_t fullUploads;		// ... of which copied the whole window
+		uint64_t bytesCopied;
+		uint64_t bytesFullEquivalent;	// what copying the whole window every time would have cost
+		uint32_t lastUploadBytes;
+		uint32_t maxUploadBytes;
+	};
+
+	static const CopyStats& copyStats() { return s_copyStats; }
+	static void resetCopyStats();
+
 protected:
 
 	PIpcBuffer* m_ipcBuffer;
@@ -63,7 +78,10 @@ protected:
 	int m_width;
 	int m_height;
 	bool m_hasAlpha;
-	bool m_dirty;
+	bool m_dirty;				// the whole window needs to be copied again
+	QRegion m_dirtyRegion;		// otherwise, just these parts of it
+
+	static void recordUpload(uint32_t bytes, uint32_t windowBytes, bool full);
 
 private:
 
@@ -72,6 +90,8 @@ private:
 
 	PIpcBuffer* getIpcTransition() const { return m_transitionBuffer; }
 	void setIpcTransitionBuffer(PIpcBuffer* buffer);
+
+	static CopyStats s_copyStats;
 };
 
 #endif /* HOSTWINDOWDATASOFTWARE_H */
@@ -25,58 +25,136 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
 
 #include "AsyncCaller.h"
 
-AsyncCallerBase::AsyncCallerBase(GMainLoop* loop, gint sourcePriority)
+struct AsyncCallerSource
 {
-	int result = ::pipe(m_pipeFd);
-	(void)result;
-
-	// setup an iochannel on the read end of the pipe
-	m_ioChannel =  g_io_channel_unix_new(m_pipeFd[0]);
-	m_ioSource = g_io_create_watch(m_ioChannel, (GIOCondition) G_IO_IN);
-	g_source_set_callback(m_ioSource, (GSourceFunc) callback, this, NULL);
-	g_source_set_can_recurse(m_ioSource, true);
-	g_source_set_priority(m_ioSource, sourcePriority);
+	GSource            source;
+	GPollFD            pollFd;
+	AsyncCallerBase*   caller;
+};
 
-	GMainContext* ctxt = g_main_loop_get_context(loop);
-	g_source_attach(m_ioSource, ctxt);
+static GSourceFuncs sAsyncCallerFuncs =
+{
+	AsyncCallerBase::sourcePrepare,
+	AsyncCallerBase::sourceCheck,
+	AsyncCallerBase::sourceDispatch,
+	NULL,
+	NULL,
+	NULL
+};
 
-	m_mutex = g_new0(GStaticRecMutex, 1);
-	g_static_rec_mutex_init(m_mutex);
+AsyncCallerBase::AsyncCallerBase(GMainLoop* loop, gint sourcePriority)
+	: m_readFd(-1)
+	, m_writeFd(-1)
+	, m_context(g_main_loop_get_context(loop))
+	, m_source(0)
+	, m_wakeupPending(0)
+	, m_calls(0)
+	, m_wakeups(0)
+	, m_dispatches(0)
+{
+	m_readFd = m_writeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+	if (m_readFd < 0) {
+
+		g_warning("%s: failed to create eventfd (%s), falling back to a pipe", __PRETTY_FUNCTION__, strerror(errno));
+
+		int pipeFd[2];
+		if (::pipe(pipeFd) == 0) {
+			for (int i = 0; i < 2; i++) {
+				::fcntl(pipeFd[i], F_SETFL, ::fcntl(pipeFd[i], F_GETFL) | O_NONBLOCK);
+				::fcntl(pipeFd[i], F_SETFD, FD_CLOEXEC);
+			}
+			m_readFd = pipeFd[0];
+			m_writeFd = pipeFd[1];
+		}
+		else {
+			// still works, just without a fd: prepare() sees the pending wakeup once call() wakes the context
+			g_critical("%s: failed to create pipe: %s", __PRETTY_FUNCTION__, strerror(errno));
+		}
+	}
+
+	// poll the fd from our own source rather than going through a GIOChannel watch
+	m_source = (AsyncCallerSource*) g_source_new(&sAsyncCallerFuncs, sizeof(AsyncCallerSource));
+	m_source->caller = this;
+	m_source->pollFd.fd = m_readFd;
+	m_source->pollFd.events = G_IO_IN;
+	m_source->pollFd.revents = 0;
+	if (m_readFd >= 0)
+		g_source_add_poll(&m_source->source, &m_source->pollFd);
+	g_source_set_can_recurse(&m_source->source, true);
+	g_source_set_priority(&m_source->source, sourcePriority);
+
+	g_source_attach(&m_source->source, m_context);
 }
 
 AsyncCallerBase::~AsyncCallerBase()
 {
-	g_source_destroy(m_ioSource);
-	g_io_channel_unref(m_ioChannel);
-	g_source_unref(m_ioSource);
-	
-    ::close(m_pipeFd[0]);
-	::close(m_pipeFd[1]);
-
-	g_static_rec_mutex_free(m_mutex);
-	g_free(m_mutex);
+	g_source_destroy(&m_source->source);
+	g_source_unref(&m_source->source);
+
+	if (m_writeFd >= 0 && m_writeFd != m_readFd)
+		::close(m_writeFd);
+	if (m_readFd >= 0)
+		::close(m_readFd);
 }
 
 void AsyncCallerBase::call()
 {	
-	char byte = 1;
+	g_atomic_int_inc(&m_calls);
+
+	// already on its way: the dispatch that's pending will pick this call up too
+	if (!g_atomic_int_compare_and_exchange(&m_wakeupPending, 0, 1))
+		return;
+
+	g_atomic_int_inc(&m_wakeups);
 
-	g_static_rec_mutex_lock(m_mutex);
-	ssize_t result = ::write(m_pipeFd[1], &byte, 1);
+	if (G_UNLIKELY(m_writeFd < 0)) {
+		g_main_context_wakeup(m_context);
+		return;
+	}
+
+	// eventfd or pipe alike: only one of these is ever waiting to be read
+	uint64_t one = 1;
+	ssize_t result = ::write(m_writeFd, &one, sizeof(one));
 	(void)result;
-	g_static_rec_mutex_unlock(m_mutex);
 }
 
-gboolean AsyncCallerBase::callback(GIOChannel* channel, GIOCondition condition, gpointer arg)
+gboolean AsyncCallerBase::sourcePrepare(GSource* source, gint* timeout)
 {
-	char byte = 0;
-	if (::read(g_io_channel_unix_get_fd(channel), &byte, 1) != 1)
+	AsyncCallerSource* s = (AsyncCallerSource*) source;
+
+	*timeout = -1;
+	return s->caller->m_readFd < 0 && g_atomic_int_get(&s->caller->m_wakeupPending);
+}
+
+gboolean AsyncCallerBase::sourceCheck(GSource* source)
+{
+	AsyncCallerSource* s = (AsyncCallerSource*) source;
+	if (s->caller->m_readFd < 0)
+		return g_atomic_int_get(&s->caller->m_wakeupPending);
+
+	return (s->pollFd.revents & G_IO_IN) != 0;
+}
+
+gboolean AsyncCallerBase::sourceDispatch(GSource* source, GSourceFunc callback, gpointer userData)
+{
+	AsyncCallerSource* s = (AsyncCallerSource*) source;
+	AsyncCallerBase* caller = s->caller;
+
+	uint64_t count = 0;
+	if (caller->m_readFd >= 0 && ::read(caller->m_readFd, &count, sizeof(count)) != sizeof(count))
 		return TRUE;
-	
-	AsyncCallerBase* caller = (AsyncCallerBase*) arg;
+
+	// anything call()ed from here on needs a new wakeup, anything before is covered by this dispatch
+	g_atomic_int_set(&caller->m_wakeupPending, 0);
+
+	caller->m_dispatches++;
 	caller->dispatch();
 
 	return TRUE;
@@ -26,6 +26,17 @@
 
 #include <glib.h>
 
+struct AsyncCallerSource;
+
+/*
+ * Runs dispatch() on the thread of the given main loop after call() is made from any thread.
+ *
+ * The wakeup is an eventfd polled by a GSource of our own. If eventfd() fails it is a pipe, and if that fails
+ * too, call() wakes the context and prepare() checks the pending flag. Calls made before the main loop gets
+ * around to dispatching collapse into one dispatch: only the first call() after a dispatch starts touches the
+ * eventfd, the rest just see the wakeup is already pending. So dispatch() must handle everything that was asked for
+ * up to the moment it runs, not one unit of work per call().
+ */
 class AsyncCallerBase
 {
 public:
@@ -35,18 +46,34 @@ public:
 
 	void call();
 
+	// call()s made, eventfd writes they caused, and dispatches run on the main loop
+	guint calls() const { return m_calls; }
+	guint wakeups() const { return m_wakeups; }
+	guint dispatches() const { return m_dispatches; }
+
+	// internal: GSource functions, only for the source this class sets up
+	static gboolean sourcePrepare(GSource* source, gint* timeout);
+	static gboolean sourceCheck(GSource* source);
+	static gboolean sourceDispatch(GSource* source, GSourceFunc callback, gpointer userData);
+
 protected:
 
 	virtual void dispatch() = 0;	
 	
 private:
 
-	static gboolean callback(GIOChannel* channel, GIOCondition condition, gpointer arg);
+	int m_readFd;				// the eventfd, or the read end of the pipe if there are no eventfds
+	int m_writeFd;				// the same eventfd, or the pipe's write end
+	GMainContext* m_context;
+	AsyncCallerSource* m_source;
+	volatile gint m_wakeupPending;
+
+	volatile gint m_calls;
+	volatile gint m_wakeups;
+	guint m_dispatches;
 
-	int m_pipeFd[2];
-	GIOChannel* m_ioChannel;
-	GSource* m_ioSource;
-	GStaticRecMutex* m_mutex;
+	AsyncCallerBase(const AsyncCallerBase&);
+	AsyncCallerBase& operator=(const AsyncCallerBase&);
 };
 
 template <class Target>
@@ -0,0 +1,148 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef MPSCRING_H
+#define MPSCRING_H
+
+#include "Common.h"
+
+#include <glib.h>
+
+/**
+ * Bounded multi-producer, single-consumer FIFO that doesn't take a lock
+ *
+ * Any number of threads may {@link MpscRing::push() push()} concurrently; only one thread (the owner
+ * of the queue, e.g. the task's main loop) may {@link MpscRing::pop() pop()}.  Each slot carries a
+ * sequence number that tells producers whether it is free and the consumer whether it has been
+ * filled, so producers only contend on a single compare-and-swap of the enqueue position and the
+ * consumer never writes to anything a producer spins on other than the slot it just emptied.
+ *
+ * Items are stored by value, so T should be something cheap to copy, typically a pointer.
+ *
+ * When the ring is full push() fails rather than blocking; the caller decides what to do with the
+ * item (see {@link TaskBase::postEvent() TaskBase::postEvent()}).
+ */
+template <class T>
+class MpscRing
+{
+public:
+
+	/**
+	 * Constructs an empty ring
+	 *
+	 * @param	capacity		Number of slots; rounded up to a power of two
+	 */
+	explicit MpscRing(guint capacity)
+		: m_enqueuePos(0)
+		, m_dequeuePos(0)
+	{
+		guint size = 2;
+		while (size < capacity)
+			size <<= 1;
+
+		m_mask = size - 1;
+		m_cells = new Cell[size];
+		for (guint i = 0; i < size; i++)
+			m_cells[i].sequence = i;
+	}
+
+	~MpscRing()
+	{
+		delete [] m_cells;
+	}
+
+	/**
+	 * Appends an item; safe to call from any thread
+	 *
+	 * @return				false if the ring is full (the item was not added)
+	 */
+	bool push(const T& item)
+	{
+		guint pos = g_atomic_int_get(&m_enqueuePos);
+		while (true) {
+
+			Cell* cell = &m_cells[pos & m_mask];
+			gint diff = (gint) ((guint) g_atomic_int_get(&cell->sequence) - pos);
+
+			if (diff == 0) {
+				// the slot is free: claim it
+				if (g_atomic_int_compare_and_exchange(&m_enqueuePos, (gint) pos, (gint) (pos + 1))) {
+					cell->data = item;
+					// publish: the consumer won't look at data before it sees this
+					g_atomic_int_set(&cell->sequence, (gint) (pos + 1));
+					return true;
+				}
+			}
+			else if (diff < 0) {
+				// the slot still holds an item from a lap ago
+				return false;
+			}
+
+			// someone else got there first
+			pos = g_atomic_int_get(&m_enqueuePos);
+		}
+	}
+
+	/**
+	 * Removes the oldest item; must only ever be called from the one consumer thread
+	 *
+	 * @return				false if the ring is empty
+	 */
+	bool pop(T& item)
+	{
+		Cell* cell = &m_cells[m_dequeuePos & m_mask];
+		gint diff = (gint) ((guint) g_atomic_int_get(&cell->sequence) - (m_dequeuePos + 1));
+		if (diff < 0)
+			return false;
+
+		item = cell->data;
+		cell->data = T();
+		// hand the slot back to the producers for the next lap
+		g_atomic_int_set(&cell->sequence, (gint) (m_dequeuePos + m_mask + 1));
+		m_dequeuePos++;
+
+		return true;
+	}
+
+	guint capacity() const { return m_mask + 1; }
+
+private:
+
+	struct Cell {
+		Cell() : sequence(0), data() {}
+
+		volatile gint sequence;
+		T data;
+	};
+
+	Cell* m_cells;
+	guint m_mask;
+
+	// producers hammer on m_enqueuePos, keep it off the consumer's cache line
+	volatile gint m_enqueuePos;
+	char m_pad[64 - sizeof(gint)];
+	guint m_dequeuePos;
+
+	MpscRing(const MpscRing&);
+	MpscRing& operator=(const MpscRing&);
+};
+
+#endif /* MPSCRING_H */
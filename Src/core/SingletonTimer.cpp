@@ -48,7 +48,8 @@ struct TimerHandle
     TimerCallback       callback;
     void*               userArg;
 	int                 refCount;
-	bool                inActiveList;
+	int                 heapIndex;		// slot in SingletonTimer::m_heap, -1 if not armed
+	uint64_t            sequence;
 };
 
 struct TimerSource
@@ -67,6 +68,18 @@ static GSourceFuncs sTimerFuncs =
     NULL
 };
 
+// after a stall many timers can be due at once: run at most this many, for at most this long, per
+// wakeup and leave the rest to the next iteration of the main loop, so input and painting get a turn
+static const int kMaxTimersPerDispatch = 32;
+static const int64_t kMaxDispatchMs = 10;
+
+static inline bool PrvFiresBefore(const TimerHandle* a, const TimerHandle* b)
+{
+	if (a->fireTime != b->fireTime)
+		return a->fireTime < b->fireTime;
+	return a->sequence < b->sequence;
+}
+
 
 SingletonTimer::SingletonTimer(GMainLoop* loop)
 {
@@ -79,7 +92,9 @@ SingletonTimer::SingletonTimer(GMainLoop* loop)
 
 	m_source->parent = this;
 	
-    m_activeList = 0;
+	m_fireSequence = 0;
+	m_slack = 0;
+	m_heap.reserve(64);
 }
 
 SingletonTimer::~SingletonTimer()
@@ -102,7 +117,7 @@ TimerHandle* SingletonTimer::create(TimerCallback callback, void* userArg)
     timer->callback = callback;
     timer->userArg  = userArg;
 	timer->refCount = 1;
-	timer->inActiveList = false;
+	timer->heapIndex = -1;
 
     return timer;    
 }
@@ -112,43 +127,28 @@ void SingletonTimer::fire(TimerHandle* timer, uint64_t timeInMs)
     if (!timer)
         return;
 
-    timer->fireTime = timeInMs > 0 ? timeInMs : 0;
-
-	if (timer->inActiveList) {
-		m_activeList = g_list_remove(m_activeList, timer);
-		timer->inActiveList = false;
-	}
+	if (timer->heapIndex >= 0)
+		heapRemove(timer);
 
-	// re-insert sorted based on
-	// 1. ascending based on firetime
-	// 2. firetime being equal, order of this call.
-	if (!m_activeList) {
-		m_activeList = g_list_append(m_activeList, timer);
-	}
-	else {
-
-		bool inserted = false;
-		for (GList* iter = g_list_first(m_activeList); iter;
-			 iter = g_list_next(iter)) {
-
-			TimerHandle* t = (TimerHandle*) iter->data;
-			if (t->fireTime > timer->fireTime) {
-				m_activeList = g_list_insert_before(m_activeList, iter, timer);
-				inserted = true;
-				break;
-			}
-		}
+	// with slack, snap to the slack grid so timers due close together come due together
+	if (m_slack > 0)
+		timeInMs = ((timeInMs + m_slack - 1) / m_slack) * m_slack;
 
-		if (!inserted)
-			m_activeList = g_list_append(m_activeList, timer);
-	}
+    timer->fireTime = timeInMs > 0 ? timeInMs : 0;
 
-	timer->inActiveList = true;
+	// ascending on firetime; firetime being equal, order of this call
+	timer->sequence = m_fireSequence++;
+	heapInsert(timer);
 
     // wake up main loop if it is suspended in a poll
     g_main_context_wakeup(g_main_loop_get_context(m_loop));    
 }
 
+void SingletonTimer::setSlack(uint32_t slackInMs)
+{
+	m_slack = slackInMs;
+}
+
 void SingletonTimer::ref(TimerHandle* timer)
 {
 	timer->refCount++;
@@ -166,25 +166,85 @@ void SingletonTimer::destroy(TimerHandle* timer)
     if (!timer)
         return;
 
-	if (timer->inActiveList)
-		m_activeList = g_list_remove(m_activeList, timer);
+	if (timer->heapIndex >= 0)
+		heapRemove(timer);
     Free(TimerHandle, timer);    
 }
 
-static TimerHandle* PrvFindMinTimer(GList* list)
+void SingletonTimer::heapSet(unsigned int index, TimerHandle* handle)
+{
+	m_heap[index] = handle;
+	handle->heapIndex = index;
+}
+
+void SingletonTimer::siftUp(unsigned int index)
+{
+	TimerHandle* handle = m_heap[index];
+	while (index > 0) {
+		unsigned int parent = (index - 1) / 2;
+		if (!PrvFiresBefore(handle, m_heap[parent]))
+			break;
+		heapSet(index, m_heap[parent]);
+		index = parent;
+	}
+	heapSet(index, handle);
+}
+
+void SingletonTimer::siftDown(unsigned int index)
+{
+	TimerHandle* handle = m_heap[index];
+	unsigned int count = m_heap.size();
+	while (true) {
+		unsigned int child = index * 2 + 1;
+		if (child >= count)
+			break;
+		if (child + 1 < count && PrvFiresBefore(m_heap[child + 1], m_heap[child]))
+			child++;
+		if (!PrvFiresBefore(m_heap[child], handle))
+			break;
+		heapSet(index, m_heap[child]);
+		index = child;
+	}
+	heapSet(index, handle);
+}
+
+void SingletonTimer::heapInsert(TimerHandle* handle)
 {
-	if (!list || g_list_length(list) == 0)
+	m_heap.push_back(handle);
+	siftUp(m_heap.size() - 1);
+}
+
+void SingletonTimer::heapRemove(TimerHandle* handle)
+{
+	unsigned int index = handle->heapIndex;
+	TimerHandle* last = m_heap.back();
+	m_heap.pop_back();
+	handle->heapIndex = -1;
+
+	if (last == handle)
+		return;
+
+	// fill the hole with the last timer and let it find its place
+	heapSet(index, last);
+	if (index > 0 && PrvFiresBefore(last, m_heap[(index - 1) / 2]))
+		siftUp(index);
+	else
+		siftDown(index);
+}
+
+static TimerHandle* PrvFindMinTimer(const std::vector<TimerHandle*>& heap)
+{
+	if (heap.empty())
         return 0;
 
-	GList* iter = g_list_first(list);
-	return (TimerHandle*) iter->data;
+	return heap.front();
 }	
 
 gboolean SingletonTimer::timerPrepare(GSource* source, gint* timeout)
 {
 	SingletonTimer* st = ((TimerSource*)(source))->parent;
 	
-	TimerHandle* minTimer = PrvFindMinTimer(st->m_activeList);
+	TimerHandle* minTimer = PrvFindMinTimer(st->m_heap);
 	if (!minTimer) {
 		*timeout = -1;
 		return FALSE;
@@ -208,7 +268,7 @@ gboolean SingletonTimer::timerCheck(GSource* source)
 {
 	SingletonTimer* st = ((TimerSource*)(source))->parent;
 
-	TimerHandle* minTimer = PrvFindMinTimer(st->m_activeList);
+	TimerHandle* minTimer = PrvFindMinTimer(st->m_heap);
 	if (!minTimer)
 		return FALSE;
 
@@ -225,17 +285,29 @@ gboolean SingletonTimer::timerDispatch(GSource* source, GSourceFunc callback, gp
 {
 	SingletonTimer* st = ((TimerSource*)(source))->parent;
 
-	TimerHandle* minTimer = PrvFindMinTimer(st->m_activeList);
-	if (!minTimer)
-		return TRUE;
+	// Run what is due in this one wakeup, within the limits above. Timers armed from
+	// within a callback wait for the next dispatch, even if they are
+	// already due, so a 0ms periodic timer can't starve the main loop
+	int64_t now = (int64_t) currentTime();
+	uint64_t lastSequence = st->m_fireSequence;
+
+	for (int dispatched = 0; dispatched < kMaxTimersPerDispatch; dispatched++) {
+
+		TimerHandle* minTimer = PrvFindMinTimer(st->m_heap);
+		if (!minTimer || minTimer->fireTime > now || minTimer->sequence >= lastSequence)
+			break;
 
-	// Currently in active list. Remove from there
-	st->m_activeList = g_list_remove(st->m_activeList, minTimer);
-	minTimer->inActiveList = false;
+		// whatever is still due makes timerPrepare() return TRUE straight away
+		if (dispatched > 0 && (int64_t) currentTime() - now >= kMaxDispatchMs)
+			break;
+
+		// Currently in active heap. Remove from there
+		st->heapRemove(minTimer);
 	
-    if (minTimer->callback) {
-        minTimer->callback(minTimer->userArg);
-    }
+		if (minTimer->callback) {
+			minTimer->callback(minTimer->userArg);
+		}
+	}
 
     return TRUE;
 }
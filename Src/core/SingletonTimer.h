@@ -37,6 +37,7 @@
 
 #include <glib.h>
 #include <stdint.h>
+#include <vector>
 
 struct TimerHandle;
 struct TimerSource;
@@ -150,6 +151,38 @@ public:
 	 */
 	void         deref(TimerHandle* timer);
 	
+	/**
+	 * Allows timers to fire up to the given number of milliseconds late so nearby deadlines share a wakeup
+	 * 
+	 * With a non-zero slack, every subsequent
+	 * {@link SingletonTimer::fire() fire()} rounds its deadline up to the
+	 * next multiple of the slack on the monotonic clock.  Timers due within
+	 * the same slack window then expire together and are dispatched from a
+	 * single main loop wakeup instead of one each.  Timers that are already
+	 * armed keep their deadline.
+	 * 
+	 * Meant for when nothing is on screen (see
+	 * {@link DisplayManager::emitDisplayStateChange() DisplayManager::emitDisplayStateChange()});
+	 * 0, the default, turns it off.
+	 * 
+	 * @param	slackInMs		Maximum extra delay for a timer, in milliseconds.
+	 */
+	void         setSlack(uint32_t slackInMs);
+	
+	/**
+	 * Gets the slack set by {@link SingletonTimer::setSlack() setSlack()}
+	 * 
+	 * @return				Maximum extra delay for a timer, in milliseconds.
+	 */
+	uint32_t     slack() const { return m_slack; }
+	
+	/**
+	 * Gets the number of timers which are currently armed
+	 * 
+	 * @return				Number of timers waiting to fire.
+	 */
+	unsigned int activeCount() const { return m_heap.size(); }
+	
 
 	/**
 	 * Gets the number of milliseconds since some system-wide unknown time
@@ -218,6 +251,42 @@ private:
 	 */
 	void destroy(TimerHandle* handle);
 	
+	/**
+	 * Adds a timer to the heap of armed timers
+	 * 
+	 * @param	handle			The timer to arm.  Must not already be in the heap.
+	 */
+	void heapInsert(TimerHandle* handle);
+	
+	/**
+	 * Takes a timer out of the heap of armed timers
+	 * 
+	 * @param	handle			The timer to disarm.  Must be in the heap.
+	 */
+	void heapRemove(TimerHandle* handle);
+	
+	/**
+	 * Moves the timer at the given heap slot towards the root until its parent is due no later than it
+	 * 
+	 * @param	index			Slot in {@link SingletonTimer::m_heap m_heap}.
+	 */
+	void siftUp(unsigned int index);
+	
+	/**
+	 * Moves the timer at the given heap slot towards the leaves until both children are due no earlier than it
+	 * 
+	 * @param	index			Slot in {@link SingletonTimer::m_heap m_heap}.
+	 */
+	void siftDown(unsigned int index);
+	
+	/**
+	 * Places a timer at a heap slot and records the slot in the timer
+	 * 
+	 * @param	index			Slot in {@link SingletonTimer::m_heap m_heap}.
+	 * @param	handle			The timer to put there.
+	 */
+	void heapSet(unsigned int index, TimerHandle* handle);
+	
 	/**
 	 * The GLib main loop structure to tie timers to
 	 */
@@ -229,15 +298,25 @@ private:
 	TimerSource* m_source;
 	
 	/**
-	 * List of TimerHandle pointers of all currently active timer callback functions
+	 * Binary min-heap of all currently armed timers
 	 * 
-	 * If a TimerHandle* is returned by
-	 * {@link SingletonTimer::create() SingletonTimer::create()}
-	 * and it has not been destroyed by
-	 * {@link SingletonTimer::destroy() SingletonTimer::destroy()},
-	 * then that pointer is on this list.
+	 * Ordered by fire time and, for equal fire times, by the order in
+	 * which {@link SingletonTimer::fire() fire()} was called.  Each
+	 * TimerHandle remembers its slot, so arming, re-arming and
+	 * cancelling a timer are O(log n) and the next deadline is always
+	 * at the front.
+	 */
+	std::vector<TimerHandle*> m_heap;
+	
+	/**
+	 * Counter stamped into each timer when it is armed, to keep equal fire times in FIFO order
+	 */
+	uint64_t     m_fireSequence;
+	
+	/**
+	 * Current slack, see {@link SingletonTimer::setSlack() setSlack()}
 	 */
-	GList*       m_activeList;
+	uint32_t     m_slack;
 
 private:
 	/**
@@ -23,9 +23,15 @@
 
 #include "TaskBase.h"
 
+static const guint kEventRingSize = 1024;
+static const guint kHighPriorityEventRingSize = 64;
+
 TaskBase::TaskBase()
 	: m_mainCtxt(0)
 	, m_mainLoop(0)
+	, m_events(kEventRingSize)
+	, m_highPriorityEvents(kHighPriorityEventRingSize)
+	, m_eventsOverflowing(0)
 	, m_asyncCaller(0)
 	, m_masterTimer(0)
 {    
@@ -34,44 +40,103 @@ TaskBase::TaskBase()
 TaskBase::~TaskBase()
 {
     delete m_asyncCaller;
+
+	Event* e = 0;
+	while (m_highPriorityEvents.pop(e))
+		e->deref();
+	while (m_events.pop(e))
+		e->deref();
 }
 
 void TaskBase::postEvent(sptr<Event> event, bool highPriority)
 {
-	m_eventsMutex.lock();
+	// created on the first post, as derived classes only set up m_mainLoop after this constructor.
+	// Published with a barrier so a thread that sees the pointer also sees the caller it points to
+	AsyncCaller<TaskBase>* caller = (AsyncCaller<TaskBase>*) g_atomic_pointer_get((volatile gpointer*) &m_asyncCaller);
+	if (G_UNLIKELY(caller == 0)) {
+		m_eventsMutex.lock();
+		caller = m_asyncCaller;
+		if (caller == 0) {
+			caller = new AsyncCaller<TaskBase>(this, &TaskBase::eventCallback, m_mainLoop);
+			g_atomic_pointer_set((volatile gpointer*) &m_asyncCaller, caller);
+		}
+		m_eventsMutex.unlock();
+	}
+
+	// the ring holds on to its own reference
+	Event* e = event.get();
+	e->ref();
+
+	bool queued = false;
+	if (G_LIKELY(!g_atomic_int_get(&m_eventsOverflowing))) {
+		if (G_UNLIKELY(highPriority))
+			queued = m_highPriorityEvents.push(e);
+		else
+			queued = m_events.push(e);
+	}
+
+	if (G_UNLIKELY(!queued)) {
+		e->deref();
+
+		m_eventsMutex.lock();
+		if (highPriority)
+			m_eventsList.push_front(event);
+		else
+			m_eventsList.push_back(event);
+		g_atomic_int_set(&m_eventsOverflowing, 1);
+		m_eventsMutex.unlock();
+	}
 
-	// FIXME: This is not right. the high priority events should be maintained in a separate queue
-	if (G_UNLIKELY(highPriority))
-		m_eventsList.push_front(event);
-	else
-		m_eventsList.push_back(event);
+	// coalesced by the caller: only the first post since the loop last started draining wakes it up
+	caller->call();
+}
 
-	if (G_UNLIKELY(m_asyncCaller == 0))
-		m_asyncCaller = new AsyncCaller<TaskBase>(this, &TaskBase::eventCallback, m_mainLoop);
-	
-	m_eventsMutex.unlock();
+void TaskBase::getEventWakeupStats(guint& posts, guint& wakeups, guint& dispatches) const
+{
+	posts = wakeups = dispatches = 0;
 
-	m_asyncCaller->call();
+	AsyncCaller<TaskBase>* caller = (AsyncCaller<TaskBase>*) g_atomic_pointer_get((volatile gpointer*) &m_asyncCaller);
+	if (caller) {
+		posts = caller->calls();
+		wakeups = caller->wakeups();
+		dispatches = caller->dispatches();
+	}
 }
 
 void TaskBase::eventCallback()
 {
 	while (true) {
 
+		Event* e = 0;
+		if (m_highPriorityEvents.pop(e) || m_events.pop(e)) {
+			sptr<Event> event(e);
+			e->deref();
+
+			handleEvent(event);
+			continue;
+		}
+
+		if (G_LIKELY(!g_atomic_int_get(&m_eventsOverflowing)))
+			break;
+
+		// the rings are empty, so whatever spilled over is next in line
 		m_eventsMutex.lock();
 
 		if (m_eventsList.empty()) {
+			g_atomic_int_set(&m_eventsOverflowing, 0);
 			m_eventsMutex.unlock();
 			break;
 		}
 
-		sptr<Event> e = m_eventsList.front();
+		sptr<Event> event = m_eventsList.front();
 		m_eventsList.pop_front();
+		if (m_eventsList.empty())
+			g_atomic_int_set(&m_eventsOverflowing, 0);
 
 		// unlock mutex before calling the callback,
 		// otherwise we may have a deadlock
 		m_eventsMutex.unlock();
 		
-		handleEvent(e);
+		handleEvent(event);
 	}
 }
@@ -40,6 +40,7 @@
 #include "AsyncCaller.h"
 #include "Event.h"
 #include "Mutex.h"
+#include "MpscRing.h"
 #include "SingletonTimer.h"
 
 /**
@@ -130,6 +131,15 @@ public:
 	 */
     SingletonTimer* masterTimer() const { return m_masterTimer; }
 	
+	/**
+	 * Gets counters for how this task's event loop has been woken up
+	 * 
+	 * @param	posts			Set to the number of wakeup requests, one per posted event.
+	 * @param	wakeups			Set to how many of those actually had to wake the loop.
+	 * @param	dispatches		Set to the number of times the loop drained the event queue.
+	 */
+	void getEventWakeupStats(guint& posts, guint& wakeups, guint& dispatches) const;
+	
 protected:
 
 	/**
@@ -165,12 +175,10 @@ protected:
 	Mutex m_mutex;
 	
 	/**
-	 * Mutex for the event queue
+	 * Mutex for the overflow event queue
 	 * 
-	 * Prevents other threads using the same event queue from modifying the queue while it's being actively
-	 * processed.  When one thread is about ready to process the queue and handle events, it will lock this
-	 * mutex until it's done modifying the queue at which point it will unlock it so other threads know it's
-	 * safe for them to modify it.
+	 * Only taken when the event rings are full (see {@link m_eventsList m_eventsList}), and to create
+	 * {@link m_asyncCaller m_asyncCaller} on the first post.
 	 * 
 	 * Note: Mutex stands for "mutually exclusive".
 	 */
@@ -179,19 +187,44 @@ protected:
 	/**
 	 * Event queue
 	 * 
-	 * This standard library list object stores a list of smart pointers to events that are in the event
-	 * processing queue (see {@link sptr sptr} for more information on smart pointers).  Events are stored
-	 * in this list in order they should be processed - first list item is the first event that the event
-	 * handling loop should feed to the derived class's event handler method.
+	 * Lock-free ring holding a reference (see {@link sptr sptr}) to each posted event, in the order
+	 * they should be handed to the derived class's event handler method.  Any thread may post, only
+	 * the task's main loop consumes.
+	 */
+	MpscRing<Event*> m_events;
+	
+	/**
+	 * High priority event queue
+	 * 
+	 * Same as {@link m_events m_events} for events posted with highPriority set; this lane is always
+	 * drained first.
+	 */
+	MpscRing<Event*> m_highPriorityEvents;
+	
+	/**
+	 * Overflow event queue
+	 * 
+	 * Events posted while the rings are full end up here, guarded by {@link m_eventsMutex m_eventsMutex}.
+	 * As long as this list is not empty ({@link m_eventsOverflowing m_eventsOverflowing} is set) new events
+	 * are appended here as well so that they don't overtake the ones waiting here.
 	 */
 	std::list<sptr<Event> > m_eventsList;
 	
+	/**
+	 * Non-zero while {@link m_eventsList m_eventsList} holds events
+	 */
+	volatile gint m_eventsOverflowing;
+	
 	/**
 	 * Asynchronous caller to handle all events in the event queue
 	 * 
 	 * Allows the internal event handler loop callback method to be called without stalling out the caller.
 	 * 
-	 * @todo Check this description for accuracy once AsyncCaller is documented.
+	 * A burst of posts made before the loop starts draining shares a single wakeup and a single
+	 * call to {@link TaskBase::eventCallback() eventCallback()}.
+	 * 
+	 * Created on the first post under {@link m_eventsMutex m_eventsMutex}; only read and written
+	 * through g_atomic_pointer_get() and g_atomic_pointer_set() outside of it.
 	 */
 	AsyncCaller<TaskBase>* m_asyncCaller;
 	
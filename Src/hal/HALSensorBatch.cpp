@@ -0,0 +1,169 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+#include "Common.h"
+
+#include <math.h>
+#include <string.h>
+#include "Time.h"
+#include "HALSensorBatch.h"
+
+// period of the synthetic sine waves, slow enough to look like a device being turned around
+static const float kSyntheticPeriodSecs = 2.0f;
+
+HALSensorSampleRing::HALSensorSampleRing()
+    : m_First(0),
+      m_Size(0),
+      m_Dropped(0)
+{
+}
+
+void HALSensorSampleRing::append(const HALSensorSample& aSample)
+{
+    if (kCapacity == m_Size)
+    {
+        m_First = (m_First + 1) % kCapacity;
+        m_Size--;
+        m_Dropped++;
+    }
+
+    m_Samples[(m_First + m_Size) % kCapacity] = aSample;
+    m_Size++;
+}
+
+void HALSensorSampleRing::clear()
+{
+    m_First = 0;
+    m_Size = 0;
+    m_Dropped = 0;
+}
+
+HALSensorBatcher::HALSensorBatcher(int aIntervalMs, QObject *aParent)
+    : QObject(aParent)
+{
+    m_Timer.setSingleShot(true);
+    m_Timer.setInterval(aIntervalMs);
+    connect(&m_Timer, SIGNAL(timeout()), this, SLOT(timerExpired()));
+}
+
+void HALSensorBatcher::setInterval(int aIntervalMs)
+{
+    // takes effect with the next batch, the pending one keeps its deadline
+    m_Timer.setInterval(aIntervalMs);
+}
+
+void HALSensorBatcher::addSample(const HALSensorSample& aSample)
+{
+    m_Samples.append(aSample);
+
+    // the interval runs from the first sample of a batch, so none waits longer than that
+    if (!m_Timer.isActive())
+    {
+        m_Timer.start();
+    }
+}
+
+void HALSensorBatcher::addEvent(const HALSensorSample& aSample)
+{
+    // the samples waiting go out with it, so the receivers still get them in order
+    m_Samples.append(aSample);
+    flush();
+}
+
+void HALSensorBatcher::flush()
+{
+    m_Timer.stop();
+
+    if (!m_Samples.isEmpty())
+    {
+        Q_EMIT batchAvailable(m_Samples);
+        m_Samples.clear();
+    }
+}
+
+void HALSensorBatcher::timerExpired()
+{
+    flush();
+}
+
+HALSyntheticSensorSource::HALSyntheticSensorSource(int aSensor, int aValueCount, int aRate, QObject *aParent)
+    : QObject(aParent),
+      m_Sensor(aSensor),
+      m_ValueCount(qBound(0, aValueCount, (int)HALSensorSample::kMaxValues)),
+      m_Rate(qMax(1, aRate)),
+      m_StartTime(0),
+      m_Generated(0),
+      m_Sequence(0)
+{
+    // a QTimer can't tick faster than once a millisecond; above 1000 Hz each tick catches up
+    m_Timer.setInterval(qMax(1, 1000 / m_Rate));
+    connect(&m_Timer, SIGNAL(timeout()), this, SLOT(timerExpired()));
+}
+
+void HALSyntheticSensorSource::start()
+{
+    m_StartTime = Time::curTimeMs();
+    m_Generated = 0;
+    m_Timer.start();
+}
+
+void HALSyntheticSensorSource::stop()
+{
+    m_Timer.stop();
+}
+
+HALSensorSample HALSyntheticSensorSource::nextSample()
+{
+    HALSensorSample sample;
+    memset(&sample, 0x00, sizeof(HALSensorSample));
+
+    sample.timestamp = Time::curTimeMs();
+    sample.sensor    = m_Sensor;
+    sample.count     = m_ValueCount;
+
+    float phase = 2.0f * (float)M_PI * ((float)m_Sequence / m_Rate) / kSyntheticPeriodSecs;
+    for (int nCounter = 0; nCounter < m_ValueCount; ++nCounter)
+    {
+        sample.values[nCounter] = sinf(phase + nCounter * (float)M_PI_2);
+    }
+
+    m_Sequence++;
+    return sample;
+}
+
+void HALSyntheticSensorSource::timerExpired()
+{
+    // as many samples as the rate calls for by now, so timer jitter doesn't change the rate
+    uint32_t due = (uint32_t)((uint64_t)(Time::curTimeMs() - m_StartTime) * m_Rate / 1000);
+
+    // after a stall (a debugger, a long frame) start counting again rather than flood the consumer
+    if (due - m_Generated > (uint32_t)HALSensorSampleRing::kCapacity)
+    {
+        m_StartTime = Time::curTimeMs();
+        m_Generated = 0;
+        due = 1;
+    }
+
+    while ((m_Generated < due) && (m_Timer.isActive()))
+    {
+        m_Generated++;
+        Q_EMIT sampleAvailable(nextSample());
+    }
+}
@@ -0,0 +1,197 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+#ifndef __HAL_SENSOR_BATCH_H__
+#define __HAL_SENSOR_BATCH_H__
+
+#include <stdint.h>
+#include <QObject>
+#include <QTimer>
+
+/**
+ * One sensor reading in a compact, fixed size form, as it is kept for a batch.
+ * The values are the sensor's fields, in the order its getSensorSample() writes them.
+ */
+struct HALSensorSample
+{
+    static const int kMaxValues = 16;   /**< Rotation: euler angles, quaternion and 3x3 matrix */
+
+    uint32_t    timestamp;              /**< Time::curTimeMs() when the sample was read */
+    int16_t     sensor;                 /**< HALConnectorBase::Sensor which read the sample */
+    int16_t     count;                  /**< Number of valid entries in values */
+    float       values[kMaxValues];
+};
+
+/**
+ * Fixed size ring of the samples read since the last batch went out.
+ * Nothing is allocated per sample; if a batch is late, the oldest samples
+ * make room for the new ones.
+ */
+class HALSensorSampleRing
+{
+public:
+    static const int kCapacity = 64;
+
+    HALSensorSampleRing();
+
+    /**
+     * Adds a sample, dropping the oldest one if the ring is full
+     */
+    void append(const HALSensorSample& aSample);
+
+    /**
+     * Empties the ring and resets the dropped count
+     */
+    void clear();
+
+    inline int size() const { return m_Size; }
+
+    inline bool isEmpty() const { return (0 == m_Size); }
+
+    /**
+     * Number of samples dropped to make room since the ring was last cleared
+     */
+    inline int dropped() const { return m_Dropped; }
+
+    /**
+     * Gets a sample
+     *
+     * @param[in] aIndex - 0 for the oldest sample, size() - 1 for the latest
+     */
+    inline const HALSensorSample& at(int aIndex) const
+    {
+        return m_Samples[(m_First + aIndex) % kCapacity];
+    }
+
+    inline const HALSensorSample& latest() const { return at(m_Size - 1); }
+
+private:
+    HALSensorSample     m_Samples[kCapacity];
+    int                 m_First;
+    int                 m_Size;
+    int                 m_Dropped;
+};
+
+/**
+ * Collects samples and hands them on in one batch at most once per interval,
+ * so that a sensor reporting faster than the screen updates costs its consumers
+ * one delivery per frame instead of one per sample.
+ */
+class HALSensorBatcher : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Constructor
+     *
+     * @param[in] aIntervalMs   - Longest time a sample waits for its batch to go out
+     * @param[in] aParent       - QObject parent
+     */
+    HALSensorBatcher(int aIntervalMs, QObject *aParent = 0);
+
+    void setInterval(int aIntervalMs);
+
+    inline int interval() const { return m_Timer.interval(); }
+
+    /**
+     * Adds a sample to the next batch and makes sure that batch goes out
+     */
+    void addSample(const HALSensorSample& aSample);
+
+    /**
+     * Adds a sample which mustn't be coalesced with the ones after it (a shake
+     * starting or ending, the device turning over) and delivers the batch at once
+     */
+    void addEvent(const HALSensorSample& aSample);
+
+    /**
+     * Delivers the pending samples now, instead of when the interval is up
+     */
+    void flush();
+
+    inline const HALSensorSampleRing& pendingSamples() const { return m_Samples; }
+
+Q_SIGNALS:
+    /**
+     * SIGNAL is emitted with the samples collected for a batch.
+     * The ring is cleared when the receivers return, so they must copy what they keep.
+     */
+    void batchAvailable(const HALSensorSampleRing& aSamples);
+
+private Q_SLOTS:
+    void timerExpired();
+
+private:
+    HALSensorSampleRing m_Samples;
+    QTimer              m_Timer;
+};
+
+/**
+ * Sensor readings made up at a steady rate, to drive the sensor delivery path
+ * (and measure it) without the hardware. Each value is a slow sine wave, a quarter
+ * turn apart from the one before it.
+ */
+class HALSyntheticSensorSource : public QObject
+{
+    Q_OBJECT
+public:
+    /**
+     * Constructor
+     *
+     * @param[in] aSensor       - HALConnectorBase::Sensor to stamp the samples with
+     * @param[in] aValueCount   - Values per sample
+     * @param[in] aRate         - Samples per second
+     * @param[in] aParent       - QObject parent
+     */
+    HALSyntheticSensorSource(int aSensor, int aValueCount, int aRate, QObject *aParent = 0);
+
+    void start();
+
+    void stop();
+
+    inline bool isActive() const { return m_Timer.isActive(); }
+
+    inline int rate() const { return m_Rate; }
+
+    /**
+     * Makes up the next sample, the way the timer does
+     */
+    HALSensorSample nextSample();
+
+Q_SIGNALS:
+    /**
+     * SIGNAL is emitted for every sample made up while the source is active
+     */
+    void sampleAvailable(const HALSensorSample& aSample);
+
+private Q_SLOTS:
+    void timerExpired();
+
+private:
+    int         m_Sensor;
+    int         m_ValueCount;
+    int         m_Rate;
+    uint32_t    m_StartTime;
+    uint32_t    m_Generated;
+    uint32_t    m_Sequence;
+    QTimer      m_Timer;
+};
+
+#endif /* __HAL_SENSOR_BATCH_H__ */
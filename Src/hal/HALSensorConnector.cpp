@@ -25,6 +25,7 @@
 #include <cjson/json.h>
 #include "palmwebtypes.h"
 #include "Settings.h"
+#include "Time.h"
 #include "HALSensorConnector.h"
 
 #define CHECK_ERROR(err, msg)                                                                               \
@@ -73,7 +74,9 @@ HALConnectorBase::HALConnectorBase (Sensor aSensorType, hal_device_type_t aDevTy
       m_SensorFD(0),
       m_CanPostEvent(bCanPostEvent),
       m_OrientationAngle(INVALID_ANGLE),
-      m_Finished(false)
+      m_Finished(false),
+      m_Batcher(0),
+      m_SyntheticSource(0)
 {
     InitSensorMap();
 }
@@ -108,6 +111,12 @@ hal_error_t HALConnectorBase::openSensor ()
 
 bool HALConnectorBase::on()
 {
+    if (m_SyntheticSource)
+    {
+        m_SyntheticSource->start();
+        return true;
+    }
+
     if (m_Handle)
     {
         hal_error_t nError;
@@ -120,6 +129,12 @@ bool HALConnectorBase::on()
 
 bool HALConnectorBase::off()
 {
+    if (m_SyntheticSource)
+    {
+        m_SyntheticSource->stop();
+        return true;
+    }
+
     if (m_Handle)
     {
         hal_error_t error;
@@ -132,6 +147,12 @@ bool HALConnectorBase::off()
 
 bool HALConnectorBase::setRate(SensorReportRate aRate)
 {
+    // A synthetic sensor keeps the rate it was created with
+    if (m_SyntheticSource)
+    {
+        return true;
+    }
+
     if (m_Handle)
     {
         hal_error_t nError;
@@ -235,6 +256,20 @@ std::vector<HALConnectorBase::Sensor> HALConnectorBase::getSupportedSensors()
     return sensorList;
 }
 
+bool HALConnectorBase::isEventSensor(Sensor aSensorType)
+{
+    switch(aSensorType)
+    {
+        case HALConnectorBase::SensorOrientation:
+        case HALConnectorBase::SensorShake:
+        case HALConnectorBase::SensorScreenProximity:
+            return true;
+
+        default:
+            return false;
+    }
+}
+
 HALConnectorBase::Sensor HALConnectorBase::MapFromHAL(hal_device_type_t aHALDevType)
 {
     HALConnectorBase::Sensor mappedType = HALConnectorBase::SensorIllegal;
@@ -369,7 +404,7 @@ std::string HALConnectorBase::getSupportedSensors(bool bJson)
     return strJson;
 }
 
-HALConnectorBase* HALConnectorBase::getSensor (Sensor aSensorType, HALConnectorObserver *aObserver, bool bCanPostEvent)
+HALConnectorBase* HALConnectorBase::createSensor (Sensor aSensorType, HALConnectorObserver *aObserver, bool bCanPostEvent)
 {
     HALConnectorBase *pSensorConnector = 0;
 
@@ -472,6 +507,13 @@ HALConnectorBase* HALConnectorBase::getSensor (Sensor aSensorType, HALConnectorO
         }
     }
 
+    return pSensorConnector;
+}
+
+HALConnectorBase* HALConnectorBase::getSensor (Sensor aSensorType, HALConnectorObserver *aObserver, bool bCanPostEvent)
+{
+    HALConnectorBase *pSensorConnector = createSensor(aSensorType, aObserver, bCanPostEvent);
+
     if (pSensorConnector)
     {
         if (HAL_ERROR_SUCCESS == pSensorConnector->openSensor())
@@ -489,6 +531,55 @@ HALConnectorBase* HALConnectorBase::getSensor (Sensor aSensorType, HALConnectorO
     return pSensorConnector;
 }
 
+HALConnectorBase* HALConnectorBase::getSyntheticSensor (Sensor aSensorType, int aRate, HALConnectorObserver *aObserver)
+{
+    if (aSensorType >= SensorLogicalAccelerometer)
+    {
+        g_warning("Logical sensors have no synthetic source, opening the hardware : [%s : %d] : [SensorType = %d]", __PRETTY_FUNCTION__, __LINE__, aSensorType);
+        return getSensor(aSensorType, aObserver);
+    }
+
+    HALConnectorBase *pSensorConnector = createSensor(aSensorType, aObserver, true);
+
+    if (pSensorConnector)
+    {
+        // The sample layout of the sensor tells the source how many values to make up
+        HALSensorSample sample;
+        memset(&sample, 0x00, sizeof(HALSensorSample));
+        pSensorConnector->getSensorSample(sample);
+
+        pSensorConnector->m_SyntheticSource = new HALSyntheticSensorSource(aSensorType, sample.count, aRate, pSensorConnector);
+        connect(pSensorConnector->m_SyntheticSource, SIGNAL(sampleAvailable(const HALSensorSample&)),
+                pSensorConnector, SLOT(syntheticSampleAvailable(const HALSensorSample&)));
+    }
+
+    return pSensorConnector;
+}
+
+void HALConnectorBase::setBatchInterval(int aIntervalMs)
+{
+    if (aIntervalMs <= 0)
+    {
+        if (m_Batcher)
+        {
+            // Don't lose what is already waiting
+            m_Batcher->flush();
+
+            delete m_Batcher;
+            m_Batcher = 0;
+        }
+    }
+    else if (m_Batcher)
+    {
+        m_Batcher->setInterval(aIntervalMs);
+    }
+    else
+    {
+        m_Batcher = new HALSensorBatcher(aIntervalMs, this);
+        connect(m_Batcher, SIGNAL(batchAvailable(const HALSensorSampleRing&)), this, SLOT(deliverBatch(const HALSensorSampleRing&)));
+    }
+}
+
 void HALConnectorBase::callObserver(bool aShouldEmit)
 {
     if (!m_Finished)
@@ -500,11 +591,55 @@ void HALConnectorBase::callObserver(bool aShouldEmit)
 
         if ((canPostEvent()) && (m_Observer))
         {
-            m_Observer->HALDataAvailable(type());
+            notifyObserver(this);
         }
     }
 }
 
+void HALConnectorBase::notifyObserver(HALConnectorBase *aSource)
+{
+    if (0 == m_Batcher)
+    {
+        m_Observer->HALDataAvailable(type());
+        return;
+    }
+
+    HALSensorSample sample;
+    sample.timestamp = Time::curTimeMs();
+    sample.sensor    = (aSource) ? aSource->type() : type();
+    sample.count     = 0;
+
+    if (aSource)
+    {
+        aSource->getSensorSample(sample);
+    }
+
+    // The sample may come from a part of a logical sensor, so go by the sensor which read it
+    if (isEventSensor((Sensor)sample.sensor))
+    {
+        m_Batcher->addEvent(sample);
+    }
+    else
+    {
+        m_Batcher->addSample(sample);
+    }
+}
+
+void HALConnectorBase::deliverBatch(const HALSensorSampleRing& aSamples)
+{
+    if ((m_Observer) && (!m_Finished))
+    {
+        m_Observer->HALDataBatchAvailable(type(), aSamples);
+    }
+}
+
+void HALConnectorBase::syntheticSampleAvailable(const HALSensorSample& aSample)
+{
+    setSensorSample(aSample);
+    postProcessSensorData();
+    callObserver();
+}
+
 void HALConnectorBase::scheduleDeletion()
 {
     if (!m_Finished)
@@ -607,6 +742,21 @@ QEvent* HALAccelerationSensorConnector::getQSensorData()
     return e;
 }
 
+void HALAccelerationSensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = X();
+    aSample.values[1] = Y();
+    aSample.values[2] = Z();
+    aSample.count = 3;
+}
+
+void HALAccelerationSensorConnector::setSensorSample(const HALSensorSample& aSample)
+{
+    m_AccelerationData.x = aSample.values[0];
+    m_AccelerationData.y = aSample.values[1];
+    m_AccelerationData.z = aSample.values[2];
+}
+
 /**
  * ALS Sensor Connector
  */
@@ -660,6 +810,12 @@ QEvent* HALAlsSensorConnector::getQSensorData()
     return (new AlsEvent(getLightIntensity()));
 }
 
+void HALAlsSensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = getLightIntensity();
+    aSample.count = 1;
+}
+
 /**
  * Angular Velocity Sensor Connector
  */
@@ -719,6 +875,21 @@ QEvent* HALAngularVelocitySensorConnector::getQSensorData()
     return e;
 }
 
+void HALAngularVelocitySensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = X();
+    aSample.values[1] = Y();
+    aSample.values[2] = Z();
+    aSample.count = 3;
+}
+
+void HALAngularVelocitySensorConnector::setSensorSample(const HALSensorSample& aSample)
+{
+    m_AngularVelocity.x = aSample.values[0];
+    m_AngularVelocity.y = aSample.values[1];
+    m_AngularVelocity.z = aSample.values[2];
+}
+
 /**
  * Bearing Sensor Connector
  */
@@ -777,6 +948,21 @@ QEvent* HALBearingSensorConnector::getQSensorData()
     return e;
 }
 
+void HALBearingSensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = bearingMagnitude();
+    aSample.values[1] = trueBearing();
+    aSample.values[2] = confidence();
+    aSample.count = 3;
+}
+
+void HALBearingSensorConnector::setSensorSample(const HALSensorSample& aSample)
+{
+    m_Bearing.magnetic     = aSample.values[0];
+    m_Bearing.true_bearing = aSample.values[1];
+    m_Bearing.confidence   = aSample.values[2];
+}
+
 bool HALBearingSensorConnector::setLocation(double aLatitude, double aLongitude)
 {
     if (m_Handle)
@@ -856,6 +1042,21 @@ QEvent* HALGravitySensorConnector::getQSensorData()
     return e;
 }
 
+void HALGravitySensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = X();
+    aSample.values[1] = Y();
+    aSample.values[2] = Z();
+    aSample.count = 3;
+}
+
+void HALGravitySensorConnector::setSensorSample(const HALSensorSample& aSample)
+{
+    m_Gravity.x = aSample.values[0];
+    m_Gravity.y = aSample.values[1];
+    m_Gravity.z = aSample.values[2];
+}
+
 /**
  * Linear Acceleration Sensor Connector
  */
@@ -920,6 +1121,27 @@ QEvent* HALLinearAccelearationSensorConnector::getQSensorData()
     return e;
 }
 
+void HALLinearAccelearationSensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = X();
+    aSample.values[1] = Y();
+    aSample.values[2] = Z();
+    aSample.values[3] = WorldX();
+    aSample.values[4] = WorldY();
+    aSample.values[5] = WorldZ();
+    aSample.count = 6;
+}
+
+void HALLinearAccelearationSensorConnector::setSensorSample(const HALSensorSample& aSample)
+{
+    m_LinearAcceleration.x       = aSample.values[0];
+    m_LinearAcceleration.y       = aSample.values[1];
+    m_LinearAcceleration.z       = aSample.values[2];
+    m_LinearAcceleration.world_x = aSample.values[3];
+    m_LinearAcceleration.world_y = aSample.values[4];
+    m_LinearAcceleration.world_z = aSample.values[5];
+}
+
 /**
  * Magnetic Field Sensor Connector
  */
@@ -984,6 +1206,17 @@ QEvent* HALMagneticFieldSensorConnector::getQSensorData()
     return e;
 }
 
+void HALMagneticFieldSensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = X();
+    aSample.values[1] = Y();
+    aSample.values[2] = Z();
+    aSample.values[3] = rawX();
+    aSample.values[4] = rawY();
+    aSample.values[5] = rawZ();
+    aSample.count = 6;
+}
+
 /**
  * Orientation Sensor Connector
  */
@@ -1124,6 +1357,12 @@ QEvent* HALOrientationSensorConnector::getQSensorData()
     return e;
 }
 
+void HALOrientationSensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = m_Orientation;
+    aSample.count = 1;
+}
+
 /**
  * convert the accelerometer orientation from the lower level into
  * an Orientation type
@@ -1228,6 +1467,12 @@ QEvent* HALScreenProximitySensorConnector::getQSensorData()
     return (new ProximityEvent(m_Present));
 }
 
+void HALScreenProximitySensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = m_Present;
+    aSample.count = 1;
+}
+
 /**
  * Rotation Sensor Connector
  */
@@ -1338,6 +1583,41 @@ QEvent* HALRotationSensorConnector::getQSensorData()
     return e;
 }
 
+void HALRotationSensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = pitch();
+    aSample.values[1] = roll();
+    aSample.values[2] = yaw();
+    aSample.values[3] = quaternionW();
+    aSample.values[4] = quaternionX();
+    aSample.values[5] = quaternionY();
+    aSample.values[6] = quaternionZ();
+    aSample.count = 7;
+
+    int nArraySize = sizeof(m_RotationData.matrix)/sizeof(m_RotationData.matrix[0]);
+    for (int nCounter = 0; (nCounter < nArraySize) && (aSample.count < HALSensorSample::kMaxValues); ++nCounter)
+    {
+        aSample.values[aSample.count++] = m_RotationData.matrix[nCounter];
+    }
+}
+
+void HALRotationSensorConnector::setSensorSample(const HALSensorSample& aSample)
+{
+    m_RotationData.euler_angle.pitch    = aSample.values[0];
+    m_RotationData.euler_angle.roll     = aSample.values[1];
+    m_RotationData.euler_angle.yaw      = aSample.values[2];
+    m_RotationData.quaternion_vector.w  = aSample.values[3];
+    m_RotationData.quaternion_vector.x  = aSample.values[4];
+    m_RotationData.quaternion_vector.y  = aSample.values[5];
+    m_RotationData.quaternion_vector.z  = aSample.values[6];
+
+    int nArraySize = sizeof(m_RotationData.matrix)/sizeof(m_RotationData.matrix[0]);
+    for (int nCounter = 0; (nCounter < nArraySize) && (7 + nCounter < aSample.count); ++nCounter)
+    {
+        m_RotationData.matrix[nCounter] = aSample.values[7 + nCounter];
+    }
+}
+
 /**
  * Shake Sensor Connector
  */
@@ -1422,6 +1702,13 @@ QEvent* HALShakeSensorConnector::getQSensorData()
     return (new ShakeEvent(m_ShakeState, m_ShakeMagnitude));
 }
 
+void HALShakeSensorConnector::getSensorSample(HALSensorSample& aSample)
+{
+    aSample.values[0] = m_ShakeState;
+    aSample.values[1] = m_ShakeMagnitude;
+    aSample.count = 2;
+}
+
 ShakeEvent::Shake HALShakeSensorConnector::mapShakeSensorEvent(int aValue)
 {
     switch (aValue)
@@ -1547,7 +1834,8 @@ void HALLogicalSensorConnectorBase::logicalSensorDataAvailable()
 {
     if ((m_Observer) && (!m_Finished))
     {
-        m_Observer->HALDataAvailable(type());
+        // sender() is the physical sensor which has just read a sample
+        notifyObserver(qobject_cast<HALConnectorBase *>(sender()));
     }
 }
 
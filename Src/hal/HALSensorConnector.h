@@ -29,6 +29,7 @@
 #include <string>
 #include <hal/hal.h>
 #include "CustomEvents.h"
+#include "HALSensorBatch.h"
 
 /**
  * Indicates a Invalid Angle. Since 0 cannot be used as an invalid angle
@@ -123,6 +124,23 @@ public:
                                         HALConnectorObserver *aObserver = 0,
                                         bool bCanPostEvent = true);
 
+    /**
+     * Factory method which returns a sensor fed by a HALSyntheticSensorSource
+     * instead of the hardware, to measure the delivery of sensor data without
+     * having to move a device around. Sensors which report integer or discrete
+     * values (ALS, Magnetic Field, Orientation, Proximity, Shake) keep reporting
+     * their initial reading. Logical sensors are opened on the real hardware.
+     *
+     * @param[in] aSensorType   - Sensor Type
+     * @param[in] aRate         - Samples per second
+     * @param[in] aObserver     - Observer for the HAL Connectors.
+     *
+     * @return appropriate Sensor instance if successful, NULL otherwise
+     */
+    static HALConnectorBase* getSyntheticSensor (Sensor aSensorType,
+                                                 int aRate,
+                                                 HALConnectorObserver *aObserver = 0);
+
     /**
      * Start the appropriate sensor
      *
@@ -186,6 +204,29 @@ public:
      */
     virtual QEvent* getQSensorData() = 0;
 
+    /**
+     * Gets the sensor data in compact form, without allocating anything
+     *
+     * @param[out] aSample - gets the values and their count; the sensor and
+     *                       timestamp are left to the caller
+     */
+    virtual void getSensorSample(HALSensorSample& aSample)
+    {
+        aSample.count = 0;
+    }
+
+    /**
+     * Delivers the samples to the observer in batches, through
+     * HALConnectorObserver::HALDataBatchAvailable(), at most once per interval
+     * instead of calling HALDataAvailable() for every sample.
+     * sensorDataAvailable() is still emitted for every sample, and a sample of a
+     * sensor reporting discrete events (see isEventSensor()) goes out right away,
+     * along with whatever is pending.
+     *
+     * @param[in] aIntervalMs - batch interval, 0 to call the observer for every sample (default)
+     */
+    void setBatchInterval(int aIntervalMs);
+
     /**
      * Gets the low level HAL handle for the sensor
      *
@@ -253,12 +294,37 @@ protected:
         return m_CanPostEvent;
     }
 
+    /**
+     * Passes the latest sample on to the observer, right away or in the next batch
+     *
+     * @param[in] aSource - Sensor which read the sample: this one, or a part of a logical sensor
+     */
+    void notifyObserver(HALConnectorBase *aSource);
+
+    /**
+     * Sets the sensor data from a sample laid out the way getSensorSample() writes it.
+     * Implement this method for a sensor to follow a HALSyntheticSensorSource.
+     */
+    virtual void setSensorSample(const HALSensorSample& ) {}
+
 private:
     /**
      * Maps the HAL device type
      */
     static HALConnectorBase::Sensor MapFromHAL(hal_device_type_t aHALDevType);
 
+    /**
+     * Find out whether a sensor reports discrete events (orientation, shake and
+     * proximity changes) rather than a continuous reading. Every one of those
+     * events matters, so they are never coalesced into a batch.
+     */
+    static bool isEventSensor(Sensor aSensorType);
+
+    /**
+     * Creates the connector for a sensor type, without opening it
+     */
+    static HALConnectorBase* createSensor (Sensor aSensorType, HALConnectorObserver *aObserver, bool bCanPostEvent);
+
 Q_SIGNALS:
     /**
      * SIGNAL is emitted whenever sensor data is available to consume
@@ -273,6 +339,17 @@ protected Q_SLOTS:
      */
     virtual void readSensorData(int aSocket) = 0;
 
+private Q_SLOTS:
+    /**
+     * SLOT gets called with the samples collected for a batch
+     */
+    void deliverBatch(const HALSensorSampleRing& aSamples);
+
+    /**
+     * SLOT gets called for every sample of a synthetic sensor
+     */
+    void syntheticSampleAvailable(const HALSensorSample& aSample);
+
 protected:
     // Functions
 
@@ -293,6 +370,8 @@ protected:
     bool                        m_CanPostEvent;
     int                         m_OrientationAngle;
     bool                        m_Finished;
+    HALSensorBatcher           *m_Batcher;
+    HALSyntheticSensorSource   *m_SyntheticSource;
 };
 
 /**
@@ -308,6 +387,21 @@ public:
      * @param[in]   - aSensorType - Sensor which has got some data to report
      */
     virtual void HALDataAvailable (HALConnectorBase::Sensor aSensorType) = 0;
+
+    /**
+     * Function gets called with the samples read since the last batch,
+     * for a sensor which delivers in batches (HALConnectorBase::setBatchInterval()).
+     * By then the sensor's own data is the latest sample, so by default this
+     * reports it once, the way HALDataAvailable() would have.
+     *
+     * @param[in]   - aSensorType - Sensor which has got some data to report
+     * @param[in]   - aSamples    - Samples in the order they were read, valid until this returns
+     */
+    virtual void HALDataBatchAvailable (HALConnectorBase::Sensor aSensorType, const HALSensorSampleRing& aSamples)
+    {
+        Q_UNUSED(aSamples);
+        HALDataAvailable(aSensorType);
+    }
 };
 
 /**
@@ -367,6 +461,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: x, y, z
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -376,6 +477,11 @@ protected Q_SLOTS:
     virtual void readSensorData(int aSocket);
 
 protected:
+    /**
+     * Sets the sensor data from a sample laid out the way getSensorSample() writes it
+     */
+    virtual void setSensorSample(const HALSensorSample& aSample);
+
     /**
      * Implement this method, if a sensor requires post processing of the sensor
      * data before sending it for App consumption
@@ -433,6 +539,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: light intensity
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -503,6 +616,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: x, y, z
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -511,6 +631,12 @@ protected Q_SLOTS:
      */
     virtual void readSensorData(int aSocket);
 
+protected:
+    /**
+     * Sets the sensor data from a sample laid out the way getSensorSample() writes it
+     */
+    virtual void setSensorSample(const HALSensorSample& aSample);
+
 private:
     hal_sensor_angular_velocity_event_item_t  m_AngularVelocity;
 };
@@ -582,6 +708,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: magnetic bearing, true bearing, confidence
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -590,6 +723,12 @@ protected Q_SLOTS:
      */
     virtual void readSensorData(int aSocket);
 
+protected:
+    /**
+     * Sets the sensor data from a sample laid out the way getSensorSample() writes it
+     */
+    virtual void setSensorSample(const HALSensorSample& aSample);
+
 private:
     hal_sensor_bearing_event_item_t m_Bearing;
 };
@@ -652,6 +791,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: x, y, z
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -660,6 +806,12 @@ protected Q_SLOTS:
      */
     virtual void readSensorData(int aSocket);
 
+protected:
+    /**
+     * Sets the sensor data from a sample laid out the way getSensorSample() writes it
+     */
+    virtual void setSensorSample(const HALSensorSample& aSample);
+
 private:
     hal_sensor_gravity_event_item_t m_Gravity;
 };
@@ -740,6 +892,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: x, y, z, world x, world y, world z
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -748,6 +907,12 @@ protected Q_SLOTS:
      */
     virtual void readSensorData(int aSocket);
 
+protected:
+    /**
+     * Sets the sensor data from a sample laid out the way getSensorSample() writes it
+     */
+    virtual void setSensorSample(const HALSensorSample& aSample);
+
 private:
     hal_sensor_linear_acceleration_event_item_t m_LinearAcceleration;
 };
@@ -827,6 +992,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: x, y, z, raw x, raw y, raw z
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -893,6 +1065,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: OrientationEvent::Orientation
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected:
     /**
      * Implement this method, if a sensor requires post processing of the sensor
@@ -952,6 +1131,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: presence
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
     /**
      * Gets the sensor data as a json Object
      *
@@ -1055,6 +1241,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: pitch, roll, yaw, quaternion w, x, y, z, rotation matrix (9)
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -1064,6 +1257,11 @@ protected Q_SLOTS:
     virtual void readSensorData(int aSocket);
 
 protected:
+    /**
+     * Sets the sensor data from a sample laid out the way getSensorSample() writes it
+     */
+    virtual void setSensorSample(const HALSensorSample& aSample);
+
     /**
      * Implement this method, if a sensor requires post processing of the sensor
      * data before sending it for App consumption
@@ -1128,6 +1326,13 @@ public:
      */
     virtual QEvent* getQSensorData();
 
+    /**
+     * Gets the sensor data in compact form
+     *
+     * Values: ShakeEvent::Shake, magnitude
+     */
+    virtual void getSensorSample(HALSensorSample& aSample);
+
 protected Q_SLOTS:
     /**
      * SLOT gets called whenever there is some sensor data available to read.
@@ -23,7 +23,8 @@
 #define GLYPHCACHE_H
 
 #include <qpainter.h>
-#include <map>
+#include <qhash.h>
+#include <qlist.h>
 #include <vector>
 #include "Logging.h"
 #include "VirtualKeyboard.h"	// for debug options
@@ -31,93 +32,230 @@
 void initPixmapFragment(QPainter::PixmapFragment & fragment, const QPointF & topLeft, const QRectF & source);
 void initPixmapFragment(QPainter::PixmapFragment & fragment, const QRectF & dest, const QRectF & source);
 
+/*
+  Glyph atlas: glyphs are packed on shelves (rows of a fixed height, filled left to right) in one or more
+  pixmap pages, and found by hashing their spec. When every page is full, the least recently drawn shelf
+  that is tall enough is emptied and reused (or, if there isn't one, the least recently drawn page), so
+  switching layouts or sizes recycles the space used by glyphs that aren't being shown anymore instead
+  of falling back to direct rendering.
+  Requirement:
+    class T must be usable as a QHash key (operator== and a qHash overload).
+*/
 template <class T> class GlyphCache {
 
 public:
-	struct Line {
-		Line(int height = 0, int width = 0) : m_height(height), m_usedWidth(width) {}
-		int	m_height;
-		int m_usedWidth;
+	struct Glyph {
+		Glyph() : m_page(-1), m_shelf(-1), m_lastUse(0) {}
+		QRect	m_rect;			// in the page's pixmap
+		int		m_page;
+		int		m_shelf;
+		quint32	m_lastUse;
 	};
 
-	typedef std::map<T, QRect> GlyphMap;
+	typedef QHash<T, Glyph> GlyphMap;
+
+	QPixmap &		pixmap(int page = 0)			{ return m_pages[page]->m_pixmap; }
+	int				pageCount() const				{ return m_pages.size(); }
 
-	QPixmap &		pixmap()						{ return m_pixmap; }
-	QRect *			lookup(const T & ref)			// return NULL if the ref isn't present in the cache
+	const Glyph *	lookup(const T & ref)			// return NULL if the ref isn't present in the cache. Counts as a use for eviction.
 	{
 		typename GlyphMap::iterator iter = m_cache.find(ref);
-		if (iter != m_cache.end())
-			return &(iter->second);
-		return NULL;
+		if (iter == m_cache.end())
+			return NULL;
+		touch(iter.value());
+		return &iter.value();
 	}
 
-	QRect &			get(const T & ref)				// never returns NULL, but the QRect may be invalid
+	// find room for a new glyph, evicting the least recently drawn ones if needed. NULL if size can't fit in a page.
+	const Glyph *	insert(const T & ref, const QSize & size)
 	{
-		return m_cache[ref];
-	}
+		if (size.width() > m_pageWidth || size.height() > m_pageHeight || size.isEmpty())
+			return NULL;
 
-	bool			allocate(const QSize & size, QRect & rect)
-	{
-		int usedHeight = 0;
-		typename std::vector<Line>::iterator bestMatch = m_lines.end();
-		int	bestMatchUsedHeight = 0;
-		for (typename std::vector<Line>::iterator line = m_lines.begin(); line != m_lines.end(); ++line)
+		int page = -1, shelf = -1;
+		if (!findShelf(size, page, shelf) && !newShelf(size, page, shelf))
 		{
-			if (line->m_height >= size.height() && line->m_usedWidth + size.width() <= m_pixmap.width())
+			m_full = true;
+			if (!evictShelf(size, page, shelf))
 			{
-				if (line->m_height == size.height())	// exact height: no need to look any further
-					return useLine(line->m_usedWidth, usedHeight, size, rect);
-				if (bestMatch == m_lines.end() || bestMatch->m_height > line->m_height)
-					bestMatch = line, bestMatchUsedHeight = usedHeight;
+				evictPage(page);
+				if (!newShelf(size, page, shelf))
+					return NULL;
 			}
-			usedHeight += line->m_height;
 		}
-		// is the best match good enough?
-		if (bestMatch != m_lines.end() && bestMatch->m_height <= size.height() * 12 / 10)
-			return useLine(bestMatch->m_usedWidth, bestMatchUsedHeight, size, rect);
-		// best match not good enough, let's create a new line if possible
-		if (usedHeight + size.height() <= m_pixmap.height() && size.width() <= m_pixmap.width())
+
+		Shelf & s = m_pages[page]->m_shelves[shelf];
+		Glyph & glyph = m_cache[ref];
+		glyph.m_rect.setRect(s.m_usedWidth, s.m_top, size.width(), size.height());
+		glyph.m_page = page;
+		glyph.m_shelf = shelf;
+		s.m_usedWidth += size.width();
+		s.m_glyphs.append(ref);
+		touch(glyph);
+		return &glyph;
+	}
+
+	bool			isFull() const					{ return m_full; }		// all pages were used up & glyphs had to be evicted
+	int				glyphCount() const				{ return m_cache.size(); }
+	int				evictionCount() const			{ return m_evictionCount; }	// glyphs evicted so far
+
+	GlyphCache(int height, int lineWidth = 1024, int maxPages = 2) : m_pageWidth(lineWidth), m_pageHeight(height), m_maxPages(qMax(maxPages, 1)), m_clock(0), m_evictionCount(0), m_full(false)
+	{
+		addPage();
+	}
+	~GlyphCache()
+	{
+		qDeleteAll(m_pages);
+	}
+
+private:
+	struct Shelf {
+		Shelf(int top = 0, int height = 0) : m_top(top), m_height(height), m_usedWidth(0), m_lastUse(0) {}
+		int			m_top;
+		int			m_height;
+		int			m_usedWidth;
+		quint32		m_lastUse;		// most recent use of any of its glyphs
+		QList<T>	m_glyphs;
+	};
+
+	struct Page {
+		Page(int width, int height) : m_pixmap(width, height), m_usedHeight(0)
+		{
+			m_pixmap.fill(QColor(0, 0, 0, 0));
+		}
+		QPixmap				m_pixmap;
+		std::vector<Shelf>	m_shelves;
+		int					m_usedHeight;
+	};
+
+	int					m_pageWidth;
+	int					m_pageHeight;
+	int					m_maxPages;
+	std::vector<Page *>	m_pages;		// pointers, so that a painter open on a page survives adding another
+	GlyphMap			m_cache;
+	quint32				m_clock;
+	int					m_evictionCount;
+	bool				m_full;
+
+	void	touch(Glyph & glyph)
+	{
+		glyph.m_lastUse = ++m_clock;
+		m_pages[glyph.m_page]->m_shelves[glyph.m_shelf].m_lastUse = m_clock;
+	}
+
+	void	addPage()
+	{
+		m_pages.push_back(new Page(m_pageWidth, m_pageHeight));
+	}
+
+	static bool	fits(const Shelf & shelf, const QSize & size, int pageWidth)
+	{
+		return shelf.m_height >= size.height() && shelf.m_usedWidth + size.width() <= pageWidth;
+	}
+
+	// best fitting existing shelf that isn't too much taller than the glyph
+	bool	findShelf(const QSize & size, int & page, int & shelf)
+	{
+		int bestHeight = size.height() * 12 / 10 + 1;
+		for (int p = 0; p < (int) m_pages.size(); ++p)
 		{
-			m_lines.push_back(Line(size.height()));
-			return useLine(m_lines.back().m_usedWidth, usedHeight, size, rect);
+			std::vector<Shelf> & shelves = m_pages[p]->m_shelves;
+			for (int s = 0; s < (int) shelves.size(); ++s)
+			{
+				if (fits(shelves[s], size, m_pageWidth) && shelves[s].m_height < bestHeight)
+				{
+					page = p, shelf = s, bestHeight = shelves[s].m_height;
+					if (bestHeight == size.height())	// exact height: no need to look any further
+						return true;
+				}
+			}
 		}
-		// can the last line be grown verticaly using the last unused pixels to fit in?...
-		if (m_lines.size() > 0)
+		return page >= 0;
+	}
+
+	// open a shelf in the first page with room left at the bottom, adding a page if allowed.
+	// Failing that, any shelf tall enough with room left will do, no matter how much height it wastes.
+	bool	newShelf(const QSize & size, int & page, int & shelf)
+	{
+		for (int p = 0; p <= (int) m_pages.size(); ++p)
 		{
-			Line & lastLine = m_lines.back();
-			usedHeight -= lastLine.m_height;
-			if (usedHeight + size.height() <= m_pixmap.height() && lastLine.m_usedWidth + size.width() <= m_pixmap.width())
+			if (p == (int) m_pages.size())
 			{
-				lastLine.m_height = size.height();
-				return useLine(lastLine.m_usedWidth, usedHeight, size, rect);
+				if (p >= m_maxPages)
+					break;
+				addPage();
 			}
+			Page * pg = m_pages[p];
+			if (pg->m_usedHeight + size.height() <= m_pageHeight)
+			{
+				pg->m_shelves.push_back(Shelf(pg->m_usedHeight, size.height()));
+				pg->m_usedHeight += size.height();
+				page = p, shelf = pg->m_shelves.size() - 1;
+				return true;
+			}
+		}
+		for (int p = 0; p < (int) m_pages.size(); ++p)
+		{
+			std::vector<Shelf> & shelves = m_pages[p]->m_shelves;
+			for (int s = 0; s < (int) shelves.size(); ++s)
+				if (fits(shelves[s], size, m_pageWidth))
+				{
+					page = p, shelf = s;
+					return true;
+				}
 		}
-		// best match is the only match, let's use it no matter how bad it is...
-		if (bestMatch != m_lines.end())
-			return useLine(bestMatch->m_usedWidth, bestMatchUsedHeight, size, rect);
-		m_full = true;
 		return false;
 	}
-	bool		isFull() const						{ return m_full; }
 
-	GlyphCache(int height, int lineWidth = 1024) : m_pixmap(lineWidth, height), m_full(false)
+	void	evictGlyphs(Shelf & shelf)
 	{
-		m_pixmap.fill(QColor(0, 0, 0, 0));
+		for (typename QList<T>::const_iterator iter = shelf.m_glyphs.constBegin(); iter != shelf.m_glyphs.constEnd(); ++iter)
+			m_cache.remove(*iter);
+		m_evictionCount += shelf.m_glyphs.size();
+		shelf.m_glyphs.clear();
+		shelf.m_usedWidth = 0;
 	}
 
-private:
-	QPixmap				m_pixmap;
-	std::vector<Line>	m_lines;
-	GlyphMap			m_cache;
-	bool				m_full;
-
-	// utility method to set the rect to the right values & update the line's used width
-	inline bool	useLine(int & lineUsedWidth, int top, const QSize & size, QRect & rect)
+	// empty the least recently drawn shelf tall enough for the glyph
+	bool	evictShelf(const QSize & size, int & page, int & shelf)
 	{
-		rect.setRect(lineUsedWidth, top, size.width(), size.height());
-		lineUsedWidth += size.width();
+		page = shelf = -1;
+		for (int p = 0; p < (int) m_pages.size(); ++p)
+		{
+			std::vector<Shelf> & shelves = m_pages[p]->m_shelves;
+			for (int s = 0; s < (int) shelves.size(); ++s)
+				if (shelves[s].m_height >= size.height() && (page < 0 || shelves[s].m_lastUse < m_pages[page]->m_shelves[shelf].m_lastUse))
+					page = p, shelf = s;
+		}
+		if (page < 0)
+			return false;
+		evictGlyphs(m_pages[page]->m_shelves[shelf]);
 		return true;
 	}
+
+	// no shelf is tall enough: empty the least recently drawn page entirely, so it can be re-shelved
+	void	evictPage(int & page)
+	{
+		page = 0;
+		quint32 oldest = 0;
+		for (int p = 0; p < (int) m_pages.size(); ++p)
+		{
+			quint32 lastUse = 0;
+			std::vector<Shelf> & shelves = m_pages[p]->m_shelves;
+			for (int s = 0; s < (int) shelves.size(); ++s)
+				lastUse = qMax(lastUse, shelves[s].m_lastUse);
+			if (p == 0 || lastUse < oldest)
+				page = p, oldest = lastUse;
+		}
+		Page * pg = m_pages[page];
+		for (int s = 0; s < (int) pg->m_shelves.size(); ++s)
+			evictGlyphs(pg->m_shelves[s]);
+		pg->m_shelves.clear();
+		pg->m_usedHeight = 0;
+	}
+
+	GlyphCache(const GlyphCache &);
+	GlyphCache & operator=(const GlyphCache &);
 };
 
 template <class T> struct DirectRenderer {
@@ -143,21 +281,25 @@ protected:
 // GlyphRenderer that only populates the cache & doesn't render anything "for real" besides that.
 template <class T> class GlyphCachePopulator : public GlyphRenderer<T> {
 public:
-	GlyphCachePopulator(GlyphCache<T> & glyphCache, DirectRenderer<T> & directRenderer) : GlyphRenderer<T>(glyphCache, directRenderer), m_painter(&glyphCache.pixmap())
+	GlyphCachePopulator(GlyphCache<T> & glyphCache, DirectRenderer<T> & directRenderer) : GlyphRenderer<T>(glyphCache, directRenderer), m_page(-1)
 	{
-		m_painter.setRenderHints(QPainter::SmoothPixmapTransform | QPainter::HighQualityAntialiasing | QPainter::TextAntialiasing, true);
-		m_painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
 	}
 	void render(const QRect & location, const T & textSpec, QFont & font, int flags = Qt::AlignCenter)
 	{
-		QRect & ref = GlyphRenderer<T>::m_glyphCache.get(textSpec);
-		if (!ref.isValid())
+		if (!GlyphRenderer<T>::m_glyphCache.lookup(textSpec))
 		{
 			QRect	boundingRect;
 			textSpec.applyFontSettings(font);
 			GlyphRenderer<T>::m_directRenderer.boundingRect(location, textSpec, font, flags, boundingRect);
-			if (GlyphRenderer<T>::m_glyphCache.allocate(boundingRect.size(), ref) && VERIFY(boundingRect.size() == ref.size()))
+			const typename GlyphCache<T>::Glyph * glyph = GlyphRenderer<T>::m_glyphCache.insert(textSpec, boundingRect.size());
+			if (glyph && VERIFY(boundingRect.size() == glyph->m_rect.size()))
 			{
+				const QRect & ref = glyph->m_rect;
+				beginPage(glyph->m_page);
+				// the spot may have been used by an evicted glyph
+				m_painter.setCompositionMode(QPainter::CompositionMode_Clear);
+				m_painter.fillRect(ref, Qt::transparent);
+				m_painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
 				m_painter.setFont(font);
 				QRect		paintRect(ref.topLeft() + location.topLeft() - boundingRect.topLeft(), location.size());
 #if VKB_SHOW_GLYPH_REGIONS
@@ -172,12 +314,25 @@ public:
 
 private:
 	QPainter	m_painter;
+	int			m_page;
+
+	void beginPage(int page)
+	{
+		if (page == m_page)
+			return;
+		if (m_painter.isActive())
+			m_painter.end();
+		m_painter.begin(&GlyphRenderer<T>::m_glyphCache.pixmap(page));
+		m_painter.setRenderHints(QPainter::SmoothPixmapTransform | QPainter::HighQualityAntialiasing | QPainter::TextAntialiasing, true);
+		m_painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+		m_page = page;
+	}
 };
 
-// GlyphRenderer that will render from the cache if possible, caching if necessary & possible...
+// GlyphRenderer that will render from the cache if possible, and directly otherwise (the idle pre-rendering fills the cache)...
 template <class T> class CachedGlyphRenderer : public GlyphRenderer<T> {
 public:
-	CachedGlyphRenderer(QPainter & painter, GlyphCache<T> & glyphCache, DirectRenderer<T> & directRenderer, int expectedFragmentCount) : GlyphRenderer<T>(glyphCache, directRenderer), m_painter(painter), m_cacheMissCount(0)
+	CachedGlyphRenderer(QPainter & painter, GlyphCache<T> & glyphCache, DirectRenderer<T> & directRenderer, int expectedFragmentCount) : GlyphRenderer<T>(glyphCache, directRenderer), m_painter(painter), m_fragmentsPage(-1), m_cacheMissCount(0)
 	{
 		m_fragments.reserve(expectedFragmentCount);
 	}
@@ -189,23 +344,26 @@ public:
 	void render(const QRect & location, const T & textSpec, QFont & font, int flags = Qt::AlignCenter)
 	{
 #if VKB_ENABLE_GLYPH_CACHE
-		QRect * ref = GlyphRenderer<T>::m_glyphCache.lookup(textSpec);
-		if (ref && VERIFY(ref->isValid()))
+		const typename GlyphCache<T>::Glyph * glyph = GlyphRenderer<T>::m_glyphCache.lookup(textSpec);
+		if (glyph && VERIFY(glyph->m_rect.isValid()))
 		{
+			const QRect & ref = glyph->m_rect;
 			int x = location.left();
 			int y = location.top();
 			if (flags & Qt::AlignHCenter)
-				x += (location.width() - ref->width()) / 2;
+				x += (location.width() - ref.width()) / 2;
 			else if (flags & Qt::AlignRight)
-				x += location.width() - ref->width();
+				x += location.width() - ref.width();
 			if (flags & Qt::AlignVCenter)
-				y += (location.height() - ref->height()) / 2;
+				y += (location.height() - ref.height()) / 2;
 			else if (flags & Qt::AlignBottom)
-				y += location.height() - ref->height();
+				y += location.height() - ref.height();
 			QPainter::PixmapFragment	fragment;
-			initPixmapFragment(fragment, QPoint(x, y), *ref);
-			if (m_fragments.size() >= m_fragments.capacity())
+			initPixmapFragment(fragment, QPoint(x, y), ref);
+			// one batch per page: glyphs never overlap, so drawing them page by page doesn't change the result
+			if (m_fragments.size() >= m_fragments.capacity() || glyph->m_page != m_fragmentsPage)
 				flush();
+			m_fragmentsPage = glyph->m_page;
 			m_fragments.push_back(fragment);
 			return;
 		}
@@ -230,7 +388,7 @@ public:
 	{
 		if (m_fragments.size() > 0)
 		{
-			m_painter.drawPixmapFragments(&m_fragments[0], m_fragments.size(), GlyphRenderer<T>::m_glyphCache.pixmap());
+			m_painter.drawPixmapFragments(&m_fragments[0], m_fragments.size(), GlyphRenderer<T>::m_glyphCache.pixmap(m_fragmentsPage));
 			m_fragments.resize(0);
 		}
 	}
@@ -239,6 +397,7 @@ public:
 private:
 	QPainter &								m_painter;
 	std::vector<QPainter::PixmapFragment>	m_fragments;
+	int										m_fragmentsPage;
 	int										m_cacheMissCount;
 };
 
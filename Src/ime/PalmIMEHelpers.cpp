@@ -32,6 +32,38 @@ quint64 currentTime()
 			(quint64) currTime.tv_nsec / 1000000ULL);
 }
 
+quint64 currentTimeUs()
+{
+	struct timespec currTime;
+	clock_gettime(CLOCK_MONOTONIC, &currTime);
+
+	return ((quint64) currTime.tv_sec * 1000000ULL +
+			(quint64) currTime.tv_nsec / 1000ULL);
+}
+
+void PaintTimeCounter::addPaint(quint64 durationUs, bool layerRebuilt)
+{
+	++m_paints;
+	if (layerRebuilt)
+		++m_layerRebuilds;
+	m_totalUs += durationUs;
+	if (durationUs > m_maxUs)
+		m_maxUs = durationUs;
+	if (m_paints >= cReportInterval)
+	{
+		g_debug("%s: %u paints, average %Lu us, max %Lu us, %u key layer rebuilds", m_name, m_paints, m_totalUs / m_paints, m_maxUs, m_layerRebuilds);
+		reset();
+	}
+}
+
+void PaintTimeCounter::reset()
+{
+	m_paints = 0;
+	m_layerRebuilds = 0;
+	m_totalUs = 0;
+	m_maxUs = 0;
+}
+
 void PerfMonitor::trace(const char * message, GLogLevelFlags logLevel)
 {
 	quint64 sys_time, user_time;
@@ -38,6 +38,7 @@ struct Mapper_IF
 };
 
 quint64 currentTime();
+quint64 currentTimeUs();
 
 inline bool isUnicodeQtKey(Qt::Key key)		{ return key >= ' ' && key < Qt::Key_Escape; }
 inline bool isFunctionKey(Qt::Key key)		{ return key >= Qt::Key_Escape; }
@@ -65,6 +66,28 @@ private:
 	quint64			m_user_timeLast;
 };
 
+// Wall clock time spent in a keyboard's paint(), and how many of those paints had to rebuild the cached key layer.
+// Logs a summary every cReportInterval paints, then starts over.
+class PaintTimeCounter
+{
+public:
+	PaintTimeCounter(const char * name) : m_name(name)
+	{
+		reset();
+	}
+	void	addPaint(quint64 durationUs, bool layerRebuilt);
+	void	reset();
+
+	static const quint32 cReportInterval = 200;
+
+private:
+	const char *	m_name;
+	quint32			m_paints;
+	quint32			m_layerRebuilds;
+	quint64			m_totalUs;
+	quint64			m_maxUs;
+};
+
 class ColorMap
 {
 public:
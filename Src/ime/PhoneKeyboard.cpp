@@ -131,6 +131,10 @@ PhoneKeyboard::PhoneKeyboard(IMEDataInterface * dataInterface) : VirtualKeyboard
 	m_keyboardBackgound(NULL),
 	m_keyboardLimitsVersion(0),
 	m_keyboardDirty(true),
+	m_keyboardLayer(NULL),
+	m_keyboardLayerVersion(0),
+	m_keyboardLayerBuiltVersion(-1),
+	m_paintTimes("PhoneKeyboard::paint"),
 	m_candidateBar(m_keymap, m_IMEDataInterface),
 	m_candidateBarLayoutOutdated(true),
 	m_generatedKeymapLayout(NULL),
@@ -161,7 +165,8 @@ PhoneKeyboard::PhoneKeyboard(IMEDataInterface * dataInterface) : VirtualKeyboard
 	m_popup("popup-bg.png"),
 	m_popup_2("popup-bg-2.png"),
 	m_popup_key("popup-key.png"),
-	m_glyphCache(600, 800)
+	m_glyphCache(600, 800),
+	m_prerenderedEvictionCount(0)
 {
 	if (VERIFY(s_instance == NULL))
 		s_instance = this;
@@ -438,6 +443,7 @@ void PhoneKeyboard::setKeyboardHeight(int height, bool notify)
 
 void PhoneKeyboard::keyboardLayoutChanged()
 {
+	invalidateKeyboardLayer();
 	if (!m_keyboardDirty && m_IMEDataInterface->m_visible.get())
 	{
 		m_keyboardDirty = true;
@@ -732,6 +738,7 @@ void PhoneKeyboard::handleKey(UKey key, QPointF where)
 		{
 			PerfMonitor regionMonitor("showXT9Regions");
 			m_candidateBar.drawXT9Regions(m_keyboardBackgound, m_keyboardTopPading);
+			invalidateKeyboardLayer();
 			triggerRepaint();
 			break;
 		}
@@ -1068,33 +1075,25 @@ void PhoneKeyboard::showKeymapRegions()
 void PhoneKeyboard::paint(QPainter & painter)
 {
 	PerfMonitor perf("PhoneKeyboard::paint");
+	quint64 paintStart = currentTimeUs();
 	m_candidateBar.paint(painter, cBlueColor);
 	const QRect & keymapRect = m_keymap.rect();
 	QRect	keyboardFrame(keymapRect.left(), keymapRect.top() - m_keyboardTopPading, keymapRect.width(), keymapRect.height() + m_keyboardTopPading);
-	if (updateBackground())
-		perf.trace("background rebuilt");
+	int		layerCacheMissCount = 0;
+	bool	layerRebuilt = updateKeyboardLayer(layerCacheMissCount);
+	if (layerRebuilt)
+		perf.trace("key layer rebuilt");
 	painter.setCompositionMode(QPainter::CompositionMode_Source);
-	painter.drawPixmap(QPointF(keyboardFrame.left(), keyboardFrame.top()), *m_keyboardBackgound);
+	painter.drawPixmap(QPointF(keyboardFrame.left(), keyboardFrame.top()), *m_keyboardLayer);
 	painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-	perf.trace("Draw background");
+	perf.trace("Draw key layer");
 	DoubleDrawRenderer				doubleDrawRenderer;
 	CachedGlyphRenderer<GlyphSpec>	renderer(painter, m_glyphCache, doubleDrawRenderer, PhoneKeymap::cKeymapColumns * (PhoneKeymap::cKeymapRows + 1));
-	for (int y = 0; y < PhoneKeymap::cKeymapRows; ++y)
+	for (std::vector<QPoint>::iterator iter = m_keyboardLayerDynamicKeys.begin(); iter != m_keyboardLayerDynamicKeys.end(); ++iter)
 	{
-		for (int x = 0; x < PhoneKeymap::cKeymapColumns; ++x)
-		{
-			QPoint	keyCoord(x, y);
-			UKey plainKey = m_keymap.map(x, y, PhoneKeymap::eLayoutPage_plain);
-			QRect r;
-			int count = m_keymap.keyboardToKeyZone(keyCoord, r);
-			if (count > 0 && plainKey != cKey_None)
-			{
-				UKey key = m_keymap.map(x, y);
-//				if (key == Qt::Key_Shift)
-//					drawKeyBackground(painter, r, keyCoord, key, false, count);
-				drawKeyCap(&painter, renderer, r, keyCoord, key, eUse_unpressed);
-			}
-		}
+		QRect r;
+		if (m_keymap.keyboardToKeyZone(*iter, r) > 0)
+			drawKeyCap(&painter, renderer, r, *iter, m_keymap.map(*iter), eUse_unpressed);
 	}
 	bool extendedKeysShown = m_extendedKeys && m_extendedKeysFrame.isValid();
 	QRect	r;
@@ -1214,13 +1213,18 @@ void PhoneKeyboard::paint(QPainter & painter)
 	}
 	m_extendedKeyShown = extendedKey;
 #if VKB_SHOW_GLYPH_CACHE
-	painter.setPen(QColor(255, 0, 0)); painter.drawRect(QRect(QPoint(0, 0), m_glyphCache.pixmap().size())); painter.drawPixmap(0, 0, m_glyphCache.pixmap());
+	for (int page = 0, x = 0; page < m_glyphCache.pageCount(); x += m_glyphCache.pixmap(page++).width())
+	{
+		painter.setPen(QColor(255, 0, 0)); painter.drawRect(QRect(QPoint(x, 0), m_glyphCache.pixmap(page).size())); painter.drawPixmap(x, 0, m_glyphCache.pixmap(page));
+	}
 #endif
 #if VKB_FORCE_FPS
 	triggerRepaint();
 #endif
-	if (renderer.getCacheMissCount() > 0 && m_keymap.getCachedGlyphsCount() < 3)
+	// glyphs evicted since the last pre-rendering pass are brought back by another pass
+	if (renderer.getCacheMissCount() + layerCacheMissCount > 0 && (m_keymap.getCachedGlyphsCount() < 3 || m_glyphCache.evictionCount() != m_prerenderedEvictionCount))
 		queueIdlePrerendering();
+	m_paintTimes.addPaint(currentTimeUs() - paintStart, layerRebuilt);
 }
 
 bool PhoneKeyboard::updateBackground()
@@ -1291,6 +1295,52 @@ bool PhoneKeyboard::updateBackground()
 	return false;
 }
 
+bool PhoneKeyboard::updateKeyboardLayer(int & outCacheMissCount)
+{
+	bool backgroundRebuilt = updateBackground();
+	if (!backgroundRebuilt && m_keyboardLayer && m_keyboardLayerBuiltVersion == m_keyboardLayerVersion)
+		return false;
+
+	const QRect & keymapFrame = m_keymap.rect();
+	QRect	keyboardFrame(keymapFrame.left(), keymapFrame.top() - m_keyboardTopPading, keymapFrame.width(), keymapFrame.height() + m_keyboardTopPading);
+	if (!m_keyboardLayer || m_keyboardLayer->size() != m_keyboardBackgound->size())
+	{
+		PixmapCache::instance().dispose(m_keyboardLayer);
+		m_keyboardLayer = PixmapCache::instance().get(m_keyboardBackgound->size());
+	}
+	QPainter	offscreenPainter(m_keyboardLayer);
+	offscreenPainter.setCompositionMode(QPainter::CompositionMode_Source);
+	offscreenPainter.drawPixmap(0, 0, *m_keyboardBackgound);
+	offscreenPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+	offscreenPainter.translate(-keyboardFrame.left(), -keyboardFrame.top());
+	offscreenPainter.setRenderHints(cRenderHints, true);
+	m_keyboardLayerDynamicKeys.clear();
+	DoubleDrawRenderer				doubleDrawRenderer;
+	CachedGlyphRenderer<GlyphSpec>	renderer(offscreenPainter, m_glyphCache, doubleDrawRenderer, PhoneKeymap::cKeymapColumns * (PhoneKeymap::cKeymapRows + 1));
+	for (int y = 0; y < PhoneKeymap::cKeymapRows; ++y)
+	{
+		for (int x = 0; x < PhoneKeymap::cKeymapColumns; ++x)
+		{
+			QPoint	keyCoord(x, y);
+			UKey plainKey = m_keymap.map(x, y, PhoneKeymap::eLayoutPage_plain);
+			QRect r;
+			int count = m_keymap.keyboardToKeyZone(keyCoord, r);
+			if (count > 0 && plainKey != cKey_None)
+			{
+				UKey key = m_keymap.map(x, y);
+				if (key == Qt::Key_Space)
+					m_keyboardLayerDynamicKeys.push_back(keyCoord);
+				else
+					drawKeyCap(&offscreenPainter, renderer, r, keyCoord, key, eUse_unpressed);
+			}
+		}
+	}
+	renderer.flush();
+	outCacheMissCount = renderer.getCacheMissCount();
+	m_keyboardLayerBuiltVersion = m_keyboardLayerVersion;
+	return true;
+}
+
 QPixmap & PhoneKeyboard::getKeyBackground(const QPoint & keyCoord, UKey key)
 {
 	/*
@@ -1653,8 +1703,8 @@ bool PhoneKeyboard::idle()
 		updateBackground();
 		return true;
 	}
-	else if (sInitExtendedGlyphs)
-	{	// pre-render extended chars, but only once per run (they are always shown at the same size & same color)
+	else if (sInitExtendedGlyphs || m_glyphCache.evictionCount() != m_prerenderedEvictionCount)
+	{	// pre-render extended chars, but only once per run (they are always shown at the same size & same color), unless they might have been evicted
 		DoubleDrawRenderer				renderer;
 		GlyphCachePopulator<GlyphSpec>	populator(m_glyphCache, renderer);
 
@@ -1702,6 +1752,7 @@ bool PhoneKeyboard::idle()
 	}
 
 	m_keymap.incCachedGlyphs();
+	m_prerenderedEvictionCount = m_glyphCache.evictionCount();
 	sCount = IMEPixmap::count();
 	m_idleInit = false;
 	//g_debug("PhoneKeyboard background init complete!");
@@ -74,6 +74,12 @@ struct GlyphSpec {
 																			(m_frontColor == rhs.m_frontColor && m_string < rhs.m_string)))));
 	}
 
+	bool operator==(const GlyphSpec & rhs) const
+	{
+		return m_fontSize == rhs.m_fontSize && m_bold == rhs.m_bold && m_frontColor.rgba() == rhs.m_frontColor.rgba() &&
+				m_backColor.rgba() == rhs.m_backColor.rgba() && m_string == rhs.m_string;
+	}
+
 	void applyFontSettings(QFont & font) const
 	{
 		font.setPixelSize(m_fontSize);
@@ -92,6 +98,11 @@ struct GlyphSpec {
 	QColor		m_backColor;
 };
 
+inline uint qHash(const GlyphSpec & spec)
+{
+	return qHash(spec.m_string) ^ (uint(spec.m_fontSize) << 20) ^ (uint(spec.m_bold) << 31) ^ spec.m_frontColor.rgba();
+}
+
 class PhoneKeyboard : public VirtualKeyboard
 {
 	Q_OBJECT
@@ -177,6 +188,8 @@ protected:
 	void	drawKeyCap(QPainter * painter, GlyphRenderer<GlyphSpec> & renderer, QRect location, const QPoint & keyCoord, UKey key, EUse use);
 	void	drawCenteredPixmap(QPainter & painter, QPixmap & pixmap, const QRect & location);
 	bool	updateBackground();
+	bool	updateKeyboardLayer(int & outCacheMissCount);
+	void	invalidateKeyboardLayer()		{ ++m_keyboardLayerVersion; }
 	void	keyboardLayoutChanged();
 	void	handleKey(UKey key, QPointF where);
     void    sendKeyDownUp(Qt::Key key, Qt::KeyboardModifiers modifiers);
@@ -225,6 +238,11 @@ private:
 	QPixmap	*			m_keyboardBackgound;	// current keyboard, cached version using the assets below without text rendering nor shift keys.
 	int					m_keyboardLimitsVersion;// version of m_keymap limits used to build m_keyboard & m_keyboardBackground
 	bool				m_keyboardDirty;		// does m_keyboard need to be rebuilt before drawing onscreen?
+	QPixmap	*			m_keyboardLayer;		// m_keyboardBackgound with every key drawn as it looks when not pressed, labels included, except for the keys below.
+	std::vector<QPoint>	m_keyboardLayerDynamicKeys;	// keys left out of m_keyboardLayer & drawn on each paint, because their label changes as you type (space bar)
+	int					m_keyboardLayerVersion;	// bumped whenever keys may look different: keymap, shift/symbol state, size...
+	int					m_keyboardLayerBuiltVersion;	// m_keyboardLayerVersion m_keyboardLayer was built for
+	PaintTimeCounter	m_paintTimes;
 	int					m_presetHeight[2];		// height in pixels for each orientation. 0/false = portrait, 1/true = landscape
 
 	CANDIDATEBAR		m_candidateBar;
@@ -276,6 +294,7 @@ private:
 
 	NineTileSprites		m_nineTileSprites;
 	GlyphCache<GlyphSpec>	m_glyphCache;
+	int						m_prerenderedEvictionCount;	// m_glyphCache.evictionCount() when the last pre-rendering pass completed
 };
 
 }; // namespace PhoneKeyboard
@@ -129,6 +129,10 @@ TabletKeyboard::TabletKeyboard(IMEDataInterface * dataInterface) : VirtualKeyboa
 	m_keyboardBackgound(NULL),
 	m_keyboardLimitsVersion(0),
 	m_keyboardDirty(true),
+	m_keyboardLayer(NULL),
+	m_keyboardLayerVersion(0),
+	m_keyboardLayerBuiltVersion(-1),
+	m_paintTimes("TabletKeyboard::paint"),
 	m_candidateBar(m_keymap, m_IMEDataInterface),
 	m_candidateBarLayoutOutdated(true),
 	m_generatedKeymapLayout(NULL),
@@ -174,7 +178,8 @@ TabletKeyboard::TabletKeyboard(IMEDataInterface * dataInterface) : VirtualKeyboa
 	m_popup("popup-bg.png"),
 	m_popup_2("popup-bg-2.png"),
 	m_popup_key("popup-key.png"),
-	m_glyphCache(440, 800)
+	m_glyphCache(440, 800),
+	m_prerenderedEvictionCount(0)
 {
 	if (VERIFY(s_instance == NULL))
 		s_instance = this;
@@ -266,6 +271,7 @@ void TabletKeyboard::setKeyboardCombo(const std::string & keyboardLanguage, cons
 	syncKeymap();
 	
 	m_keymap.setHasMoreThanOneLayoutFamily(hasMoreThanOneKeyboardLayout);
+	invalidateKeyboardLayer();	// may change the label of the language key
 
 	m_candidateBar.setLanguage(autoCorrectLanguage);
 	m_keymap.setAutoCorrectLanguage(autoCorrectLanguage);
@@ -482,6 +488,7 @@ void TabletKeyboard::setKeyboardHeight(int height, bool notify)
 
 void TabletKeyboard::keyboardLayoutChanged()
 {
+	invalidateKeyboardLayer();
 	if (!m_keyboardDirty && m_IMEDataInterface->m_visible.get())
 	{
 		m_keyboardDirty = true;
@@ -862,6 +869,7 @@ void TabletKeyboard::handleKey(UKey key, QPointF where)
 		{
 			PerfMonitor regionMonitor("showXT9Regions");
 			m_candidateBar.drawXT9Regions(m_keyboardBackgound, m_keyboardTopPading);
+			invalidateKeyboardLayer();
 			triggerRepaint();
 			break;
 		}
@@ -1243,35 +1251,25 @@ void TabletKeyboard::paint(QPainter & painter)
 {
 	//painter.setClipping(false);
 	PerfMonitor perf("TabletKeyboard::paint");
+	quint64 paintStart = currentTimeUs();
 	m_candidateBar.paint(painter, cBlueColor);
 	const QRect & keymapRect = m_keymap.rect();
 	QRect	keyboardFrame(keymapRect.left(), keymapRect.top() - m_keyboardTopPading, keymapRect.width(), keymapRect.height() + m_keyboardTopPading);
-	if (updateBackground())
-		perf.trace("background rebuilt");
+	int		layerCacheMissCount = 0;
+	bool	layerRebuilt = updateKeyboardLayer(layerCacheMissCount);
+	if (layerRebuilt)
+		perf.trace("key layer rebuilt");
 	painter.setCompositionMode(QPainter::CompositionMode_Source);
-	painter.drawPixmap(QPointF(keyboardFrame.left(), keyboardFrame.top()), *m_keyboardBackgound);
+	painter.drawPixmap(QPointF(keyboardFrame.left(), keyboardFrame.top()), *m_keyboardLayer);
 	painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
-	perf.trace("Draw background");
+	perf.trace("Draw key layer");
 	DoubleDrawRenderer				doubleDrawRenderer;
 	CachedGlyphRenderer<GlyphSpec>	renderer(painter, m_glyphCache, doubleDrawRenderer, TabletKeymap::cKeymapColumns * (TabletKeymap::cKeymapRows + 1));
-	for (int y = 0; y < TabletKeymap::cKeymapRows; ++y)
+	for (std::vector<QPoint>::iterator iter = m_keyboardLayerDynamicKeys.begin(); iter != m_keyboardLayerDynamicKeys.end(); ++iter)
 	{
-		for (int x = 0; x < TabletKeymap::cKeymapColumns; ++x)
-		{
-			QPoint	keyCoord(x, y);
-			UKey key = m_keymap.map(x, y);
-			QRect r;
-			int count = m_keymap.keyboardToKeyZone(keyCoord, r);
-			if (count > 0 && key != cKey_None)
-			{
-				if (key == Qt::Key_Shift)
-					drawKeyBackground(painter, r, keyCoord, key, false, count);
-				if (key != cKey_Trackball)
-					drawKeyCap(&painter, renderer, r, keyCoord, key, false);
-				else //Draw trackball
-					drawKeyCap(&painter, renderer, r, keyCoord, key, false);
-			}
-		}
+		QRect r;
+		if (m_keymap.keyboardToKeyZone(*iter, r) > 0)
+			drawKeyCap(&painter, renderer, r, *iter, m_keymap.map(*iter), false);
 	}
 	renderer.flush();
 	perf.trace("Draw labels");
@@ -1379,13 +1377,18 @@ void TabletKeyboard::paint(QPainter & painter)
 	}
 	m_extendedKeyShown = extendedKey;
 #if VKB_SHOW_GLYPH_CACHE
-	painter.setPen(QColor(255, 0, 0)); painter.drawRect(QRect(QPoint(0, 0), m_glyphCache.pixmap().size())); painter.drawPixmap(0, 0, m_glyphCache.pixmap());
+	for (int page = 0, x = 0; page < m_glyphCache.pageCount(); x += m_glyphCache.pixmap(page++).width())
+	{
+		painter.setPen(QColor(255, 0, 0)); painter.drawRect(QRect(QPoint(x, 0), m_glyphCache.pixmap(page).size())); painter.drawPixmap(x, 0, m_glyphCache.pixmap(page));
+	}
 #endif
 #if VKB_FORCE_FPS
 	triggerRepaint();
 #endif
-	if (renderer.getCacheMissCount() > 0 && (!m_glyphCache.isFull() || m_keymap.getCachedGlyphsCount() < 3))
+	// glyphs evicted since the last pre-rendering pass are brought back by another pass
+	if (renderer.getCacheMissCount() + layerCacheMissCount > 0 && (m_keymap.getCachedGlyphsCount() < 3 || m_glyphCache.evictionCount() != m_prerenderedEvictionCount))
 		queueIdlePrerendering();
+	m_paintTimes.addPaint(currentTimeUs() - paintStart, layerRebuilt);
 }
 
 bool TabletKeyboard::updateBackground()
@@ -1466,6 +1469,56 @@ bool TabletKeyboard::updateBackground()
 	return false;
 }
 
+bool TabletKeyboard::updateKeyboardLayer(int & outCacheMissCount)
+{
+	bool backgroundRebuilt = updateBackground();
+	if (!backgroundRebuilt && m_keyboardLayer && m_keyboardLayerBuiltVersion == m_keyboardLayerVersion)
+		return false;
+
+	const QRect & keymapFrame = m_keymap.rect();
+	QRect	keyboardFrame(keymapFrame.left(), keymapFrame.top() - m_keyboardTopPading, keymapFrame.width(), keymapFrame.height() + m_keyboardTopPading);
+	if (!m_keyboardLayer || m_keyboardLayer->size() != m_keyboardBackgound->size())
+	{
+		PixmapCache::instance().dispose(m_keyboardLayer);
+		m_keyboardLayer = PixmapCache::instance().get(m_keyboardBackgound->size());
+	}
+	QPainter	offscreenPainter(m_keyboardLayer);
+	offscreenPainter.setCompositionMode(QPainter::CompositionMode_Source);
+	offscreenPainter.drawPixmap(0, 0, *m_keyboardBackgound);
+	offscreenPainter.setCompositionMode(QPainter::CompositionMode_SourceOver);
+	offscreenPainter.translate(-keyboardFrame.left(), -keyboardFrame.top());
+	offscreenPainter.setRenderHints(cRenderHints, true);
+	m_keyboardLayerDynamicKeys.clear();
+	DoubleDrawRenderer				doubleDrawRenderer;
+	CachedGlyphRenderer<GlyphSpec>	renderer(offscreenPainter, m_glyphCache, doubleDrawRenderer, TabletKeymap::cKeymapColumns * (TabletKeymap::cKeymapRows + 1));
+	for (int y = 0; y < TabletKeymap::cKeymapRows; ++y)
+	{
+		for (int x = 0; x < TabletKeymap::cKeymapColumns; ++x)
+		{
+			QPoint	keyCoord(x, y);
+			UKey key = m_keymap.map(x, y);
+			QRect r;
+			int count = m_keymap.keyboardToKeyZone(keyCoord, r);
+			if (count > 0 && key != cKey_None)
+			{
+				// the space bar's label follows the candidates, the trackball's arrows its velocity
+				if (key == Qt::Key_Space || key == cKey_Trackball)
+				{
+					m_keyboardLayerDynamicKeys.push_back(keyCoord);
+					continue;
+				}
+				if (key == Qt::Key_Shift)
+					drawKeyBackground(offscreenPainter, r, keyCoord, key, false, count);
+				drawKeyCap(&offscreenPainter, renderer, r, keyCoord, key, false);
+			}
+		}
+	}
+	renderer.flush();
+	outCacheMissCount = renderer.getCacheMissCount();
+	m_keyboardLayerBuiltVersion = m_keyboardLayerVersion;
+	return true;
+}
+
 QPixmap & TabletKeyboard::getKeyBackground(const QPoint & keyCoord, UKey key)
 {
 	if (keyCoord.y() == 0)
@@ -1605,6 +1658,9 @@ void TabletKeyboard::drawKeyCap(QPainter * painter, GlyphRenderer<GlyphSpec> & r
 					painter->drawPixmap((int) location.left() + (location.width() - pix->width()) / 2, (int) location.top() + (location.height() - pix->height()) / 2, *pix);
 				else
 				{
+					// lit up by m_trackballVelocity, which changes with no layer invalidation: never baked
+					Q_ASSERT(painter->device() != m_keyboardLayer);
+
 					//Ball
 					painter->drawPixmap((int) location.center().x() - pix->width()/2, (int) location.center().y() - pix->height()/2, *pix);
 					
@@ -1883,8 +1939,8 @@ bool TabletKeyboard::idle()
 		updateBackground();
 		return true;
 	}
-	else if (sInitExtendedGlyphs)
-	{	// pre-render extended chars, but only once per run (they are always shown at the same size & same color)
+	else if (sInitExtendedGlyphs || m_glyphCache.evictionCount() != m_prerenderedEvictionCount)
+	{	// pre-render extended chars, but only once per run (they are always shown at the same size & same color), unless they might have been evicted
 		DoubleDrawRenderer				renderer;
 		GlyphCachePopulator<GlyphSpec>	populator(m_glyphCache, renderer);
 
@@ -1940,6 +1996,7 @@ bool TabletKeyboard::idle()
 	}
 
 	m_keymap.incCachedGlyphs();
+	m_prerenderedEvictionCount = m_glyphCache.evictionCount();
 	sCount = IMEPixmap::count();
 	m_idleInit = false;
 	//g_debug("TabletKeyboard background init complete!");
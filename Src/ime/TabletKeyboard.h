@@ -79,6 +79,12 @@ struct GlyphSpec {
 		return false;
 	}
 
+	bool operator==(const GlyphSpec & rhs) const
+	{
+		return m_fontSize == rhs.m_fontSize && m_bold == rhs.m_bold && m_frontColor.rgba() == rhs.m_frontColor.rgba() &&
+				m_backColor.rgba() == rhs.m_backColor.rgba() && m_string == rhs.m_string;
+	}
+
 	void applyFontSettings(QFont & font) const
 	{
 		font.setPixelSize(m_fontSize);
@@ -97,6 +103,11 @@ struct GlyphSpec {
 	QColor		m_backColor;
 };
 
+inline uint qHash(const GlyphSpec & spec)
+{
+	return qHash(spec.m_string) ^ (uint(spec.m_fontSize) << 20) ^ (uint(spec.m_bold) << 31) ^ spec.m_frontColor.rgba();
+}
+
 class TabletKeyboard : public VirtualKeyboard
 {
 	Q_OBJECT
@@ -179,6 +190,8 @@ protected:
 	void	draw9Tile(QPainter & painter, QRect & location, QPixmap & pixmap, bool pressed);
 	void	drawKeyCap(QPainter * painter, GlyphRenderer<GlyphSpec> & renderer, QRect location, const QPoint & keyCoord, UKey key, bool pressed);
 	bool	updateBackground();
+	bool	updateKeyboardLayer(int & outCacheMissCount);
+	void	invalidateKeyboardLayer()		{ ++m_keyboardLayerVersion; }
 	void	keyboardLayoutChanged();
 	void	handleKey(UKey key, QPointF where);
     void    sendKeyDownUp(Qt::Key key, Qt::KeyboardModifiers modifiers);
@@ -233,6 +246,11 @@ private:
 	QPixmap	*			m_keyboardBackgound;	// current keyboard, cached version using the assets below without text rendering nor shift keys.
 	int					m_keyboardLimitsVersion;// version of m_keymap limits used to build m_keyboard & m_keyboardBackground
 	bool				m_keyboardDirty;		// does m_keyboard need to be rebuilt before drawing onscreen?
+	QPixmap	*			m_keyboardLayer;		// m_keyboardBackgound with every key drawn as it looks when not pressed, labels included, except for the keys below.
+	std::vector<QPoint>	m_keyboardLayerDynamicKeys;	// keys left out of m_keyboardLayer & drawn on each paint, because they change as you type (space bar label) or move (trackball arrows)
+	int					m_keyboardLayerVersion;	// bumped whenever keys may look different: keymap, shift/symbol state, size...
+	int					m_keyboardLayerBuiltVersion;	// m_keyboardLayerVersion m_keyboardLayer was built for
+	PaintTimeCounter	m_paintTimes;
 	int					m_presetHeight[cKey_Resize_Last - cKey_Resize_First + 1];	// height in pixels for each size. Index 0 is the smallest, last index the largest
 
 	CANDIDATEBAR		m_candidateBar;
@@ -302,6 +320,7 @@ private:
 
 	NineTileSprites		m_nineTileSprites;
 	GlyphCache<GlyphSpec>	m_glyphCache;
+	int						m_prerenderedEvictionCount;	// m_glyphCache.evictionCount() when the last pre-rendering pass completed
 };
 
 }; // namespace TabletKeyboard
@@ -0,0 +1,209 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include "TouchRecording.h"
+
+#include <string.h>
+#include <glib.h>
+
+static const char kRecordingMagic[4] = { 'L', 'T', 'R', '1' };
+
+static void PrvAppendEvent(std::vector<struct input_event>& events, const struct timeval& time,
+						   int type, int code, int value)
+{
+	struct input_event ev;
+	memset(&ev, 0, sizeof(ev));
+	ev.time = time;
+	ev.type = type;
+	ev.code = code;
+	ev.value = value;
+	events.push_back(ev);
+}
+
+TouchRecorder::TouchRecorder()
+	: m_file(0)
+	, m_eventsWritten(0)
+{
+}
+
+TouchRecorder::~TouchRecorder()
+{
+	close();
+}
+
+bool TouchRecorder::open(const char* path, int displayWidth, int displayHeight)
+{
+	close();
+
+	m_file = fopen(path, "wb");
+	if (!m_file) {
+		g_warning("%s: failed to open %s", __PRETTY_FUNCTION__, path);
+		return false;
+	}
+
+	TouchRecordingHeader header;
+	memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+	header.eventSize = sizeof(struct input_event);
+	header.displayWidth = displayWidth;
+	header.displayHeight = displayHeight;
+
+	if (fwrite(&header, sizeof(header), 1, m_file) != 1) {
+		g_warning("%s: failed to write %s", __PRETTY_FUNCTION__, path);
+		close();
+		return false;
+	}
+
+	m_eventsWritten = 0;
+	return true;
+}
+
+void TouchRecorder::close()
+{
+	if (!m_file)
+		return;
+
+	fclose(m_file);
+	m_file = 0;
+}
+
+void TouchRecorder::write(const struct input_event* events, int count)
+{
+	if (!m_file || count <= 0)
+		return;
+
+	// stdio buffers this, the touch path never waits on the disk
+	if (fwrite(events, sizeof(struct input_event), count, m_file) != (size_t) count) {
+		g_warning("%s: write failed, recording stopped", __PRETTY_FUNCTION__);
+		close();
+		return;
+	}
+
+	m_eventsWritten += count;
+}
+
+TouchRecording::TouchRecording()
+	: m_displayWidth(0)
+	, m_displayHeight(0)
+{
+}
+
+bool TouchRecording::load(const char* path)
+{
+	gchar* data = 0;
+	gsize size = 0;
+
+	if (!g_file_get_contents(path, &data, &size, NULL)) {
+		g_warning("%s: failed to read %s", __PRETTY_FUNCTION__, path);
+		return false;
+	}
+
+	TouchRecordingHeader header;
+	if (size < sizeof(header)) {
+		g_free(data);
+		return false;
+	}
+
+	memcpy(&header, data, sizeof(header));
+	if (memcmp(header.magic, kRecordingMagic, sizeof(header.magic)) != 0 ||
+		header.eventSize != sizeof(struct input_event)) {
+		g_warning("%s: %s is not a touch recording for this architecture", __PRETTY_FUNCTION__, path);
+		g_free(data);
+		return false;
+	}
+
+	int count = (size - sizeof(header)) / sizeof(struct input_event);
+	const struct input_event* events = (const struct input_event*) (data + sizeof(header));
+
+	m_displayWidth = header.displayWidth;
+	m_displayHeight = header.displayHeight;
+	m_events.assign(events, events + count);
+	indexScans();
+
+	g_free(data);
+	return true;
+}
+
+void TouchRecording::setEvents(const std::vector<struct input_event>& events, int displayWidth, int displayHeight)
+{
+	m_displayWidth = displayWidth;
+	m_displayHeight = displayHeight;
+	m_events = events;
+	indexScans();
+}
+
+void TouchRecording::indexScans()
+{
+	// a trailing partial scan (recording stopped mid scan) is dropped
+	m_scanStarts.clear();
+	int start = 0;
+	for (int i = 0; i < (int) m_events.size(); i++) {
+		if (m_events[i].type == EV_SYN) {
+			m_scanStarts.push_back(start);
+			start = i + 1;
+		}
+	}
+}
+
+const struct input_event* TouchRecording::scan(int index, int& r_count) const
+{
+	int start = m_scanStarts[index];
+	int end = index + 1 < (int) m_scanStarts.size() ? m_scanStarts[index + 1] : (int) m_events.size();
+
+	// don't hand out whatever follows the last EV_SYN
+	while (end > start && m_events[end - 1].type != EV_SYN)
+		end--;
+
+	r_count = end - start;
+	return &m_events[start];
+}
+
+uint64_t TouchRecording::scanTimeUs(int index) const
+{
+	int count;
+	const struct input_event* events = scan(index, count);
+	const struct timeval& time = events[count - 1].time;
+	return (uint64_t) time.tv_sec * 1000000 + time.tv_usec;
+}
+
+void TouchRecording::appendTouch(std::vector<struct input_event>& events, const struct timeval& time,
+								 int finger, int x, int y, int pressed)
+{
+	PrvAppendEvent(events, time, EV_FINGERID, finger, finger);
+	if (pressed >= 0)
+		PrvAppendEvent(events, time, EV_KEY, BTN_TOUCH, pressed);
+	PrvAppendEvent(events, time, EV_ABS, ABS_X, x);
+	PrvAppendEvent(events, time, EV_ABS, ABS_Y, y);
+}
+
+void TouchRecording::appendGesture(std::vector<struct input_event>& events, const struct timeval& time,
+								   int gesture, int xVelocity, int yVelocity)
+{
+	PrvAppendEvent(events, time, EV_GESTURE, 0, gesture);
+	PrvAppendEvent(events, time, EV_REL, REL_X, xVelocity);
+	PrvAppendEvent(events, time, EV_REL, REL_Y, yVelocity);
+}
+
+void TouchRecording::appendSync(std::vector<struct input_event>& events, const struct timeval& time)
+{
+	PrvAppendEvent(events, time, EV_SYN, SYN_REPORT, 0);
+}
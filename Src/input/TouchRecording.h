@@ -0,0 +1,116 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef TOUCHRECORDING_H
+#define TOUCHRECORDING_H
+
+#include "Common.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/time.h>
+#include <linux/input.h>
+#include <vector>
+
+#include "HidLib.h"
+
+#ifndef EV_GESTURE
+#define EV_GESTURE 0x06
+#endif
+
+/*
+ * Binary recordings of the raw touchpanel event stream.
+ *
+ * A recording is a TouchRecordingHeader followed by struct input_events exactly as
+ * QWSHiddTpHandler::pumpHiddData() consumes them. Each finger in a scan is an EV_FINGERID (value is the
+ * finger), an optional BTN_TOUCH press or release, ABS_X and ABS_Y, and for a gesture an EV_GESTURE (value
+ * is the GestureType_t) followed by its velocity as REL_X/REL_Y. EV_SYN ends the scan. The kernel
+ * timestamps are kept, so a replay can reproduce the original pacing or compress it.
+ */
+
+struct TouchRecordingHeader
+{
+	char magic[4];				// "LTR1"
+	uint32_t eventSize;			// sizeof(struct input_event) on the device that recorded it
+	uint32_t displayWidth;
+	uint32_t displayHeight;
+};
+
+class TouchRecorder
+{
+public:
+
+	TouchRecorder();
+	~TouchRecorder();
+
+	bool open(const char* path, int displayWidth, int displayHeight);
+	void close();
+	bool isOpen() const { return m_file != 0; }
+
+	void write(const struct input_event* events, int count);
+	uint32_t eventsWritten() const { return m_eventsWritten; }
+
+private:
+
+	FILE* m_file;
+	uint32_t m_eventsWritten;
+
+	TouchRecorder(const TouchRecorder&);
+	TouchRecorder& operator=(const TouchRecorder&);
+};
+
+class TouchRecording
+{
+public:
+
+	TouchRecording();
+
+	bool load(const char* path);
+
+	int displayWidth() const { return m_displayWidth; }
+	int displayHeight() const { return m_displayHeight; }
+	const std::vector<struct input_event>& events() const { return m_events; }
+
+	// a scan is the events up to and including an EV_SYN
+	int scanCount() const { return m_scanStarts.size(); }
+	const struct input_event* scan(int index, int& r_count) const;
+	uint64_t scanTimeUs(int index) const;
+
+	// for building streams by hand
+	static void appendTouch(std::vector<struct input_event>& events, const struct timeval& time,
+							int finger, int x, int y, int pressed /* 1, 0, or -1 for neither */);
+	static void appendGesture(std::vector<struct input_event>& events, const struct timeval& time,
+							  int gesture, int xVelocity, int yVelocity);
+	static void appendSync(std::vector<struct input_event>& events, const struct timeval& time);
+
+	void setEvents(const std::vector<struct input_event>& events, int displayWidth, int displayHeight);
+
+private:
+
+	void indexScans();
+
+	int m_displayWidth;
+	int m_displayHeight;
+	std::vector<struct input_event> m_events;
+	std::vector<int> m_scanStarts;
+};
+
+#endif /* TOUCHRECORDING_H */
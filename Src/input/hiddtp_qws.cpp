@@ -25,8 +25,12 @@
 #include <sys/un.h>
 #include <errno.h>
 #include <linux/input.h>
+#include <string>
+#include <vector>
 #include <QApplication>
 #include <QDateTime>
+#include <QEventLoop>
+#include <QTimer>
 #include <QWSServer>
 #include <QInputEvent>
 #include <QTouchEvent>
@@ -39,10 +43,38 @@
 #include "Preferences.h"
 #include "Settings.h"
 #include "HostBase.h"
+#include "FrameTimings.h"
 
 // One page worth of events (4096/16)
 #define MAX_HIDD_EVENTS 256
 
+// a scan stamped further back than this (a replayed recording, a driver on another clock) is taken
+// as scanned when it's processed
+static const uint64_t kMaxScanAgeUs = 1000000;
+
+// when the touch was scanned, on FrameTimings' monotonic clock, so the resampler sees the panel's
+// own spacing between scans rather than how late each one was processed
+static uint64_t PrvScanTimeUs(const struct timeval& time)
+{
+	// the HAL doesn't say which clock it stamps scans with, the first one tells
+	static enum { ClockUnknown, ClockMonotonic, ClockOther } s_scanClock = ClockUnknown;
+
+	uint64_t now = FrameTimings::nowUs();
+	uint64_t scanned = (uint64_t) time.tv_sec * 1000000 + time.tv_usec;
+	bool recent = scanned <= now && now - scanned <= kMaxScanAgeUs;
+
+	if (G_UNLIKELY(s_scanClock == ClockUnknown)) {
+		s_scanClock = recent ? ClockMonotonic : ClockOther;
+		if (!recent)
+			g_warning("%s: touch scan times are not on the monotonic clock, resampling by processing time instead",
+					  __PRETTY_FUNCTION__);
+	}
+
+	if (s_scanClock != ClockMonotonic || !recent)
+		return now;
+	return scanned;
+}
+
 extern void qt_translateRawTouchEvent(QWidget *window, QTouchEvent::DeviceType deviceType, const QList<
 									  QTouchEvent::TouchPoint> &touchPoints);
 
@@ -67,15 +99,47 @@ void QWSHiddTpHandler::resume() {
 
 void QWSHiddTpHandler::pumpHiddData(struct input_event* inputEvents, int numEvents)
 {
-	/*
-	 *TODO: fix the unit test support
-	 */
-	/* d->parseHiddData(inputEvents, numEvents); */
+	d->parseHiddData(inputEvents, numEvents);
+}
+
+int QWSHiddTpHandler::replay(const TouchRecording& recording, int speedPercent)
+{
+	int scans = recording.scanCount();
+	if (scans == 0)
+		return 0;
+
+	uint64_t firstScanUs = recording.scanTimeUs(0);
+	uint32_t startMs = Time::curTimeMs();
+
+	std::vector<struct input_event> events;
+	for (int i = 0; i < scans; i++) {
+
+		if (speedPercent > 0) {
+			uint32_t dueMs = startMs + (uint32_t) ((recording.scanTimeUs(i) - firstScanUs) / (10 * speedPercent));
+			uint32_t nowMs = Time::curTimeMs();
+			if ((int32_t) (dueMs - nowMs) > 0) {
+				QEventLoop loop;
+				QTimer::singleShot(dueMs - nowMs, &loop, SLOT(quit()));
+				loop.exec();
+			}
+		}
+		else {
+			QCoreApplication::processEvents();
+		}
+
+		// pumpHiddData() takes the events non-const
+		int count;
+		const struct input_event* scan = recording.scan(i, count);
+		events.assign(scan, scan + count);
+		pumpHiddData(&events[0], count);
+	}
+
+	return scans;
 }
 
-void QWSHiddTpHandler::startRecording()
+void QWSHiddTpHandler::startRecording(const char* pathPrefix)
 {
-	d->startRecording();    
+	d->startRecording(pathPrefix);
 }
 
 void QWSHiddTpHandler::stopRecording()
@@ -94,6 +158,7 @@ QWSHiddTpHandlerPrivate::QWSHiddTpHandlerPrivate(QWSHiddTpHandler *h, const QStr
 	, m_sendPenCancel (false)
 	, m_isSuspended (false)
 	, m_recordFile(0)
+	, m_resampleMode(TouchResampler::ModeOff)
 {
 
 	flickGesture = new FlickGesture;
@@ -208,6 +273,9 @@ void QWSHiddTpHandlerPrivate::readHiddData() {
 
 		QList<HiddTouch> hiddTouches;
 		HiddTouch* currentTouch = 0;
+		std::vector<struct input_event> recordedEvents;
+		timeval scanTime;
+		Time::curTime(&scanTime);
     
 		for (int j=0; j<count; j++)
 		{
@@ -241,6 +309,24 @@ void QWSHiddTpHandlerPrivate::readHiddData() {
 			{
 				currentTouch->state = FingerUp;
 			}
+
+			scanTime = time;
+			if (m_recorder.isOpen())
+			{
+				TouchRecording::appendTouch(recordedEvents, time, touch->finger, touch->x, touch->y,
+											currentTouch->state == FingerDown ? 1 :
+											currentTouch->state == FingerUp ? 0 : -1);
+				if (currentTouch->gestureKey != Qt::Key_unknown)
+					TouchRecording::appendGesture(recordedEvents, time, touch->gestureKey,
+												  touch->xVelocity, touch->yVelocity);
+			}
+		}
+
+		// in the same form pumpHiddData() takes, so the recording can be replayed through it
+		if (m_recorder.isOpen())
+		{
+			TouchRecording::appendSync(recordedEvents, scanTime);
+			m_recorder.write(&recordedEvents[0], recordedEvents.size());
 		}
     
 		hal_device_release_event(m_halPenHandle, event_handle);
@@ -260,6 +346,60 @@ void QWSHiddTpHandlerPrivate::readHiddData() {
 	}
 }
 
+void QWSHiddTpHandlerPrivate::parseHiddData(struct input_event* inputEvents, int numEvents)
+{
+	if (m_recorder.isOpen())
+		m_recorder.write(inputEvents, numEvents);
+
+	QList<HiddTouch> hiddTouches;
+	HiddTouch* currentTouch = 0;
+
+	for (int i = 0; i < numEvents; i++) {
+
+		struct input_event* ev = &inputEvents[i];
+		switch (ev->type) {
+		case EV_FINGERID:
+			hiddTouches.append(HiddTouch());
+			currentTouch = &hiddTouches[hiddTouches.size()-1];
+			currentTouch->hiddId = ev->value;
+			currentTouch->time = ev->time;
+			break;
+		case EV_KEY:
+			if (currentTouch && ev->code == BTN_TOUCH)
+				currentTouch->state = ev->value ? FingerDown : FingerUp;
+			break;
+		case EV_ABS:
+			if (!currentTouch)
+				break;
+			if (ev->code == ABS_X)
+				currentTouch->x = ev->value;
+			else if (ev->code == ABS_Y)
+				currentTouch->y = ev->value;
+			break;
+		case EV_REL:
+			if (!currentTouch)
+				break;
+			if (ev->code == REL_X)
+				currentTouch->xVelocity = ev->value;
+			else if (ev->code == REL_Y)
+				currentTouch->yVelocity = ev->value;
+			break;
+		case EV_GESTURE:
+			if (currentTouch)
+				currentTouch->gestureKey = lookupGesture(ev->value);
+			break;
+		case EV_SYN:
+			// end of a TP scan, same as a HAL event in readHiddData()
+			updateTouchEvents(hiddTouches);
+			hiddTouches.clear();
+			currentTouch = 0;
+			break;
+		default:
+			break;
+		}
+	}
+}
+
 bool QWSHiddTpHandlerPrivate::updateTouchEvents(QList<QWSHiddTpHandlerPrivate::HiddTouch>& hiddTouches) 
 {
 	bool triggerTouchEvent = false;
@@ -491,6 +631,7 @@ void QWSHiddTpHandlerPrivate::addNewTouch(QWSHiddTpHandlerPrivate::HiddTouch& to
 	}
 
 	m_touches.insert(m_touches.begin(), touch); // inserting latest touch at head
+	m_resampler.addSample(touch.id, PrvScanTimeUs(touch.time), touch.x, touch.y);
 
 	// cache the last primary finger down
 	m_lastTouchDown = QPoint(touch.x, touch.y);
@@ -515,6 +656,7 @@ bool QWSHiddTpHandlerPrivate::updateOldTouch(QWSHiddTpHandlerPrivate::HiddTouch&
 
 	it->seenInScan = true;
 	it->time = touch.time;
+	it->settling = false;
 
 	if (touch.state == FingerUp) {
 		it->state = touch.state;
@@ -526,10 +668,20 @@ bool QWSHiddTpHandlerPrivate::updateOldTouch(QWSHiddTpHandlerPrivate::HiddTouch&
 		it->y = touch.y;
 		updated = true;
 	}
+	else if (it->shownAhead) {
+		// the finger stopped short of where the last move was drawn, one more move puts it back
+		it->state = FingerMove;
+		it->settling = true;
+		updated = true;
+	}
 	else {
 		it->state = FingerNoMove;
 	}
 
+	// a scan where the finger held still is history too, it brings the velocity down
+	if (it->state != FingerUp)
+		m_resampler.addSample(it->id, PrvScanTimeUs(it->time), it->x, it->y);
+
 	// updates do not modify id as this is assigned in addNewTouch
 	// updates do not modify isPrimary as this is marked in addNewTouch and removeReleasedTouches
 
@@ -549,6 +701,7 @@ void QWSHiddTpHandlerPrivate::removeReleasedTouches() {
 		if (it->state == FingerUp) {
 			if (it->isPrimary)
 				markNewPrimary = true;
+			m_resampler.removeTouch(it->id);
 			it = m_touches.erase(it); // dont increment as erase will return the next item
 		} else {
 			++it;
@@ -568,7 +721,11 @@ void QWSHiddTpHandlerPrivate::generateTouchEvent()
 		return;
 	
 	QList<QTouchEvent::TouchPoint> touchPoints;
-	QList<HiddTouch>::const_iterator it;
+	QList<HiddTouch>::iterator it;
+
+	// moves are drawn where the finger will be when the frame they cause is shown, not where it was
+	// scanned; the raw positions in m_touches stay as they are for the next scan's comparisons
+	uint64_t frameUs = FrameTimings::instance()->nextFrameUs(FrameTimings::nowUs());
 
 	QWidget* widget = QWidget::mouseGrabber();
 	if (!widget) {
@@ -598,7 +755,16 @@ void QWSHiddTpHandlerPrivate::generateTouchEvent()
 	for (it = m_touches.begin(); it != m_touches.end(); ++it) {
 		QTouchEvent::TouchPoint touchPoint;
 		touchPoint.setId(it->id);
-		touchPoint.setPos(QPoint(it->x, it->y));
+
+		QPoint pos(it->x, it->y);
+		int resampledX, resampledY;
+		if (it->state == QWSHiddTpHandlerPrivate::FingerMove && !it->settling &&
+			m_resampler.resample(it->id, frameUs, m_resampleMode, resampledX, resampledY)) {
+			pos = QPoint(resampledX, resampledY);
+		}
+		if (it->state == QWSHiddTpHandlerPrivate::FingerMove)
+			it->shownAhead = pos != QPoint(it->x, it->y);
+		touchPoint.setPos(pos);
 
 		touchPoint.setScreenPos(touchPoint.pos());
 		switch (it->state) {
@@ -626,7 +792,7 @@ void QWSHiddTpHandlerPrivate::generateTouchEvent()
 
 		if (it->isPrimary) {
 
-			QPoint mousePos = QPoint(it->x, it->y);
+			QPoint mousePos = pos;
 			if (widget) {
 				
 				if (it->state == QWSHiddTpHandlerPrivate::FingerDown) {
@@ -654,6 +820,8 @@ void QWSHiddTpHandlerPrivate::generateTouchEvent()
 						m_mousePress = mousePos;
 						m_mousePressTime = currTime;
 					}
+
+					m_resampleMode = TouchResampler::currentMode();
 				} else if (it->state == QWSHiddTpHandlerPrivate::FingerMove) {
 					//printf("Mouse Move: %d, %d\n", mousePos.x(), mousePos.y());
 					QMouseEvent ev(QEvent::MouseMove, mousePos, mousePos,
@@ -664,6 +832,8 @@ void QWSHiddTpHandlerPrivate::generateTouchEvent()
 		}
 	}
 	
+	FrameTimings::instance()->touchDispatched();
+
 	//printf ("sending touch event\n");
 	qt_translateRawTouchEvent(QApplication::activeWindow(), QTouchEvent::TouchScreen, touchPoints);
 
@@ -693,21 +863,32 @@ gboolean QWSHiddTpHandlerPrivate::ioCallback(GIOChannel* channel, GIOCondition c
 	return TRUE;
 }
 
-void QWSHiddTpHandlerPrivate::startRecording()
+void QWSHiddTpHandlerPrivate::startRecording(const char* pathPrefix)
 {
 	if (m_recordFile) {
 		fclose(m_recordFile);
 		m_recordFile = 0;
 	}
 
-	QDateTime now = QDateTime::currentDateTime();
-	QString nowString = now.toString(Qt::ISODate);
+	std::string fileName;
+	if (pathPrefix) {
+		fileName = pathPrefix;
+	}
+	else {
+		QDateTime now = QDateTime::currentDateTime();
+		QString nowString = now.toString(Qt::ISODate);
+		fileName = std::string("/var/log/sysmgr-tp.") + nowString.toUtf8().data();
+	}
 
-	char fileName[128];
-	sprintf(fileName, "/var/log/sysmgr-tp.%s", nowString.toUtf8().data());
+	std::string eventsFileName = fileName + ".events";
+	m_recorder.open(eventsFileName.c_str(), m_deviceWidth, m_deviceHeight);
+
+	m_recordFile = fopen(fileName.c_str(), "w");
+	if (!m_recordFile)
+		return;
 
-	m_recordFile = fopen(fileName, "w");
 	fprintf(m_recordFile, "Start Recording....\n");
+	fprintf(m_recordFile, "Raw events: %s\n", eventsFileName.c_str());
 	fprintf(m_recordFile, "Initial State: \n");
 	fprintf(m_recordFile, "Num touches: %d, Num Meta touches: %d\n", m_touches.size(), m_metaActiveTouchesCount);
 			
@@ -722,9 +903,13 @@ void QWSHiddTpHandlerPrivate::startRecording()
 
 void QWSHiddTpHandlerPrivate::stopRecording()
 {
+	uint32_t eventsWritten = m_recorder.eventsWritten();
+	m_recorder.close();
+
 	if (!m_recordFile)
 		return;
 
+	fprintf(m_recordFile, "Raw events recorded: %u\n", eventsWritten);
 	fprintf(m_recordFile, "Final State: \n");
 	fprintf(m_recordFile, "Num touches: %d, Num Meta touches: %d\n", m_touches.size(), m_metaActiveTouchesCount);
 			
@@ -34,6 +34,8 @@
 #include "HidLib.h"
 #include "FlickGesture.h"
 #include "ScreenEdgeFlickGesture.h"
+#include "TouchRecording.h"
+#include "TouchResampler.h"
 #include <hal/hal.h>
 
 #define EV_GESTURE 0x06
@@ -66,7 +68,13 @@ public:
 	void suspend();
 	void resume();
 	void pumpHiddData(struct input_event* inputEvents, int numEvents);
-	void startRecording();
+
+	// feeds the recorded scans to pumpHiddData(), spaced as recorded at speedPercent 100, faster above
+	// that, and back to back at 0; the event loop runs in between so gesture timers still fire
+	int replay(const TouchRecording& recording, int speedPercent);
+
+	// pathPrefix gets the touch state at start and stop as text, pathPrefix.events the raw events
+	void startRecording(const char* pathPrefix = 0);
 	void stopRecording();
 	
 protected:
@@ -84,7 +92,7 @@ public:
 	int setupHiddSocket(const char* path);
 	void parseHiddData(struct input_event* inputEvents, int numEvents);
 
-	void startRecording();
+	void startRecording(const char* pathPrefix);
 	void stopRecording();
 
 	void enableScreenEdgeGesture();
@@ -116,6 +124,8 @@ private:
 		bool isPrimary;
 		bool isMetaTouch;
 		bool seenInScan;
+		bool shownAhead;	// the last move was drawn at a resampled position, not at x, y
+		bool settling;		// this move only takes the finger back to x, y, it is not resampled
 
 		HiddTouch() {
 		    reset();
@@ -137,6 +147,8 @@ private:
 		    yVelocity = 0;
 		    isMetaTouch = false;
 			seenInScan = false;
+			shownAhead = false;
+			settling = false;
 		}
 	};
 
@@ -157,6 +169,9 @@ private:
 
 	bool m_isSuspended;
 	FILE* m_recordFile;
+	TouchRecorder m_recorder;
+	TouchResampler m_resampler;
+	TouchResampler::Mode m_resampleMode;	// decided by whatever took the last primary press
 	bool m_enableScreenEdgeGesture;
 
 	bool updateTouchEvents(QList<HiddTouch>& hiddTouches);
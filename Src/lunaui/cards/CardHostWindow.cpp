@@ -38,6 +38,7 @@
 #include "WindowServer.h"
 #include "WindowServerLuna.h"
 #include "AppDirectRenderingArbitrator.h"
+#include "RoundedCornerCompositor.h"
 
 #define MESSAGES_INTERNAL_FILE "SysMgrMessagesInternal.h"
 #include <PIpcMessageMacros.h>
@@ -153,8 +154,7 @@ void CardHostWindow::resizeWindowBufferEvent(int w, int h, QRect windowScreenBou
 			setMaximized(false); // disable direct rendering for the resize event
 		setBoundingRect(windowScreenBounds.width(), windowScreenBounds.height());
 
-		m_paintPath = QPainterPath();
-		m_paintPath.addRoundedRect(m_boundingRect, 25, 25);
+		setPaintPath(m_boundingRect, 25, 25);
 
 		// reconstruct shadow
 		CardDropShadowEffect* shadow = static_cast<CardDropShadowEffect*>(graphicsEffect());
@@ -442,7 +442,8 @@ void CardHostWindow::paintBase(QPainter* painter, bool maximized)
 			painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
 			painter->fillRect(boundingRect(), *m_data->acquireTransitionPixmap());
 		} else {
-			painter->fillPath(m_paintPath, *m_data->acquireTransitionPixmap());
+			RoundedCornerCompositor::draw(painter, m_paintRect, m_paintRadiusX, m_paintRadiusY,
+										  *m_data->acquireTransitionPixmap(), targetRect.topLeft());
 		}
 
 		if (G_LIKELY(maximized))
@@ -462,17 +463,16 @@ void CardHostWindow::paintBase(QPainter* painter, bool maximized)
 			const QPixmap* pix = acquireScreenPixmap();
 			if (pix) {
 				QRectF brect = boundingRect();
-				QPainterPath paintPath;
+				QRectF paintRect;
 
                                 initializeRoundedCornerStage();
 
                                 painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
 
 				if (m_adjustmentAngle == 90 || m_adjustmentAngle == -90) {
-					QRectF rotRect = QRectF(brect.y(), brect.x(), brect.height(), brect.width());
-					paintPath.addRoundedRect(rotRect, 25, 25);
+					paintRect = QRectF(brect.y(), brect.x(), brect.height(), brect.width());
 				} else {
-					paintPath.addRoundedRect(m_boundingRect, 25, 25);
+					paintRect = m_boundingRect;
 				}
 
 				int originX = brect.x();
@@ -483,15 +483,14 @@ void CardHostWindow::paintBase(QPainter* painter, bool maximized)
 					originY = brect.x();
 				}
 
+				QPointF origin(originX, originY);
 				if (fullScreen()) {
 					if (m_adjustmentAngle == 90 || m_adjustmentAngle == -90) {
-						painter->setBrushOrigin(originX - (pix->width()-brect.height())/2, originY);
+						origin = QPointF(originX - (pix->width()-brect.height())/2, originY);
 					} else {
-						painter->setBrushOrigin(originX, originY - (pix->height() - brect.height()) / 2);
+						origin = QPointF(originX, originY - (pix->height() - brect.height()) / 2);
 					}
 				}
-				else
-					painter->setBrushOrigin(originX, originY);
                                 painter->rotate(m_adjustmentAngle);
 #if defined(USE_ROUNDEDCORNER_SHADER)
                                 m_roundedCornerShaderStage->setOnPainter(painter);
@@ -503,10 +502,9 @@ void CardHostWindow::paintBase(QPainter* painter, bool maximized)
                                 }
                                 m_roundedCornerShaderStage->removeFromPainter(painter);
 #else
-                                painter->fillPath(paintPath, *pix);
+                                RoundedCornerCompositor::draw(painter, paintRect, 25, 25, *pix, origin);
 #endif
                                 painter->rotate(-m_adjustmentAngle);
-				painter->setBrushOrigin(0, 0);
 			}
 		}
 	}
@@ -2579,7 +2579,7 @@ void CardWebApp::thawFromCache()
 	// which may indirectly rely on timers working.
 	m_page->webkitPage()->throttle(100, 0);
 
-	WebAppCache::remove(this);
+	WebAppCache::take(this);
 	m_page->webkitPage()->evaluateScript("if (window.Mojo && Mojo.show) Mojo.show()");
 
 	g_message("THAWING app %s", m_page->appId().c_str());
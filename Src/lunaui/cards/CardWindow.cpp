@@ -64,6 +64,7 @@
 #include "WindowServer.h"
 #include "GhostCard.h"
 #include "QtUtils.h"
+#include "RoundedCornerCompositor.h"
 
 #include <SysMgrDefs.h>
 #include <QGestureEvent>
@@ -112,6 +113,8 @@ CardWindow::CardWindow(Window::Type type, HostWindowData* data, IpcClientHost* c
 	, m_transition(0)
 	, m_transitionTimer(HostBase::instance()->masterTimer(), this, &CardWindow::transitionTimerTicked)
     , m_splashBackgroundName()
+	, m_paintRadiusX(0)
+	, m_paintRadiusY(0)
 	, m_compMode(QPainter::CompositionMode_Source)
 	, m_group(0)
 	, m_attachedToGroup(true)
@@ -155,6 +158,8 @@ CardWindow::CardWindow(Window::Type type, const QPixmap& pixmap)
 	, m_transition(0)
 	, m_transitionTimer(HostBase::instance()->masterTimer(), this, &CardWindow::transitionTimerTicked)
 	, m_splashBackgroundName()
+	, m_paintRadiusX(0)
+	, m_paintRadiusY(0)
 	, m_compMode(QPainter::CompositionMode_Source)
 	, m_group(0)
 	, m_attachedToGroup(true)
@@ -182,7 +187,7 @@ CardWindow::CardWindow(Window::Type type, const QPixmap& pixmap)
 
 void CardWindow::init()
 {
-	setFlags(QGraphicsItem::ItemIsFocusable);
+	setFlag(QGraphicsItem::ItemIsFocusable);
 	grabGesture((Qt::GestureType) SysMgrGestureFlick);
 	grabGesture((Qt::GestureType) SysMgrGestureSingleClick);
 	grabGesture(Qt::PinchGesture);
@@ -916,12 +921,10 @@ void CardWindow::queueUpWindowForFlip(QRect windowScreenBounds, bool sync)
 		trans.rotate( - SystemUiController::instance()->getRotationAngle());
 		m_tempRotatedBrush.setTransform(trans);
 
-		m_paintPath = QPainterPath();
-
 		if ((m_adjustmentAngle != 90 && m_adjustmentAngle != -90) || this->type() == Window::Type_Emulated_Card){
-			m_paintPath.addRoundedRect(boundingRect(), 25, 25);
+			setPaintPath(boundingRect(), 25, 25);
 		} else {
-			m_paintPath.addRoundedRect(QRectF(m_boundingRect.y(), m_boundingRect.x(), m_boundingRect.height(), m_boundingRect.width()), 25, 25);
+			setPaintPath(QRectF(m_boundingRect.y(), m_boundingRect.x(), m_boundingRect.height(), m_boundingRect.width()), 25, 25);
 		}
 	}
 
@@ -949,8 +952,7 @@ void CardWindow::queuedFlipCanceled(QRect windowScreenBounds)
 	m_boundingRect = m_preFlipBoundingRect;
 
 	//restore the paint path to what it was, in case it got changed
-	m_paintPath = QPainterPath();
-	m_paintPath.addRoundedRect(boundingRect(), 25, 25);
+	setPaintPath(boundingRect(), 25, 25);
 
 	m_isResizing = false;
 	m_flipsQueuedUp--;
@@ -1583,17 +1585,25 @@ void CardWindow::setVisibleDimensions(int width, int height)
 	if (shadow)
 		shadow->cacheDrawingData();
 
-	m_paintPath = QPainterPath();
-
 	if ((m_adjustmentAngle != 90 && m_adjustmentAngle != -90) || (this->type() == Window::Type_Emulated_Card || this->type() == Window::Type_ModalChildWindowCard)) {
-                m_paintPath.addRoundedRect(boundingRect(), 8, 6); //where you alter the loading rect stuff
+                setPaintPath(boundingRect(), 8, 6); //where you alter the loading rect stuff
 	} else {
-		m_paintPath.addRoundedRect(QRectF(m_boundingRect.y(), m_boundingRect.x(), m_boundingRect.height(), m_boundingRect.width()), 25, 25);
+		setPaintPath(QRectF(m_boundingRect.y(), m_boundingRect.x(), m_boundingRect.height(), m_boundingRect.width()), 25, 25);
 	}
 
 	initializeRoundedCornerStage();
 }
 
+void CardWindow::setPaintPath(const QRectF& rect, qreal xRadius, qreal yRadius)
+{
+	m_paintPath = QPainterPath();
+	m_paintPath.addRoundedRect(rect, xRadius, yRadius);
+
+	m_paintRect = rect;
+	m_paintRadiusX = xRadius;
+	m_paintRadiusY = yRadius;
+}
+
 void CardWindow::setPaintCompositionMode(QPainter::CompositionMode mode)
 {
 	m_compMode = mode;
@@ -1663,7 +1673,8 @@ void CardWindow::paintBase(QPainter* painter, bool maximized)
 			painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
 			painter->fillRect(boundingRect(), *m_data->acquireTransitionPixmap());
 		} else {
-			painter->fillPath(m_paintPath, *m_data->acquireTransitionPixmap());
+			RoundedCornerCompositor::draw(painter, m_paintRect, m_paintRadiusX, m_paintRadiusY,
+										  *m_data->acquireTransitionPixmap(), targetRect.topLeft());
 		}
 
 		if (G_LIKELY(maximized))
@@ -1735,34 +1746,38 @@ void CardWindow::paintBase(QPainter* painter, bool maximized)
 
 				} else {
 #endif
+					QPointF origin;
 					if(m_adjustmentAngle) {
 
 						painter->rotate(m_adjustmentAngle);
 						if (m_adjustmentAngle == 90 || m_adjustmentAngle == -90){
 							if (fullScreen())
-								painter->setBrushOrigin(brect.y(), brect.x() - (pix->height() - brect.height()) / 2);
+								origin = QPointF(brect.y(), brect.x() - (pix->height() - brect.height()) / 2);
 							else
-								painter->setBrushOrigin(brect.y(), brect.x());
+								origin = QPointF(brect.y(), brect.x());
 						} else {
 							if (fullScreen())
-								painter->setBrushOrigin(brect.x(), brect.y() - (pix->height() - brect.height()) / 2);
+								origin = QPointF(brect.x(), brect.y() - (pix->height() - brect.height()) / 2);
 							else
-								painter->setBrushOrigin(brect.x(), brect.y());
+								origin = QPointF(brect.x(), brect.y());
 						}
 					} else {
 						if (fullScreen())
-							painter->setBrushOrigin(brect.x(), brect.y() - (pix->height() - brect.height()) / 2);
+							origin = QPointF(brect.x(), brect.y() - (pix->height() - brect.height()) / 2);
 						else
-							painter->setBrushOrigin(brect.x(), brect.y());
+							origin = QPointF(brect.x(), brect.y());
 					}
 
 					if(!m_isResizing) {
-						painter->fillPath(m_paintPath, *pix);
+						// plain blits plus four small masked corners, instead of a path fill over the whole card
+						RoundedCornerCompositor::draw(painter, m_paintRect, m_paintRadiusX, m_paintRadiusY, *pix, origin);
 					} else {
+						// the brush is rotated against the card while resizing, so that still needs the path fill
+						painter->setBrushOrigin(origin);
 						painter->fillPath(m_paintPath, m_tempRotatedBrush);
+						painter->setBrushOrigin(0, 0);
 					}
 
-					painter->setBrushOrigin(0, 0);
 					if(m_adjustmentAngle)
 						painter->rotate(-m_adjustmentAngle);
 #if defined(USE_ROUNDEDCORNER_SHADER)
@@ -294,6 +294,9 @@ protected:
 
     virtual void initializeRoundedCornerStage();
 
+	// m_paintPath, plus the rect and radii it was made of for RoundedCornerCompositor
+	void setPaintPath(const QRectF& rect, qreal xRadius, qreal yRadius);
+
 	bool isInValidOrientation();
 
 protected:
@@ -356,6 +359,9 @@ protected:
 	std::string m_splashBackgroundName;
 
 	QPainterPath m_paintPath;
+	QRectF m_paintRect;
+	qreal m_paintRadiusX;
+	qreal m_paintRadiusY;
 	QPainter::CompositionMode m_compMode;
 
 	Position m_position;
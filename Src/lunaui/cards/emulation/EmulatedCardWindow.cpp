@@ -333,8 +333,7 @@ void EmulatedCardWindow::resizeWindowBufferEvent(int w, int h, QRect windowScree
 		setBoundingRect(windowScreenBounds.width(), windowScreenBounds.height());
 		setVisibleDimensions(windowScreenBounds.width(), windowScreenBounds.height());
 
-		m_paintPath = QPainterPath();
-		m_paintPath.addRoundedRect(m_boundingRect, 25, 25);
+		setPaintPath(m_boundingRect, 25, 25);
 
 		// reconstruct shadow
 		CardDropShadowEffect* shadow = static_cast<CardDropShadowEffect*>(graphicsEffect());
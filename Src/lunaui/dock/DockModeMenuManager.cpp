@@ -187,7 +187,7 @@ void DockModeMenuManager::activateAppMenu(bool open)
 	SystemUiController::instance()->setMenuVisible (open);
 
 	if (open) {
-		m_statusBar->setMaximizedAppTitle (true, LOCALIZED("Choose an App").c_str());
+		m_statusBar->setMaximizedAppTitle (true, LOCALIZED_REF("Choose an App").data());
 	}
 	else {
 		m_statusBar->setMaximizedAppTitle (true, m_currentApp.c_str());
@@ -46,6 +46,68 @@ PixPagerDebugger::PixPagerDebugger(PixPager * target)
 {
 }
 
+PixPagerDebugger::OccupancyStats::OccupancyStats()
+: maxBytes(0)
+, currentBytes(0)
+, regularPages(0)
+, regularBytes(0)
+, atlasPages(0)
+, atlasBytes(0)
+, atlasCells(0)
+, atlasCellsOccupied(0)
+, pinnedPages(0)
+, pinnedBytes(0)
+, coldUnpinnedPages(0)
+, evictedPages(0)
+, evictedBytes(0)
+, coldUnpins(0)
+, compactions(0)
+, compactedBytes(0)
+{
+}
+
+bool PixPagerDebugger::occupancyStats(OccupancyStats& r_stats) const
+{
+	if (m_qp_target.isNull())
+		return false;
+
+	r_stats = OccupancyStats();
+	r_stats.maxBytes = m_qp_target->m_maxSizeInBytes;
+	r_stats.currentBytes = m_qp_target->m_currentSizeInBytes;
+	r_stats.evictedPages = m_qp_target->m_evictedPages;
+	r_stats.evictedBytes = m_qp_target->m_evictedBytes;
+	r_stats.coldUnpins = m_qp_target->m_coldUnpins;
+	r_stats.compactions = m_qp_target->m_compactions;
+	r_stats.compactedBytes = m_qp_target->m_compactedBytes;
+
+	for (QHash<QUuid,PixPagerPage *>::const_iterator it = m_qp_target->m_pageCache.constBegin();
+			it != m_qp_target->m_pageCache.constEnd(); ++it)
+	{
+		PixPagerPage * pPage = it.value();
+		PixPagerAtlasPage * pAtlasPage = qobject_cast<PixPagerAtlasPage *>(pPage);
+		if (pAtlasPage)
+		{
+			++r_stats.atlasPages;
+			r_stats.atlasBytes += pPage->m_sizeInBytes;
+			r_stats.atlasCells += pAtlasPage->m_rows * pAtlasPage->m_columns;
+			r_stats.atlasCellsOccupied += pAtlasPage->m_directory.size();
+			if (pAtlasPage->m_unpinnedWhenCold)
+				++r_stats.coldUnpinnedPages;
+		}
+		else
+		{
+			++r_stats.regularPages;
+			r_stats.regularBytes += pPage->m_sizeInBytes;
+		}
+		if (pPage->m_pinned)
+		{
+			++r_stats.pinnedPages;
+			r_stats.pinnedBytes += pPage->m_sizeInBytes;
+		}
+	}
+	return true;
+}
+
 QTextStream& operator<<(QTextStream& stream,const PixPagerPage::PixmapRects& r)
 {
 	stream << "[ " << r.coordinateRect.topRight().x()
@@ -115,6 +177,16 @@ void PixPagerDebugger::dumpPagesAsImagesToDisk(bool includeRegularPages,bool inc
 	infoFileOut << "Pager Max Size: " << m_qp_target->m_maxSizeInBytes << "\n";
 	infoFileOut << "Pager Current Size: " << m_qp_target->m_currentSizeInBytes << "\n";
 	infoFileOut << "Pager Access Count: " << m_qp_target->m_accessCounter << "\n";
+	OccupancyStats stats;
+	occupancyStats(stats);
+	infoFileOut << "Regular pages: " << stats.regularPages << " (" << stats.regularBytes << " bytes)"
+				<< " Atlas pages: " << stats.atlasPages << " (" << stats.atlasBytes << " bytes)\n";
+	infoFileOut << "Atlas cells occupied: " << stats.atlasCellsOccupied << " / " << stats.atlasCells << "\n";
+	infoFileOut << "Pinned pages: " << stats.pinnedPages << " (" << stats.pinnedBytes << " bytes)"
+				<< " cold (unpinned) atlas pages: " << stats.coldUnpinnedPages << "\n";
+	infoFileOut << "Evicted: " << stats.evictedPages << " pages, " << stats.evictedBytes << " bytes"
+				<< " Cold unpins: " << stats.coldUnpins
+				<< " Compactions: " << stats.compactions << " (" << stats.compactedBytes << " bytes reclaimed)\n";
 	infoFileOut << "\n--Page Stats--\n\n";
 	//walk the pager's pages and create images for all the pages
 	for (QHash<QUuid,PixPagerPage *>::const_iterator it = m_qp_target->m_pageCache.constBegin();
@@ -132,7 +204,8 @@ void PixPagerDebugger::dumpPagesAsImagesToDisk(bool includeRegularPages,bool inc
 		infoFileOut << " size: " << pPage->m_sizeInBytes;
 		infoFileOut << " pinned: " << (pPage->m_pinned ? "true" : "false") << "\n";
 		infoFileOut << " access count: " << pPage->m_accessCounter
-					<< " access r-frequency: " << pPage->m_accessFrequency;
+					<< " access r-frequency: " << pPage->m_accessFrequency
+					<< " heat: " << pPage->heatAt(m_qp_target->m_accessCounter);
 		if (pPage->m_data.isNull() == false)
 		{
 			infoFileOut << " pixmap dimensions: " << pPage->m_data->size();
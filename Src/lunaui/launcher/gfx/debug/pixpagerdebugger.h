@@ -32,6 +32,32 @@ class PixPagerDebugger : public QObject
 public:
 	static PixPagerDebugger * newDebugger(PixPager * target);
 
+	class OccupancyStats
+	{
+	public:
+		OccupancyStats();
+		quint32 maxBytes;
+		quint32 currentBytes;
+		quint32 regularPages;
+		quint32 regularBytes;
+		quint32 atlasPages;
+		quint32 atlasBytes;
+		quint32 atlasCells;
+		quint32 atlasCellsOccupied;
+		quint32 pinnedPages;
+		quint32 pinnedBytes;
+		quint32 coldUnpinnedPages;		//atlas pages currently unpinned because they went cold
+		//since the pager was created
+		quint32 evictedPages;
+		quint32 evictedBytes;
+		quint32 coldUnpins;
+		quint32 compactions;
+		quint32 compactedBytes;
+	};
+
+	//false if the target pager is gone
+	bool occupancyStats(OccupancyStats& r_stats) const;
+
 	void dumpPagesAsImagesToDisk(bool includeRegularPages=true,bool includeAtlasPages=true);
 
 private:
@@ -43,6 +43,8 @@ PixPagerPage::PixPagerPage(PixPager * p_pager)
 , m_sizeInBytes(0)
 , m_accessCounter(0)
 , m_accessFrequency(0.0)
+, m_lastAccess(p_pager ? p_pager->m_accessCounter : 0)
+, m_heat(1.0)			//a new page counts as one access, so it isn't the first thing evicted
 , m_initiatedDelete(false)
 {
 }
@@ -54,6 +56,21 @@ PixPagerPage::~PixPagerPage()
 	delete m_data;
 }
 
+qreal PixPagerPage::heatAt(quint32 now) const
+{
+	//unsigned difference, so this is fine across the pager's access counter wrapping
+	const quint32 age = now - m_lastAccess;
+	if (age == 0)
+		return m_heat;
+	return m_heat * qPow(0.5,(qreal)age / (qreal)PIXPAGER_HEAT_HALFLIFE);
+}
+
+void PixPagerPage::touch(quint32 now)
+{
+	m_heat = heatAt(now) + 1.0;
+	m_lastAccess = now;
+}
+
 void PixPagerPage::slotPixmapObjectDeleted()
 {
 	if (m_initiatedDelete)
@@ -80,6 +97,7 @@ PixPagerAtlasPage::PixPagerAtlasPage(PixPager * p_pager,quint32 sizeDesignation,
 , m_interRowPixelSpace(DEFAULT_ATLAS_PAGE_INTERROW_SPACE)
 , m_interColPixelSpace(DEFAULT_ATLAS_PAGE_INTERCOL_SPACE)
 , m_lastPositionAllocated(INVALID_LOCATION)
+, m_unpinnedWhenCold(false)
 {
 	m_pinned = true;
 	if (p_directory)
@@ -103,6 +121,19 @@ QRect PixPagerAtlasPage::targetRectForGridCoordinates(const QPair<quint32,quint3
 	));
 }
 
+bool PixPagerAtlasPage::gridCoordinatesForTargetRect(const QRect& targetRect,QPair<quint32,quint32>& r_gridCoordinates) const
+{
+	if ((targetRect.x() < (int)m_xLeadingPixelSpace) || (targetRect.y() < (int)m_yLeadingPixelSpace))
+		return false;
+	const QPair<quint32,quint32> gridCoordinates(
+			(targetRect.x()-m_xLeadingPixelSpace) / (m_pixmapSqSize+m_interColPixelSpace),
+			(targetRect.y()-m_yLeadingPixelSpace) / (m_pixmapSqSize+m_interRowPixelSpace));
+	if (targetRectForGridCoordinates(gridCoordinates) != targetRect)
+		return false;
+	r_gridCoordinates = gridCoordinates;
+	return true;
+}
+
 ///////////////////////////////////// PixPager code //////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
@@ -110,8 +141,16 @@ QRect PixPagerAtlasPage::targetRectForGridCoordinates(const QPair<quint32,quint3
 PixPager::PixPager()
 : m_currentSizeInBytes(0)
 , m_accessCounter(0)
+, m_evictedPages(0)
+, m_evictedBytes(0)
+, m_coldUnpins(0)
+, m_compactions(0)
+, m_compactedBytes(0)
 {
 	m_maxSizeInBytes = GraphicsSettings::DiUiGraphicsSettings()->totalCacheSizeLimitInBytes;
+	m_maintenanceTimer.setSingleShot(true);
+	m_maintenanceTimer.setInterval(PIXPAGER_MAINTENANCE_INTERVAL_MS);
+	connect(&m_maintenanceTimer,SIGNAL(timeout()),this,SLOT(slotMaintenance()));
 }
 
 //virtual
@@ -134,23 +173,12 @@ void PixPager::_pagePixmapDeleted(PixPagerPage * p_page)
 	//see if it's an atlas page first
 	PixPagerAtlasPage * p_atlasPage = qobject_cast<PixPagerAtlasPage *>(p_page);
 	if (p_atlasPage)
-	{
-		//remove from aliased hash
-		m_atlasPages_alias.remove(p_atlasPage->m_pixmapSqSize);
-		//run through the hash with the individual icon uid keys and remove the entries that have this page as the value
-		QMutableHashIterator<QUuid, PixPagerPage *> i(m_atlasPagesByIndividualUids_alias);
-		while (i.hasNext()) {
-			i.next();
-			if (i.value() == p_page)
-				i.remove();
-		}
-	}
+		_removeAtlasAliases(p_atlasPage);
 
 	//remove from the master hash (the actual cache)
 	m_pageCache.remove(p_page->m_data->id());
 	//decrement from the total size of the cache
-	if (p_atlasPage && (GraphicsSettings::DiUiGraphicsSettings()->atlasPagesExemptFromSizeLimit == false))
-		m_currentSizeInBytes -= qMax(p_page->m_sizeInBytes,m_currentSizeInBytes);
+	_releasePageSize(p_page);
 	//actually delete the pixpagerpage, but clear its m_data so that it doesn't try to delete the pmo that's
 	//already being deleted (that deletion is what caused this function to execute)
 	p_page->m_data = 0;
@@ -173,9 +201,7 @@ PixmapObject * PixPager::getPixmap(const QUuid& uid,QRect& r_coordRect,QSize& r_
 			qFatal("%s: page found in an atlas index but failed to qcast to atlas page type",__FUNCTION__);
 			//execution will abort here
 		}
-		++m_accessCounter;
-		++(p_atlasPage->m_accessCounter);
-		p_atlasPage->m_accessFrequency = (qreal)p_atlasPage->m_accessCounter / (qreal)m_accessCounter;
+		_touchPage(p_atlasPage);
 		//find the coordinate rect and size
 		QHash<QUuid,PixPagerPage::PixmapRects>::const_iterator dirfound = p_atlasPage->m_directory.find(uid);
 		if (dirfound == p_atlasPage->m_directory.end())
@@ -196,9 +222,7 @@ PixmapObject * PixPager::getPixmap(const QUuid& uid,QRect& r_coordRect,QSize& r_
 	if (found != m_pageCache.end())
 	{
 		//found it. It's just a regular page here
-		++m_accessCounter;
-		++(found.value()->m_accessCounter);
-		found.value()->m_accessFrequency = (qreal)found.value()->m_accessCounter / (qreal)m_accessCounter;
+		_touchPage(found.value());
 
 		if (found.value()->m_data->data() == NULL)
 		{
@@ -221,10 +245,11 @@ QUuid PixPager::addPixmap(QPixmap * p_pixmap,bool pinPage)
 
 	//check the space requirements
 	const quint32 pmsize = PixmapObject::sizeOfPixmap(p_pixmap);
-	if (pmsize + m_currentSizeInBytes > m_maxSizeInBytes)
+	const quint32 expungeAmount = _expungeAmountForMinsize(pmsize);
+	if (expungeAmount > 0)
 	{
 		//have to expunge something
-		if (_findAndExpunge(pmsize) == 0)
+		if (_findAndExpunge(expungeAmount) == 0)
 			return QUuid();		//couldn't add it due to lack of space
 	}
 
@@ -264,7 +289,11 @@ QUuid PixPager::addPixmapToAtlasPage(QPixmap * p_pixmap,bool allowScale,bool all
 	QMap<quint32, PixPagerPage *>::iterator i = m_atlasPages_alias.find(sqSize);
 	while (i != m_atlasPages_alias.end() && i.key() == sqSize) {
 		PixPagerAtlasPage * pAtlasPage = qobject_cast<PixPagerAtlasPage *>(i.value());
-		if (!pAtlasPage) continue;
+		if (!pAtlasPage)
+		{
+			++i;
+			continue;
+		}
 		if ((pSelectedPage == NULL)
 				|| (pAtlasPage->occupancyRate() < minOccupancy))
 		{
@@ -307,91 +336,234 @@ QUuid PixPager::addPixmapToAtlasPage(QPixmap * p_pixmap,bool allowScale,bool all
 			}
 		}
 		//found location
-
-
+		QUuid iconId;
+		if (_addAtlasPixmapEntry(*pSelectedPage,p_pixmap,sqSize,targetLocation,iconId) != PageOpsReturnCode::OK)
+			return QUuid();
+		m_atlasPagesByIndividualUids_alias.insert(iconId,pSelectedPage);
+		return iconId;
 	}
 	return QUuid();
 }
 
-quint32 PixPager::_findAndExpunge(quint32 minSize)
+bool PixPager::removePixmap(const QUuid& uid)
 {
-	//SLOW
-	//IMPROVE
+	QHash<QUuid,PixPagerPage *>::iterator found = m_atlasPagesByIndividualUids_alias.find(uid);
+	if (found != m_atlasPagesByIndividualUids_alias.end())
+	{
+		PixPagerAtlasPage * p_atlasPage = qobject_cast<PixPagerAtlasPage *>(found.value());
+		m_atlasPagesByIndividualUids_alias.erase(found);
+		if (p_atlasPage == NULL)
+			return true;
+		//leave a hole: the cell goes back on the free list. The pixels stay until the cell is reused or the page is compacted
+		QHash<QUuid,PixPagerPage::PixmapRects>::iterator dirfound = p_atlasPage->m_directory.find(uid);
+		if (dirfound != p_atlasPage->m_directory.end())
+		{
+			QPair<quint32,quint32> location;
+			if (p_atlasPage->gridCoordinatesForTargetRect(dirfound.value().coordinateRect,location))
+				p_atlasPage->m_freeList.append(location);
+			p_atlasPage->m_directory.erase(dirfound);
+		}
+		_scheduleMaintenance();
+		return true;
+	}
 
-	if (minSize > m_maxSizeInBytes)
-			return 0;		//not possible to expunge enough, since the size of the cache is smaller than the size requested
+	found = m_pageCache.find(uid);
+	if ((found == m_pageCache.end()) || (qobject_cast<PixPagerAtlasPage *>(found.value()) != NULL))
+		return false;		//not here, or it's a whole atlas page, which isn't something that was handed out by an add function
+	_deletePage(found.value());
+	return true;
+}
 
-	QMap<quint32,PixPagerPage *> sizeMap;
+void PixPager::_touchPage(PixPagerPage * p_page)
+{
+	++m_accessCounter;
+	++(p_page->m_accessCounter);
+	p_page->m_accessFrequency = (qreal)p_page->m_accessCounter / (qreal)m_accessCounter;
+	p_page->touch(m_accessCounter);
 
-	//search for a page to expunge
-	PixPagerPage * pSinglePage = 0;
-	quint32 minDelta = UINT_MAX;
-	quint32 maxExpungePossible = 0;
-	QHash<QUuid,PixPagerPage *>::const_iterator it = m_pageCache.constBegin();
-	while (it != m_pageCache.constEnd()) {
-		if ((*it)->m_pinned)
-			continue;	//pinned page...skip
+	PixPagerAtlasPage * p_atlasPage = qobject_cast<PixPagerAtlasPage *>(p_page);
+	if (p_atlasPage && p_atlasPage->m_unpinnedWhenCold)
+	{
+		//it's warm again
+		p_atlasPage->m_pinned = true;
+		p_atlasPage->m_unpinnedWhenCold = false;
+	}
+	_scheduleMaintenance();
+}
 
-		maxExpungePossible +=(*it)->m_sizeInBytes;
-		if ((*it)->m_sizeInBytes < minSize)
-		{
-			sizeMap.insertMulti((*it)->m_sizeInBytes,it.value());
+void PixPager::_scheduleMaintenance()
+{
+	if (!m_maintenanceTimer.isActive())
+		m_maintenanceTimer.start();
+}
+
+void PixPager::slotMaintenance()
+{
+	QList<PixPagerAtlasPage *> emptyPages;
+	for (QHash<QUuid,PixPagerPage *>::const_iterator it = m_pageCache.constBegin();
+			it != m_pageCache.constEnd(); ++it)
+	{
+		PixPagerAtlasPage * p_atlasPage = qobject_cast<PixPagerAtlasPage *>(it.value());
+		if (p_atlasPage == NULL)
 			continue;
-		}
-		if ((*it)->m_sizeInBytes == minSize)
+
+		if (p_atlasPage->m_directory.isEmpty())
 		{
-			pSinglePage = *it;
-			break;
+			emptyPages.append(p_atlasPage);
+			continue;
 		}
-		//else the page is > minSize
-		if (((*it)->m_sizeInBytes - minSize) < minDelta)
+
+		if (p_atlasPage->m_pinned && !p_atlasPage->m_unpinnedWhenCold
+				&& (p_atlasPage->heatAt(m_accessCounter) < PIXPAGER_COLD_HEAT))
 		{
-			minDelta = ((*it)->m_sizeInBytes - minSize);
-			pSinglePage = *it;
+			//let the replacement policy have it; the next access pins it again
+			p_atlasPage->m_pinned = false;
+			p_atlasPage->m_unpinnedWhenCold = true;
+			++m_coldUnpins;
 		}
+
+		if (p_atlasPage->occupancyRate() <= PIXPAGER_COMPACT_OCCUPANCY)
+			_compactAtlasPage(p_atlasPage);
 	}
-	if (pSinglePage)
+
+	for (QList<PixPagerAtlasPage *>::const_iterator it = emptyPages.constBegin(); it != emptyPages.constEnd(); ++it)
+		_deletePage(*it);
+}
+
+quint32 PixPager::_findAndExpunge(quint32 minSize)
+{
+	if (minSize > m_maxSizeInBytes)
+			return 0;		//not possible to expunge enough, since the size of the cache is smaller than the size requested
+
+	//the candidates are all the unpinned pages (regular pages, and atlas pages that went cold), coldest first
+	QMap<qreal,PixPagerPage *> heatMap;
+	quint32 maxExpungePossible = 0;
+	for (QHash<QUuid,PixPagerPage *>::const_iterator it = m_pageCache.constBegin();
+			it != m_pageCache.constEnd(); ++it)
 	{
-		//this is the one to expunge
-		_deleteRegularPage(pSinglePage);
-		return 1;
+		if ((*it)->m_pinned)
+			continue;	//pinned page...skip
+
+		maxExpungePossible += (*it)->m_sizeInBytes;
+		heatMap.insertMulti((*it)->heatAt(m_accessCounter),it.value());
 	}
 
-	//didn't find a single page that fit minsize and wasn't pinned.
-	//First, were enough expunge-able pages even found? No sense in expunging good pages if I can't reach my minSize quota
+	//No sense in expunging good pages if I can't reach my minSize quota
 	if (maxExpungePossible < minSize)
 		return 0;
 
-	//Ok, a minSize expunge is possible through a series of smaller page expunges
-	//Walk the map backwards (it'll be sorted by page size in ASCENDING order at this point), and
-	//remove all the pages until total >= minsize
-	// None of the pages in the map are pinned.
-
 	quint32 totalExpunged=0;
 	quint32 ecount=0;
-	QMap<quint32, PixPagerPage *>::const_iterator wi = sizeMap.constEnd();
-	while (wi != sizeMap.constBegin())
+	for (QMap<qreal, PixPagerPage *>::const_iterator wi = heatMap.constBegin();
+			(wi != heatMap.constEnd()) && (totalExpunged < minSize); ++wi)
 	{
-		--wi;
-		totalExpunged += wi.key();
-		_deleteRegularPage(*wi);
+		totalExpunged += (*wi)->m_sizeInBytes;
+		_deletePage(*wi);
 		++ecount;
-		if (totalExpunged >= minSize)
-			break;
 	}
+	m_evictedPages += ecount;
+	m_evictedBytes += totalExpunged;
 	return ecount;
 }
 
-void PixPager::_deleteRegularPage(PixPagerPage * p_page)
+void PixPager::_deletePage(PixPagerPage * p_page)
 {
+	PixPagerAtlasPage * p_atlasPage = qobject_cast<PixPagerAtlasPage *>(p_page);
+	if (p_atlasPage)
+		_removeAtlasAliases(p_atlasPage);
 	//remove from the master hash (the actual cache)
 	m_pageCache.remove(p_page->m_data->id());
 	//decrement from the total size of the cache
-	m_currentSizeInBytes -= qMax(p_page->m_sizeInBytes,m_currentSizeInBytes);
+	_releasePageSize(p_page);
 	//actually delete the pixpagerpage,
 	delete p_page;
 }
 
+void PixPager::_removeAtlasAliases(PixPagerAtlasPage * p_atlasPage)
+{
+	//remove from aliased map; there can be several pages for the same size, only take out this one
+	QMap<quint32,PixPagerPage *>::iterator ai = m_atlasPages_alias.find(p_atlasPage->m_pixmapSqSize);
+	while (ai != m_atlasPages_alias.end() && ai.key() == p_atlasPage->m_pixmapSqSize)
+	{
+		if (ai.value() == p_atlasPage)
+			ai = m_atlasPages_alias.erase(ai);
+		else
+			++ai;
+	}
+	//the page's directory has all the individual icon uids that alias it
+	for (QHash<QUuid,PixPagerPage::PixmapRects>::const_iterator it = p_atlasPage->m_directory.constBegin();
+			it != p_atlasPage->m_directory.constEnd(); ++it)
+	{
+		m_atlasPagesByIndividualUids_alias.remove(it.key());
+	}
+}
+
+void PixPager::_releasePageSize(PixPagerPage * p_page)
+{
+	m_currentSizeInBytes -= qMin(p_page->m_sizeInBytes,m_currentSizeInBytes);
+}
+
+bool PixPager::_compactAtlasPage(PixPagerAtlasPage * p_atlasPage)
+{
+	const quint32 count = (quint32)p_atlasPage->m_directory.size();
+	if (count == 0)
+		return false;
+
+	//as square a grid as will hold what's left
+	const quint32 numColumns = (quint32)qCeil(qSqrt((qreal)count));
+	const quint32 numRows = (count + numColumns - 1) / numColumns;
+	if (numRows * numColumns >= p_atlasPage->m_rows * p_atlasPage->m_columns)
+		return false;
+
+	const quint32 newWidth = nextpwr2(p_atlasPage->m_xLeadingPixelSpace+(numColumns*p_atlasPage->m_pixmapSqSize)
+			+(numColumns-1)*p_atlasPage->m_interColPixelSpace+p_atlasPage->m_xTrailingPixelSpace);
+	const quint32 newHeight = nextpwr2(p_atlasPage->m_yLeadingPixelSpace+(numRows*p_atlasPage->m_pixmapSqSize)
+			+(numRows-1)*p_atlasPage->m_interRowPixelSpace+p_atlasPage->m_yTrailingPixelSpace);
+	const quint32 newSize = (quint32)PixmapObject::sizeOfPixmap(newWidth,newHeight);
+	if (newSize >= p_atlasPage->m_sizeInBytes)
+		return false;		//the power of 2 rounding ate the gain; repacking alone buys nothing
+
+	PixmapObject * pPmo = new PixmapObject((int)newWidth,(int)newHeight);
+	(*pPmo)->fill(Qt::transparent);
+	QPainter copier(*pPmo);
+	copier.setCompositionMode(QPainter::CompositionMode_Source);
+
+	const quint32 oldSize = p_atlasPage->m_sizeInBytes;
+	p_atlasPage->m_rows = numRows;
+	p_atlasPage->m_columns = numColumns;
+
+	//the uids don't change, only their coordinate rects, so nothing outside the page needs re-keying
+	quint32 cell = 0;
+	for (QHash<QUuid,PixPagerPage::PixmapRects>::iterator it = p_atlasPage->m_directory.begin();
+			it != p_atlasPage->m_directory.end(); ++it, ++cell)
+	{
+		const QPair<quint32,quint32> location(cell % numColumns,cell / numColumns);
+		const QRect targetRect = p_atlasPage->targetRectForGridCoordinates(location);
+		copier.drawPixmap(targetRect,*(*(p_atlasPage->m_data)),it.value().coordinateRect);
+		it.value().coordinateRect = targetRect;
+		p_atlasPage->m_lastPositionAllocated = location;
+	}
+	copier.end();
+
+	p_atlasPage->m_freeList.clear();
+	for (; cell < numRows * numColumns; ++cell)
+		p_atlasPage->m_freeList.append(QPair<quint32,quint32>(cell % numColumns,cell / numColumns));
+
+	//swap the pixmap, same as _copyAndExpandAtlasPage
+	p_atlasPage->m_initiatedDelete = true;
+	pPmo->setId(p_atlasPage->m_data->id());
+	delete p_atlasPage->m_data;
+	p_atlasPage->m_data = pPmo;
+	p_atlasPage->m_sizeInBytes = (quint32)pPmo->sizeOf();
+	connect(pPmo,SIGNAL(signalObjectDestroyed()),p_atlasPage,SLOT(slotPixmapObjectDeleted()));
+	p_atlasPage->m_initiatedDelete = false;
+
+	m_currentSizeInBytes -= qMin(oldSize - p_atlasPage->m_sizeInBytes,m_currentSizeInBytes);
+	++m_compactions;
+	m_compactedBytes += oldSize - p_atlasPage->m_sizeInBytes;
+	return true;
+}
+
 quint32 PixPager::_determineSquareSize(QPixmap * p_pixmap,bool allowScale) const
 {
 	//SLOW
@@ -578,8 +750,16 @@ PageOpsReturnCode::Enum PixPager::_createAndAddAtlasPageWithInitialEntry(QPixmap
 	m_pageCache.insert(pPmo->id(),pPage);
 	//fill in the uid return param for the actual atlas page
 	r_pageUid = pPmo->id();
-	//set the last pos allocated
+	//set the last pos allocated; every other cell of the initial grid is free
 	pPage->m_lastPositionAllocated = QPair<quint32,quint32>(0,0);
+	for (quint32 j=0;j<initialRows;++j)
+	{
+		for (quint32 i=0;i<initialColumns;++i)
+		{
+			if (i || j)
+				pPage->m_freeList.append(QPair<quint32,quint32>(i,j));
+		}
+	}
 	//all good!
 	return PageOpsReturnCode::OK;
 
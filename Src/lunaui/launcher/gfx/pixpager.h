@@ -46,6 +46,17 @@
  *			reversed, so the original size is needed. e.g. a 30x30 icon could be stored in a 32x32-designated page.
  *			If the scaling factor is small (especially if it's a scale-up), then the negative visual effects will be minimal
  *
+ *		a word on the cache policy:
+ *			Every page keeps a "heat": its access count, halved for every PIXPAGER_HEAT_HALFLIFE accesses to the pager that
+ *			went to other pages. So it weighs both how often and how recently a page was used, and comparing two pages' heats
+ *			only needs the pager's access counter, not a clock. When space is needed, the coldest unpinned pages go first.
+ *			Atlas pages start out pinned, but a periodic maintenance pass unpins the ones that have gone cold (they get pinned
+ *			again on the next access), so a stale atlas page can eventually be evicted like any other page.
+ *			Removing a pixmap from an atlas page leaves a hole; the hole's cell goes onto the page's free list, which is the
+ *			only place new cells are handed out from (lowest row, then lowest column first, so pages stay dense at the top left).
+ *			The maintenance pass also repacks atlas pages that have become sparse into the smallest page that holds what's
+ *			left, and drops atlas pages that have become empty.
+ *
  *		NOT THREAD SAFE! among other things, the most blatant problem is that getPixmap()'s returned QPixmap must remain
  *		valid throughout the function that made the call. This will not be guaranteed with multiple threads, as a cache purge
  *		triggered by another thread could wipe out that QPixmap
@@ -63,8 +74,12 @@
 #include <QMap>
 #include <QPair>
 #include <QList>
+#include <QTimer>
 
-/////HOW TO KEEP TRACK OF HOLES!?
+#define PIXPAGER_HEAT_HALFLIFE				256			//pager accesses
+#define PIXPAGER_COLD_HEAT					0.25		//below this, a pinned atlas page is unpinned by the maintenance pass
+#define PIXPAGER_COMPACT_OCCUPANCY			0.5			//at or below this, an atlas page is repacked (if that makes it smaller)
+#define PIXPAGER_MAINTENANCE_INTERVAL_MS	5000
 
 class PixPager;
 class PixmapObject;
@@ -106,9 +121,15 @@ public:
 
 	quint32 m_accessCounter;
 	qreal m_accessFrequency;				//a proportion of accesses to this page vs the total of accesses for all pages
+	quint32 m_lastAccess;					//the pager's access counter at the last access to this page
+	qreal m_heat;							//decayed access count as of m_lastAccess; see the cache policy notes at the top
 
 	bool m_initiatedDelete;
 
+	//the heat as of pager access count 'now'
+	qreal heatAt(quint32 now) const;
+	void touch(quint32 now);
+
 public Q_SLOTS:
 
 	virtual void slotPixmapObjectDeleted();
@@ -136,34 +157,30 @@ public:
 		return (qreal)(m_directory.size())/(qreal)(m_rows*m_columns);
 	}
 
+	//every unoccupied cell is on the free list (new cells from page expansion as well as holes left by removals),
+	// so this is the only place cells are allocated from. Lowest row, then lowest column goes first
 	bool getFromFreelist(QPair<quint32,quint32>& r_location)
 	{
 		if (m_freeList.empty())
 			return false;
-		r_location = m_freeList.takeFirst();
+		int best = 0;
+		for (int i=1;i<m_freeList.size();++i)
+		{
+			if ((m_freeList[i].second < m_freeList[best].second)
+					|| ((m_freeList[i].second == m_freeList[best].second) && (m_freeList[i].first < m_freeList[best].first)))
+				best = i;
+		}
+		r_location = m_freeList.takeAt(best);
 		return true;
 	}
 	bool unoccupiedLocation(QPair<quint32,quint32>& r_location)
 	{
-		if (m_lastPositionAllocated == INVALID_LOCATION)
-			return getFromFreelist(r_location);
-		//go sequentially
-		if ((m_lastPositionAllocated.first == m_columns-1) && (m_lastPositionAllocated.second == m_rows-1))
-			return getFromFreelist(r_location);
-		else if (m_lastPositionAllocated.first == m_columns-1)
-		{
-			//next row, col=0
-			r_location = QPair<quint32,quint32>(0,m_lastPositionAllocated.second+1);
-		}
-		else
-		{
-			//next column, same row
-			r_location = QPair<quint32,quint32>(m_lastPositionAllocated.first+1,m_lastPositionAllocated.second);
-		}
-		return true;
+		return getFromFreelist(r_location);
 	}
 
 	QRect targetRectForGridCoordinates(const QPair<quint32,quint32>& gridCoordinates) const;
+	//the reverse of the above; false if the rect isn't exactly one of this page's cells
+	bool gridCoordinatesForTargetRect(const QRect& targetRect,QPair<quint32,quint32>& r_gridCoordinates) const;
 
 	QHash<QUuid,PixmapRects> m_directory;		//keeps the locations of the contained
 															//mini-pm's keyed on their uids null if the page isn't an atlas
@@ -180,6 +197,7 @@ public:
 	quint32 m_interRowPixelSpace;
 	quint32 m_interColPixelSpace;
 	QPair<quint32,quint32> m_lastPositionAllocated;
+	bool m_unpinnedWhenCold;			//pinned again when it's accessed
 	static QPair<quint32,quint32> INVALID_LOCATION;
 };
 
@@ -224,15 +242,30 @@ public:
 	 */
 	QUuid addPixmapToAtlasPage(QPixmap * p_pixmap,bool allowScale=true,bool allowPageCreation=false);
 
+	//takes out a pixmap added by either of the above (a uid returned by addPixmapToAtlasPage leaves a hole in its atlas page,
+	// to be reused or compacted away later). Returns false if the uid isn't in the pager
+	bool removePixmap(const QUuid& uid);
+
 	friend class PixPagerPage;
 	friend class PixPagerDebugger;
 
+private Q_SLOTS:
+
+	//unpins cold atlas pages, compacts sparse ones and deletes empty ones
+	void slotMaintenance();
+
 private:
 
 	void _pagePixmapDeleted(PixPagerPage * p_page);
+	void _touchPage(PixPagerPage * p_page);
+	void _scheduleMaintenance();
 	//returns # of pages expunged
 	quint32  _findAndExpunge(quint32 minSize);
-	void _deleteRegularPage(PixPagerPage * p_page);
+	void _deletePage(PixPagerPage * p_page);
+	void _removeAtlasAliases(PixPagerAtlasPage * p_atlasPage);
+	void _releasePageSize(PixPagerPage * p_page);
+	//repacks the page's pixmaps into the smallest grid that holds them; returns false if that wouldn't make the page smaller
+	bool _compactAtlasPage(PixPagerAtlasPage * p_atlasPage);
 	// try and figure out if the pixmap can be "squarified" to an existing atlas page size requirement
 	//		given the current atlas page size designations and the allowed scale factors in the gfxsettings
 	//		file. If yes, the new square size is returned (i.e. the quint returned is the length of a side
@@ -268,6 +301,15 @@ private:
 	quint32 m_currentSizeInBytes;
 	quint32 m_accessCounter;		//getPixmap access for all pages
 
+	//cache policy stats, see PixPagerDebugger
+	quint32 m_evictedPages;
+	quint32 m_evictedBytes;
+	quint32 m_coldUnpins;
+	quint32 m_compactions;
+	quint32 m_compactedBytes;		//bytes given back by compactions
+
+	QTimer m_maintenanceTimer;
+
 	//keyed by the size of the small pixmaps within ...so 64 -> 64x64 pixmaps
 	//alias hashes, so they don't own the pixpagerpages
 	// there may be multiple entries with the same size (using insertMulti)
@@ -21,6 +21,16 @@
 
 #include "expblur.h"
 
+#include <glib.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 BlurExponential::BlurExponential()
 {
 }
@@ -44,6 +54,16 @@ static inline void blurrow( QImage & im, int line, int alpha);
 template<int aprec, int zprec>
 static inline void blurcol( QImage & im, int col, int alpha);
 
+template<int aprec>
+static inline int expbluralpha(int radius)
+{
+  /* Calculate the alpha such that 90% of
+     the kernel is within the radius.
+     (Kernel extends to infinity)
+  */
+  return (int)((1<<aprec)*(1.0f-expf(-2.3f/(radius+1.f))));
+}
+
 /*
 *  expblur(QImage &img, int radius)
 *
@@ -65,11 +85,7 @@ void expblur( QImage &img, int radius )
   if(radius<1)
     return;
 
-  /* Calculate the alpha such that 90% of
-     the kernel is within the radius.
-     (Kernel extends to infinity)
-  */
-  int alpha = (int)((1<<aprec)*(1.0f-expf(-2.3f/(radius+1.f))));
+  int alpha = expbluralpha<aprec>(radius);
 
   for(int row=0;row<img.height();row++)
   {
@@ -152,10 +168,352 @@ static inline void blurcol( QImage & im, int col, int alpha)
 
 }
 
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+//
+// The fast path. Same arithmetic as blurinner<16,7>() above, bit for bit, but:
+//	- all four channels of a pixel go through one vector, and each vector carries a pixel from each of two
+//		lines, so two independent IIRs run side by side (NEON or SSE2; plain blurinner() otherwise)
+//	- the column pass works on strips of BLUR_TILE columns that are transposed into a scratch buffer, blurred
+//		as rows (i.e. sequentially in memory) and transposed back, rather than walking down the image a pixel
+//		per cache line
+//	- rows, and column strips, are independent, so they're split into bands across a small thread pool
+//
+// With zprec 7 the state never leaves 0..255<<7, and (x<<7)-z stays within +-32640, so everything fits in
+// 16 bit lanes. alpha is 0.16 fixed point, so (alpha*d)>>16 is the high half of a 16x16 multiply; alpha
+// doesn't fit a signed 16 bit lane once it's >= 0x8000, and in that case the signed high half comes out
+// exactly d short (alpha_u = alpha_s + 0x10000), which gets added back.
+//
+/////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+#define BLUR_APREC					16
+#define BLUR_ZPREC					7
+#define BLUR_TILE					16			//pixels; a 64 byte cache line of ARGB32
+#define BLUR_MIN_PIXELS_PER_BAND	(64*1024)	//below this, handing work to another thread costs more than it saves
+#define BLUR_MAX_THREADS			4
+
+#if defined(__ARM_NEON__) || defined(__SSE2__)
+
+#if defined(__ARM_NEON__)
+
+typedef int16x8_t BlurLanes;		//channels of the pixel from line a in 0..3, line b in 4..7
+
+static inline BlurLanes blurload(const quint32 * pa,const quint32 * pb)
+{
+	uint32x2_t p = vset_lane_u32(*pb,vdup_n_u32(*pa),1);
+	return vreinterpretq_s16_u16(vmovl_u8(vreinterpret_u8_u32(p)));
+}
+
+static inline void blurstore(quint32 * pa,quint32 * pb,BlurLanes z)
+{
+	uint32x2_t p = vreinterpret_u32_u8(vqmovun_s16(vshrq_n_s16(z,BLUR_ZPREC)));
+	*pa = vget_lane_u32(p,0);
+	*pb = vget_lane_u32(p,1);
+}
+
+static inline BlurLanes blurmulhi(BlurLanes a,BlurLanes b)
+{
+	int16x4_t lo = vshrn_n_s32(vmull_s16(vget_low_s16(a),vget_low_s16(b)),16);
+	int16x4_t hi = vshrn_n_s32(vmull_s16(vget_high_s16(a),vget_high_s16(b)),16);
+	return vcombine_s16(lo,hi);
+}
+
+static inline BlurLanes blurstep(BlurLanes z,BlurLanes x,BlurLanes alpha,BlurLanes alphaHighMask)
+{
+	// z += (alpha * ((x<<zprec)-z))>>aprec
+	BlurLanes d = vsubq_s16(vshlq_n_s16(x,BLUR_ZPREC),z);
+	BlurLanes m = vaddq_s16(blurmulhi(alpha,d),vandq_s16(d,alphaHighMask));
+	return vaddq_s16(z,m);
+}
+
+static inline BlurLanes blursplat(int v)
+{
+	return vdupq_n_s16((short)v);
+}
+
+#else
+
+typedef __m128i BlurLanes;		//channels of the pixel from line a in 0..3, line b in 4..7
+
+static inline BlurLanes blurload(const quint32 * pa,const quint32 * pb)
+{
+	__m128i p = _mm_unpacklo_epi32(_mm_cvtsi32_si128((int)*pa),_mm_cvtsi32_si128((int)*pb));
+	return _mm_unpacklo_epi8(p,_mm_setzero_si128());
+}
+
+static inline void blurstore(quint32 * pa,quint32 * pb,BlurLanes z)
+{
+	__m128i v = _mm_srai_epi16(z,BLUR_ZPREC);
+	v = _mm_packus_epi16(v,v);
+	*pa = (quint32)_mm_cvtsi128_si32(v);
+	*pb = (quint32)_mm_cvtsi128_si32(_mm_srli_si128(v,4));
+}
+
+static inline BlurLanes blurstep(BlurLanes z,BlurLanes x,BlurLanes alpha,BlurLanes alphaHighMask)
+{
+	BlurLanes d = _mm_sub_epi16(_mm_slli_epi16(x,BLUR_ZPREC),z);
+	BlurLanes m = _mm_add_epi16(_mm_mulhi_epi16(alpha,d),_mm_and_si128(d,alphaHighMask));
+	return _mm_add_epi16(z,m);
+}
+
+static inline BlurLanes blursplat(int v)
+{
+	return _mm_set1_epi16((short)v);
+}
+
+#endif
+
+//two lines of the same length, each contiguous in memory. forwardEnd is where the forward sweep stops: the
+//row pass goes all the way, the column pass (see blurcol) stops a pixel short.
+//pa and pb may be the same line (an odd one out); both halves then compute and store the same values
+static inline void blurlines(quint32 * pa,quint32 * pb,int count,int forwardEnd,int alpha)
+{
+	if (count < 2)
+		return;
+
+	const BlurLanes alphaLanes = blursplat(alpha);
+	const BlurLanes alphaHighMask = blursplat(alpha >= 0x8000 ? -1 : 0);
+
+	BlurLanes z = blurload(pa,pb);
+#if defined(__ARM_NEON__)
+	z = vshlq_n_s16(z,BLUR_ZPREC);
+#else
+	z = _mm_slli_epi16(z,BLUR_ZPREC);
+#endif
+	for (int index=1; index<forwardEnd; index++)
+	{
+		z = blurstep(z,blurload(&pa[index],&pb[index]),alphaLanes,alphaHighMask);
+		blurstore(&pa[index],&pb[index],z);
+	}
+	for (int index=count-2; index>=0; index--)
+	{
+		z = blurstep(z,blurload(&pa[index],&pb[index]),alphaLanes,alphaHighMask);
+		blurstore(&pa[index],&pb[index],z);
+	}
+}
+
+#else
+
+static inline void blurline(quint32 * ptr,int count,int forwardEnd,int alpha)
+{
+	if (count < 2)
+		return;
+
+	int zR,zG,zB,zA;
+	zR = *((unsigned char *)ptr    )<<BLUR_ZPREC;
+	zG = *((unsigned char *)ptr + 1)<<BLUR_ZPREC;
+	zB = *((unsigned char *)ptr + 2)<<BLUR_ZPREC;
+	zA = *((unsigned char *)ptr + 3)<<BLUR_ZPREC;
+
+	for (int index=1; index<forwardEnd; index++)
+		blurinner<BLUR_APREC,BLUR_ZPREC>((unsigned char *)&ptr[index],zR,zG,zB,zA,alpha);
+	for (int index=count-2; index>=0; index--)
+		blurinner<BLUR_APREC,BLUR_ZPREC>((unsigned char *)&ptr[index],zR,zG,zB,zA,alpha);
+}
+
+static inline void blurlines(quint32 * pa,quint32 * pb,int count,int forwardEnd,int alpha)
+{
+	blurline(pa,count,forwardEnd,alpha);
+	if (pb != pa)
+		blurline(pb,count,forwardEnd,alpha);
+}
+
+#endif
+
+//copies the w x h block at src into dst, transposed, a tile at a time so both sides stay in cache
+static void blurtranspose(const quint32 * src,int srcStride,quint32 * dst,int dstStride,int w,int h)
+{
+	for (int ty=0; ty<h; ty+=BLUR_TILE)
+	{
+		const int yEnd = qMin(ty+BLUR_TILE,h);
+		for (int tx=0; tx<w; tx+=BLUR_TILE)
+		{
+			const int xEnd = qMin(tx+BLUR_TILE,w);
+			for (int y=ty; y<yEnd; ++y)
+			{
+				const quint32 * s = src + y*srcStride;
+				for (int x=tx; x<xEnd; ++x)
+					dst[x*dstStride + y] = s[x];
+			}
+		}
+	}
+}
+
+namespace
+{
+
+struct BlurJob
+{
+	quint32 * bits;
+	int stride;				//in pixels
+	int width;
+	int height;
+	int alpha;
+	bool columns;			//false: the bands are rows, true: the bands are column strips
+
+	volatile gint remaining;
+	GMutex * mutex;
+	GCond * done;
+};
+
+struct BlurBand
+{
+	BlurJob * job;
+	int first;
+	int last;				//exclusive
+};
+
+}
+
+static void blurband(const BlurBand& band)
+{
+	const BlurJob& job = *band.job;
+
+	if (!job.columns)
+	{
+		for (int row=band.first; row<band.last; row+=2)
+		{
+			quint32 * a = job.bits + row*job.stride;
+			quint32 * b = (row+1 < band.last) ? a + job.stride : a;
+			blurlines(a,b,job.width,job.width,job.alpha);
+		}
+		return;
+	}
+
+	//a strip of BLUR_TILE columns at a time: transpose it into rows, blur them, transpose back
+	quint32 * scratch = (quint32 *)malloc(sizeof(quint32) * BLUR_TILE * job.height);
+	if (!scratch)
+		return;
+	for (int col=band.first; col<band.last; col+=BLUR_TILE)
+	{
+		const int strip = qMin(BLUR_TILE,band.last-col);
+		blurtranspose(job.bits + col,job.stride,scratch,job.height,strip,job.height);
+		for (int i=0; i<strip; i+=2)
+		{
+			quint32 * a = scratch + i*job.height;
+			quint32 * b = (i+1 < strip) ? a + job.height : a;
+			blurlines(a,b,job.height,job.height-1,job.alpha);
+		}
+		blurtranspose(scratch,job.height,job.bits + col,job.stride,job.height,strip);
+	}
+	free(scratch);
+}
+
+static void blurpoolfunc(gpointer data,gpointer)
+{
+	BlurBand * band = (BlurBand *)data;
+	BlurJob * job = band->job;
+	blurband(*band);
+	delete band;
+
+	if (g_atomic_int_dec_and_test(&job->remaining))
+	{
+		g_mutex_lock(job->mutex);
+		g_cond_signal(job->done);
+		g_mutex_unlock(job->mutex);
+	}
+}
+
+static GThreadPool * blurpool(int& r_threads)
+{
+	static volatile gsize s_initialized = 0;
+	static GThreadPool * s_pool = 0;
+	static int s_threads = 0;
+
+	//blurs can come from more than one thread; the first one in sets the pool up, the others wait for it
+	if (g_once_init_enter(&s_initialized))
+	{
+		//the calling thread does a share too, so one less than the number of cores
+		int threads = qBound(0,(int)sysconf(_SC_NPROCESSORS_ONLN) - 1,BLUR_MAX_THREADS - 1);
+		if (threads > 0 && g_thread_supported())
+		{
+			GError * error = 0;
+			s_pool = g_thread_pool_new(blurpoolfunc,0,threads,FALSE,&error);
+			if (!s_pool)
+			{
+				g_warning("%s: failed to create the blur pool: %s",__PRETTY_FUNCTION__,error ? error->message : "?");
+				if (error)
+					g_error_free(error);
+			}
+		}
+		if (s_pool)
+			s_threads = threads;
+		g_once_init_leave(&s_initialized,1);
+	}
+	r_threads = s_threads;
+	return s_pool;
+}
+
+//splits [0,count) into bands, hands all but the first to the pool, does the first one here and waits for the rest
+static void blurpass(BlurJob& job,int count,int pixelsPerUnit,int granularity)
+{
+	int threads = 0;
+	GThreadPool * pool = blurpool(threads);
+
+	int bands = qMin(threads + 1,(count * pixelsPerUnit) / BLUR_MIN_PIXELS_PER_BAND);
+	bands = qMax(bands,1);
+	//round the band size up to the granularity so column bands are made of whole strips
+	int bandSize = (count + bands - 1) / bands;
+	bandSize = ((bandSize + granularity - 1) / granularity) * granularity;
+	bands = (count + bandSize - 1) / bandSize;
+
+	if (bands <= 1 || !pool)
+	{
+		BlurBand band = { &job, 0, count };
+		blurband(band);
+		return;
+	}
+
+	g_atomic_int_set(&job.remaining,bands - 1);
+	for (int i=1; i<bands; ++i)
+	{
+		BlurBand * band = new BlurBand;
+		band->job = &job;
+		band->first = i * bandSize;
+		band->last = qMin(count,(i + 1) * bandSize);
+		g_thread_pool_push(pool,band,NULL);
+	}
+
+	BlurBand first = { &job, 0, bandSize };
+	blurband(first);
+
+	g_mutex_lock(job.mutex);
+	while (g_atomic_int_get(&job.remaining) > 0)
+		g_cond_wait(job.done,job.mutex);
+	g_mutex_unlock(job.mutex);
+}
+
 QImage BlurExponential::blurImage(const QImage& srcImage,int radius)
 {
 	QImage dest = srcImage;
-	expblur<16,7>(dest,radius);
+	if ((radius < 1) || (dest.depth() != 32) || dest.isNull())
+	{
+		expblur<BLUR_APREC,BLUR_ZPREC>(dest,radius);
+		return dest;
+	}
+
+	BlurJob job;
+	job.bits = (quint32 *)dest.bits();
+	job.stride = dest.bytesPerLine() / 4;
+	job.width = dest.width();
+	job.height = dest.height();
+	job.alpha = expbluralpha<BLUR_APREC>(radius);
+	job.remaining = 0;
+	job.mutex = g_mutex_new();
+	job.done = g_cond_new();
+
+	job.columns = false;
+	blurpass(job,job.height,job.width,1);
+	job.columns = true;
+	blurpass(job,job.width,job.height,BLUR_TILE);
+
+	g_cond_free(job.done);
+	g_mutex_free(job.mutex);
 	return dest;
 }
 
+QImage BlurExponential::blurImageReference(const QImage& srcImage,int radius)
+{
+	QImage dest = srcImage;
+	expblur<BLUR_APREC,BLUR_ZPREC>(dest,radius);
+	return dest;
+}
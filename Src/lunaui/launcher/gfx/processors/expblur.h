@@ -34,8 +34,12 @@ public:
 	BlurExponential();
 	virtual ~BlurExponential();
 
+	//vectorized and spread over a few threads; same output as blurImageReference()
 	static QImage blurImage(const QImage& srcImage,int radius);
 
+	//the original scalar, single threaded version; for tests and benchmarks
+	static QImage blurImageReference(const QImage& srcImage,int radius);
+
 };
 
 #endif /* EXPBLUR_H_ */
@@ -134,14 +134,14 @@ void ClockWindow::tick()
 	// get current local time
 	if (m_twelveHour) {
 
-		strftime(m_time, MaxTimeChars, LOCALIZED("%I:%M").c_str(), timeinfo);
+		strftime(m_time, MaxTimeChars, LOCALIZED_REF("%I:%M").data(), timeinfo);
 
 		if (m_time[0] == '0') {
 			memmove(m_time, m_time+1, MaxTimeChars-1);
 		}
 	}
 	else {
-		strftime(m_time, MaxTimeChars, LOCALIZED("%H:%M").c_str(), timeinfo);
+		strftime(m_time, MaxTimeChars, LOCALIZED_REF("%H:%M").data(), timeinfo);
 	}
 
 	// recalculate the width of the new time
@@ -1384,7 +1384,7 @@ void LockWindow::slotPasswordSubmitted(QString password, bool isPIN)
 
 			if(retriesLeft > 1) {
 				char tries[100];
-				sprintf (tries, LOCALIZED("%d Tries Remaining").c_str(), retriesLeft);
+				sprintf (tries, LOCALIZED_REF("%d Tries Remaining").data(), retriesLeft);
 				message = tries;
 			} else if (retriesLeft == 1) {
 				changeState(StateLastTryDialog);
@@ -1437,7 +1437,7 @@ void LockWindow::slotPasswordSubmitted(QString password, bool isPIN)
 										  Q_ARG(QVariant, fromStdUtf8(LOCALIZED("Try Again"))), Q_ARG(QVariant, minLen>0), Q_ARG(QVariant, minLen));
 
 				if(minLen > 0) {
-					sprintf(hint, LOCALIZED("Must be at least %d numbers").c_str(), minLen);
+					sprintf(hint, LOCALIZED_REF("Must be at least %d numbers").data(), minLen);
 				} else {
 					sprintf(hint, " ");
 				}
@@ -1467,7 +1467,7 @@ void LockWindow::slotPasswordSubmitted(QString password, bool isPIN)
 											  Q_ARG(QVariant, fromStdUtf8(errorText)), Q_ARG(QVariant, minLen>0), Q_ARG(QVariant, minLen));
 
 					if(minLen > 0) {
-						sprintf(hint, LOCALIZED("Must be at least %d numbers").c_str(), minLen);
+						sprintf(hint, LOCALIZED_REF("Must be at least %d numbers").data(), minLen);
 					} else {
 						sprintf(hint, " ");
 					}
@@ -1492,7 +1492,7 @@ void LockWindow::slotPasswordSubmitted(QString password, bool isPIN)
 										  Q_ARG(QVariant, fromStdUtf8(LOCALIZED("Try Again"))), Q_ARG(QVariant, minLen>0), Q_ARG(QVariant, minLen));
 
 				if(minLen > 0) {
-					sprintf(hint, LOCALIZED("Must be at least %d characters").c_str(), minLen);
+					sprintf(hint, LOCALIZED_REF("Must be at least %d characters").data(), minLen);
 				} else {
 					sprintf(hint, " ");
 				}
@@ -1521,7 +1521,7 @@ void LockWindow::slotPasswordSubmitted(QString password, bool isPIN)
 											  Q_ARG(QVariant, fromStdUtf8(errorText)), Q_ARG(QVariant, minLen>0), Q_ARG(QVariant, minLen));
 
 					if(minLen > 0) {
-						sprintf(hint, LOCALIZED("Must be at least %d characters").c_str(), minLen);
+						sprintf(hint, LOCALIZED_REF("Must be at least %d characters").data(), minLen);
 					} else {
 						sprintf(hint, " ");
 					}
@@ -1997,7 +1997,7 @@ void LockWindow::showPinPanel()
 
 		if(m_setupNewPin) {
 			if(minLen > 0) {
-				sprintf(hint, LOCALIZED("Must be at least %d numbers").c_str(), minLen);
+				sprintf(hint, LOCALIZED_REF("Must be at least %d numbers").data(), minLen);
 			} else {
 				sprintf(hint, " ");
 			}
@@ -2008,7 +2008,7 @@ void LockWindow::showPinPanel()
 									  Q_ARG(QVariant, fromStdUtf8(hintStr)), Q_ARG(QVariant, minLen>0), Q_ARG(QVariant, (int)minLen));
 		} else if(m_setupNewPassword) {
 			if(minLen > 0) {
-				sprintf(hint, LOCALIZED("Must be at least %d characters").c_str(), minLen);
+				sprintf(hint, LOCALIZED_REF("Must be at least %d characters").data(), minLen);
 			} else {
 				sprintf(hint, " ");
 			}
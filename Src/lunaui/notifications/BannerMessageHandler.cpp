@@ -38,6 +38,7 @@
 #include <QSharedData>
 #include <QSignalTransition>
 #include <QStateMachine>
+#include <QStaticText>
 #include <QString>
 #include <QTimer>
 
@@ -105,7 +106,9 @@ public:
 		, doNotSuppress(_doNotSuppress)
 		, fontMetrics(*_font)
 		, msg(_msg.empty() ? QString() : QString::fromUtf8(_msg.c_str()))
-		, elidedWidth(0)
+		, elidedWidth(-1)
+		, shapingCount(0)
+		, paintCount(0)
 		, posAnimProg(0.0)
 		, alpha(1.0f)
 		, triggered(false)
@@ -148,14 +151,31 @@ public:
 
 	void createElidedMessage(int width) {
 		elidedMsg = fontMetrics.elidedText(msg, Qt::ElideRight, width);
+		elidedWidth = fontMetrics.boundingRect(elidedMsg).width();
+		shapingCount += 2;
 	}
 
 	int elidedMsgWidth(int width) {
 
-		if(elidedMsg.isEmpty())
+		if(elidedWidth < 0)
 			createElidedMessage(width);
 
-		return fontMetrics.boundingRect(elidedMsg).width();
+		return elidedWidth;
+	}
+
+	// Lays out the text once for every frame of the animations. The vertical scroll shows the whole
+	// message clipped to the view, the other scroll types the elided one.
+	void prepareText(const QFont& font) {
+		prepareStaticText(msgText, msg, font);
+		prepareStaticText(elidedMsgText, elidedMsg, font);
+	}
+
+	void prepareStaticText(QStaticText& text, const QString& str, const QFont& font) {
+		text.setText(str);
+		text.setTextFormat(Qt::PlainText);
+		text.setPerformanceHint(QStaticText::AggressiveCaching);
+		text.prepare(QTransform(), font);
+		shapingCount++;
 	}
 
 	std::string appId;
@@ -171,8 +191,14 @@ public:
 	QString msg;
 	int elidedWidth;
 	QString elidedMsg;
+	QStaticText msgText;
+	QStaticText elidedMsgText;
 	QPixmap pixmap;
 
+	// how often the text was shaped against how often it was painted, logged when the banner goes away
+	int shapingCount;
+	int paintCount;
+
 	qreal posAnimProg;
 	qreal alpha;
 	bool triggered;
@@ -317,6 +343,8 @@ void BannerMessageHandler::paintBanner(QPainter* painter, BannerMessage* m)
 
 	
 	BannerMessageView* view = d->viewList.last();
+
+	m->paintCount++;
 	
 	if(view->scrollType() == BannerMessageView::VerticalScroll) {
 		int width = view->bmViewGetWidth();
@@ -335,11 +363,19 @@ void BannerMessageHandler::paintBanner(QPainter* painter, BannerMessage* m)
 			offsetX += m->pixmap.width() + kTextMarginX;
 		}
 
-		painter->drawText(QRect(offsetX, ((1.0 - m->posAnimProgress()) * d->viewHeight),
-								width - offsetX,
-								d->viewHeight),
-						  Qt::AlignLeft | Qt::AlignVCenter,
-						  m->msg);
+		QRect textRect(offsetX, ((1.0 - m->posAnimProgress()) * d->viewHeight),
+					   width - offsetX,
+					   d->viewHeight);
+
+		if (m->msgText.size().width() > textRect.width()) {
+			painter->save();
+			painter->setClipRect(textRect, Qt::IntersectClip);
+			drawBannerText(painter, m->msgText, textRect);
+			painter->restore();
+		}
+		else {
+			drawBannerText(painter, m->msgText, textRect);
+		}
 	} else if(view->scrollType() == BannerMessageView::HorizontalScroll) {
 		int width = view->bmViewGetWidth();
 
@@ -361,11 +397,9 @@ void BannerMessageHandler::paintBanner(QPainter* painter, BannerMessage* m)
 			maxTextWidth -= m->pixmap.width() + kTextMarginX;
 		}
 
-		painter->drawText(QRect(offsetX, 0,
-								width - offsetX,
-								d->viewHeight),
-						  Qt::AlignLeft | Qt::AlignVCenter,
-						  m->elidedMsg);
+		drawBannerText(painter, m->elidedMsgText, QRect(offsetX, 0,
+														width - offsetX,
+														d->viewHeight));
 		painter->setClipping(false);
 
 	} else if(view->scrollType() == BannerMessageView::StatusBarScroll) {
@@ -398,11 +432,9 @@ void BannerMessageHandler::paintBanner(QPainter* painter, BannerMessage* m)
 			maxTextWidth -= m->pixmap.width() + kTextMarginX;
 		}
 
-		painter->drawText(QRect(offsetX, 0,
-								width - offsetX,
-								d->viewHeight),
-						  Qt::AlignLeft | Qt::AlignVCenter,
-						  m->elidedMsg);
+		drawBannerText(painter, m->elidedMsgText, QRect(offsetX, 0,
+														width - offsetX,
+														d->viewHeight));
 		painter->setClipRect(QRect(), Qt::NoClip);
 		painter->setClipping(false);
 		painter->translate(m->posAnimProgress() *  bw, 0);
@@ -424,12 +456,17 @@ void BannerMessageHandler::paintBanner(QPainter* painter, BannerMessage* m)
 			offsetX += m->pixmap.width() + kTextMarginX;
 		}
 
-		painter->drawText(QRect(offsetX, 0, width - offsetX, d->viewHeight),
-						  Qt::AlignLeft | Qt::AlignVCenter,
-						  m->elidedMsg);
+		drawBannerText(painter, m->elidedMsgText, QRect(offsetX, 0, width - offsetX, d->viewHeight));
 	}
 }
 
+// Same placement as drawText() with Qt::AlignLeft | Qt::AlignVCenter
+void BannerMessageHandler::drawBannerText(QPainter* painter, const QStaticText& text, const QRect& rect)
+{
+	int y = rect.y() + (rect.height() - qRound(text.size().height())) / 2;
+	painter->drawStaticText(rect.x(), y, text);
+}
+
 void BannerMessageHandler::addMessage(const std::string& appId,
 									  const std::string& msgId,
 									  const std::string& msg,
@@ -631,6 +668,7 @@ void BannerMessageHandler::setupState(BannerMessage* m, int viewWidth)
 	}
 
 	m->createElidedMessage(maxTextWidth);
+	m->prepareText(d->font);
 
 	if (d->msgList.size() == 1)
 		m->timer->setInterval(kMaxShowTimeMs);
@@ -927,6 +965,8 @@ void BannerMessageHandler::bannerStateMachineFinished()
 
 		BannerMessage* m = mp.data();
 		if (m->stateMachine == sm) {
+			g_debug("BannerMessageHandler: banner %s, %s painted %d times, text shaped %d times",
+					m->appId.c_str(), m->msgId.c_str(), m->paintCount, m->shapingCount);
 			d->deletedMsgList.removeAll(mp);
 			return;
 		}
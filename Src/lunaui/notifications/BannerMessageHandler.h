@@ -31,6 +31,8 @@
 #include "SoundPlayerPool.h"
 
 class QPainter;
+class QRect;
+class QStaticText;
 
 class BannerMessage;
 class BannerMessageEvent;
@@ -119,6 +121,7 @@ private:
 	void playSound(BannerMessage* m);
 
 	void paintBanner(QPainter* p, BannerMessage* m);
+	void drawBannerText(QPainter* painter, const QStaticText& text, const QRect& rect);
 
 	int msgCount() const;
 
@@ -40,6 +40,7 @@ DashboardWindow::DashboardWindow(HostWindowData* data, IpcClientHost* clientHost
 	, m_persistent(false)
 	, m_manualDragMode(false)
 	, m_dashHeight(52)
+	, m_contentSerial(0)
 {
     
 }
@@ -62,6 +63,12 @@ void DashboardWindow::onMessageReceived(const PIpcMessage& msg)
 	IPC_END_MESSAGE_MAP()
 }
 
+void DashboardWindow::onUpdateWindowRegion(int x, int y, int w, int h)
+{
+	m_contentSerial++;
+	HostWindow::onUpdateWindowRegion(x, y, w, h);
+}
+
 void DashboardWindow::onSetIcon(const std::string& iconName)
 {
 	setIcon(appDescription()->folderPath(), iconName);
@@ -56,6 +56,11 @@ public:
 	unsigned int dashHeight() { return m_dashHeight; }
 	virtual void inputEvent(Event* e);
 
+	virtual void onUpdateWindowRegion(int x, int y, int w, int h);
+
+	// bumped whenever the client updates any part of the window, so the container knows what to repaint
+	unsigned int contentSerial() const { return m_contentSerial; }
+
 private:
 
 	virtual void paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*) {}
@@ -66,6 +71,7 @@ private:
 
 	bool m_manualDragMode;
 	unsigned int m_dashHeight;
+	unsigned int m_contentSerial;
 };	
 
 #endif /* DASHBOARDWINDOW_H */
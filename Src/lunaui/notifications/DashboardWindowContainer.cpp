@@ -76,6 +76,7 @@ DashboardWindowContainer::DashboardWindowContainer(DashboardWindowManager* wm, i
 	, m_itemSeparator(NULL)
 	, m_heightAnimation(this, &DashboardWindowContainer::heightAnimationValueChanged)
 	, m_dashboardManualDrag(false)
+	, m_compositeValid(false)
 {
 
 	setObjectName("DashboardWindowContainer");
@@ -485,6 +486,8 @@ QVariant DashboardWindowContainer::itemChange(GraphicsItemChange change, const Q
 		bool val = value.toBool();
 		if (!val) {
 
+			invalidateComposite();
+
 			m_anim.stop();
 			m_anim.clear();
 
@@ -612,6 +615,7 @@ void DashboardWindowContainer::addWindow(DashboardWindow* win)
 	}
 
 	update();
+	invalidateComposite();
 	
 	win->setParentItem(this);
 	m_items.push_back(win);
@@ -1264,7 +1268,6 @@ void DashboardWindowContainer::paint(QPainter* painter, const QStyleOptionGraphi
 		return;
 	}
 
-	int itemsToDisplay = 0, startIndex = 0, endIndex = 0, curSize = m_items.size();
 	QRect bRect = boundingRect().toRect();
 
 	if (m_items.empty()) {
@@ -1274,33 +1277,10 @@ void DashboardWindowContainer::paint(QPainter* painter, const QStyleOptionGraphi
 	QPainter::CompositionMode previous = painter->compositionMode();
 	painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
 
-	startIndex = 0;
-	endIndex = curSize;
-
 	painter->fillRect(bRect.x(), bRect.y(), bRect.width(), bRect.height(),  Qt::black);
 	painter->setClipRect(bRect.x(), bRect.y(), bRect.width(), bRect.height());
 
-	for(int i = startIndex;;) {
-		DashboardWindow* w = m_items.at(i);
-		QPoint p = w->pos().toPoint();
-
-		const QPixmap* pix = w->acquireScreenPixmap();
-		if (!pix) {
-			g_critical("%s: Failed to acquireScreenPixmap", __PRETTY_FUNCTION__);
-			continue;
-		}
-
-		p -= QPoint(pix->width() / 2, pix->height() / 2);
-
-		painter->drawPixmap(p, *pix);
-
-		// Check if we need to continue or if we are done painting
-		++i;
-		if(i < endIndex)
-			continue;
-		else
-			break;
-	}
+	paintWindows(painter, bRect);
 
 	// Draw the masks if needed
 	if(ShowNoMasks != m_maskDisplayStatus){
@@ -1332,9 +1312,7 @@ void DashboardWindowContainer::paint(QPainter* painter, const QStyleOptionGraphi
 
 void DashboardWindowContainer::paintInsideMenu(QPainter* painter)
 {
-	int itemsToDisplay = 0, startIndex = 0, endIndex = 0, curSize = m_items.size();
 	QRect bRect = boundingRect().toRect();
-	QRect shade;
 
 	if (m_items.empty()) {
 		return;
@@ -1343,20 +1321,133 @@ void DashboardWindowContainer::paintInsideMenu(QPainter* painter)
 	QPainter::CompositionMode previous = painter->compositionMode();
 	painter->setCompositionMode(QPainter::CompositionMode_SourceOver);
 
-	endIndex = 0;
-	startIndex = curSize - 1;
-
 	bool clipWasEnabled = painter->hasClipping();
 	QPainterPath oldPath = painter->clipPath();
 
 	painter->setClipRect(bRect.x(), bRect.y(), bRect.width(), bRect.height(), Qt::IntersectClip);
 
-	// paint the dashboard windows
-	for(int i = startIndex;;) {
+	// the menu scrolls this item under the clip of its flickable, so that clip is what is visible of it
+	paintWindows(painter, painter->clipBoundingRect().toAlignedRect() & bRect);
+
+	// restore the painter
+	painter->setCompositionMode(previous);
+	painter->setClipPath(oldPath, clipWasEnabled ? Qt::ReplaceClip : Qt::NoClip);
+	painter->setClipping(clipWasEnabled);
+}
+
+void DashboardWindowContainer::paintWindows(QPainter* painter, const QRect& viewport)
+{
+	if (viewport.isEmpty())
+		return;
+
+	if (!Settings::LunaSettings()->dashboardCompositeCache ||
+		painter->worldTransform().type() > QTransform::TxTranslate) {
+		paintVisibleWindows(painter, viewport);
+		return;
+	}
+
+	QVector<QPoint> positions(m_items.size());
+	QVector<unsigned int> serials(m_items.size());
+	for (int i = 0; i < m_items.size(); i++) {
+		positions[i] = m_items[i]->pos().toPoint();
+		serials[i] = m_items[i]->contentSerial();
+	}
+
+	// scrolling, swiping or animating: a composite would be stale again by the next frame, so don't
+	// build one until the windows have stayed put for a frame
+	if (viewport != m_compositeRect || m_items != m_compositeWindows || positions != m_compositePositions) {
+		m_compositeRect = viewport;
+		m_compositeWindows = m_items;
+		m_compositePositions = positions;
+		m_compositeValid = false;
+		paintVisibleWindows(painter, viewport);
+		return;
+	}
+
+	// windows whose content changed since the composite was painted; they can be painted over in place
+	// unless swiped aside, with the swipe background in the same row
+	QList<int> changed;
+	bool rebuild = !m_compositeValid;
+	for (int i = 0; i < m_items.size() && !rebuild; i++) {
+		if (serials[i] == m_compositeSerials[i] || !windowVisible(m_items[i], viewport))
+			continue;
+
+		int restingX = m_isMenu ? m_items[i]->boundingRect().width() / 2 : 0;
+		if (positions[i].x() == restingX)
+			changed.append(i);
+		else
+			rebuild = true;
+	}
+
+	if (rebuild) {
+		if (m_composite.size() != viewport.size())
+			m_composite = QPixmap(viewport.size());
+		m_composite.fill(Qt::transparent);
+
+		QPainter p(&m_composite);
+		p.translate(-viewport.topLeft());
+		paintVisibleWindows(&p, viewport);
+		p.end();
+
+		m_compositeValid = true;
+	}
+	else if (!changed.isEmpty()) {
+		QPainter p(&m_composite);
+		p.translate(-viewport.topLeft());
+
+		Q_FOREACH(int i, changed) {
+			const QPixmap* pix = m_items[i]->acquireScreenPixmap();
+			if (!pix) {
+				g_critical("%s: Failed to acquireScreenPixmap", __PRETTY_FUNCTION__);
+				continue;
+			}
+
+			QRect r(positions[i] - QPoint(pix->width() / 2, pix->height() / 2), pix->size());
+			p.setCompositionMode(QPainter::CompositionMode_Source);
+			p.fillRect(r, Qt::transparent);
+			p.setCompositionMode(QPainter::CompositionMode_SourceOver);
+			p.drawPixmap(r.topLeft(), *pix);
+		}
+		p.end();
+	}
+
+	m_compositeSerials = serials;
+
+	painter->drawPixmap(viewport.topLeft(), m_composite);
+}
+
+void DashboardWindowContainer::invalidateComposite()
+{
+	m_composite = QPixmap();
+	m_compositeValid = false;
+	m_compositeWindows.clear();
+	m_compositePositions.clear();
+	m_compositeSerials.clear();
+}
+
+// Only looks at the window's position, so it is cheap enough to run over every window each frame: the
+// pixmaps of the windows scrolled out of the viewport are never acquired
+bool DashboardWindowContainer::windowVisible(DashboardWindow* w, const QRect& viewport) const
+{
+	// a whole row, whatever the window's horizontal swipe offset, and in the menu the separator above it
+	int height = w->boundingRect().height();
+	int top = w->pos().y() - height / 2 - (m_isMenu ? m_menuSeparatorHeight : 0);
+	int bottom = w->pos().y() + height / 2;
+
+	return bottom > viewport.y() && top < viewport.y() + viewport.height();
+}
+
+void DashboardWindowContainer::paintVisibleWindows(QPainter* painter, const QRect& viewport)
+{
+	if (m_isMenu) {
+		paintVisibleWindowsInsideMenu(painter, viewport);
+		return;
+	}
+
+	for (int i = 0; i < m_items.size(); i++) {
 		DashboardWindow* w = m_items.at(i);
-		QPoint p = w->pos().toPoint();
-		QRectF  wRect = w->boundingRect();
-		bool separator = m_itemSeparator && ((i != startIndex) || (p.y() > wRect.height()/2));
+		if (!windowVisible(w, viewport))
+			continue;
 
 		const QPixmap* pix = w->acquireScreenPixmap();
 		if (!pix) {
@@ -1364,41 +1455,68 @@ void DashboardWindowContainer::paintInsideMenu(QPainter* painter)
 			continue;
 		}
 
+		QPoint p = w->pos().toPoint();
 		p -= QPoint(pix->width() / 2, pix->height() / 2);
 
 		painter->drawPixmap(p, *pix);
+	}
+}
 
-		// if it is not the first window, paint the item divider above the window
-		if(G_LIKELY(separator)) {
-			painter->drawPixmap(p.x(), p.y() - m_menuSeparatorHeight, pix->width(), m_menuSeparatorHeight, *m_itemSeparator);
-		}
+void DashboardWindowContainer::paintVisibleWindowsInsideMenu(QPainter* painter, const QRect& viewport)
+{
+	int startIndex = m_items.size() - 1, endIndex = 0;
+	QRect shade;
+
+	// paint the dashboard windows
+	for(int i = startIndex;;) {
+		DashboardWindow* w = m_items.at(i);
+		QPoint p = w->pos().toPoint();
+		QRectF  wRect = w->boundingRect();
+		bool separator = m_itemSeparator && ((i != startIndex) || (p.y() > wRect.height()/2));
 
-		// if the window has been moved from its default position, then paint the background assets
-		if(m_menuSwipeBkg && m_menuSwipeHighlight) {
-			if(w->pos().x() > wRect.width()/2) {
-				shade.setRect(0,
-							  p.y() - (separator ? m_menuSeparatorHeight : 0),
-							  MIN(w->pos().x() - wRect.width()/2, wRect.width()),
-							  wRect.height() + (separator ? m_menuSeparatorHeight : 0));
+		bool visible = windowVisible(w, viewport);
+		const QPixmap* pix = visible ? w->acquireScreenPixmap() : 0;
+		if (visible && !pix) {
+			g_critical("%s: Failed to acquireScreenPixmap", __PRETTY_FUNCTION__);
+		}
 
-				paintHoriz3Tile(painter, m_menuSwipeBkg,
-								shade.x(), shade.y(), shade.width(), shade.height(),
-								MIN(shade.width(), 5), MIN(shade.width(), 5));
+		if (pix) {
+			p -= QPoint(pix->width() / 2, pix->height() / 2);
 
-				painter->drawPixmap(shade.right() - m_menuSwipeHighlight->width() + 1, shade.top(), m_menuSwipeHighlight->width(), shade.height(),
-						            *m_menuSwipeHighlight, 0, 0, m_menuSwipeHighlight->width(), m_menuSwipeHighlight->height());
-			} else if (w->pos().x() < wRect.width()/2) {
-				shade.setRect(MAX(0, w->pos().x() + wRect.width()/2),
-							  p.y() - (separator ? m_menuSeparatorHeight : 0),
-							  MIN(wRect.width()/2 - w->pos().x(), wRect.width()),
-							  wRect.height() + (separator ? m_menuSeparatorHeight : 0));
+			painter->drawPixmap(p, *pix);
 
-				paintHoriz3Tile(painter, m_menuSwipeBkg,
-								shade.x(), shade.y(), shade.width(), shade.height(),
-								MIN(shade.width(), 5), MIN(shade.width(), 5));
+			// if it is not the first window, paint the item divider above the window
+			if(G_LIKELY(separator)) {
+				painter->drawPixmap(p.x(), p.y() - m_menuSeparatorHeight, pix->width(), m_menuSeparatorHeight, *m_itemSeparator);
+			}
 
-				painter->drawPixmap(shade.left(), shade.top(), m_menuSwipeHighlight->width(), shade.height(),
-						            *m_menuSwipeHighlight, 0, 0, m_menuSwipeHighlight->width(), m_menuSwipeHighlight->height());
+			// if the window has been moved from its default position, then paint the background assets
+			if(m_menuSwipeBkg && m_menuSwipeHighlight) {
+				if(w->pos().x() > wRect.width()/2) {
+					shade.setRect(0,
+								  p.y() - (separator ? m_menuSeparatorHeight : 0),
+								  MIN(w->pos().x() - wRect.width()/2, wRect.width()),
+								  wRect.height() + (separator ? m_menuSeparatorHeight : 0));
+
+					paintHoriz3Tile(painter, m_menuSwipeBkg,
+									shade.x(), shade.y(), shade.width(), shade.height(),
+									MIN(shade.width(), 5), MIN(shade.width(), 5));
+
+					painter->drawPixmap(shade.right() - m_menuSwipeHighlight->width() + 1, shade.top(), m_menuSwipeHighlight->width(), shade.height(),
+										*m_menuSwipeHighlight, 0, 0, m_menuSwipeHighlight->width(), m_menuSwipeHighlight->height());
+				} else if (w->pos().x() < wRect.width()/2) {
+					shade.setRect(MAX(0, w->pos().x() + wRect.width()/2),
+								  p.y() - (separator ? m_menuSeparatorHeight : 0),
+								  MIN(wRect.width()/2 - w->pos().x(), wRect.width()),
+								  wRect.height() + (separator ? m_menuSeparatorHeight : 0));
+
+					paintHoriz3Tile(painter, m_menuSwipeBkg,
+									shade.x(), shade.y(), shade.width(), shade.height(),
+									MIN(shade.width(), 5), MIN(shade.width(), 5));
+
+					painter->drawPixmap(shade.left(), shade.top(), m_menuSwipeHighlight->width(), shade.height(),
+										*m_menuSwipeHighlight, 0, 0, m_menuSwipeHighlight->width(), m_menuSwipeHighlight->height());
+				}
 			}
 		}
 
@@ -1436,11 +1554,6 @@ void DashboardWindowContainer::paintInsideMenu(QPainter* painter)
 			break;
 		}
 	}
-
-	// restore the painter
-	painter->setCompositionMode(previous);
-	painter->setClipPath(oldPath, clipWasEnabled ? Qt::ReplaceClip : Qt::NoClip);
-	painter->setClipping(clipWasEnabled);
 }
 
 void DashboardWindowContainer::paintHoriz3Tile(QPainter* painter, QPixmap* maskImg, int x, int y, int width, int height, int leftOffset, int rightOffset)
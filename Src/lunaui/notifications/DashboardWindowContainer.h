@@ -31,6 +31,7 @@
 #include <QWeakPointer>
 #include <QPointer>
 #include <QPixmap>
+#include <QVector>
 
 QT_BEGIN_NAMESPACE
 class QPropertyAnimation;
@@ -90,6 +91,11 @@ private:
 	virtual bool sceneEvent(QEvent* event);
 	virtual void paint(QPainter* painter, const QStyleOptionGraphicsItem*, QWidget*);
 	virtual void paintInsideMenu(QPainter* painter);
+	void paintWindows(QPainter* painter, const QRect& viewport);
+	void paintVisibleWindows(QPainter* painter, const QRect& viewport);
+	void paintVisibleWindowsInsideMenu(QPainter* painter, const QRect& viewport);
+	bool windowVisible(DashboardWindow* w, const QRect& viewport) const;
+	void invalidateComposite();
 	void paintHoriz3Tile(QPainter* painter, QPixmap* maskImg, int x, int y, int width, int height, int leftOffset, int rightOffset);
 	void animateResize(int width, int height);
 	void heightAnimationValueChanged( const QVariant & value);
@@ -197,6 +203,14 @@ private:
 	QPixmap* m_menuSwipeBkg;
 	QPixmap* m_menuSwipeHighlight;
 	QPixmap* m_itemSeparator;
+
+	// the windows as last painted, kept while they stay where they are (see paintWindows)
+	QPixmap m_composite;
+	bool m_compositeValid;
+	QRect m_compositeRect;
+	QList<DashboardWindow*> m_compositeWindows;
+	QVector<QPoint> m_compositePositions;
+	QVector<unsigned int> m_compositeSerials;
 };
 
 #endif /* DASHBOARDWINDOWCONTAINER_H */
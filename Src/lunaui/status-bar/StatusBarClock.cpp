@@ -182,7 +182,7 @@ void StatusBarClock::tick()
 		m_lastUpdateTime.min = timeinfo->tm_min;
 
 		if (m_twelveHour) {
-			::strftime(m_timeBuf, kMaxTimeChars, LOCALIZED("%I:%M").c_str(), timeinfo);
+			::strftime(m_timeBuf, kMaxTimeChars, LOCALIZED_REF("%I:%M").data(), timeinfo);
 
 			if (m_timeBuf[0] == '0') {
 				m_curTimeStr = m_timeBuf + 1;
@@ -190,7 +190,7 @@ void StatusBarClock::tick()
 				m_curTimeStr = m_timeBuf;
 			}
 		} else {
-			::strftime(m_timeBuf, kMaxTimeChars, LOCALIZED("%H:%M").c_str(), timeinfo);
+			::strftime(m_timeBuf, kMaxTimeChars, LOCALIZED_REF("%H:%M").data(), timeinfo);
 			m_curTimeStr = m_timeBuf;
 		}
 		setTimeText(m_curTimeStr);
@@ -290,7 +290,7 @@ void StatusBarServicesConnector::slotAirplaneModeChanged(bool enabled)
 				// the fact that we are in Airplane Mode (at boot time)
 				// Note that we have a separate icon for airplane mode, so we will ask the icon to
 				// disable itself
-				sprintf(m_carrierText, "%s", LOCALIZED("Airplane Mode").c_str());
+				sprintf(m_carrierText, "%s", LOCALIZED_REF("Airplane Mode").data());
 				updateRSSIIcon(false, StatusBar::RSSI_FLIGHT_MODE);
 				Q_EMIT signalCarrierTextChanged(m_carrierText);
 			}
@@ -930,10 +930,10 @@ void StatusBarServicesConnector::handlePowerStatus(const char* radioState, bool
 				sprintf(m_carrierText, "HP webOS");
 		}
 		else if (m_phoneType == PHONE_TYPE_GSM) {
-			sprintf(m_carrierText, "%s", LOCALIZED("Network search...").c_str());
+			sprintf(m_carrierText, "%s", LOCALIZED_REF("Network search...").data());
 		}
 		else {
-			sprintf(m_carrierText, "%s", LOCALIZED("Searching...").c_str());
+			sprintf(m_carrierText, "%s", LOCALIZED_REF("Searching...").data());
 		}
 
 		Q_EMIT signalCarrierTextChanged(m_carrierText);
@@ -954,10 +954,10 @@ void StatusBarServicesConnector::handlePowerStatus(const char* radioState, bool
 			if (m_airplaneMode) {
 				//Airplane mode now has its own icon in the status bar, so hide
 				//the rssi icon when we go into airplane mode
-				sprintf(m_carrierText, "%s", LOCALIZED("Airplane Mode").c_str());
+				sprintf(m_carrierText, "%s", LOCALIZED_REF("Airplane Mode").data());
 				updateRSSIIcon(false, StatusBar::RSSI_FLIGHT_MODE);
 			} else {
-				sprintf(m_carrierText, "%s", LOCALIZED("Phone offline").c_str());
+				sprintf(m_carrierText, "%s", LOCALIZED_REF("Phone offline").data());
 				updateRSSIIcon(false, StatusBar::RSSI_0);
 			}
 
@@ -1114,22 +1114,22 @@ void StatusBarServicesConnector::handleNetworkStatus(const char* networkState, s
 		m_phoneService = NoService;
 
 		if (m_simLocked) {
-			sprintf(m_carrierText, "%s", LOCALIZED("SIM lock").c_str());
+			sprintf(m_carrierText, "%s", LOCALIZED_REF("SIM lock").data());
 		} else if(registration) {
 			if(!strcmp(registration, "searching")) {
 				// SEARCHING
 				m_phoneService = Searching;
 				if (m_phoneType == PHONE_TYPE_GSM) {
-					sprintf(m_carrierText, "%s", LOCALIZED("Network search...").c_str());
+					sprintf(m_carrierText, "%s", LOCALIZED_REF("Network search...").data());
 				}
 				else {
-					sprintf(m_carrierText, "%s", LOCALIZED("Searching...").c_str());
+					sprintf(m_carrierText, "%s", LOCALIZED_REF("Searching...").data());
 				}
 			} else {
 				if (m_simBad && (m_phoneType == PHONE_TYPE_GSM || m_ruim)) {
-					sprintf(m_carrierText, "%s", LOCALIZED("Check SIM").c_str());
+					sprintf(m_carrierText, "%s", LOCALIZED_REF("Check SIM").data());
 				} else {
-					sprintf(m_carrierText, "%s", LOCALIZED("No service").c_str());
+					sprintf(m_carrierText, "%s", LOCALIZED_REF("No service").data());
 				}
 			}
 		}
@@ -1145,11 +1145,11 @@ void StatusBarServicesConnector::handleNetworkStatus(const char* networkState, s
 		m_phoneService = Limited;
 
 		if (m_simBad) {
-			sprintf(m_carrierText, "%s", LOCALIZED("Check SIM-SOS only").c_str());
+			sprintf(m_carrierText, "%s", LOCALIZED_REF("Check SIM-SOS only").data());
 		} else if(m_simLocked) {
-			sprintf(m_carrierText, "%s", LOCALIZED("SIM lock-SOS only").c_str());
+			sprintf(m_carrierText, "%s", LOCALIZED_REF("SIM lock-SOS only").data());
 		} else {
-			sprintf(m_carrierText, "%s", LOCALIZED("SOS Only").c_str());
+			sprintf(m_carrierText, "%s", LOCALIZED_REF("SOS Only").data());
 		}
 
 		if (registration && !strcmp(registration, "denied")) {
@@ -1169,7 +1169,7 @@ void StatusBarServicesConnector::handleNetworkStatus(const char* networkState, s
 		m_phoneInLimitedService = true;
 		updateRSSIIcon(true, StatusBar::RSSI_0);
 	} else {
-		sprintf(m_carrierText, "%s", LOCALIZED("No service").c_str());
+		sprintf(m_carrierText, "%s", LOCALIZED_REF("No service").data());
 		Q_EMIT signalRoamingStateChanged(false);
 
 	}
@@ -1369,21 +1369,21 @@ bool StatusBarServicesConnector::telephonySIMEventsCallback(LSHandle* handle, LS
 					if (!strcmp(state, "simnotfound") || !strcmp(state, "siminvalid")) {
 						m_simBad = true;
 						if (m_phoneService == NoService) {
-							sprintf(m_carrierText, "%s", LOCALIZED("Check SIM").c_str());
+							sprintf(m_carrierText, "%s", LOCALIZED_REF("Check SIM").data());
 						}
 						else if (m_phoneService == Limited) {
-							sprintf(m_carrierText, "%s", LOCALIZED("Check SIM-SOS only").c_str());
+							sprintf(m_carrierText, "%s", LOCALIZED_REF("Check SIM-SOS only").data());
 						}
 					} else if (!strcmp(state, "simready")) {
 						if(m_phoneService == Limited) {
-							sprintf(m_carrierText, "%s", LOCALIZED("SOS Only").c_str());
+							sprintf(m_carrierText, "%s", LOCALIZED_REF("SOS Only").data());
 						} else if(m_phoneService == NoService) {
-							sprintf(m_carrierText, "%s", LOCALIZED("No service").c_str());
+							sprintf(m_carrierText, "%s", LOCALIZED_REF("No service").data());
 						} else if(m_phoneService == Searching) {
 							if (m_phoneType == PHONE_TYPE_GSM) {
-								sprintf(m_carrierText, "%s", LOCALIZED("Network search...").c_str());
+								sprintf(m_carrierText, "%s", LOCALIZED_REF("Network search...").data());
 							} else {
-								sprintf(m_carrierText, "%s", LOCALIZED("Searching...").c_str());
+								sprintf(m_carrierText, "%s", LOCALIZED_REF("Searching...").data());
 							}
 						}
 						m_simBad = false;
@@ -1391,10 +1391,10 @@ bool StatusBarServicesConnector::telephonySIMEventsCallback(LSHandle* handle, LS
 					} else if (!strcmp(state, "pinrequired") || !strcmp(state, "pukrequired") || !strcmp(state, "pinpermblocked")) {
 						m_simLocked = true;
 						if (m_phoneInLimitedService) {
-							sprintf(m_carrierText, "%s", LOCALIZED("Check SIM-SOS only").c_str());
+							sprintf(m_carrierText, "%s", LOCALIZED_REF("Check SIM-SOS only").data());
 						}
 						else {
-							sprintf(m_carrierText, "%s", LOCALIZED("SIM lock").c_str());
+							sprintf(m_carrierText, "%s", LOCALIZED_REF("SIM lock").data());
 						}
 					}
 
@@ -921,7 +921,7 @@ void SystemMenu::slotBatteryLevelUpdated(int percentage)
 		if((percentage >= 0) && (percentage <= 100))
 			sprintf(text, "%d%%", percentage);
 		else
-			sprintf(text, "%s", LOCALIZED("Not Available").c_str()); // $$$ LOCALIZE
+			sprintf(text, "%s", LOCALIZED_REF("Not Available").data()); // $$$ LOCALIZE
 
 		textStr = text;
 		m_menuHandler->updateBatteryLevel(fromStdUtf8(textStr));
@@ -0,0 +1,469 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include "Common.h"
+
+#include "FeedbackMixer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/prctl.h>
+
+#if defined(HAVE_PULSE_FEEDBACK)
+#include <pulse/simple.h>
+#include <pulse/error.h>
+#endif
+
+#include "FrameTimings.h"
+
+static const uint64_t kPeriodUs = (uint64_t) FeedbackMixer::kPeriodFrames * 1000000 / FeedbackMixer::kSampleRate;
+
+class NullFeedbackSink : public FeedbackSink
+{
+public:
+
+	virtual bool write(const int16_t*, int) { return true; }
+	virtual bool paced() const { return false; }
+};
+
+// raw interleaved frames, for tests to compare against what they asked for
+class FileFeedbackSink : public FeedbackSink
+{
+public:
+
+	FileFeedbackSink(FILE* file) : m_file(file) {}
+	virtual ~FileFeedbackSink() { fclose(m_file); }
+
+	virtual bool write(const int16_t* frames, int frameCount) {
+		if (fwrite(frames, sizeof(int16_t) * FeedbackMixer::kChannels, frameCount, m_file) != (size_t) frameCount)
+			return false;
+		return fflush(m_file) == 0;
+	}
+
+	virtual bool paced() const { return false; }
+
+private:
+
+	FILE* m_file;
+};
+
+#if defined(HAVE_PULSE_FEEDBACK)
+
+class PulseFeedbackSink : public FeedbackSink
+{
+public:
+
+	static PulseFeedbackSink* open(const char* device) {
+
+		pa_sample_spec spec;
+		spec.format = PA_SAMPLE_S16LE;
+		spec.rate = FeedbackMixer::kSampleRate;
+		spec.channels = FeedbackMixer::kChannels;
+
+		// keep the server side buffer to a couple of periods, and start playing as soon as one arrives
+		uint32_t periodBytes = FeedbackMixer::kPeriodFrames * FeedbackMixer::kChannels * sizeof(int16_t);
+		pa_buffer_attr attr;
+		attr.maxlength = (uint32_t) -1;
+		attr.tlength = periodBytes * 2;
+		attr.prebuf = periodBytes;
+		attr.minreq = periodBytes;
+		attr.fragsize = (uint32_t) -1;
+
+		int error = 0;
+		pa_simple* pa = pa_simple_new(NULL, "LunaSysMgr", PA_STREAM_PLAYBACK, device, "feedback",
+									  &spec, NULL, &attr, &error);
+		if (!pa) {
+			g_warning("%s: failed to open %s: %s", __PRETTY_FUNCTION__, device ? device : "default sink",
+					  pa_strerror(error));
+			return 0;
+		}
+
+		return new PulseFeedbackSink(pa);
+	}
+
+	virtual ~PulseFeedbackSink() { pa_simple_free(m_pa); }
+
+	virtual bool write(const int16_t* frames, int frameCount) {
+		int error = 0;
+		if (pa_simple_write(m_pa, frames, frameCount * FeedbackMixer::kChannels * sizeof(int16_t), &error) < 0) {
+			g_warning("%s: %s", __PRETTY_FUNCTION__, pa_strerror(error));
+			return false;
+		}
+		return true;
+	}
+
+	virtual bool paced() const { return true; }
+
+	virtual uint32_t latencyUs() {
+		int error = 0;
+		pa_usec_t latency = pa_simple_get_latency(m_pa, &error);
+		return latency == (pa_usec_t) -1 ? 0 : (uint32_t) latency;
+	}
+
+private:
+
+	PulseFeedbackSink(pa_simple* pa) : m_pa(pa) {}
+
+	pa_simple* m_pa;
+};
+
+#endif
+
+FeedbackSink* FeedbackSink::create(const std::string& spec)
+{
+	if (spec == "null")
+		return new NullFeedbackSink;
+
+	if (spec == "pulse" || spec.compare(0, 6, "pulse:") == 0) {
+#if defined(HAVE_PULSE_FEEDBACK)
+		return PulseFeedbackSink::open(spec.size() > 6 ? spec.c_str() + 6 : NULL);
+#else
+		g_warning("%s: built without pulseaudio output", __PRETTY_FUNCTION__);
+		return 0;
+#endif
+	}
+
+	FILE* file = fopen(spec.c_str(), "wb");
+	if (!file) {
+		g_warning("%s: failed to open %s", __PRETTY_FUNCTION__, spec.c_str());
+		return 0;
+	}
+
+	return new FileFeedbackSink(file);
+}
+
+static inline uint32_t PrvReadLE32(const guchar* p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static inline uint16_t PrvReadLE16(const guchar* p)
+{
+	return p[0] | (p[1] << 8);
+}
+
+FeedbackMixer::FeedbackMixer(const std::string& samplesPath, FeedbackSink* sink)
+	: m_samplesPath(samplesPath)
+	, m_loaded(0)
+	, m_sink(sink)
+	, m_thread(0)
+	, m_mutex(g_mutex_new())
+	, m_cond(g_cond_new())
+	, m_quit(false)
+	, m_pendingCount(0)
+	, m_voiceCount(0)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	if (m_sink)
+		m_thread = g_thread_create(FeedbackMixer::mixerThread, this, TRUE, NULL);
+}
+
+FeedbackMixer::~FeedbackMixer()
+{
+	if (m_thread) {
+		g_mutex_lock(m_mutex);
+		m_quit = true;
+		g_cond_signal(m_cond);
+		g_mutex_unlock(m_mutex);
+
+		g_thread_join(m_thread);
+	}
+
+	for (SampleMap::iterator it = m_samples.begin(); it != m_samples.end(); ++it)
+		delete [] it->second.frames;
+
+	delete m_sink;
+
+	g_cond_free(m_cond);
+	g_mutex_free(m_mutex);
+}
+
+bool FeedbackMixer::play(const std::string& name)
+{
+	uint64_t requestedUs = FrameTimings::nowUs();
+
+	const Sample* sample = 0;
+	if (loaded()) {
+		SampleMap::const_iterator it = m_samples.find(name);
+		if (it != m_samples.end())
+			sample = &it->second;
+	}
+
+	g_mutex_lock(m_mutex);
+
+	if (!sample) {
+		m_stats.fallbacks++;
+		g_mutex_unlock(m_mutex);
+		return false;
+	}
+
+	// a burst of clicks faster than the mixer drains them is inaudible as separate sounds anyway
+	if (m_pendingCount == kMaxVoices) {
+		m_stats.dropped++;
+		g_mutex_unlock(m_mutex);
+		return true;
+	}
+
+	Voice& voice = m_pending[m_pendingCount++];
+	voice.sample = sample;
+	voice.position = 0;
+	voice.requestedUs = requestedUs;
+
+	g_cond_signal(m_cond);
+	g_mutex_unlock(m_mutex);
+
+	return true;
+}
+
+gpointer FeedbackMixer::mixerThread(gpointer data)
+{
+	::prctl(PR_SET_NAME, "FeedbackMixer", 0, 0, 0);
+
+	static_cast<FeedbackMixer*>(data)->run();
+	return 0;
+}
+
+void FeedbackMixer::run()
+{
+	loadSamples();
+	g_atomic_int_set(&m_loaded, 1);
+
+	int16_t out[kPeriodFrames * kChannels];
+	Voice started[kMaxVoices];
+	uint64_t nextPeriodUs = 0;
+
+	while (true) {
+
+		g_mutex_lock(m_mutex);
+
+		while (!m_quit && m_pendingCount == 0 && m_voiceCount == 0) {
+			g_cond_wait(m_cond, m_mutex);
+			nextPeriodUs = 0;
+		}
+
+		// whatever is already playing is let finish, so a sound isn't cut off mid click
+		if (m_quit && m_pendingCount == 0 && m_voiceCount == 0) {
+			g_mutex_unlock(m_mutex);
+			break;
+		}
+
+		int startedCount = m_pendingCount;
+		for (int i = 0; i < m_pendingCount; i++) {
+
+			started[i] = m_pending[i];
+
+			if (m_voiceCount < kMaxVoices) {
+				m_voices[m_voiceCount++] = m_pending[i];
+				continue;
+			}
+
+			// out of voices, the one that has played longest gives way
+			int oldest = 0;
+			for (int v = 1; v < m_voiceCount; v++) {
+				if (m_voices[v].position > m_voices[oldest].position)
+					oldest = v;
+			}
+			m_voices[oldest] = m_pending[i];
+		}
+		m_pendingCount = 0;
+
+		g_mutex_unlock(m_mutex);
+
+		mixPeriod(out);
+
+		if (!m_sink->write(out, kPeriodFrames))
+			g_warning("%s: dropped a period", __PRETTY_FUNCTION__);
+
+		uint64_t queuedUs = FrameTimings::nowUs() + m_sink->latencyUs();
+		for (int i = 0; i < startedCount; i++)
+			recordPlayed(started[i].requestedUs, queuedUs);
+
+		if (!m_sink->paced()) {
+			uint64_t now = FrameTimings::nowUs();
+			if (nextPeriodUs == 0)
+				nextPeriodUs = now;
+			nextPeriodUs += kPeriodUs;
+			if (nextPeriodUs > now)
+				g_usleep(nextPeriodUs - now);
+		}
+	}
+}
+
+void FeedbackMixer::mixPeriod(int16_t* out)
+{
+	gint32 acc[kPeriodFrames * kChannels];
+	memset(acc, 0, sizeof(acc));
+
+	int v = 0;
+	while (v < m_voiceCount) {
+
+		Voice& voice = m_voices[v];
+		int frames = MIN(kPeriodFrames, voice.sample->frameCount - voice.position);
+		const int16_t* src = voice.sample->frames + voice.position * kChannels;
+
+		for (int i = 0; i < frames * kChannels; i++)
+			acc[i] += src[i];
+
+		voice.position += frames;
+		if (voice.position >= voice.sample->frameCount)
+			m_voices[v] = m_voices[--m_voiceCount];
+		else
+			v++;
+	}
+
+	for (int i = 0; i < kPeriodFrames * kChannels; i++)
+		out[i] = (int16_t) CLAMP(acc[i], -32768, 32767);
+}
+
+void FeedbackMixer::recordPlayed(uint64_t requestedUs, uint64_t queuedUs)
+{
+	uint32_t latencyUs = (uint32_t) (queuedUs - requestedUs);
+
+	g_mutex_lock(m_mutex);
+	m_stats.played++;
+	m_stats.lastLatencyUs = latencyUs;
+	m_stats.maxLatencyUs = MAX(m_stats.maxLatencyUs, latencyUs);
+	m_stats.totalLatencyUs += latencyUs;
+	g_mutex_unlock(m_mutex);
+}
+
+void FeedbackMixer::getStats(Stats& r_stats) const
+{
+	g_mutex_lock(m_mutex);
+	r_stats = m_stats;
+	g_mutex_unlock(m_mutex);
+}
+
+void FeedbackMixer::resetStats()
+{
+	g_mutex_lock(m_mutex);
+	memset(&m_stats, 0, sizeof(m_stats));
+	g_mutex_unlock(m_mutex);
+}
+
+void FeedbackMixer::loadSamples()
+{
+	GDir* dir = g_dir_open(m_samplesPath.c_str(), 0, NULL);
+	if (!dir) {
+		g_warning("%s: no samples in %s", __PRETTY_FUNCTION__, m_samplesPath.c_str());
+		return;
+	}
+
+	const gchar* fileName;
+	while ((fileName = g_dir_read_name(dir)) != 0) {
+
+		if (!g_str_has_suffix(fileName, ".wav"))
+			continue;
+
+		std::string name(fileName, strlen(fileName) - 4);
+		Sample sample;
+		if (loadWav(m_samplesPath + "/" + fileName, sample))
+			m_samples[name] = sample;
+	}
+
+	g_dir_close(dir);
+
+	g_message("%s: preloaded %d feedback sounds from %s", __PRETTY_FUNCTION__,
+			  (int) m_samples.size(), m_samplesPath.c_str());
+}
+
+bool FeedbackMixer::loadWav(const std::string& path, Sample& r_sample)
+{
+	gchar* data = 0;
+	gsize size = 0;
+
+	if (!g_file_get_contents(path.c_str(), &data, &size, NULL))
+		return false;
+
+	// anything bigger is music, not feedback, and is left to audiod
+	if (size > (gsize) kMaxSampleBytes || size < 12 ||
+		memcmp(data, "RIFF", 4) != 0 || memcmp(data + 8, "WAVE", 4) != 0) {
+		g_free(data);
+		return false;
+	}
+
+	const guchar* bytes = (const guchar*) data;
+	int channels = 0;
+	int rate = 0;
+	int bits = 0;
+	const guchar* pcm = 0;
+	gsize pcmBytes = 0;
+
+	gsize offset = 12;
+	while (offset + 8 <= size) {
+
+		const guchar* chunk = bytes + offset;
+		gsize chunkSize = PrvReadLE32(chunk + 4);
+		if (chunkSize > size - offset - 8)
+			chunkSize = size - offset - 8;
+
+		if (memcmp(chunk, "fmt ", 4) == 0 && chunkSize >= 16) {
+			if (PrvReadLE16(chunk + 8) != 1)		// PCM
+				break;
+			channels = PrvReadLE16(chunk + 10);
+			rate = PrvReadLE32(chunk + 12);
+			bits = PrvReadLE16(chunk + 22);
+		}
+		else if (memcmp(chunk, "data", 4) == 0) {
+			pcm = chunk + 8;
+			pcmBytes = chunkSize;
+		}
+
+		offset += 8 + chunkSize + (chunkSize & 1);
+	}
+
+	if (!pcm || bits != 16 || channels < 1 || channels > 2 || rate < 8000 || rate > 96000) {
+		g_warning("%s: %s is not 16 bit mono or stereo PCM", __PRETTY_FUNCTION__, path.c_str());
+		g_free(data);
+		return false;
+	}
+
+	// convert to the output format up front, so mixing is only adds
+	int srcFrames = pcmBytes / (channels * 2);
+	int dstFrames = (int) ((int64_t) srcFrames * kSampleRate / rate);
+	if (dstFrames <= 0) {
+		g_free(data);
+		return false;
+	}
+
+	r_sample.frames = new int16_t[dstFrames * kChannels];
+	r_sample.frameCount = dstFrames;
+
+	for (int i = 0; i < dstFrames; i++) {
+
+		// 16.16 position in the source, linearly interpolated
+		int64_t pos = ((int64_t) i * rate << 16) / kSampleRate;
+		int index = (int) (pos >> 16);
+		int frac = (int) (pos & 0xffff);
+		int next = MIN(index + 1, srcFrames - 1);
+
+		for (int c = 0; c < kChannels; c++) {
+			int srcChannel = channels == 1 ? 0 : c;
+			int a = (int16_t) PrvReadLE16(pcm + (index * channels + srcChannel) * 2);
+			int b = (int16_t) PrvReadLE16(pcm + (next * channels + srcChannel) * 2);
+			r_sample.frames[i * kChannels + c] = (int16_t) (a + (int) (((int64_t) (b - a) * frac) >> 16));
+		}
+	}
+
+	g_free(data);
+	return true;
+}
@@ -0,0 +1,137 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#ifndef FEEDBACKMIXER_H
+#define FEEDBACKMIXER_H
+
+#include "Common.h"
+
+#include <stdint.h>
+#include <map>
+#include <string>
+#include <glib.h>
+
+/*
+ * Where the mixed feedback stream goes: 16 bit interleaved stereo at FeedbackMixer::kSampleRate.
+ * Opened once and kept for the life of the process.
+ */
+class FeedbackSink
+{
+public:
+
+	virtual ~FeedbackSink() {}
+
+	virtual bool write(const int16_t* frames, int frameCount) = 0;
+
+	// true if write() blocks at the playback rate; otherwise the mixer paces itself
+	virtual bool paced() const = 0;
+
+	// audio handed to the sink that hasn't been heard yet
+	virtual uint32_t latencyUs() { return 0; }
+
+	// "pulse" (when built with HAVE_PULSE_FEEDBACK), "null", or the path of a file to write raw frames to
+	static FeedbackSink* create(const std::string& spec);
+};
+
+/*
+ * Plays the short key click and tap sounds in process.
+ *
+ * Every <name>.wav in the samples directory small enough to be a feedback sound is decoded, converted to
+ * the output format and kept in memory. play() then only queues a voice for the mixer thread, which sums
+ * the active voices into one long lived output stream, so a click costs neither an IPC round trip to
+ * audiod nor opening a stream. Names that weren't preloaded are left to the caller, which asks audiod.
+ */
+class FeedbackMixer
+{
+public:
+
+	struct Stats {
+		uint32_t played;			// voices that made it to the sink
+		uint32_t fallbacks;			// play() calls for names that weren't preloaded
+		uint32_t dropped;			// requests turned away because too many were pending
+		uint32_t lastLatencyUs;		// from play() to its first sample being queued in the sink, plus the sink's own latency
+		uint32_t maxLatencyUs;
+		uint64_t totalLatencyUs;
+	};
+
+	// takes ownership of sink; samples are loaded on the mixer thread, play() falls back until they are
+	FeedbackMixer(const std::string& samplesPath, FeedbackSink* sink);
+	~FeedbackMixer();		// lets the sounds already playing finish
+
+	// false if name isn't (or isn't yet) preloaded
+	bool play(const std::string& name);
+
+	bool loaded() const { return g_atomic_int_get(const_cast<volatile gint*>(&m_loaded)) != 0; }
+	int sampleCount() const { return loaded() ? (int) m_samples.size() : 0; }
+
+	void getStats(Stats& r_stats) const;
+	void resetStats();
+
+	static const int kSampleRate = 44100;
+	static const int kChannels = 2;
+	static const int kPeriodFrames = 256;		// ~6ms
+	static const int kMaxVoices = 8;
+	static const int kMaxSampleBytes = 512 * 1024;
+
+private:
+
+	struct Sample {
+		int16_t* frames;
+		int frameCount;
+	};
+
+	struct Voice {
+		const Sample* sample;
+		int position;
+		uint64_t requestedUs;
+	};
+
+	static gpointer mixerThread(gpointer data);
+	void run();
+	void loadSamples();
+	bool loadWav(const std::string& path, Sample& r_sample);
+	void mixPeriod(int16_t* out);
+	void recordPlayed(uint64_t requestedUs, uint64_t queuedUs);
+
+	typedef std::map<std::string, Sample> SampleMap;
+
+	std::string m_samplesPath;
+	SampleMap m_samples;			// written by the mixer thread before m_loaded is set, read only after
+	volatile gint m_loaded;
+
+	FeedbackSink* m_sink;
+	GThread* m_thread;
+
+	GMutex* m_mutex;				// guards m_pending, m_stats and m_quit
+	GCond* m_cond;
+	bool m_quit;
+	Voice m_pending[kMaxVoices];
+	int m_pendingCount;
+	Stats m_stats;
+
+	Voice m_voices[kMaxVoices];		// mixer thread only
+	int m_voiceCount;
+
+	FeedbackMixer(const FeedbackMixer&);
+	FeedbackMixer& operator=(const FeedbackMixer&);
+};
+
+#endif /* FEEDBACKMIXER_H */
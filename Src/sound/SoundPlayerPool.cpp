@@ -25,8 +25,10 @@
 #include <algorithm>
 #include <cjson/json.h>
 
+#include "FeedbackMixer.h"
 #include "HostBase.h"
 #include "Preferences.h"
+#include "Settings.h"
 
 static SoundPlayerPool* s_instance = 0;
 static const int kMaxPooledPlayers = 0;
@@ -42,9 +44,17 @@ SoundPlayerPool* SoundPlayerPool::instance()
 
 SoundPlayerPool::SoundPlayerPool()
 	: m_purgeTimer(HostBase::instance()->masterTimer(), this, &SoundPlayerPool::purgeTimerFired)
+	, m_feedbackMixer(0)
 {
     s_instance = this;
 
+	const Settings* settings = Settings::LunaSettings();
+	if (settings->feedbackMixerEnabled) {
+		FeedbackSink* sink = FeedbackSink::create(settings->feedbackMixerSink);
+		if (sink)
+			m_feedbackMixer = new FeedbackMixer(settings->feedbackSoundsPath, sink);
+	}
+
 	bool ret;
 	LSError error;
 	LSErrorInit(&error);
@@ -67,8 +77,8 @@ SoundPlayerPool::SoundPlayerPool()
 SoundPlayerPool::~SoundPlayerPool()
 {
 	s_instance = 0;
-	
-	// no-op    
+
+	delete m_feedbackMixer;
 }
 
 sptr<SoundPlayer> SoundPlayerPool::play(const std::string& filePath,
@@ -86,7 +96,7 @@ sptr<SoundPlayer> SoundPlayerPool::play(const std::string& filePath,
 	}
 	
 	// Add to list of active players
-	m_activePlayers.push_back(player);
+	m_activePlayers[player.get()] = player;
 
 	player->play(filePath, streamClass, repeat, duration);
 
@@ -107,7 +117,11 @@ void SoundPlayerPool::playFeedback(const std::string& name,
 {
 	if (sinkName.empty() && !Preferences::instance()->playFeedbackSounds())
 		return;
-	
+
+	// sounds for a specific sink, and any we haven't preloaded, still go through audiod
+	if (sinkName.empty() && m_feedbackMixer && m_feedbackMixer->play(name))
+		return;
+
 	bool ret;
 	LSError error;
 	LSErrorInit(&error);
@@ -133,26 +147,11 @@ void SoundPlayerPool::playFeedback(const std::string& name,
 void SoundPlayerPool::queueFinishedPlayer(sptr<SoundPlayer> player)
 {
 	// Add to list of finished players
-	bool foundInFinishedPlayers = false;
-	for (PlayerList::const_iterator it = m_finishedPlayers.begin();
-		it != m_finishedPlayers.end(); ++it) {
-		if (it->get() == player.get()) {
-			foundInFinishedPlayers = true;
-			break;
-		}
-	}
-
-	if (!foundInFinishedPlayers)
-		m_finishedPlayers.push_back(player);
+	m_finishedPlayers[player.get()] = player;
 
 	// Remove from list of active players
-	for (PlayerList::iterator it = m_activePlayers.begin(); it != m_activePlayers.end(); ++it) {
-		if (it->get() == player.get()) {
-			m_activePlayers.erase(it);
-			break;
-		}
-	}
-		
+	m_activePlayers.erase(player.get());
+
 	if (!m_purgeTimer.running())
 		m_purgeTimer.start(0);
 }
@@ -165,21 +164,15 @@ bool SoundPlayerPool::purgeTimerFired()
 	it = m_finishedPlayers.begin();
 	while (it != m_finishedPlayers.end()) {
 		
-		if ((*it)->dead())
-			it = m_finishedPlayers.erase(it);
+		if (it->second->dead())
+			m_finishedPlayers.erase(it++);
 		else
 			++it;
 	}
 
-	int count = m_finishedPlayers.size();
 	it = m_finishedPlayers.begin();
-	while (it != m_finishedPlayers.end()) {
-
-		if (count <= kMaxPooledPlayers)
-			break;
-
-		it = m_finishedPlayers.erase(it);
-	}
+	while (it != m_finishedPlayers.end() && (int) m_finishedPlayers.size() > kMaxPooledPlayers)
+		m_finishedPlayers.erase(it++);
 	
     return false;
 }
@@ -190,9 +183,9 @@ sptr<SoundPlayer> SoundPlayerPool::getPooledPlayer()
 	PlayerList::iterator it = m_finishedPlayers.begin();
 	while (it != m_finishedPlayers.end()) {
 
-		sptr<SoundPlayer> player = (*it);
+		sptr<SoundPlayer> player = it->second;
 		// explicitly remove from dormant set
-		it = m_finishedPlayers.erase(it);
+		m_finishedPlayers.erase(it++);
 
 		if (player->dead())
 			continue;
@@ -24,7 +24,7 @@
 
 #include "Common.h"
 
-#include <list>
+#include <map>
 #include <string>
 #include <lunaservice.h>
 
@@ -37,6 +37,8 @@
 #include "SoundPlayer.h"
 #endif
 
+class FeedbackMixer;
+
 class SoundPlayerPool
 {
 public:
@@ -50,6 +52,9 @@ public:
 
 	void playFeedback(const std::string& name, const std::string& sinkName=std::string());
 
+	// 0 unless Settings::feedbackMixerEnabled
+	FeedbackMixer* feedbackMixer() const { return m_feedbackMixer; }
+
 private:
 
 	SoundPlayerPool();
@@ -61,12 +66,13 @@ private:
 
 private:
 
-	typedef std::list<sptr<SoundPlayer> > PlayerList;
+	typedef std::map<SoundPlayer*, sptr<SoundPlayer> > PlayerList;
 
 	PlayerList m_activePlayers;
 	PlayerList m_finishedPlayers;
 	LSHandle* m_lsHandle;
 	Timer<SoundPlayerPool> m_purgeTimer;
+	FeedbackMixer* m_feedbackMixer;
 
 	friend class SoundPlayer;
 };
@@ -66,6 +66,8 @@ public:
 	virtual void beginPaint() = 0;
 	virtual void endPaint(bool preserveOnFlip, const PRect& rect, bool flipBuffers = true) = 0;
 	virtual void sendWindowUpdate(int x, int y, int w, int h) = 0;
+	// implementations that batch sendWindowUpdate()s send what they are holding on to
+	virtual void flushWindowUpdates() {}
 
 	virtual bool hasDirectRendering() const { return false; }
 	virtual bool directRenderingAllowed(bool val) = 0;
@@ -45,6 +45,15 @@
 #include "Logging.h"
 #include "Settings.h"
 
+uint32_t RemoteWindowDataSoftware::s_updatesRequested = 0;
+uint32_t RemoteWindowDataSoftware::s_updatesSent = 0;
+uint32_t RemoteWindowDataSoftware::s_updateFlushes = 0;
+
+static inline int PrvArea(int left, int top, int right, int bottom)
+{
+	return (right - left) * (bottom - top);
+}
+
 RemoteWindowDataSoftware::RemoteWindowDataSoftware(int width, int height, bool hasAlpha, bool createIpcBuffer)
 	: m_ipcBuffer(0)
 	, m_width(width)
@@ -55,6 +64,8 @@ RemoteWindowDataSoftware::RemoteWindowDataSoftware(int width, int height, bool h
 	, m_surface(0)
 	, m_directRendering(false)
 	, m_displayOpened(false)
+	, m_numPendingUpdates(0)
+	, m_flushSource(0)
 {
 	m_pitch = calcPitch(m_width);
     
@@ -71,6 +82,11 @@ RemoteWindowDataSoftware::RemoteWindowDataSoftware(int width, int height, bool h
 
 RemoteWindowDataSoftware::~RemoteWindowDataSoftware()
 {
+	if (m_flushSource) {
+		g_source_destroy(m_flushSource);
+		g_source_unref(m_flushSource);
+	}
+
 	if (m_context) {
 		m_surface->releaseRef();
 		m_context->releaseRef();
@@ -91,6 +107,9 @@ int RemoteWindowDataSoftware::key() const
 
 void RemoteWindowDataSoftware::flip()
 {
+	// the host has to see these in the old orientation
+	flushWindowUpdates();
+
 	int width = m_width;
 	m_width = m_height;
 	m_height = width;
@@ -159,11 +178,97 @@ void RemoteWindowDataSoftware::endPaint(bool preserveOnFlip, const PRect& rect,
 void RemoteWindowDataSoftware::sendWindowUpdate(int x, int y, int w, int h)
 {
 	luna_assert(m_channel);
-	if (!m_directRendering) {
-		m_channel->sendAsyncMessage(new ViewHost_UpdateWindowRegion(key(), x, y, w, h));
+	if (m_directRendering || w <= 0 || h <= 0)
+		return;
+
+	s_updatesRequested++;
+
+	// Queue the rect rather than sending it: WebKit tends to paint a frame as many small rects, and
+	// several paint paths may run before we get back to the main loop. Everything queued until then
+	// goes out together, merged wherever that doesn't make the host copy much more than it has to
+	UpdateRect r = { x, y, x + w, y + h };
+
+	bool merged = true;
+	while (merged) {
+		merged = false;
+		for (int i = 0; i < m_numPendingUpdates; i++) {
+			const UpdateRect& p = m_pendingUpdates[i];
+			UpdateRect u = { MIN(p.left, r.left), MIN(p.top, r.top), MAX(p.right, r.right), MAX(p.bottom, r.bottom) };
+			int separate = PrvArea(p.left, p.top, p.right, p.bottom) + PrvArea(r.left, r.top, r.right, r.bottom);
+			if (PrvArea(u.left, u.top, u.right, u.bottom) <= separate + separate / 2) {
+				r = u;
+				m_pendingUpdates[i] = m_pendingUpdates[--m_numPendingUpdates];
+				merged = true;
+				break;
+			}
+		}
+	}
+
+	if (m_numPendingUpdates == kMaxPendingUpdates) {
+		// too scattered, fall back to the bounding rect of all of them
+		for (int i = 0; i < m_numPendingUpdates; i++) {
+			const UpdateRect& p = m_pendingUpdates[i];
+			r.left = MIN(p.left, r.left);
+			r.top = MIN(p.top, r.top);
+			r.right = MAX(p.right, r.right);
+			r.bottom = MAX(p.bottom, r.bottom);
+		}
+		m_numPendingUpdates = 0;
+	}
+
+	m_pendingUpdates[m_numPendingUpdates++] = r;
+
+	if (!m_flushSource) {
+		m_flushSource = g_idle_source_new();
+		g_source_set_priority(m_flushSource, G_PRIORITY_DEFAULT);
+		g_source_set_callback(m_flushSource, flushWindowUpdatesCallback, this, NULL);
+		g_source_attach(m_flushSource, g_main_loop_get_context(WebAppManager::instance()->mainLoop()));
 	}
 }
 
+gboolean RemoteWindowDataSoftware::flushWindowUpdatesCallback(gpointer arg)
+{
+	RemoteWindowDataSoftware* data = (RemoteWindowDataSoftware*) arg;
+
+	// the source goes away when we return FALSE
+	g_source_unref(data->m_flushSource);
+	data->m_flushSource = 0;
+
+	data->flushWindowUpdates();
+	return FALSE;
+}
+
+void RemoteWindowDataSoftware::flushWindowUpdates()
+{
+	if (m_flushSource) {
+		g_source_destroy(m_flushSource);
+		g_source_unref(m_flushSource);
+		m_flushSource = 0;
+	}
+
+	if (m_numPendingUpdates == 0)
+		return;
+
+	luna_assert(m_channel);
+
+	for (int i = 0; i < m_numPendingUpdates; i++) {
+		const UpdateRect& r = m_pendingUpdates[i];
+		m_channel->sendAsyncMessage(new ViewHost_UpdateWindowRegion(key(), r.left, r.top,
+																	 r.right - r.left, r.bottom - r.top));
+	}
+
+	s_updatesSent += m_numPendingUpdates;
+	s_updateFlushes++;
+	m_numPendingUpdates = 0;
+}
+
+void RemoteWindowDataSoftware::getUpdateStats(uint32_t& requested, uint32_t& sent, uint32_t& flushes)
+{
+	requested = s_updatesRequested;
+	sent = s_updatesSent;
+	flushes = s_updateFlushes;
+}
+
 bool RemoteWindowDataSoftware::hasDirectRendering() const
 {
 #if defined(DIRECT_RENDERING)
@@ -232,6 +337,8 @@ void RemoteWindowDataSoftware::prepareSceneTransition(CardWebApp* cardWebApp)
 	metaData->transitionBufferKey = m_transitionIpcBuffer->key();
 	m_metaDataBuffer->unlock();
 
+	flushWindowUpdates();
+
 	m_channel->sendAsyncMessage(new ViewHost_SceneTransitionPrepare(key(), m_width, m_height));
 }
 
@@ -250,6 +357,8 @@ void RemoteWindowDataSoftware::runSceneTransition(CardWebApp* cardWebApp, const
 
 	unlock();
 
+	flushWindowUpdates();
+
 	std::string transitionName = transitionType;
 	if (isPop)
 		transitionName += "-pop";
@@ -274,11 +383,15 @@ void RemoteWindowDataSoftware::crossAppSceneActive(CardWebApp* cardWebApp, int a
 
 	unlock();
 
+	flushWindowUpdates();
+
 	m_channel->sendAsyncMessage(new ViewHost_SceneTransitionRun(key(), "zoom-fade-push"));
 }
 
 void RemoteWindowDataSoftware::prepareCrossAppSceneTransition()
 {
+	flushWindowUpdates();
+
 	m_channel->sendAsyncMessage(new ViewHost_SceneTransitionPrepareCrossApp(key()));
 }
 
@@ -318,6 +431,9 @@ void RemoteWindowDataSoftware::resize(int newWidth, int newHeight)
 	if (m_width == newWidth && m_height == newHeight)
 		return;
 
+	// these refer to the buffer that is about to go away
+	flushWindowUpdates();
+
 	luna_assert(m_ipcBuffer);
 
 	if (m_context) {
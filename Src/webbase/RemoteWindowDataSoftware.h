@@ -23,6 +23,8 @@
 #define REMOTEWINDOWDATASOFTWARE_H
 
 #include <PGSurface.h>
+#include <glib.h>
+#include <stdint.h>
 
 #include "Common.h"
 #include "RemoteWindowData.h"
@@ -64,6 +66,12 @@ public:
 
 	virtual void resize(int newWidth, int newHeight);
 	virtual void clear();
+
+	// sends the window updates queued by sendWindowUpdate() right away
+	virtual void flushWindowUpdates();
+
+	// sendWindowUpdate() calls, ViewHost_UpdateWindowRegion messages they turned into, and flushes (~frames)
+	static void getUpdateStats(uint32_t& requested, uint32_t& sent, uint32_t& flushes);
 	
 protected:
 
@@ -87,6 +95,22 @@ protected:
 
 private:
 
+	enum { kMaxPendingUpdates = 4 };
+
+	struct UpdateRect {
+		int left, top, right, bottom;
+	};
+
+	static gboolean flushWindowUpdatesCallback(gpointer arg);
+
+	UpdateRect m_pendingUpdates[kMaxPendingUpdates];
+	int m_numPendingUpdates;
+	GSource* m_flushSource;
+
+	static uint32_t s_updatesRequested;
+	static uint32_t s_updatesSent;
+	static uint32_t s_updateFlushes;
+
 	RemoteWindowDataSoftware(const RemoteWindowDataSoftware&);
 	RemoteWindowDataSoftware& operator=(const RemoteWindowDataSoftware&);
 };
@@ -21,57 +21,222 @@
 
 #include "WebAppCache.h"
 
+#include <stdint.h>
 #include <list>
-#include <algorithm>
+#include <set>
+#include <string>
+#include <tr1/unordered_map>
+
+#include <glib.h>
 
 #include "WebAppBase.h"
+#include "WebAppManager.h"
+#include "Settings.h"
+
+// a parked app keeps its page, script heap and caches alive even when it has no window buffer
+static const int kMinParkedAppBytes = 2 * 1024 * 1024;
+
+struct WebAppCacheEntry {
+	WebAppBase* app;
+	int bytes;
+};
+
+typedef std::list<WebAppCacheEntry> WebAppCacheType;		// front is the most recently parked
+typedef std::tr1::unordered_map<WebAppBase*, WebAppCacheType::iterator> WebAppCacheIndex;
+
+struct WebAppCacheState {
+	WebAppCacheState() : bytes(0), hits(0), misses(0), evictions(0), reaper(0) {}
+
+	WebAppCacheType lru;
+	WebAppCacheIndex index;
+	int bytes;
+
+	uint32_t hits;
+	uint32_t misses;
+	uint32_t evictions;
+
+	std::set<WebAppBase*> evicted;						// waiting for the reaper to delete them
+	std::set<std::string> evictedAppIds;				// evicted and not launched or parked again since
+	GSource* reaper;
+};
 
-typedef std::list<WebAppBase*> WebAppCacheType;
-static WebAppCacheType* s_cache = 0;
+static WebAppCacheState* s_cache = 0;
 
-static WebAppCacheType* PrvCache()
+static WebAppCacheState* PrvCache()
 {
 	if (!s_cache)
-		s_cache = new WebAppCacheType;
+		s_cache = new WebAppCacheState;
 	return s_cache;
 }
 
-void WebAppCache::put(WebAppBase* app)
+// what a parked app costs us, roughly: its window buffer, and never less than the page behind it
+static int PrvFootprint(WebAppBase* app)
+{
+	int width = 0, height = 0;
+	app->windowSize(width, height);
+	return MAX(width * height * 4, kMinParkedAppBytes);
+}
+
+static void PrvUnlink(WebAppCacheState* cache, WebAppCacheType::iterator it)
+{
+	cache->bytes -= it->bytes;
+	cache->index.erase(it->app);
+	cache->lru.erase(it);
+}
+
+static gboolean PrvReap(gpointer)
 {
-	WebAppCacheType* cache = PrvCache();
-	
-	WebAppCacheType::iterator it = std::find(cache->begin(), cache->end(), app);
-	if (it != cache->end()) {
-		WebAppBase* a = *it;
-		if (a != app) {
-			delete a;
+	WebAppCacheState* cache = PrvCache();
+	cache->reaper = 0;
+
+	while (!cache->evicted.empty()) {
+		WebAppBase* app = *(cache->evicted.begin());
+		cache->evicted.erase(cache->evicted.begin());
+		g_message("%s: deleting parked app %s", __PRETTY_FUNCTION__, app->appId().c_str());
+		delete app;
+	}
+
+	return FALSE;
+}
+
+static void PrvEvict(WebAppCacheState* cache, WebAppCacheType::iterator it)
+{
+	WebAppBase* app = it->app;
+	PrvUnlink(cache, it);
+
+	cache->evictions++;
+	cache->evicted.insert(app);
+	cache->evictedAppIds.insert(app->appId());
+
+	if (!cache->reaper) {
+		cache->reaper = g_idle_source_new();
+		g_source_set_callback(cache->reaper, PrvReap, NULL, NULL);
+		g_source_attach(cache->reaper, g_main_loop_get_context(WebAppManager::instance()->mainLoop()));
+		g_source_unref(cache->reaper);
+	}
+}
+
+// keep-alive apps stay parked, as they always have: they are never evicted and don't count against the limits
+static void PrvEvictDownTo(WebAppCacheState* cache, int maxEntries, int maxBytes)
+{
+	int entries = 0;
+	int bytes = 0;
+	for (WebAppCacheType::const_iterator it = cache->lru.begin(); it != cache->lru.end(); ++it) {
+		if (!it->app->keepAlive()) {
+			entries++;
+			bytes += it->bytes;
 		}
+	}
+
+	// least recently parked first; the most recent one stays even if it alone is over the byte budget
+	WebAppCacheType::iterator it = cache->lru.end();
+	while (it != cache->lru.begin() && (entries > maxEntries || (entries > 1 && bytes > maxBytes))) {
+		--it;
+		if (it->app->keepAlive())
+			continue;
 
-		cache->erase(it);
+		WebAppCacheType::iterator victim = it++;
+		entries--;
+		bytes -= victim->bytes;
+		PrvEvict(cache, victim);
 	}
-	
-	cache->push_back(app);
+}
+
+void WebAppCache::put(WebAppBase* app)
+{
+	WebAppCacheState* cache = PrvCache();
+
+	// in case it got evicted and then parked again before the reaper ran
+	cache->evicted.erase(app);
+	cache->evictedAppIds.erase(app->appId());
+
+	// parked again: it moves to the front, with whatever it costs now
+	WebAppCacheIndex::iterator found = cache->index.find(app);
+	if (found != cache->index.end())
+		PrvUnlink(cache, found->second);
+
+	WebAppCacheEntry entry;
+	entry.app = app;
+	entry.bytes = PrvFootprint(app);
+
+	cache->lru.push_front(entry);
+	cache->index[app] = cache->lru.begin();
+	cache->bytes += entry.bytes;
+
+	const Settings* settings = Settings::LunaSettings();
+	PrvEvictDownTo(cache, settings->maxNumParkedApps, settings->maxParkedAppsMemoryKB * 1024);
 }
 
 void WebAppCache::remove(WebAppBase* app)
 {
-	WebAppCacheType* cache = PrvCache();
+	WebAppCacheState* cache = PrvCache();
 
-	WebAppCacheType::iterator it = std::find(cache->begin(), cache->end(), app);
-	if (it != cache->end()) {
-		cache->erase(it);
+	if (cache->evicted.erase(app))
 		return;
-	}
+
+	WebAppCacheIndex::iterator found = cache->index.find(app);
+	if (found != cache->index.end())
+		PrvUnlink(cache, found->second);
+}
+
+void WebAppCache::take(WebAppBase* app)
+{
+	PrvCache()->hits++;
+	remove(app);
+}
+
+void WebAppCache::recordMiss(const std::string& appId)
+{
+	// a first launch, or a relaunch of an app that was never parked, isn't one the cache could have served
+	if (PrvCache()->evictedAppIds.erase(appId))
+		PrvCache()->misses++;
 }
 
 void WebAppCache::flush()
 {
-	WebAppCacheType* cache = PrvCache();
+	WebAppCacheState* cache = PrvCache();
     
-	while (!cache->empty()) {
-		WebAppBase* a = *(cache->begin());
-		cache->pop_front();
+	while (!cache->lru.empty()) {
+		WebAppBase* a = cache->lru.front().app;
+		PrvUnlink(cache, cache->lru.begin());
+		delete a;
+	}
+
+	while (!cache->evicted.empty()) {
+		WebAppBase* a = *(cache->evicted.begin());
+		cache->evicted.erase(cache->evicted.begin());
 		delete a;
 	}
+}
+
+void WebAppCache::trim(MemoryWatcher::MemState state)
+{
+	WebAppCacheState* cache = PrvCache();
+	const Settings* settings = Settings::LunaSettings();
+
+	switch (state) {
+	case MemoryWatcher::Medium:
+		PrvEvictDownTo(cache, MAX(1, settings->maxNumParkedApps / 2), settings->maxParkedAppsMemoryKB * 1024 / 2);
+		break;
+	case MemoryWatcher::Low:
+		PrvEvictDownTo(cache, 1, 0);
+		break;
+	case MemoryWatcher::Critical:
+		PrvEvictDownTo(cache, 0, 0);
+		break;
+	default:
+		return;
+	}
+
+	g_message("%s: %d parked apps left, %d bytes", __PRETTY_FUNCTION__, (int) cache->lru.size(), cache->bytes);
+}
+
+void WebAppCache::getStatsJSON(std::string& json)
+{
+	WebAppCacheState* cache = PrvCache();
 
+	gchar* str = g_strdup_printf("\"entries\": %d, \"bytes\": %d, \"hits\": %u, \"misses\": %u, \"evictions\": %u",
+								 (int) cache->lru.size(), cache->bytes, cache->hits, cache->misses, cache->evictions);
+	json = str;
+	g_free(str);
 }
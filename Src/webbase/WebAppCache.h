@@ -24,8 +24,25 @@
 
 #include "Common.h"
 
+#include <string>
+
+#include "MemoryWatcher.h"
+
 class WebAppBase;
 
+/*
+ * Parked (closed but kept alive) card apps, least recently parked evicted first.
+ *
+ * Keyed by instance, so several instances of one app can be parked side by side. The cache holds at
+ * most Settings::maxNumParkedApps apps and at most Settings::maxParkedAppsMemoryKB worth of window
+ * buffers, counting an app with a small or no window as a couple of MB (the newest app is always
+ * kept, even if it alone is over that). It is trimmed further
+ * as MemoryWatcher reports memory pressure, down to nothing at Critical. Apps marked keep-alive
+ * (WebAppBase::keepAlive()) are exempt from all of it: never evicted, and not counted against the limits.
+ *
+ * Evicted apps are deleted from an idle callback rather than from under whoever caused the
+ * eviction; an evicted app that gets thawed before then simply stays alive.
+ */
 class WebAppCache
 {
 public:
@@ -33,6 +50,16 @@ public:
 	static void put(WebAppBase* app);
 	static void remove(WebAppBase* app);
 	static void flush();
+
+	// remove() for an app that is being brought back: counts as a hit
+	static void take(WebAppBase* app);
+	// a card app is being launched from scratch: counts as a miss if it was parked and evicted since
+	static void recordMiss(const std::string& appId);
+
+	static void trim(MemoryWatcher::MemState state);
+
+	// "entries", "bytes", "hits", "misses", "evictions" as the members of a JSON object (no braces)
+	static void getStatsJSON(std::string& json);
 };
 
 #endif /* WEBAPPCACHE_H */
@@ -22,6 +22,9 @@
 #include "Common.h"
 
 #include <set>
+#include <map>
+#include <vector>
+#include <algorithm>
 #include <glib.h>
 
 #include <palmwebglobal.h>
@@ -30,19 +33,51 @@
 #include "WebAppDeferredUpdateHandler.h"
 #include "WebPage.h"
 #include "WindowedWebApp.h"
+#include "Time.h"
 
 typedef std::set<WindowedWebApp*> AppSet;
+typedef std::map<WindowedWebApp*, uint32_t> PendingAppMap;	// app -> when it was first deferred
+typedef std::vector<WindowedWebApp*> AppList;
 
 static AppSet s_registeredApps = AppSet();
-static AppSet s_nonActiveApps = AppSet();
+static PendingAppMap s_nonActiveApps = PendingAppMap();
 static WindowedWebApp* s_activeApp = 0;
 static GSource* s_paintSource = 0;
-static const int kPaintTimeOutSecs = 1;
+static uint32_t s_paintCount = 0;
+static const int kPaintTickMs = 100;
+static const int kPaintBudgetMs = 12;
 static const int kActiveAppThrottle = 100;
 static const int kInactiveAppThrottle = 5;
 static const int kActiveAppMinTimerIntervalMs = 0;
 static const int kInactiveAppMinTimerIntervalMs = 2000;
 
+struct PrvPendingPaint {
+	WindowedWebApp* app;
+	uint32_t deferredSince;
+	bool onScreen;
+};
+
+// apps on screen first, then the ones that have been waiting the longest
+struct PrvPaintOrder {
+	bool operator()(const PrvPendingPaint& a, const PrvPendingPaint& b) const {
+		if (a.onScreen != b.onScreen)
+			return a.onScreen;
+		return a.deferredSince < b.deferredSince;
+	}
+};
+
+// suspending, resuming and painting an app can register or unregister apps, so those loops
+// go over a copy of the pending apps
+static void PrvPendingApps(AppList& apps)
+{
+	apps.clear();
+	apps.reserve(s_nonActiveApps.size());
+	for (PendingAppMap::const_iterator it = s_nonActiveApps.begin();
+		 it != s_nonActiveApps.end(); ++it) {
+		apps.push_back(it->first);
+	}
+}
+
 void WebAppDeferredUpdateHandler::registerApp(WindowedWebApp* app)
 {
 	//printf("%s: %p\n", __PRETTY_FUNCTION__, app);
@@ -51,7 +86,7 @@ void WebAppDeferredUpdateHandler::registerApp(WindowedWebApp* app)
 
 	if (s_activeApp && s_activeApp != app) {
 		//printf("%s: %p (app direct rendering already active)\n", __PRETTY_FUNCTION__, app);
-		s_nonActiveApps.insert(app);
+		s_nonActiveApps.insert(PendingAppMap::value_type(app, Time::curTimeMs()));
 		suspendApp(app);
 	}
 }
@@ -82,14 +117,24 @@ void WebAppDeferredUpdateHandler::directRenderingActive(WindowedWebApp* app)
 	stopIdleUpdateTimer();
 
 	s_activeApp = app;
-	s_nonActiveApps.clear();
-	s_nonActiveApps = s_registeredApps;
-	s_nonActiveApps.erase(s_activeApp);
+	s_nonActiveApps.erase(app);
+
+	// apps still waiting from an earlier round keep their place in the queue
+	uint32_t now = Time::curTimeMs();
+	for (AppSet::const_iterator it = s_registeredApps.begin();
+		 it != s_registeredApps.end(); ++it) {
+		if (*it != s_activeApp)
+			s_nonActiveApps.insert(PendingAppMap::value_type(*it, now));
+	}
 
 	resumeApp(s_activeApp);
 
-	for (AppSet::const_iterator it = s_nonActiveApps.begin();
-		 it != s_nonActiveApps.end(); ++it) {
+	AppList apps;
+	PrvPendingApps(apps);
+	for (AppList::const_iterator it = apps.begin(); it != apps.end(); ++it) {
+		if (s_nonActiveApps.find(*it) == s_nonActiveApps.end())
+			continue;
+
 		//printf("%s: suspending %p\n", __PRETTY_FUNCTION__, *it);
 		suspendApp(*it);
 	}
@@ -110,8 +155,12 @@ void WebAppDeferredUpdateHandler::directRenderingInactive(WindowedWebApp* app)
 	if (s_nonActiveApps.empty())
 		return;
 
-	for (AppSet::const_iterator it = s_nonActiveApps.begin();
-		 it != s_nonActiveApps.end(); ++it) {
+	AppList apps;
+	PrvPendingApps(apps);
+	for (AppList::const_iterator it = apps.begin(); it != apps.end(); ++it) {
+		if (s_nonActiveApps.find(*it) == s_nonActiveApps.end())
+			continue;
+
 		//printf("%s: resuming %p\n", __PRETTY_FUNCTION__, *it);
 		(*it)->resumeAppRendering();
 	}
@@ -119,6 +168,19 @@ void WebAppDeferredUpdateHandler::directRenderingInactive(WindowedWebApp* app)
 	startIdleUpdateTimer();
 }
 
+void WebAppDeferredUpdateHandler::getStats(int& pendingPaints, int& oldestPendingMs, uint32_t& paintCount)
+{
+	pendingPaints = s_nonActiveApps.size();
+	oldestPendingMs = 0;
+	paintCount = s_paintCount;
+
+	uint32_t now = Time::curTimeMs();
+	for (PendingAppMap::const_iterator it = s_nonActiveApps.begin();
+		 it != s_nonActiveApps.end(); ++it) {
+		oldestPendingMs = MAX(oldestPendingMs, (int) (now - it->second));
+	}
+}
+
 void WebAppDeferredUpdateHandler::startIdleUpdateTimer()
 {
 	if (s_paintSource)
@@ -126,7 +188,7 @@ void WebAppDeferredUpdateHandler::startIdleUpdateTimer()
 
 	//printf("%s", __PRETTY_FUNCTION__);
 
-	s_paintSource = g_timeout_source_new_seconds(kPaintTimeOutSecs);
+	s_paintSource = g_timeout_source_new(kPaintTickMs);
 	g_source_set_callback(s_paintSource, WebAppDeferredUpdateHandler::paintSourceCallback,
 						  NULL, NULL);
 	g_source_attach(s_paintSource,
@@ -153,12 +215,33 @@ gboolean WebAppDeferredUpdateHandler::paintSourceCallback(gpointer)
 		return false;
 	}
 
-	AppSet::iterator it = s_nonActiveApps.begin();
-	WindowedWebApp* app = *it;
-	s_nonActiveApps.erase(it);
+	std::vector<PrvPendingPaint> queue;
+	queue.reserve(s_nonActiveApps.size());
+	for (PendingAppMap::const_iterator it = s_nonActiveApps.begin();
+		 it != s_nonActiveApps.end(); ++it) {
+		PrvPendingPaint pending = { it->first, it->second, it->first->isOnScreen() };
+		queue.push_back(pending);
+	}
+	std::sort(queue.begin(), queue.end(), PrvPaintOrder());
+
+	// always paint at least one app per tick, then keep going while there's budget left
+	uint32_t start = Time::curTimeMs();
+	for (std::vector<PrvPendingPaint>::const_iterator it = queue.begin();
+		 it != queue.end(); ++it) {
+
+		if (it != queue.begin() && (int) (Time::curTimeMs() - start) >= kPaintBudgetMs)
+			break;
 
-	//printf("%s: paint %p\n", __PRETTY_FUNCTION__, app);
-	app->paint(true);
+		WindowedWebApp* app = it->app;
+
+		// painting may have caused apps to be unregistered
+		if (s_nonActiveApps.erase(app) == 0)
+			continue;
+
+		//printf("%s: paint %p\n", __PRETTY_FUNCTION__, app);
+		app->paint(true);
+		s_paintCount++;
+	}
 
 	return true;
 }
@@ -22,6 +22,8 @@
 #ifndef WEBAPPDEFERREDUPDATEHANDLER_H
 #define WEBAPPDEFERREDUPDATEHANDLER_H
 
+#include <stdint.h>
+
 class WindowedWebApp;
 
 class WebAppDeferredUpdateHandler
@@ -34,6 +36,9 @@ public:
 	static void directRenderingActive(WindowedWebApp* app);
 	static void directRenderingInactive(WindowedWebApp* app);
 
+	// apps waiting for their deferred paint, and how long the oldest of them has been waiting
+	static void getStats(int& pendingPaints, int& oldestPendingMs, uint32_t& paintCount);
+
 private:
 
 	static void startIdleUpdateTimer();
@@ -49,6 +49,8 @@
 #include "Utils.h"
 #include "WebAppBase.h"
 #include "WebAppFactory.h"
+#include "WebAppDeferredUpdateHandler.h"
+#include "RemoteWindowDataSoftware.h"
 #include "WindowedWebApp.h"
 #include "WebPage.h"
 
@@ -1009,6 +1011,10 @@ WebAppBase* WebAppManager::launchUrlInternal(const std::string& url, Window::Typ
 
 	std::string procId = _procId;
 
+	// could have been thawed instead, had it still been parked
+	if (winType == Window::Type_Card)
+		WebAppCache::recordMiss(appId);
+
 	if (!procId.size())
 		procId = ProcessManager::instance()->processIdFactory();
 
@@ -1530,6 +1536,8 @@ bool WebAppManager::preventAppUnderLowMemory(const std::string& appId, Window::T
 
 void WebAppManager::slotMemoryStateChanged(MemoryWatcher::MemState state)
 {
+	WebAppCache::trim(state);
+
 	const char* normalStateStr = "normal";
 	const char* lowStateStr = "low";
 	const char* criticalStateStr = "critical";
@@ -1645,6 +1653,44 @@ static bool PrvDumpHeapProfiler(LSHandle* lsHandle, LSMessage *message,
 }
 #endif // USE_HEAP_PROFILER
 
+// parked app cache and deferred painting, as members of the getStats object
+static std::string PrvAppStats()
+{
+	std::string appCacheStats;
+	WebAppCache::getStatsJSON(appCacheStats);
+
+	int pendingPaints = 0, oldestPendingMs = 0;
+	uint32_t paintCount = 0;
+	WebAppDeferredUpdateHandler::getStats(pendingPaints, oldestPendingMs, paintCount);
+
+	gchar* paintStats = g_strdup_printf("\"pending\": %d, \"oldestPendingMs\": %d, \"painted\": %u",
+										pendingPaints, oldestPendingMs, paintCount);
+
+	guint posts = 0, wakeups = 0, dispatches = 0;
+	WebAppManager::instance()->getEventWakeupStats(posts, wakeups, dispatches);
+
+	gchar* eventStats = g_strdup_printf("\"posts\": %u, \"wakeups\": %u, \"dispatches\": %u",
+										posts, wakeups, dispatches);
+
+	uint32_t updatesRequested = 0, updatesSent = 0, updateFlushes = 0;
+	RemoteWindowDataSoftware::getUpdateStats(updatesRequested, updatesSent, updateFlushes);
+
+	// per flush (~ per frame): requested is what used to go out, sent is what goes out now
+	gchar* updateStats = g_strdup_printf("\"requested\": %u, \"sent\": %u, \"flushes\": %u, "
+										 "\"requestedPerFlush\": %.2f, \"sentPerFlush\": %.2f",
+										 updatesRequested, updatesSent, updateFlushes,
+										 updateFlushes ? (double) updatesRequested / updateFlushes : 0.0,
+										 updateFlushes ? (double) updatesSent / updateFlushes : 0.0);
+
+	std::string stats = " \"appCache\": { " + appCacheStats + " }, \"deferredPaints\": { " + paintStats + " }"
+						+ ", \"eventQueue\": { " + eventStats + " }, \"windowUpdates\": { " + updateStats + " }";
+	g_free(paintStats);
+	g_free(eventStats);
+	g_free(updateStats);
+
+	return stats;
+}
+
 bool PrvGetLunaStats(LSHandle* handle, LSMessage* message, void* ctxt)
 {
     SUBSCRIBE_SCHEMA_RETURN(handle, message);
@@ -1706,6 +1752,9 @@ bool PrvGetLunaStats(LSHandle* handle, LSMessage* message, void* ctxt)
         jsonStr += ", ";
     }
 
+	jsonStr += PrvAppStats();
+	jsonStr += ", ";
+
 	if (subscribed)
 		WebAppManager::instance()->initiateLunaStatsReporting();
 
@@ -1768,6 +1817,9 @@ gboolean PrvPostLunaStats(gpointer ctxt)
         jsonStr += perfStats;
     }
 
+	jsonStr += ", ";
+	jsonStr += PrvAppStats();
+
 	jsonStr += " }";
 
 	if (!LSSubscriptionPost(WebAppManager::instance()->getStatsServiceHandle(),
@@ -20,6 +20,7 @@
 
 
 #include "WebKitSensorConnector.h"
+#include "Settings.h"
 
 WebKitSensorConnector::WebKitSensorConnector(Palm::SensorType aSensorType, Palm::fnSensorDataCallback aDataCB, Palm::fnSensorErrorCallback aErrCB, void *pUserData)
     : m_PalmSensorType(aSensorType)
@@ -29,9 +30,24 @@ WebKitSensorConnector::WebKitSensorConnector(Palm::SensorType aSensorType, Palm:
 {
 #if defined (TARGET_DEVICE)
     m_HALSensorType = WebKitToHAL(aSensorType);
+    m_Listening = false;
 
     // Create the sensor
-    m_Sensor = HALConnectorBase::getSensor(m_HALSensorType, this);
+    const Settings* settings = Settings::LunaSettings();
+    if (settings->sensorSyntheticRate > 0)
+    {
+        m_Sensor = HALConnectorBase::getSyntheticSensor(m_HALSensorType, settings->sensorSyntheticRate, this);
+    }
+    else
+    {
+        m_Sensor = HALConnectorBase::getSensor(m_HALSensorType, this);
+    }
+
+    // A page can't use readings faster than it paints, so take them in batches
+    if (m_Sensor)
+    {
+        m_Sensor->setBatchInterval(settings->sensorBatchIntervalMs);
+    }
 
     // Immediately switch-off the sensor, as HAL starts sending the HAL data immediately
     off();
@@ -211,7 +227,8 @@ HALConnectorBase::SensorReportRate WebKitSensorConnector::WebKitToHAL(Palm::Sens
 
 void WebKitSensorConnector::HALDataAvailable (HALConnectorBase::Sensor aSensorType)
 {
-    if ((HALConnectorBase::SensorIllegal != aSensorType) && (m_Sensor) && (m_DataCB))
+    // Readings still in flight after the page has turned the sensor off aren't worth a json string
+    if ((HALConnectorBase::SensorIllegal != aSensorType) && (m_Sensor) && (m_DataCB) && (m_Listening))
     {
         std::string jsonData = m_Sensor->toJSONString();
 
@@ -219,6 +236,18 @@ void WebKitSensorConnector::HALDataAvailable (HALConnectorBase::Sensor aSensorTy
     }
 }
 
+void WebKitSensorConnector::HALDataBatchAvailable (HALConnectorBase::Sensor aSensorType, const HALSensorSampleRing& aSamples)
+{
+    if (aSamples.dropped())
+    {
+        g_debug("[%s : %d] : Batch of %d samples dropped %d : Sensor Type : [%d]", __PRETTY_FUNCTION__, __LINE__, aSamples.size(), aSamples.dropped(), m_HALSensorType);
+    }
+
+    // By now the sensor holds the latest sample of the batch, which is the one the page gets:
+    // one json string per batch instead of one per sample
+    HALDataAvailable(aSensorType);
+}
+
 #endif
 
 bool WebKitSensorConnector::on()
@@ -229,6 +258,7 @@ bool WebKitSensorConnector::on()
     if (m_Sensor)
     {
         bRetValue = m_Sensor->on();
+        m_Listening = bRetValue;
         if (!bRetValue)
         {
             g_critical("[%s : %d] : Critical Error Occurred while trying to turn the sensor on : Sensor Type : [%d]", __PRETTY_FUNCTION__, __LINE__, m_HALSensorType);
@@ -248,6 +278,7 @@ bool WebKitSensorConnector::off()
     if (m_Sensor)
     {
         bRetValue = m_Sensor->off();
+        m_Listening = false;
         if (!bRetValue)
         {
             g_critical("[%s : %d] : Critical Error Occurred while trying to turn the sensor off : Sensor Type : [%d]", __PRETTY_FUNCTION__, __LINE__, m_HALSensorType);
@@ -96,6 +96,15 @@ protected:
      * @param[in]   - aSensorType - Sensor which has got some data to report
      */
     virtual void HALDataAvailable (HALConnectorBase::Sensor aSensorType);
+
+    /**
+     * Function gets called with the samples HAL has read since the last batch.
+     * Only the latest reading is passed on to the page.
+     *
+     * @param[in]   - aSensorType - Sensor which has got some data to report
+     * @param[in]   - aSamples    - Samples in the order they were read
+     */
+    virtual void HALDataBatchAvailable (HALConnectorBase::Sensor aSensorType, const HALSensorSampleRing& aSamples);
 #endif
 
 private:
@@ -113,6 +122,7 @@ private:
     //Data
     HALConnectorBase*               m_Sensor;
     HALConnectorBase::Sensor        m_HALSensorType;
+    bool                            m_Listening;
 #endif
 
     Palm::SensorType                m_PalmSensorType;
@@ -140,6 +140,18 @@ void WindowedWebApp::init()
 	m_data->setSupportsDirectRendering(m_winType == Window::Type_Card);
 }
 
+bool WindowedWebApp::isOnScreen() const
+{
+	if (!m_metaDataBuffer)
+		return false;
+
+	m_metaDataBuffer->lock();
+	bool onScreen = m_metaData->onScreen;
+	m_metaDataBuffer->unlock();
+
+	return onScreen;
+}
+
 void WindowedWebApp::attach(WebPage* page)
 {
 	// Call into super
@@ -925,6 +937,8 @@ void WindowedWebApp::asyncFlipEvent(int newWidth, int newHeight, int newScreenWi
 	paint(true);
 
 	// notify Host that this window is done resizing
+	if (m_data)
+		m_data->flushWindowUpdates();
 	m_channel->sendAsyncMessage(new ViewHost_AsyncFlipCompleted(routingId(), newWidth, newHeight, newScreenWidth, newScreenHeight));
 }
 
@@ -1011,6 +1025,8 @@ void WindowedWebApp::loadFinished()
 		g_debug("%s: %d Adding to windowManager: %s", __PRETTY_FUNCTION__, __LINE__, m_page ? m_page->url() : "");
 		paint(true);
 
+		if (m_data)
+			m_data->flushWindowUpdates();
 		m_channel->sendAsyncMessage(new ViewHost_AddWindow(routingId()));
 		m_addedToWindowMgr=true;
 	}
@@ -1098,6 +1114,8 @@ void WindowedWebApp::stageReady()
 		g_debug("%s: %d Adding to windowManager: %s", __PRETTY_FUNCTION__, __LINE__, m_page ? m_page->url() : "");
 	 	paint(true);
 
+	 	if (m_data)
+	 		m_data->flushWindowUpdates();
 	 	m_channel->sendAsyncMessage(new ViewHost_AddWindow(routingId()));
 	 	m_addedToWindowMgr=true;
 	}
@@ -1165,6 +1183,8 @@ bool WindowedWebApp::showWindowTimeout()
 	if (!m_addedToWindowMgr && m_winType != Window::Type_ChildCard) {
 	 	paint(true);
 
+	 	if (m_data)
+	 		m_data->flushWindowUpdates();
 	 	m_channel->sendAsyncMessage(new ViewHost_AddWindow(routingId()));
 	 	m_addedToWindowMgr=true;
 	}
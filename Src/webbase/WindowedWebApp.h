@@ -78,6 +78,9 @@ public:
 
 	virtual bool isFocused() const { return m_focused; }
 
+	// as last reported by the HostWindow, see WindowMetaData::onScreen
+	bool isOnScreen() const;
+
 	virtual void sceneTransitionFinished() {}
 
 	virtual void applyLaunchFeedback(int cx, int cy);
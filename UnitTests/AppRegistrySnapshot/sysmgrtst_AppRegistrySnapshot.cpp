@@ -0,0 +1,217 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include <QtTest/QtTest>
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <glib.h>
+
+#include "AppRegistrySnapshot.h"
+
+// -------------------------------------------------------------------------
+
+class AppRegistrySnapshotTest : public QObject
+{
+	Q_OBJECT
+
+private:
+
+	void writeApps(int count, uint32_t generation);
+
+	std::string m_path;
+
+private Q_SLOTS:
+
+	void init();
+	void cleanup();
+	void testRoundTrip();
+	void testRefresh();
+	void testRejectsCorrupt();
+	void testRejectsUntrusted();
+	void benchmarkFindLaunchPoint();
+};
+
+void AppRegistrySnapshotTest::init()
+{
+	m_path = (QDir::tempPath() + "/sysmgrtst_AppRegistrySnapshot").toStdString();
+	::unlink(m_path.c_str());
+}
+
+void AppRegistrySnapshotTest::cleanup()
+{
+	::unlink(m_path.c_str());
+}
+
+// apps added in descending id order, each with a default launch point and every third with a second one
+void AppRegistrySnapshotTest::writeApps(int count, uint32_t generation)
+{
+	AppRegistrySnapshotWriter writer;
+	for (int i = count - 1; i >= 0; i--) {
+		std::string id = QString("com.example.app%1").arg(i, 4, 10, QChar('0')).toStdString();
+		writer.addApp(id, "App " + id, "1.0.0", "/media/cryptofs/apps/" + id, "index.html", "Games",
+					  "", 0, 0, AppRegistryApp::Visible | AppRegistryApp::Removable);
+		writer.addLaunchPoint(id + "_default", "App " + id, "", "/icon.png", "", AppRegistryLaunchPoint::Default);
+		if (i % 3 == 0)
+			writer.addLaunchPoint(id + "_extra", "Extra", "", "/icon.png", "{\"a\":1}", AppRegistryLaunchPoint::Removable);
+	}
+	QVERIFY(writer.write(m_path, generation));
+}
+
+void AppRegistrySnapshotTest::testRoundTrip()
+{
+	writeApps(10, 7);
+
+	AppRegistrySnapshot snapshot;
+	QVERIFY(snapshot.open(m_path));
+	QCOMPARE(snapshot.generation(), (uint32_t) 7);
+	QCOMPARE(snapshot.appCount(), 10);
+	QCOMPARE(snapshot.launchPointCount(), 14);
+
+	// sorted by id whatever the order they were added in
+	for (int i = 1; i < snapshot.appCount(); i++)
+		QVERIFY(strcmp(snapshot.string(snapshot.app(i - 1).id), snapshot.string(snapshot.app(i).id)) < 0);
+
+	int index = snapshot.findApp("com.example.app0003");
+	QVERIFY(index >= 0);
+	const AppRegistryApp& app = snapshot.app(index);
+	QCOMPARE(snapshot.string(app.folderPath), "/media/cryptofs/apps/com.example.app0003");
+	QCOMPARE(snapshot.string(app.category), "Games");
+	QCOMPARE(snapshot.string(app.miniIcon), "");
+	QCOMPARE(app.flags, (uint32_t) (AppRegistryApp::Visible | AppRegistryApp::Removable));
+	QCOMPARE(app.launchPointCount, (uint32_t) 2);
+	QCOMPARE(snapshot.string(snapshot.launchPoint(app.firstLaunchPoint).launchPointId), "com.example.app0003_default");
+	QCOMPARE(snapshot.string(snapshot.launchPoint(app.firstLaunchPoint + 1).params), "{\"a\":1}");
+
+	int lpIndex = snapshot.findLaunchPoint("com.example.app0006_extra");
+	QVERIFY(lpIndex >= 0);
+	QCOMPARE(snapshot.string(snapshot.app(snapshot.launchPoint(lpIndex).app).id), "com.example.app0006");
+
+	QCOMPARE(snapshot.findApp("com.example.missing"), -1);
+	QCOMPARE(snapshot.findLaunchPoint("com.example.app0001_extra"), -1);
+}
+
+void AppRegistrySnapshotTest::testRefresh()
+{
+	AppRegistrySnapshot snapshot;
+	QVERIFY(!snapshot.open(m_path));
+	QVERIFY(!snapshot.refresh());
+
+	writeApps(3, 1);
+	QVERIFY(snapshot.refresh());
+	QCOMPARE(snapshot.appCount(), 3);
+
+	// nothing installed or removed: just a stat()
+	QVERIFY(!snapshot.refresh());
+
+	// a reader holding a mapping keeps seeing the file it mapped until it refreshes
+	writeApps(5, 2);
+	QCOMPARE(snapshot.appCount(), 3);
+	QVERIFY(snapshot.refresh());
+	QCOMPARE(snapshot.generation(), (uint32_t) 2);
+	QCOMPARE(snapshot.appCount(), 5);
+}
+
+void AppRegistrySnapshotTest::testRejectsCorrupt()
+{
+	writeApps(4, 1);
+
+	gchar* contents = 0;
+	gsize length = 0;
+	QVERIFY(g_file_get_contents(m_path.c_str(), &contents, &length, NULL));
+
+	// a launch point pointing past the string table
+	AppRegistryHeader header;
+	memcpy(&header, contents, sizeof(header));
+	AppRegistryLaunchPoint* lp = (AppRegistryLaunchPoint*) (contents + header.launchPointsOffset);
+	lp->title = header.stringsSize + 100;
+	QVERIFY(g_file_set_contents(m_path.c_str(), contents, length, NULL));
+
+	AppRegistrySnapshot snapshot;
+	QVERIFY(!snapshot.open(m_path));
+
+	// truncated
+	QVERIFY(g_file_set_contents(m_path.c_str(), contents, length / 2, NULL));
+	QVERIFY(!snapshot.open(m_path));
+
+	g_free(contents);
+}
+
+void AppRegistrySnapshotTest::testRejectsUntrusted()
+{
+	writeApps(4, 1);
+
+	// written readable by everyone, writable by nobody else
+	struct stat st;
+	QVERIFY(::stat(m_path.c_str(), &st) == 0);
+	QCOMPARE((int) (st.st_mode & 0777), 0644);
+
+	AppRegistrySnapshot snapshot;
+	QVERIFY(snapshot.open(m_path));
+	snapshot.close();
+
+	// anybody could have put it there
+	QVERIFY(::chmod(m_path.c_str(), 0666) == 0);
+	QVERIFY(!snapshot.open(m_path));
+	QVERIFY(::chmod(m_path.c_str(), 0644) == 0);
+
+	// a symlink isn't followed, whatever it points at
+	std::string linkPath = m_path + ".link";
+	::unlink(linkPath.c_str());
+	QVERIFY(::symlink(m_path.c_str(), linkPath.c_str()) == 0);
+	QVERIFY(!snapshot.open(linkPath));
+	::unlink(linkPath.c_str());
+
+	// and a symlink where the old file was is replaced, not written through
+	std::string targetPath = m_path + ".target";
+	QVERIFY(g_file_set_contents(targetPath.c_str(), "untouched", -1, NULL));
+	::unlink(m_path.c_str());
+	QVERIFY(::symlink(targetPath.c_str(), m_path.c_str()) == 0);
+	writeApps(4, 2);
+	QVERIFY(snapshot.open(m_path));
+	QCOMPARE(snapshot.generation(), (uint32_t) 2);
+
+	gchar* contents = 0;
+	QVERIFY(g_file_get_contents(targetPath.c_str(), &contents, NULL, NULL));
+	QCOMPARE(contents, "untouched");
+	g_free(contents);
+	::unlink(targetPath.c_str());
+}
+
+void AppRegistrySnapshotTest::benchmarkFindLaunchPoint()
+{
+	writeApps(300, 1);
+
+	AppRegistrySnapshot snapshot;
+	QVERIFY(snapshot.open(m_path));
+
+	QBENCHMARK {
+		for (int i = 0; i < 300; i += 3) {
+			std::string id = QString("com.example.app%1_extra").arg(i, 4, 10, QChar('0')).toStdString();
+			QVERIFY(snapshot.findLaunchPoint(id.c_str()) >= 0);
+		}
+	}
+}
+
+QTEST_APPLESS_MAIN(AppRegistrySnapshotTest)
+#include "sysmgrtst_AppRegistrySnapshot.moc"
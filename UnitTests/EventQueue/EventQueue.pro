@@ -0,0 +1,55 @@
+# @@@LICENSE
+#
+#      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# LICENSE@@@
+CONFIG += qt no_keywords
+QT += testlib
+QT -= gui
+CONFIG += link_pkgconfig
+PKGCONFIG = glib-2.0 gthread-2.0
+
+VPATH = ../../Src \
+		../../Src/core
+
+INCLUDEPATH = $$VPATH
+
+QMAKE_CXXFLAGS += -fno-rtti -fno-exceptions -Wall -Werror
+
+# TaskBase's events are SysMgrEvents; the sysmgr-ipc headers are all it needs from the staging area
+INCLUDEPATH += \
+		$$(LUNA_STAGING)/include/sysmgr-ipc \
+		$$(STAGING_INCDIR)/sysmgr-ipc
+
+# standalone: TaskBase, its MpscRing lanes and AsyncCaller only need glib, so none of the
+# desktop.pri/device.pri sources and libraries are pulled in here
+OBJECTS_DIR = .obj
+MOC_DIR = .moc
+
+TARGET = sysmgrtst_EventQueue
+
+SOURCES += \
+	AsyncCaller.cpp \
+	Mutex.cpp \
+	TaskBase.cpp \
+	sysmgrtst_EventQueue.cpp
+
+HEADERS += \
+	AsyncCaller.h \
+	Event.h \
+	Mutex.h \
+	MpscRing.h \
+	TaskBase.h \
+	sptr.h
@@ -0,0 +1,442 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+#include <QtTest/QtTest>
+
+#include <list>
+#include <vector>
+#include <glib.h>
+
+#include "sptr.h"
+#include "Mutex.h"
+#include "MpscRing.h"
+#include "Event.h"
+#include "TaskBase.h"
+
+// -------------------------------------------------------------------------
+
+static const int kProducers = 4;
+static const int kItemsPerProducer = 20000;
+
+// stands in for Event: ref counted, and tells us who posted it and in what order
+class Item : public RefCounted
+{
+public:
+	Item(int p, int s) : producer(p), seq(s) {}
+	int producer;
+	int seq;
+};
+
+// the queue TaskBase::postEvent used to have: a recursive mutex around a std::list of sptrs
+class ListQueue
+{
+public:
+	void push(sptr<Item> item) {
+		m_mutex.lock();
+		m_list.push_back(item);
+		m_mutex.unlock();
+	}
+
+	bool pop(sptr<Item>& item) {
+		m_mutex.lock();
+		if (m_list.empty()) {
+			m_mutex.unlock();
+			return false;
+		}
+		item = m_list.front();
+		m_list.pop_front();
+		m_mutex.unlock();
+		return true;
+	}
+
+private:
+	Mutex m_mutex;
+	std::list<sptr<Item> > m_list;
+};
+
+// the way TaskBase uses the ring: the ring owns a reference to each queued item
+class RingQueue
+{
+public:
+	RingQueue() : m_ring(1024) {}
+
+	~RingQueue() {
+		Item* item = 0;
+		while (m_ring.pop(item))
+			item->deref();
+	}
+
+	void push(sptr<Item> item) {
+		item->ref();
+		// the benchmark has no overflow list, wait for the consumer instead
+		while (!m_ring.push(item.get()))
+			g_thread_yield();
+	}
+
+	bool pop(sptr<Item>& item) {
+		Item* raw = 0;
+		if (!m_ring.pop(raw))
+			return false;
+		item = raw;
+		raw->deref();
+		return true;
+	}
+
+private:
+	MpscRing<Item*> m_ring;
+};
+
+// a TaskBase on a context of the test's own, which the test iterates by hand. Events carry the
+// producer in x and its sequence number in y
+class TestTask : public TaskBase
+{
+public:
+	TestTask(GMainContext* ctxt) {
+		m_mainCtxt = ctxt;
+		m_mainLoop = g_main_loop_new(ctxt, FALSE);
+	}
+
+	virtual ~TestTask() {
+		g_main_loop_unref(m_mainLoop);
+	}
+
+	virtual void run() {}
+	virtual void quit() {}
+
+	void post(int producer, int seq, bool highPriority=false) {
+		sptr<Event> e(new Event);
+		e->x = producer;
+		e->y = seq;
+		postEvent(e, highPriority);
+	}
+
+	bool overflowing() { return g_atomic_int_get(&m_eventsOverflowing); }
+
+	std::vector<std::pair<int, int> > handled;
+
+protected:
+
+	virtual void handleEvent(sptr<Event> event) {
+		handled.push_back(std::make_pair((int) event->x, (int) event->y));
+	}
+};
+
+static gboolean timeoutCallback(gpointer data)
+{
+	*static_cast<bool*>(data) = true;
+	return FALSE;
+}
+
+// iterates the task's context until it has handled count events; false if that took over 10s,
+// i.e. a wakeup got lost
+static bool handleEvents(GMainContext* ctxt, TestTask& task, int count)
+{
+	bool timedOut = false;
+	GSource* timeout = g_timeout_source_new(10000);
+	g_source_set_callback(timeout, timeoutCallback, &timedOut, NULL);
+	g_source_attach(timeout, ctxt);
+
+	while ((int) task.handled.size() < count && !timedOut)
+		g_main_context_iteration(ctxt, TRUE);
+
+	g_source_destroy(timeout);
+	g_source_unref(timeout);
+	return !timedOut;
+}
+
+template <class Queue>
+struct ProducerArgs {
+	Queue* queue;
+	int producer;
+};
+
+template <class Queue>
+static gpointer producerThread(gpointer data)
+{
+	ProducerArgs<Queue>* args = static_cast<ProducerArgs<Queue>*>(data);
+	for (int i = 0; i < kItemsPerProducer; i++)
+		args->queue->push(sptr<Item>(new Item(args->producer, i)));
+	return 0;
+}
+
+struct TaskProducerArgs {
+	TestTask* task;
+	int producer;
+};
+
+static gpointer taskProducerThread(gpointer data)
+{
+	TaskProducerArgs* args = static_cast<TaskProducerArgs*>(data);
+	for (int i = 0; i < kItemsPerProducer; i++)
+		args->task->post(args->producer, i);
+	return 0;
+}
+
+// kProducers threads posting to a task whose loop runs on this thread, faster than the rings drain
+// so that posts overflow and go back to the rings along the way. False if anything got lost (or a
+// wakeup did), duplicated or reordered within a producer
+static bool runProducersAndTask(GMainContext* ctxt, TestTask& task)
+{
+	TaskProducerArgs args[kProducers];
+	GThread* threads[kProducers];
+	for (int p = 0; p < kProducers; p++) {
+		args[p].task = &task;
+		args[p].producer = p;
+		threads[p] = g_thread_create(taskProducerThread, &args[p], TRUE, NULL);
+	}
+
+	bool received = handleEvents(ctxt, task, kProducers * kItemsPerProducer);
+
+	for (int p = 0; p < kProducers; p++)
+		g_thread_join(threads[p]);
+
+	if (!received || (int) task.handled.size() != kProducers * kItemsPerProducer || task.overflowing())
+		return false;
+
+	std::vector<int> nextSeq(kProducers, 0);
+	for (size_t i = 0; i < task.handled.size(); i++) {
+		int producer = task.handled[i].first;
+		if (task.handled[i].second != nextSeq[producer])
+			return false;
+		nextSeq[producer]++;
+	}
+	return true;
+}
+
+// runs kProducers threads against one consumer (this thread); returns false if anything got lost,
+// duplicated or reordered within a producer
+template <class Queue>
+static bool runProducersAndConsumer(Queue& queue)
+{
+	ProducerArgs<Queue> args[kProducers];
+	GThread* threads[kProducers];
+	for (int p = 0; p < kProducers; p++) {
+		args[p].queue = &queue;
+		args[p].producer = p;
+		threads[p] = g_thread_create(producerThread<Queue>, &args[p], TRUE, NULL);
+	}
+
+	std::vector<int> nextSeq(kProducers, 0);
+	bool inOrder = true;
+	int received = 0;
+	while (received < kProducers * kItemsPerProducer) {
+		sptr<Item> item;
+		if (!queue.pop(item)) {
+			g_thread_yield();
+			continue;
+		}
+		if (item->seq != nextSeq[item->producer])
+			inOrder = false;
+		nextSeq[item->producer] = item->seq + 1;
+		received++;
+	}
+
+	for (int p = 0; p < kProducers; p++)
+		g_thread_join(threads[p]);
+
+	sptr<Item> extra;
+	return inOrder && !queue.pop(extra);
+}
+
+class EventQueueTest : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	EventQueueTest() {}
+
+private Q_SLOTS:
+
+	void initTestCase();
+	void testRingFifo();
+	void testRingFull();
+	void testRingConcurrent();
+	void testTaskPriority();
+	void testTaskOverflow();
+	void testTaskWakeup();
+	void testTaskConcurrent();
+	void benchmarkMutexList();
+	void benchmarkRing();
+	void benchmarkTask();
+
+private:
+
+	GMainContext* m_ctxt;
+};
+
+void EventQueueTest::initTestCase()
+{
+	if (!g_thread_supported())
+		g_thread_init(NULL);
+
+	m_ctxt = g_main_context_new();
+}
+
+void EventQueueTest::testRingFifo()
+{
+	MpscRing<int> ring(8);
+	int value = 0;
+
+	QVERIFY(!ring.pop(value));
+
+	// a few laps, so the sequence numbers wrap around the slots
+	for (int lap = 0; lap < 5; lap++) {
+		for (int i = 0; i < 6; i++)
+			QVERIFY(ring.push(lap * 10 + i));
+		for (int i = 0; i < 6; i++) {
+			QVERIFY(ring.pop(value));
+			QCOMPARE(value, lap * 10 + i);
+		}
+		QVERIFY(!ring.pop(value));
+	}
+}
+
+void EventQueueTest::testRingFull()
+{
+	MpscRing<int> ring(5);
+	QCOMPARE(ring.capacity(), 8u);
+
+	for (int i = 0; i < 8; i++)
+		QVERIFY(ring.push(i));
+	QVERIFY(!ring.push(8));
+
+	int value = 0;
+	QVERIFY(ring.pop(value));
+	QCOMPARE(value, 0);
+	QVERIFY(ring.push(8));
+
+	for (int i = 1; i <= 8; i++) {
+		QVERIFY(ring.pop(value));
+		QCOMPARE(value, i);
+	}
+	QVERIFY(!ring.pop(value));
+}
+
+void EventQueueTest::testRingConcurrent()
+{
+	RingQueue queue;
+	QVERIFY(runProducersAndConsumer(queue));
+}
+
+void EventQueueTest::testTaskPriority()
+{
+	TestTask task(m_ctxt);
+	for (int i = 0; i < 5; i++)
+		task.post(0, i);
+	task.post(1, 0, true);
+	task.post(1, 1, true);
+
+	QVERIFY(handleEvents(m_ctxt, task, 7));
+
+	// the high priority lane is drained first, each lane in the order it was posted
+	QCOMPARE(task.handled[0], std::make_pair(1, 0));
+	QCOMPARE(task.handled[1], std::make_pair(1, 1));
+	for (int i = 0; i < 5; i++)
+		QCOMPARE(task.handled[2 + i], std::make_pair(0, i));
+}
+
+void EventQueueTest::testTaskOverflow()
+{
+	TestTask task(m_ctxt);
+
+	// nothing drains until the loop runs, so the normal ring (1024 slots) fills up and the rest spills
+	const int count = 3000;
+	for (int i = 0; i < count; i++)
+		task.post(0, i);
+	QVERIFY(task.overflowing());
+
+	// and events that spilled keep their order behind what's in the ring
+	QVERIFY(handleEvents(m_ctxt, task, count));
+	QCOMPARE((int) task.handled.size(), count);
+	for (int i = 0; i < count; i++)
+		QCOMPARE(task.handled[i].second, i);
+	QVERIFY(!task.overflowing());
+
+	// back to the ring once the overflow list is empty
+	task.handled.clear();
+	task.post(0, count);
+	QVERIFY(!task.overflowing());
+	QVERIFY(handleEvents(m_ctxt, task, 1));
+	QCOMPARE(task.handled[0].second, count);
+}
+
+void EventQueueTest::testTaskWakeup()
+{
+	TestTask task(m_ctxt);
+	guint posts, wakeups, dispatches;
+
+	// a burst before the loop gets around to it: one wakeup, one dispatch
+	for (int i = 0; i < 100; i++)
+		task.post(0, i);
+	task.getEventWakeupStats(posts, wakeups, dispatches);
+	QCOMPARE(posts, 100u);
+	QCOMPARE(wakeups, 1u);
+	QCOMPARE(dispatches, 0u);
+
+	QVERIFY(handleEvents(m_ctxt, task, 100));
+	task.getEventWakeupStats(posts, wakeups, dispatches);
+	QCOMPARE(wakeups, 1u);
+	QCOMPARE(dispatches, 1u);
+
+	// once drained, the next post has to wake the loop again
+	task.post(0, 100);
+	task.getEventWakeupStats(posts, wakeups, dispatches);
+	QCOMPARE(wakeups, 2u);
+	QVERIFY(handleEvents(m_ctxt, task, 101));
+	QCOMPARE(task.handled.back().second, 100);
+
+	// nothing is left to wake up for
+	QVERIFY(!g_main_context_iteration(m_ctxt, FALSE));
+}
+
+void EventQueueTest::testTaskConcurrent()
+{
+	TestTask task(m_ctxt);
+	QVERIFY(runProducersAndTask(m_ctxt, task));
+}
+
+void EventQueueTest::benchmarkMutexList()
+{
+	QBENCHMARK {
+		ListQueue queue;
+		QVERIFY(runProducersAndConsumer(queue));
+	}
+}
+
+void EventQueueTest::benchmarkRing()
+{
+	QBENCHMARK {
+		RingQueue queue;
+		QVERIFY(runProducersAndConsumer(queue));
+	}
+}
+
+// the whole path: postEvent() from the producers, wakeups and eventCallback() on the loop
+void EventQueueTest::benchmarkTask()
+{
+	QBENCHMARK {
+		TestTask task(m_ctxt);
+		QVERIFY(runProducersAndTask(m_ctxt, task));
+	}
+}
+
+QTEST_APPLESS_MAIN(EventQueueTest)
+#include "sysmgrtst_EventQueue.moc"
@@ -0,0 +1,178 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+#include <QtTest/QtTest>
+
+#include <glib.h>
+
+#include "expblur.h"
+
+// -------------------------------------------------------------------------
+
+// something with edges, gradients and varying alpha so every channel of the IIR gets exercised
+static QImage makeImage(int width, int height)
+{
+	QImage image(width, height, QImage::Format_ARGB32_Premultiplied);
+	guint32 seed = 0x1234567u + width * 31 + height;
+	for (int y = 0; y < height; y++) {
+		QRgb* line = (QRgb*) image.scanLine(y);
+		for (int x = 0; x < width; x++) {
+			seed = seed * 1664525u + 1013904223u;
+			int a = ((x / 16 + y / 16) & 1) ? 255 : (seed >> 24);
+			int r = (x * 255 / qMax(width - 1, 1)) * a / 255;
+			int g = (y * 255 / qMax(height - 1, 1)) * a / 255;
+			int b = ((seed >> 8) & 0xff) * a / 255;
+			line[x] = qRgba(r, g, b, a);
+		}
+	}
+	return image;
+}
+
+class ExpBlurTest : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	ExpBlurTest() {}
+
+private Q_SLOTS:
+
+	void initTestCase();
+	void testMatchesReference_data();
+	void testMatchesReference();
+	void testSubImage();
+	void benchmarkReference_data();
+	void benchmarkReference();
+	void benchmarkBlur_data();
+	void benchmarkBlur();
+
+private:
+
+	void addSizes();
+};
+
+void ExpBlurTest::initTestCase()
+{
+	if (!g_thread_supported())
+		g_thread_init(NULL);
+}
+
+void ExpBlurTest::testMatchesReference_data()
+{
+	QTest::addColumn<int>("width");
+	QTest::addColumn<int>("height");
+	QTest::addColumn<int>("radius");
+
+	// odd sizes leave partial column strips and an unpaired line; tiny ones have nothing to blur
+	static const int sizes[][2] = { {1, 1}, {2, 1}, {1, 7}, {3, 3}, {17, 5}, {33, 65}, {320, 480}, {1024, 768} };
+	static const int radii[] = { 1, 2, 5, 10, 20, 64 };
+
+	for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (unsigned r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+			QString name = QString("%1x%2 r%3").arg(sizes[s][0]).arg(sizes[s][1]).arg(radii[r]);
+			QTest::newRow(name.toAscii().constData()) << sizes[s][0] << sizes[s][1] << radii[r];
+		}
+	}
+}
+
+void ExpBlurTest::testMatchesReference()
+{
+	QFETCH(int, width);
+	QFETCH(int, height);
+	QFETCH(int, radius);
+
+	QImage image = makeImage(width, height);
+	QImage expected = BlurExponential::blurImageReference(image, radius);
+	QImage actual = BlurExponential::blurImage(image, radius);
+
+	QCOMPARE(actual.size(), expected.size());
+	for (int y = 0; y < height; y++)
+		QVERIFY(memcmp(actual.constScanLine(y), expected.constScanLine(y), width * 4) == 0);
+
+	// the source is left alone
+	QVERIFY(image == makeImage(width, height));
+}
+
+void ExpBlurTest::testSubImage()
+{
+	// bytesPerLine wider than the image, as for an image wrapping part of a bigger buffer
+	QImage big = makeImage(200, 100);
+	QImage sub(big.bits() + 8 * 4, 150, 100, big.bytesPerLine(), QImage::Format_ARGB32_Premultiplied);
+
+	QImage expected = BlurExponential::blurImageReference(sub, 7);
+	QImage actual = BlurExponential::blurImage(sub, 7);
+	for (int y = 0; y < sub.height(); y++)
+		QVERIFY(memcmp(actual.constScanLine(y), expected.constScanLine(y), sub.width() * 4) == 0);
+}
+
+void ExpBlurTest::addSizes()
+{
+	QTest::addColumn<int>("width");
+	QTest::addColumn<int>("height");
+	QTest::addColumn<int>("radius");
+
+	static const int sizes[][2] = { {320, 480}, {1024, 768}, {768, 1024} };
+	static const int radii[] = { 2, 5, 10, 20 };
+
+	for (unsigned s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+		for (unsigned r = 0; r < sizeof(radii) / sizeof(radii[0]); r++) {
+			QString name = QString("%1x%2 r%3").arg(sizes[s][0]).arg(sizes[s][1]).arg(radii[r]);
+			QTest::newRow(name.toAscii().constData()) << sizes[s][0] << sizes[s][1] << radii[r];
+		}
+	}
+}
+
+void ExpBlurTest::benchmarkReference_data()
+{
+	addSizes();
+}
+
+void ExpBlurTest::benchmarkReference()
+{
+	QFETCH(int, width);
+	QFETCH(int, height);
+	QFETCH(int, radius);
+
+	QImage image = makeImage(width, height);
+	QBENCHMARK {
+		QImage blurred = BlurExponential::blurImageReference(image, radius);
+	}
+}
+
+void ExpBlurTest::benchmarkBlur_data()
+{
+	addSizes();
+}
+
+void ExpBlurTest::benchmarkBlur()
+{
+	QFETCH(int, width);
+	QFETCH(int, height);
+	QFETCH(int, radius);
+
+	QImage image = makeImage(width, height);
+	QBENCHMARK {
+		QImage blurred = BlurExponential::blurImage(image, radius);
+	}
+}
+
+QTEST_APPLESS_MAIN(ExpBlurTest)
+#include "sysmgrtst_ExpBlur.moc"
@@ -0,0 +1,231 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include <QtTest/QtTest>
+
+#include <stdio.h>
+#include <unistd.h>
+#include <vector>
+#include <glib.h>
+
+#include "FeedbackMixer.h"
+
+// -------------------------------------------------------------------------
+
+static void writeLE(FILE* file, guint32 value, int bytes)
+{
+	for (int i = 0; i < bytes; i++)
+		fputc((value >> (8 * i)) & 0xff, file);
+}
+
+static void writeWav(const QString& path, int channels, int rate, const std::vector<gint16>& samples)
+{
+	FILE* file = fopen(path.toUtf8().constData(), "wb");
+	QVERIFY(file);
+
+	fwrite("RIFF", 4, 1, file);
+	writeLE(file, 36 + samples.size() * 2, 4);
+	fwrite("WAVEfmt ", 8, 1, file);
+	writeLE(file, 16, 4);
+	writeLE(file, 1, 2);
+	writeLE(file, channels, 2);
+	writeLE(file, rate, 4);
+	writeLE(file, rate * channels * 2, 4);
+	writeLE(file, channels * 2, 2);
+	writeLE(file, 16, 2);
+	fwrite("data", 4, 1, file);
+	writeLE(file, samples.size() * 2, 4);
+	for (size_t i = 0; i < samples.size(); i++)
+		writeLE(file, (guint16) samples[i], 2);
+
+	fclose(file);
+}
+
+static std::vector<gint16> readFrames(const QString& path)
+{
+	std::vector<gint16> frames;
+	FILE* file = fopen(path.toUtf8().constData(), "rb");
+	if (!file)
+		return frames;
+
+	gint16 buffer[1024];
+	size_t count;
+	while ((count = fread(buffer, sizeof(gint16), 1024, file)) > 0)
+		frames.insert(frames.end(), buffer, buffer + count);
+
+	fclose(file);
+	return frames;
+}
+
+class FeedbackMixerTest : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	FeedbackMixerTest() {}
+
+private Q_SLOTS:
+
+	void initTestCase();
+	void init();
+	void cleanup();
+	void testUnknownFallsBack();
+	void testPlaysSample();
+	void testMixClamps();
+	void testRejectsNonPcm();
+
+private:
+
+	FeedbackMixer* createMixer();
+	void waitForPlayed(FeedbackMixer* mixer, uint32_t played);
+
+	QString m_dir;
+	QString m_output;
+	std::vector<gint16> m_click;
+};
+
+void FeedbackMixerTest::initTestCase()
+{
+	if (!g_thread_supported())
+		g_thread_init(NULL);
+}
+
+void FeedbackMixerTest::init()
+{
+	m_dir = QDir::tempPath() + QString("/sysmgrtst_FeedbackMixer.%1").arg(getpid());
+	QDir().mkpath(m_dir);
+	m_output = m_dir + "/out.raw";
+
+	// stereo at the output rate, so it should come out untouched
+	m_click.clear();
+	for (int i = 0; i < 1000; i++) {
+		m_click.push_back(i * 30);
+		m_click.push_back(-i * 30);
+	}
+	writeWav(m_dir + "/click.wav", 2, FeedbackMixer::kSampleRate, m_click);
+
+	// mono at half the rate, loud enough that two of them clip
+	std::vector<gint16> loud(500, 30000);
+	writeWav(m_dir + "/loud.wav", 1, FeedbackMixer::kSampleRate / 2, loud);
+}
+
+void FeedbackMixerTest::cleanup()
+{
+	QDir dir(m_dir);
+	Q_FOREACH(const QString& name, dir.entryList(QDir::Files))
+		dir.remove(name);
+	QDir().rmdir(m_dir);
+}
+
+FeedbackMixer* FeedbackMixerTest::createMixer()
+{
+	FeedbackMixer* mixer = new FeedbackMixer(m_dir.toStdString(),
+											 FeedbackSink::create(m_output.toStdString()));
+	for (int i = 0; i < 1000 && !mixer->loaded(); i++)
+		g_usleep(1000);
+	return mixer;
+}
+
+void FeedbackMixerTest::waitForPlayed(FeedbackMixer* mixer, uint32_t played)
+{
+	FeedbackMixer::Stats stats;
+	for (int i = 0; i < 1000; i++) {
+		mixer->getStats(stats);
+		if (stats.played >= played)
+			break;
+		g_usleep(1000);
+	}
+	QCOMPARE(stats.played, played);
+}
+
+void FeedbackMixerTest::testUnknownFallsBack()
+{
+	FeedbackMixer* mixer = createMixer();
+	QVERIFY(mixer->loaded());
+	QCOMPARE(mixer->sampleCount(), 2);
+
+	QVERIFY(!mixer->play("nosuchsound"));
+
+	FeedbackMixer::Stats stats;
+	mixer->getStats(stats);
+	QCOMPARE(stats.fallbacks, 1u);
+	QCOMPARE(stats.played, 0u);
+
+	delete mixer;
+}
+
+void FeedbackMixerTest::testPlaysSample()
+{
+	FeedbackMixer* mixer = createMixer();
+	QVERIFY(mixer->play("click"));
+	waitForPlayed(mixer, 1);
+
+	FeedbackMixer::Stats stats;
+	mixer->getStats(stats);
+	QVERIFY(stats.maxLatencyUs > 0);
+	QCOMPARE(stats.totalLatencyUs, (uint64_t) stats.lastLatencyUs);
+
+	// the sample is written out whole, padded with silence to the end of the last period
+	delete mixer;
+	std::vector<gint16> out = readFrames(m_output);
+	int periods = (m_click.size() / 2 + FeedbackMixer::kPeriodFrames - 1) / FeedbackMixer::kPeriodFrames;
+	QCOMPARE((int) out.size(), periods * FeedbackMixer::kPeriodFrames * FeedbackMixer::kChannels);
+	for (size_t i = 0; i < m_click.size(); i++)
+		QCOMPARE(out[i], m_click[i]);
+	for (size_t i = m_click.size(); i < out.size(); i++)
+		QCOMPARE(out[i], (gint16) 0);
+}
+
+void FeedbackMixerTest::testMixClamps()
+{
+	FeedbackMixer* mixer = createMixer();
+	QVERIFY(mixer->play("loud"));
+	QVERIFY(mixer->play("loud"));
+	waitForPlayed(mixer, 2);
+
+	delete mixer;
+	std::vector<gint16> out = readFrames(m_output);
+
+	// resampled to twice as many frames, upmixed to stereo; the two voices may start a period apart
+	int clipped = 0;
+	for (size_t i = 0; i < out.size(); i++) {
+		QVERIFY(out[i] == 0 || out[i] == 30000 || out[i] == 32767);
+		if (out[i] == 32767)
+			clipped++;
+	}
+	QVERIFY(clipped > 0);
+}
+
+void FeedbackMixerTest::testRejectsNonPcm()
+{
+	FILE* file = fopen((m_dir + "/junk.wav").toUtf8().constData(), "wb");
+	fputs("RIFF....WAVEnothing useful", file);
+	fclose(file);
+
+	FeedbackMixer* mixer = createMixer();
+	QCOMPARE(mixer->sampleCount(), 2);
+	QVERIFY(!mixer->play("junk"));
+	delete mixer;
+}
+
+QTEST_APPLESS_MAIN(FeedbackMixerTest)
+#include "sysmgrtst_FeedbackMixer.moc"
@@ -0,0 +1,45 @@
+# @@@LICENSE
+#
+#      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+# http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# LICENSE@@@
+CONFIG += qt no_keywords
+QT += testlib
+QT -= gui
+CONFIG += link_pkgconfig
+PKGCONFIG = glib-2.0
+
+VPATH = ../../Src/hal \
+		../../Src/core
+
+INCLUDEPATH = $$VPATH ../../Src
+
+QMAKE_CXXFLAGS += -fno-rtti -fno-exceptions -Wall -Werror
+
+LIBS += -lcjson
+
+# standalone: HALSensorBatch doesn't need the HAL, the synthetic source stands in for the sensors
+OBJECTS_DIR = .obj
+MOC_DIR = .moc
+
+TARGET = sysmgrtst_HALSensorBatch
+
+SOURCES += \
+	HALSensorBatch.cpp \
+	sysmgrtst_HALSensorBatch.cpp
+
+HEADERS += \
+	HALSensorBatch.h \
+	Time.h
@@ -0,0 +1,288 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+#include <QtTest/QtTest>
+
+#include <string>
+#include <cjson/json.h>
+
+#include "HALSensorBatch.h"
+
+// -------------------------------------------------------------------------
+
+static const int kSensor = 1;
+
+static HALSensorSample makeSample(int i)
+{
+	HALSensorSample sample;
+	memset(&sample, 0, sizeof(sample));
+	sample.timestamp = i;
+	sample.sensor = kSensor;
+	sample.count = 3;
+	sample.values[0] = i;
+	return sample;
+}
+
+// what HALAccelerationSensorConnector::toJSONObject() and toJSONString() build for a page
+static std::string toJSONString(const HALSensorSample& sample)
+{
+	json_object* value = json_object_new_object();
+	json_object_object_add(value, "x", json_object_new_double(sample.values[0]));
+	json_object_object_add(value, "y", json_object_new_double(sample.values[1]));
+	json_object_object_add(value, "z", json_object_new_double(sample.values[2]));
+
+	json_object* object = json_object_new_object();
+	json_object_object_add(object, "acceleration", value);
+
+	std::string str = json_object_to_json_string(object);
+	json_object_put(object);
+	return str;
+}
+
+class SampleReceiver : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	SampleReceiver() : jsonBytes(0) {}
+
+	QList<int> batchSizes;
+	QList<int> firstTimestamps;
+	QList<HALSensorSample> samples;
+	size_t jsonBytes;
+
+public Q_SLOTS:
+
+	void batchAvailable(const HALSensorSampleRing& ring)
+	{
+		batchSizes.append(ring.size());
+		firstTimestamps.append(ring.at(0).timestamp);
+	}
+
+	void sampleAvailable(const HALSensorSample& sample)
+	{
+		samples.append(sample);
+	}
+
+	// what WebKitSensorConnector hands a page, for every sample or for the latest one of a batch
+	void sampleToPage(const HALSensorSample& sample)
+	{
+		jsonBytes += toJSONString(sample).size();
+	}
+
+	void batchToPage(const HALSensorSampleRing& ring)
+	{
+		jsonBytes += toJSONString(ring.latest()).size();
+	}
+};
+
+class HALSensorBatchTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+
+	void testRing();
+	void testRingOverflow();
+	void testBatcherCoalesces();
+	void testBatcherFlush();
+	void testBatcherEvent();
+	void testSyntheticSource();
+	void benchmarkDelivery_data();
+	void benchmarkDelivery();
+};
+
+void HALSensorBatchTest::testRing()
+{
+	HALSensorSampleRing ring;
+	QVERIFY(ring.isEmpty());
+
+	for (int i = 0; i < 10; i++)
+		ring.append(makeSample(i));
+
+	QCOMPARE(ring.size(), 10);
+	QCOMPARE(ring.dropped(), 0);
+	for (int i = 0; i < 10; i++)
+		QCOMPARE((int) ring.at(i).timestamp, i);
+	QCOMPARE((int) ring.latest().timestamp, 9);
+
+	ring.clear();
+	QVERIFY(ring.isEmpty());
+}
+
+void HALSensorBatchTest::testRingOverflow()
+{
+	HALSensorSampleRing ring;
+	for (int i = 0; i < HALSensorSampleRing::kCapacity + 5; i++)
+		ring.append(makeSample(i));
+
+	// the oldest make room
+	QCOMPARE(ring.size(), (int) HALSensorSampleRing::kCapacity);
+	QCOMPARE(ring.dropped(), 5);
+	QCOMPARE((int) ring.at(0).timestamp, 5);
+	QCOMPARE((int) ring.latest().timestamp, HALSensorSampleRing::kCapacity + 4);
+
+	ring.clear();
+	QCOMPARE(ring.dropped(), 0);
+	ring.append(makeSample(100));
+	QCOMPARE((int) ring.at(0).timestamp, 100);
+}
+
+void HALSensorBatchTest::testBatcherCoalesces()
+{
+	HALSensorBatcher batcher(20);
+	SampleReceiver receiver;
+	QObject::connect(&batcher, SIGNAL(batchAvailable(const HALSensorSampleRing&)),
+					 &receiver, SLOT(batchAvailable(const HALSensorSampleRing&)));
+
+	for (int i = 0; i < 10; i++)
+		batcher.addSample(makeSample(i));
+
+	// nothing until the interval is up, then all of it at once
+	QCOMPARE(receiver.batchSizes.size(), 0);
+	QTest::qWait(100);
+	QCOMPARE(receiver.batchSizes, QList<int>() << 10);
+	QVERIFY(batcher.pendingSamples().isEmpty());
+
+	batcher.addSample(makeSample(10));
+	QTest::qWait(100);
+	QCOMPARE(receiver.batchSizes, QList<int>() << 10 << 1);
+	QCOMPARE(receiver.firstTimestamps, QList<int>() << 0 << 10);
+}
+
+void HALSensorBatchTest::testBatcherFlush()
+{
+	HALSensorBatcher batcher(20);
+	SampleReceiver receiver;
+	QObject::connect(&batcher, SIGNAL(batchAvailable(const HALSensorSampleRing&)),
+					 &receiver, SLOT(batchAvailable(const HALSensorSampleRing&)));
+
+	batcher.addSample(makeSample(0));
+	batcher.addSample(makeSample(1));
+	batcher.flush();
+	QCOMPARE(receiver.batchSizes, QList<int>() << 2);
+
+	// an empty ring isn't delivered, on time or early
+	batcher.flush();
+	QTest::qWait(60);
+	QCOMPARE(receiver.batchSizes, QList<int>() << 2);
+}
+
+void HALSensorBatchTest::testBatcherEvent()
+{
+	HALSensorBatcher batcher(20);
+	SampleReceiver receiver;
+	QObject::connect(&batcher, SIGNAL(batchAvailable(const HALSensorSampleRing&)),
+					 &receiver, SLOT(batchAvailable(const HALSensorSampleRing&)));
+
+	// a shake starting goes out at once, with the readings before it
+	batcher.addSample(makeSample(0));
+	batcher.addSample(makeSample(1));
+	batcher.addEvent(makeSample(2));
+	QCOMPARE(receiver.batchSizes, QList<int>() << 3);
+
+	// and every change of state on its own, however close together
+	batcher.addEvent(makeSample(3));
+	batcher.addEvent(makeSample(4));
+	QCOMPARE(receiver.batchSizes, QList<int>() << 3 << 1 << 1);
+	QCOMPARE(receiver.firstTimestamps, QList<int>() << 0 << 3 << 4);
+	QVERIFY(batcher.pendingSamples().isEmpty());
+
+	QTest::qWait(60);
+	QCOMPARE(receiver.batchSizes.size(), 3);
+}
+
+void HALSensorBatchTest::testSyntheticSource()
+{
+	HALSyntheticSensorSource source(kSensor, 3, 500);
+	SampleReceiver receiver;
+	QObject::connect(&source, SIGNAL(sampleAvailable(const HALSensorSample&)),
+					 &receiver, SLOT(sampleAvailable(const HALSensorSample&)));
+
+	source.start();
+	QVERIFY(source.isActive());
+	QTest::qWait(200);
+	source.stop();
+
+	// 100 samples give or take a loaded machine
+	int count = receiver.samples.size();
+	QVERIFY2(count >= 50 && count <= 150, qPrintable(QString("%1 samples").arg(count)));
+
+	for (int i = 0; i < count; i++) {
+		const HALSensorSample& sample = receiver.samples.at(i);
+		QCOMPARE((int) sample.sensor, kSensor);
+		QCOMPARE((int) sample.count, 3);
+		for (int v = 0; v < 3; v++)
+			QVERIFY(sample.values[v] >= -1.0f && sample.values[v] <= 1.0f);
+	}
+
+	QTest::qWait(50);
+	QCOMPARE(receiver.samples.size(), count);
+}
+
+void HALSensorBatchTest::benchmarkDelivery_data()
+{
+	QTest::addColumn<bool>("batched");
+	QTest::addColumn<int>("rate");
+
+	QTest::newRow("every sample, 60 Hz") << false << 60;
+	QTest::newRow("batched, 60 Hz") << true << 60;
+	QTest::newRow("every sample, 250 Hz") << false << 250;
+	QTest::newRow("batched, 250 Hz") << true << 250;
+}
+
+// a second of a sensor reporting at the given rate to a page painting at 60 Hz: the synthetic source's
+// samples either each go to the page as a json string, the way WebKitSensorConnector has always done it,
+// or through a HALSensorBatcher which is flushed every 16 ms, in place of its timer, and the page gets a
+// json string per batch
+void HALSensorBatchTest::benchmarkDelivery()
+{
+	QFETCH(bool, batched);
+	QFETCH(int, rate);
+
+	HALSyntheticSensorSource source(kSensor, 3, rate);
+	HALSensorBatcher batcher(1000);
+	SampleReceiver receiver;
+	QObject::connect(&batcher, SIGNAL(batchAvailable(const HALSensorSampleRing&)),
+					 &receiver, SLOT(batchToPage(const HALSensorSampleRing&)));
+
+	QBENCHMARK {
+		int batchEnd = 16;
+		for (int i = 0; i < rate; i++) {
+			HALSensorSample sample = source.nextSample();
+			if (!batched) {
+				receiver.sampleToPage(sample);
+				continue;
+			}
+
+			batcher.addSample(sample);
+			if (i * 1000 / rate >= batchEnd) {
+				batcher.flush();
+				batchEnd += 16;
+			}
+		}
+		batcher.flush();
+	}
+	QVERIFY(receiver.jsonBytes > 0);
+}
+
+QTEST_MAIN(HALSensorBatchTest)
+#include "sysmgrtst_HALSensorBatch.moc"
@@ -101,7 +101,10 @@ SOURCES += \
 	BannerMessageEventFactory.cpp \
 	ApplicationDescription.cpp \
 	LaunchPoint.cpp \
+	LaunchPointSearchIndex.cpp \
 	ApplicationManager.cpp \
+	AppScanCache.cpp \
+	AppRegistrySnapshot.cpp \
 	CmdResourceHandlers.cpp \
 	ApplicationManagerService.cpp \
 	BackupManager.cpp \
@@ -110,7 +113,9 @@ SOURCES += \
 	ApplicationInstaller.cpp \
 	WindowManagerBase.cpp \
 	WindowServer.cpp \
-	FpsHistory.cpp \
+	FrameTimings.cpp \
+	TouchResampler.cpp \
+	ScreenCapture.cpp \
 	WindowServerLuna.cpp \
 	WindowServerMinimal.cpp \
 	WindowManagerMinimal.cpp \
@@ -129,6 +134,7 @@ SOURCES += \
 	SingletonTimer.cpp \
 	Timer.cpp \
 	WebAppManager.cpp \
+	WebAppDeferredUpdateHandler.cpp \
 	Settings.cpp \
 	DisplayManager.cpp \
 	DisplayStates.cpp \
@@ -154,9 +160,11 @@ SOURCES += \
 	PersistentWindowCache.cpp \
 	WindowContentTransitionRunner.cpp \
 	RoundedCorners.cpp \
+	RoundedCornerCompositor.cpp \
 	CoreNaviManager.cpp \
 	CoreNaviLeds.cpp \
 	MemoryWatcher.cpp \
+	LocaleCatalog.cpp \
 	Localization.cpp \
 	SSLSupport.cpp \
 	DeviceInfo.cpp \
@@ -164,6 +172,7 @@ SOURCES += \
 	EASPolicyManager.cpp \
 	AnimationSettings.cpp \
 	MimeSystem.cpp \
+	RedirectMatcher.cpp \
 	IpcServer.cpp \
 	IpcClientHost.cpp \
 	WebAppMgrProxy.cpp\
@@ -172,6 +181,7 @@ SOURCES += \
 	FullEraseConfirmationWindow.cpp \
 	Variant.cpp \
 	SoundPlayerPool.cpp \
+	FeedbackMixer.cpp \
 	AsyncCaller.cpp \
 	HostWindow.cpp \
 	HostWindowData.cpp \
@@ -237,6 +247,7 @@ HEADERS += \
 	ApplicationInstallerErrors.h \
 	ApplicationInstaller.h \
 	ApplicationManager.h \
+	AppScanCache.h \
 	ApplicationStatus.h \
 	BackupManager.h \
 	CmdResourceHandlers.h \
@@ -258,13 +269,17 @@ HEADERS += \
 	RemoteWindowData.h \
 	InputManager.h \
 	LaunchPoint.h \
+	LaunchPointSearchIndex.h \
+	LocaleCatalog.h \
 	Localization.h \
 	Logging.h \
 	MetaKeyManager.h \
 	MimeSystem.h \
+	RedirectMatcher.h \
 	Preferences.h \
 	ProcessManager.h \
 	RoundedCorners.h \
+	RoundedCornerCompositor.h \
 	Security.h \
 	Settings.h \
 	SuspendBlocker.h \
@@ -275,6 +290,9 @@ HEADERS += \
 	Window.h \
 	WindowManagerBase.h \
 	WindowServer.h \
+	FrameTimings.h \
+	TouchResampler.h \
+	ScreenCapture.h \
 	AnimationEquations.h \
 	AsyncCaller.h \
 	AsyncTask.h \
@@ -326,11 +344,13 @@ HEADERS += \
 	WebAppMgrProxy.h \
 	SoundPlayer.h \
 	SoundPlayerPool.h \
+	FeedbackMixer.h \
 	MemoryWatcher.h \
 	ProcessBase.h \
 	WebAppBase.h \
 	WebAppFactory.h \
 	WebAppManager.h \
+	WebAppDeferredUpdateHandler.h \
 	WebPageCache.h \
 	WebPageClient.h \
 	WebPage.h \
@@ -30,6 +30,8 @@
 
 #include <HidLib.h>
 #include "hiddtp_qws.h"
+#include "TouchRecording.h"
+#include "TouchResampler.h"
 
 Q_IMPORT_PLUGIN (hiddtp)
 Q_IMPORT_PLUGIN (hiddkbd)
@@ -111,6 +113,7 @@ private:
 	void sendTwoTouchDown(int x1, int y1, int x2, int y2, int code1=0, int code2=1);
 	void sendTwoTouchUpdate(int x1, int y1, int x2, int y2, int code1=0, int code2=1);
 	void sendTwoTouchUp(int x1, int y1, int x2, int y2, int code1=0, int code2=1);
+	void makeDrag(TouchRecording& recording, int scans, int intervalMs);
 
 private Q_SLOTS:
 	
@@ -118,6 +121,13 @@ private Q_SLOTS:
 	void testTap();
 	void testNoTapWithTwoFingers();
 	void testTapAfterTwoTouchDowns();
+	void testRecordAndReplay();
+	void testReplaySpeed();
+	void testReplayFile();
+	void benchmarkReplay();
+	void testResampleInterpolate();
+	void testResamplePredict();
+	void testResampleModes();
 };
 
 void InputTouch::initTestCase()
@@ -469,5 +479,167 @@ void InputTouch::testTapAfterTwoTouchDowns()
 	QVERIFY(s_sawTapGestureFinish);
 }
 
+// a one finger drag, intervalMs apart, that ends where it started so it still counts as a tap
+void InputTouch::makeDrag(TouchRecording& recording, int scans, int intervalMs)
+{
+	std::vector<struct input_event> events;
+	struct timeval time = { 1000, 0 };
+
+	for (int i = 0; i < scans; i++) {
+		int pressed = i == 0 ? 1 : (i == scans - 1 ? 0 : -1);
+		int offset = (i == 0 || i == scans - 1) ? 0 : (i & 1);
+		TouchRecording::appendTouch(events, time, 0, 100 + offset, 100 + offset, pressed);
+		TouchRecording::appendSync(events, time);
+
+		time.tv_usec += intervalMs * 1000;
+		time.tv_sec += time.tv_usec / 1000000;
+		time.tv_usec %= 1000000;
+	}
+
+	QDesktopWidget* desktopWidget = QApplication::desktop();
+	recording.setEvents(events, desktopWidget->screenGeometry().width(), desktopWidget->screenGeometry().height());
+}
+
+void InputTouch::testRecordAndReplay()
+{
+	QWSHiddTpHandler* handler = static_cast<QWSHiddTpHandler*>(QWSServer::mouseHandler());
+	QString prefix = QDir::tempPath() + "/sysmgrtst_InputTouch";
+	QString eventsPath = prefix + ".events";
+
+	handler->startRecording(prefix.toUtf8().constData());
+	sendTouchDown(100, 100);
+	sendTouchUp(100, 100);
+	handler->stopRecording();
+
+	TouchRecording recording;
+	QVERIFY(recording.load(eventsPath.toUtf8().constData()));
+	QCOMPARE(recording.scanCount(), 2);
+	QCOMPARE((int) recording.events().size(), 10);
+
+	s_sawTapGestureStart = false;
+	s_sawTapGestureFinish = false;
+
+	QCOMPARE(handler->replay(recording, 0), 2);
+	QVERIFY(s_sawTapGestureStart);
+	QVERIFY(s_sawTapGestureFinish);
+
+	QFile::remove(prefix);
+	QFile::remove(eventsPath);
+}
+
+void InputTouch::testReplaySpeed()
+{
+	QWSHiddTpHandler* handler = static_cast<QWSHiddTpHandler*>(QWSServer::mouseHandler());
+
+	// 200ms as recorded
+	TouchRecording recording;
+	makeDrag(recording, 11, 20);
+
+	QTime timer;
+	timer.start();
+	s_sawTapGestureFinish = false;
+	QCOMPARE(handler->replay(recording, 100), 11);
+	QVERIFY(s_sawTapGestureFinish);
+	QVERIFY(timer.elapsed() >= 190);
+
+	timer.start();
+	s_sawTapGestureFinish = false;
+	QCOMPARE(handler->replay(recording, 1000), 11);
+	QVERIFY(s_sawTapGestureFinish);
+	QVERIFY(timer.elapsed() < 150);
+}
+
+void InputTouch::testReplayFile()
+{
+	// e.g. a Sym+Opt+w recording pulled off a device
+	QByteArray path = qgetenv("SYSMGRTST_TOUCH_RECORDING");
+	if (path.isEmpty())
+		QSKIP("set SYSMGRTST_TOUCH_RECORDING to replay a recorded .events file", SkipSingle);
+
+	TouchRecording recording;
+	QVERIFY(recording.load(path.constData()));
+
+	QWSHiddTpHandler* handler = static_cast<QWSHiddTpHandler*>(QWSServer::mouseHandler());
+	QCOMPARE(handler->replay(recording, 100), recording.scanCount());
+}
+
+void InputTouch::benchmarkReplay()
+{
+	QWSHiddTpHandler* handler = static_cast<QWSHiddTpHandler*>(QWSServer::mouseHandler());
+
+	TouchRecording recording;
+	makeDrag(recording, 200, 16);
+
+	QBENCHMARK {
+		handler->replay(recording, 0);
+	}
+}
+
+void InputTouch::testResampleInterpolate()
+{
+	// moving 10px every 8ms
+	TouchResampler resampler;
+	resampler.addSample(0, 100000, 0, 0);
+	resampler.addSample(0, 108000, 10, 0);
+	resampler.addSample(0, 116000, 20, 0);
+
+	int x = -1, y = -1;
+	QVERIFY(!resampler.resample(0, 120000, TouchResampler::ModeOff, x, y));
+	QCOMPARE(x, -1);
+
+	// a frame at 120ms is drawn with the finger as it was at 112ms, half way between two scans
+	QVERIFY(resampler.resample(0, 120000, TouchResampler::ModeInterpolate, x, y));
+	QCOMPARE(x, 15);
+	QCOMPARE(y, 0);
+
+	// never ahead of the newest scan
+	QVERIFY(resampler.resample(0, 140000, TouchResampler::ModeInterpolate, x, y));
+	QCOMPARE(x, 20);
+
+	// a single position is not enough to go on
+	resampler.addSample(1, 116000, 50, 50);
+	QVERIFY(!resampler.resample(1, 120000, TouchResampler::ModeInterpolate, x, y));
+
+	resampler.removeTouch(0);
+	QVERIFY(!resampler.resample(0, 120000, TouchResampler::ModeInterpolate, x, y));
+}
+
+void InputTouch::testResamplePredict()
+{
+	TouchResampler resampler;
+	resampler.setMaxPredictionUs(12000);
+	resampler.addSample(0, 100000, 0, 0);
+	resampler.addSample(0, 108000, 10, 20);
+	resampler.addSample(0, 116000, 20, 40);
+
+	// 8ms past the newest scan, at 1.25px/ms and 2.5px/ms
+	int x, y;
+	QVERIFY(resampler.resample(0, 124000, TouchResampler::ModePredict, x, y));
+	QCOMPARE(x, 30);
+	QCOMPARE(y, 60);
+
+	// capped at 12ms
+	QVERIFY(resampler.resample(0, 200000, TouchResampler::ModePredict, x, y));
+	QCOMPARE(x, 35);
+	QCOMPARE(y, 70);
+
+	// the finger stopped: a held scan takes the velocity over the window down, a long pause removes it
+	resampler.addSample(0, 124000, 20, 40);
+	QVERIFY(resampler.resample(0, 132000, TouchResampler::ModePredict, x, y));
+	QVERIFY(x < 30);
+	resampler.addSample(0, 200000, 20, 40);
+	QVERIFY(resampler.resample(0, 208000, TouchResampler::ModePredict, x, y));
+	QCOMPARE(x, 20);
+	QCOMPARE(y, 40);
+}
+
+void InputTouch::testResampleModes()
+{
+	QCOMPARE(TouchResampler::modeFromString("off", TouchResampler::ModePredict), TouchResampler::ModeOff);
+	QCOMPARE(TouchResampler::modeFromString("interpolate", TouchResampler::ModeOff), TouchResampler::ModeInterpolate);
+	QCOMPARE(TouchResampler::modeFromString("predict", TouchResampler::ModeOff), TouchResampler::ModePredict);
+	QCOMPARE(TouchResampler::modeFromString("bogus", TouchResampler::ModeInterpolate), TouchResampler::ModeInterpolate);
+}
+
 QTEST_MAIN(InputTouch) 
 #include "sysmgrtst_InputTouch.moc"
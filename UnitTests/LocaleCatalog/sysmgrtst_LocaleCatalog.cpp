@@ -0,0 +1,270 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include <QtTest/QtTest>
+
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <glib.h>
+
+#include "QtUtils.h"
+#include "LocaleCatalog.h"
+
+// -------------------------------------------------------------------------
+
+static const int kStringCount = 400;
+
+static std::string key(int i)
+{
+	return QString("Must be at least %d numbers (%1)").arg(i).toStdString();
+}
+
+static std::string translation(int i)
+{
+	return QString::fromUtf8("Au moins %d chiffres \xc3\xa9 (%1)").arg(i).toUtf8().constData();
+}
+
+class LocaleCatalogTest : public QObject
+{
+	Q_OBJECT
+
+private:
+
+	void writeStrings(int count);
+	void writeSource(const char* contents, time_t mtime);
+
+	std::string m_path;
+	std::string m_sourcePath;
+	struct stat m_source;
+
+private Q_SLOTS:
+
+	void init();
+	void cleanup();
+	void testRoundTrip();
+	void testMisses();
+	void testEmpty();
+	void testRejectsCorrupt();
+	void testSource();
+	void benchmarkLookup_data();
+	void benchmarkLookup();
+};
+
+void LocaleCatalogTest::init()
+{
+	m_path = (QDir::tempPath() + "/sysmgrtst_LocaleCatalog").toStdString();
+	::unlink(m_path.c_str());
+
+	m_sourcePath = m_path + ".json";
+	writeSource("{}", 1000000000);
+}
+
+void LocaleCatalogTest::cleanup()
+{
+	::unlink(m_path.c_str());
+	::unlink(m_sourcePath.c_str());
+}
+
+// stands in for the strings.json a catalog is compiled from, as of the given modification time
+void LocaleCatalogTest::writeSource(const char* contents, time_t mtime)
+{
+	QVERIFY(g_file_set_contents(m_sourcePath.c_str(), contents, -1, NULL));
+
+	struct timeval times[2];
+	times[0].tv_sec = times[1].tv_sec = mtime;
+	times[0].tv_usec = times[1].tv_usec = 0;
+	QVERIFY(::utimes(m_sourcePath.c_str(), times) == 0);
+	QVERIFY(::stat(m_sourcePath.c_str(), &m_source) == 0);
+}
+
+void LocaleCatalogTest::writeStrings(int count)
+{
+	LocaleCatalogWriter writer;
+	for (int i = 0; i < count; i++)
+		QVERIFY(writer.add(key(i), translation(i)));
+
+	QCOMPARE(writer.count(), count);
+	QVERIFY(writer.write(m_path, m_source));
+}
+
+void LocaleCatalogTest::testRoundTrip()
+{
+	LocaleCatalogWriter writer;
+	for (int i = 0; i < kStringCount; i++)
+		QVERIFY(writer.add(key(i), translation(i)));
+
+	// layered files: the first one to define a key wins
+	QVERIFY(!writer.add(key(3), "ignored"));
+	QVERIFY(!writer.add("", "ignored"));
+	QVERIFY(writer.add("Untranslated", ""));
+	QVERIFY(writer.write(m_path, m_source));
+
+	LocaleCatalog catalog;
+	QVERIFY(catalog.open(m_path));
+	QCOMPARE(catalog.count(), kStringCount + 1);
+
+	for (int i = 0; i < kStringCount; i++) {
+		std::string k = key(i);
+		LocalizedStringRef value;
+		QVERIFY(catalog.lookup(k.data(), k.size(), &value));
+		QCOMPARE(value.toStdString(), translation(i));
+
+		// usable as a C string as is
+		QCOMPARE(value.data()[value.length()], '\0');
+	}
+
+	LocalizedStringRef value;
+	QVERIFY(catalog.lookup("Untranslated", strlen("Untranslated"), &value));
+	QVERIFY(value.isEmpty());
+}
+
+void LocaleCatalogTest::testMisses()
+{
+	writeStrings(kStringCount);
+
+	LocaleCatalog catalog;
+	QVERIFY(catalog.open(m_path));
+
+	LocalizedStringRef value("untouched", 9);
+	for (int i = kStringCount; i < 10 * kStringCount; i++) {
+		std::string k = key(i);
+		QVERIFY(!catalog.lookup(k.data(), k.size(), &value));
+	}
+
+	// prefixes of keys that are there
+	std::string k = key(7);
+	QVERIFY(!catalog.lookup(k.data(), k.size() - 1, &value));
+	QVERIFY(!catalog.lookup("", 0, &value));
+	QVERIFY(value == "untouched");
+}
+
+void LocaleCatalogTest::testEmpty()
+{
+	writeStrings(0);
+
+	LocaleCatalog catalog;
+	QVERIFY(catalog.open(m_path));
+	QCOMPARE(catalog.count(), 0);
+
+	LocalizedStringRef value;
+	QVERIFY(!catalog.lookup("OK", 2, &value));
+}
+
+void LocaleCatalogTest::testRejectsCorrupt()
+{
+	writeStrings(20);
+
+	gchar* contents = 0;
+	gsize length = 0;
+	QVERIFY(g_file_get_contents(m_path.c_str(), &contents, &length, NULL));
+
+	// a value running past the string table
+	LocaleCatalogHeader header;
+	memcpy(&header, contents, sizeof(header));
+	LocaleCatalogEntry* slots = (LocaleCatalogEntry*) (contents + header.slotsOffset);
+	for (uint32_t i = 0; i < header.slotCount; i++) {
+		if (slots[i].key != LocaleCatalogEntry::kEmpty) {
+			slots[i].valueLength = header.stringsSize;
+			break;
+		}
+	}
+	QVERIFY(g_file_set_contents(m_path.c_str(), contents, length, NULL));
+
+	LocaleCatalog catalog;
+	QVERIFY(!catalog.open(m_path));
+	QVERIFY(!catalog.isOpen());
+
+	// truncated
+	QVERIFY(g_file_set_contents(m_path.c_str(), contents, length / 2, NULL));
+	QVERIFY(!catalog.open(m_path));
+
+	g_free(contents);
+}
+
+void LocaleCatalogTest::testSource()
+{
+	writeStrings(20);
+
+	LocaleCatalog catalog;
+	QVERIFY(!catalog.compiledFrom(m_source));
+	QVERIFY(catalog.open(m_path));
+	QVERIFY(catalog.compiledFrom(m_source));
+
+	// a package putting back an older file, the same size
+	writeSource("[]", 999999999);
+	QVERIFY(!catalog.compiledFrom(m_source));
+
+	// edited within the same second the catalog was compiled from
+	writeSource("{ }", 1000000000);
+	QVERIFY(!catalog.compiledFrom(m_source));
+
+	writeSource("{}", 1000000000);
+	QVERIFY(catalog.compiledFrom(m_source));
+}
+
+void LocaleCatalogTest::benchmarkLookup_data()
+{
+	QTest::addColumn<bool>("catalog");
+
+	QTest::newRow("parsed into a QHash") << false;
+	QTest::newRow("mapped catalog") << true;
+}
+
+// what LOCALIZED() costs per call: the QHash path also builds the std::string key and copies the value
+// out, the way getLocalizedString() did
+void LocaleCatalogTest::benchmarkLookup()
+{
+	QFETCH(bool, catalog);
+
+	writeStrings(kStringCount);
+
+	LocaleCatalog mapped;
+	QVERIFY(mapped.open(m_path));
+
+	QHash<std::string, std::string> hash;
+	std::vector<std::string> keys;
+	for (int i = 0; i < kStringCount; i++) {
+		keys.push_back(key(i));
+		hash.insert(key(i), translation(i));
+	}
+
+	size_t total = 0;
+	QBENCHMARK {
+		for (int i = 0; i < kStringCount; i++) {
+			const char* k = keys[i].c_str();
+			if (catalog) {
+				LocalizedStringRef value;
+				mapped.lookup(k, strlen(k), &value);
+				total += value.length();
+			}
+			else {
+				std::string value = hash.value(std::string(k));
+				total += value.size();
+			}
+		}
+	}
+	QVERIFY(total > 0);
+}
+
+QTEST_APPLESS_MAIN(LocaleCatalogTest)
+#include "sysmgrtst_LocaleCatalog.moc"
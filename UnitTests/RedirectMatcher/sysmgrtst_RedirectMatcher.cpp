@@ -0,0 +1,214 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+#include <QtTest/QtTest>
+
+#include <regex.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "RedirectMatcher.h"
+
+// -------------------------------------------------------------------------
+
+// roughly what command-resource-handlers.json plus a device full of apps registers
+static const char* s_handlerTable[] = {
+	"^mailto:",
+	"^tel:",
+	"^sms:",
+	"^im:",
+	"^rtsp:",
+	"^callto:",
+	"^wtai://wp/mc;",
+	"^palmcontact:",
+	"^maploc:",
+	"^mapto:",
+	"^music:",
+	"^video:",
+	"^amazonmp3:",
+	"^skype:",
+	"^facebook:",
+	"^twitter:",
+	"^geo:",
+	"^market:",
+	"^intent:",
+	"^about:",
+	"^https?://maps\\.google\\.com/",
+	"^https?://www\\.google\\.com/maps",
+	"^https?://www\\.youtube\\.com/watch\\?",
+	"^https?://m\\.youtube\\.com/",
+	"^https?://youtu\\.be/",
+	"^http://www\\.amazon\\.com/gp/dmusic/",
+	"^http://www\\.facebook\\.com/",
+	"^http://m\\.facebook\\.com/",
+	"^http://twitter\\.com/",
+	"^http://mobile\\.twitter\\.com/",
+	"^http://www\\.flickr\\.com/photos/",
+	"^http://developer\\.palm\\.com/appredirect/\\?packageid=",
+	"^http://help\\.palm\\.com/",
+	"^file:///.*\\.(mp3|ogg|aac|m4a)$",
+	"^file:///.*\\.(mp4|3gp|m4v)$",
+	"^file:///.*\\.pdf$",
+	"^file:///.*\\.(doc|docx|xls|xlsx|ppt|pptx)$",
+	"^[a-z]+://[^/]*\\.dropbox\\.com/",
+	".*\\.pls$",
+	0
+};
+
+static const char* s_urls[] = {
+	"mailto:someone@example.com",
+	"tel:5555551212",
+	"http://www.youtube.com/watch?v=abcdef",
+	"https://maps.google.com/?q=sunnyvale",
+	"http://www.example.com/index.html",
+	"http://news.example.org/some/long/path/article?id=1234",
+	"file:///media/internal/music/song.mp3",
+	"file:///media/internal/docs/report.pdf",
+	"HTTP://WWW.FACEBOOK.COM/someone",
+	"https://www.dropbox.com/s/xyz",
+	0
+};
+
+class RedirectMatcherTest : public QObject
+{
+	Q_OBJECT
+
+public:
+
+	RedirectMatcherTest() {}
+
+private:
+
+	std::vector<std::string> m_urlRes;
+	std::vector<regex_t> m_compiled;
+	std::vector<std::string> m_urls;
+	RedirectMatcher m_matcher;
+
+	bool matches(uint32_t index, const std::string& url) {
+		return regexec(&m_compiled[index], url.c_str(), 0, NULL, 0) == 0;
+	}
+
+	// what MimeSystem::getActiveHandlerForRedirect did before: every handler, in table order
+	int firstMatchLinear(const std::string& url) {
+		for (uint32_t i = 0; i < m_compiled.size(); ++i) {
+			if (matches(i, url))
+				return i;
+		}
+		return -1;
+	}
+
+	int firstMatchPruned(const std::string& url) {
+		std::vector<uint32_t> candidates;
+		m_matcher.candidates(url, candidates);
+		for (std::vector<uint32_t>::const_iterator it = candidates.begin(); it != candidates.end(); ++it) {
+			if (matches(*it, url))
+				return *it;
+		}
+		return -1;
+	}
+
+private Q_SLOTS:
+
+	void initTestCase();
+	void cleanupTestCase();
+	void testLiteralPrefix();
+	void testNoMatchesPruned();
+	void benchmarkLinear();
+	void benchmarkPruned();
+};
+
+void RedirectMatcherTest::initTestCase()
+{
+	for (int i = 0; s_handlerTable[i]; ++i) {
+		m_urlRes.push_back(s_handlerTable[i]);
+		regex_t re;
+		QVERIFY(regcomp(&re, s_handlerTable[i], REG_EXTENDED | REG_ICASE | REG_NOSUB) == 0);
+		m_compiled.push_back(re);
+	}
+
+	for (int i = 0; s_urls[i]; ++i)
+		m_urls.push_back(s_urls[i]);
+
+	m_matcher.build(m_urlRes);
+	qDebug() << m_matcher.patternCount() << "patterns," << m_matcher.unprunableCount() << "unprunable";
+}
+
+void RedirectMatcherTest::cleanupTestCase()
+{
+	for (std::vector<regex_t>::iterator it = m_compiled.begin(); it != m_compiled.end(); ++it)
+		regfree(&(*it));
+	m_compiled.clear();
+}
+
+void RedirectMatcherTest::testLiteralPrefix()
+{
+	QCOMPARE(RedirectMatcher::literalPrefix("^mailto:"), std::string("mailto:"));
+	QCOMPARE(RedirectMatcher::literalPrefix("^https?://youtu\\.be/"), std::string("http"));
+	QCOMPARE(RedirectMatcher::literalPrefix("^http://M\\.Facebook\\.com/"), std::string("http://m.facebook.com/"));
+	QCOMPARE(RedirectMatcher::literalPrefix("^file:///.*\\.pdf$"), std::string("file:///"));
+	QCOMPARE(RedirectMatcher::literalPrefix("^ab+c"), std::string("ab"));
+	QCOMPARE(RedirectMatcher::literalPrefix("^a{0,1}b"), std::string(""));
+	QCOMPARE(RedirectMatcher::literalPrefix("^mailto:|^tel:"), std::string(""));
+	QCOMPARE(RedirectMatcher::literalPrefix("^(mailto|tel):"), std::string(""));
+	QCOMPARE(RedirectMatcher::literalPrefix("^[|]x"), std::string(""));
+	QCOMPARE(RedirectMatcher::literalPrefix(".*\\.pls$"), std::string(""));
+}
+
+void RedirectMatcherTest::testNoMatchesPruned()
+{
+	for (std::vector<std::string>::const_iterator url = m_urls.begin(); url != m_urls.end(); ++url) {
+
+		std::vector<uint32_t> candidates;
+		m_matcher.candidates(*url, candidates);
+
+		for (uint32_t i = 0; i < m_compiled.size(); ++i) {
+			if (!matches(i, *url))
+				continue;
+			QVERIFY2(std::find(candidates.begin(), candidates.end(), i) != candidates.end(),
+					 (*url + " vs " + m_urlRes[i]).c_str());
+		}
+
+		QCOMPARE(firstMatchPruned(*url), firstMatchLinear(*url));
+	}
+}
+
+void RedirectMatcherTest::benchmarkLinear()
+{
+	int found = 0;
+	QBENCHMARK {
+		for (std::vector<std::string>::const_iterator url = m_urls.begin(); url != m_urls.end(); ++url)
+			found += firstMatchLinear(*url) >= 0 ? 1 : 0;
+	}
+	QVERIFY(found > 0);
+}
+
+void RedirectMatcherTest::benchmarkPruned()
+{
+	int found = 0;
+	QBENCHMARK {
+		for (std::vector<std::string>::const_iterator url = m_urls.begin(); url != m_urls.end(); ++url)
+			found += firstMatchPruned(*url) >= 0 ? 1 : 0;
+	}
+	QVERIFY(found > 0);
+}
+
+QTEST_APPLESS_MAIN(RedirectMatcherTest)
+#include "sysmgrtst_RedirectMatcher.moc"
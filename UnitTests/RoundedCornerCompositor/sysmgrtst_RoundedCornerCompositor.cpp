@@ -0,0 +1,194 @@
+/* @@@LICENSE
+*
+*      Copyright (c) 2012 Hewlett-Packard Development Company, L.P.
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+* http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*
+* LICENSE@@@ */
+
+
+
+
+#include <QtTest/QtTest>
+
+#include <QImage>
+#include <QLinearGradient>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPixmap>
+
+#include "RoundedCornerCompositor.h"
+
+// -------------------------------------------------------------------------
+
+static const int kCardWidth = 320;
+static const int kCardHeight = 480;
+static const qreal kRadius = 25;
+
+// something that shows a misplaced source rect: a gradient with a grid over it
+static QPixmap makeCard()
+{
+	QImage image(kCardWidth, kCardHeight, QImage::Format_ARGB32_Premultiplied);
+	QPainter p(&image);
+	QLinearGradient gradient(0, 0, kCardWidth, kCardHeight);
+	gradient.setColorAt(0, QColor(0x20, 0x60, 0xc0));
+	gradient.setColorAt(1, QColor(0xe0, 0xa0, 0x40));
+	p.fillRect(image.rect(), gradient);
+	p.setPen(Qt::white);
+	for (int i = 0; i < kCardWidth; i += 16)
+		p.drawLine(i, 0, i, kCardHeight);
+	for (int i = 0; i < kCardHeight; i += 16)
+		p.drawLine(0, i, kCardWidth, i);
+	p.end();
+	return QPixmap::fromImage(image);
+}
+
+// the card centered on the origin, like CardWindow's bounding rect
+static void paintCard(QPainter* painter, const QPixmap& card, bool compositor)
+{
+	QRectF rect(-kCardWidth / 2, -kCardHeight / 2, kCardWidth, kCardHeight);
+	if (compositor) {
+		RoundedCornerCompositor::draw(painter, rect, kRadius, kRadius, card, rect.topLeft());
+	}
+	else {
+		QPainterPath path;
+		path.addRoundedRect(rect, kRadius, kRadius);
+		painter->setBrushOrigin(rect.topLeft());
+		painter->fillPath(path, card);
+		painter->setBrushOrigin(0, 0);
+	}
+}
+
+static QImage render(const QPixmap& card, qreal scale, bool compositor)
+{
+	QImage target(kCardWidth + 40, kCardHeight + 40, QImage::Format_ARGB32_Premultiplied);
+	target.fill(qRgb(0x80, 0x00, 0x00));
+
+	QPainter p(&target);
+	p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+	p.translate(target.width() / 2, target.height() / 2);
+	p.scale(scale, scale);
+	paintCard(&p, card, compositor);
+	p.end();
+	return target;
+}
+
+static int channelDiff(QRgb a, QRgb b)
+{
+	return qMax(qMax(qAbs(qRed(a) - qRed(b)), qAbs(qGreen(a) - qGreen(b))),
+				qMax(qAbs(qBlue(a) - qBlue(b)), qAbs(qAlpha(a) - qAlpha(b))));
+}
+
+class RoundedCornerCompositorTest : public QObject
+{
+	Q_OBJECT
+
+private Q_SLOTS:
+
+	void init();
+	void testMasks();
+	void testMatchesPathFill_data();
+	void testMatchesPathFill();
+	void benchmarkCardView_data();
+	void benchmarkCardView();
+};
+
+void RoundedCornerCompositorTest::init()
+{
+	RoundedCornerCompositor::clearMasks();
+}
+
+void RoundedCornerCompositorTest::testMasks()
+{
+	const QImage& topLeft = RoundedCornerCompositor::cornerMask(20, 10, RoundedCornerCompositor::TopLeft);
+	QCOMPARE(topLeft.size(), QSize(20, 10));
+	QCOMPARE(qAlpha(topLeft.pixel(0, 0)), 0);
+	QCOMPARE(qAlpha(topLeft.pixel(19, 9)), 255);
+
+	const QImage& bottomRight = RoundedCornerCompositor::cornerMask(20, 10, RoundedCornerCompositor::BottomRight);
+	QCOMPARE(qAlpha(bottomRight.pixel(19, 9)), 0);
+	QCOMPARE(qAlpha(bottomRight.pixel(0, 0)), 255);
+
+	// kept for the next frame
+	QCOMPARE(RoundedCornerCompositor::cachedMasks(), 2);
+	RoundedCornerCompositor::cornerMask(20, 10, RoundedCornerCompositor::TopLeft);
+	QCOMPARE(RoundedCornerCompositor::cachedMasks(), 2);
+}
+
+void RoundedCornerCompositorTest::testMatchesPathFill_data()
+{
+	QTest::addColumn<qreal>("scale");
+
+	QTest::newRow("maximized size") << (qreal) 1.0;
+	QTest::newRow("card view") << (qreal) 0.6;
+}
+
+void RoundedCornerCompositorTest::testMatchesPathFill()
+{
+	QFETCH(qreal, scale);
+
+	QPixmap card = makeCard();
+	QImage expected = render(card, scale, false);
+	QImage actual = render(card, scale, true);
+
+	// only the anti-aliased outline may come out a little different
+	int differing = 0;
+	for (int y = 0; y < expected.height(); y++) {
+		for (int x = 0; x < expected.width(); x++) {
+			int diff = channelDiff(expected.pixel(x, y), actual.pixel(x, y));
+			QVERIFY2(diff <= 96, qPrintable(QString("(%1, %2) off by %3").arg(x).arg(y).arg(diff)));
+			if (diff > 8)
+				differing++;
+		}
+	}
+
+	int perimeter = 2 * (kCardWidth + kCardHeight) * scale;
+	QVERIFY2(differing < perimeter / 4, qPrintable(QString("%1 pixels differ").arg(differing)));
+}
+
+void RoundedCornerCompositorTest::benchmarkCardView_data()
+{
+	QTest::addColumn<bool>("compositor");
+	QTest::addColumn<int>("cards");
+
+	QTest::newRow("path fill, 3 cards") << false << 3;
+	QTest::newRow("compositor, 3 cards") << true << 3;
+	QTest::newRow("path fill, 12 cards") << false << 12;
+	QTest::newRow("compositor, 12 cards") << true << 12;
+}
+
+// a frame of card view: cards at card view scale, overlapping side by side across a 1024x768 screen
+void RoundedCornerCompositorTest::benchmarkCardView()
+{
+	QFETCH(bool, compositor);
+	QFETCH(int, cards);
+
+	QPixmap card = makeCard();
+	QImage screen(1024, 768, QImage::Format_ARGB32_Premultiplied);
+
+	QBENCHMARK {
+		screen.fill(0);
+		QPainter p(&screen);
+		p.setRenderHint(QPainter::SmoothPixmapTransform, true);
+		for (int i = 0; i < cards; i++) {
+			p.save();
+			p.translate(150 + i * (724 / cards), 384);
+			p.scale(0.6, 0.6);
+			paintCard(&p, card, compositor);
+			p.restore();
+		}
+	}
+}
+
+QTEST_MAIN(RoundedCornerCompositorTest)
+#include "sysmgrtst_RoundedCornerCompositor.moc"
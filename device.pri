@@ -127,9 +127,11 @@ contains(CONFIG_BUILD, qpa) {
 else {
     HEADERS += 		hiddkbd_qws.h \
 			hiddtp_qws.h \
+			TouchRecording.h \
 			
     SOURCES +=  	hiddkbd_qws.cpp \
 			hiddtp_qws.cpp \
+			TouchRecording.cpp \
 			hiddkbd.cpp \
 			hiddtp.cpp 
 
@@ -139,12 +141,14 @@ else {
 HEADERS += 		HostArm.h \
 			SoundPlayer.h \
 			hal/HalInputControl.h \
+                        hal/HALSensorBatch.h \
                         hal/HALSensorConnector.h
 
 VPATH += Src/input
 
 SOURCES += 	   SoundPlayer.cpp \
 	   hal/HalInputControl.cpp \
+           hal/HALSensorBatch.cpp \
            hal/HALSensorConnector.cpp
 
 
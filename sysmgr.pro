@@ -137,7 +137,10 @@ SOURCES = \
 	BannerMessageEventFactory.cpp \
 	ApplicationDescription.cpp \
 	LaunchPoint.cpp \
+	LaunchPointSearchIndex.cpp \
 	ApplicationManager.cpp \
+	AppScanCache.cpp \
+	AppRegistrySnapshot.cpp \
 	CmdResourceHandlers.cpp \
 	ApplicationManagerService.cpp \
 	BackupManager.cpp \
@@ -145,7 +148,9 @@ SOURCES = \
 	ApplicationInstaller.cpp \
 	WindowManagerBase.cpp \
 	WindowServer.cpp \
-	FpsHistory.cpp \
+	FrameTimings.cpp \
+	TouchResampler.cpp \
+	ScreenCapture.cpp \
 	TouchPlot.cpp \
 	WindowServerLuna.cpp \
 	WindowServerMinimal.cpp \
@@ -191,15 +196,18 @@ SOURCES = \
 	PersistentWindowCache.cpp \
 	WindowContentTransitionRunner.cpp \
 	RoundedCorners.cpp \
+	RoundedCornerCompositor.cpp \
 	CoreNaviManager.cpp \
 	CoreNaviLeds.cpp \
 	MemoryWatcher.cpp \
+	LocaleCatalog.cpp \
 	Localization.cpp \
 	DeviceInfo.cpp \
 	Security.cpp \
 	EASPolicyManager.cpp \
 	AnimationSettings.cpp \
 	MimeSystem.cpp \
+	RedirectMatcher.cpp \
 	IpcServer.cpp \
 	IpcClientHost.cpp \
 	WebAppMgrProxy.cpp\
@@ -207,6 +215,7 @@ SOURCES = \
 	ApplicationStatus.cpp \
 	FullEraseConfirmationWindow.cpp \
 	SoundPlayerPool.cpp \
+	FeedbackMixer.cpp \
 	AsyncCaller.cpp \
 	HostWindow.cpp \
 	HostWindowData.cpp \
@@ -311,6 +320,8 @@ HEADERS = \
 	ApplicationInstallerErrors.h \
 	ApplicationInstaller.h \
 	ApplicationManager.h \
+	AppScanCache.h \
+	AppRegistrySnapshot.h \
 	ApplicationStatus.h \
 	BackupManager.h \
 	CmdResourceHandlers.h \
@@ -333,13 +344,17 @@ HEADERS = \
 	RemoteWindowData.h \
 	InputManager.h \
 	LaunchPoint.h \
+	LaunchPointSearchIndex.h \
+	LocaleCatalog.h \
 	Localization.h \
 	Logging.h \
 	MetaKeyManager.h \
 	MimeSystem.h \
+	RedirectMatcher.h \
 	Preferences.h \
 	ProcessManager.h \
 	RoundedCorners.h \
+	RoundedCornerCompositor.h \
 	Security.h \
 	Settings.h \
 	SuspendBlocker.h \
@@ -350,6 +365,9 @@ HEADERS = \
 	Window.h \
 	WindowManagerBase.h \
 	WindowServer.h \
+	FrameTimings.h \
+	TouchResampler.h \
+	ScreenCapture.h \
 	TouchPlot.h \
 	AnimationEquations.h \
 	AsyncCaller.h \
@@ -394,6 +412,7 @@ HEADERS = \
 	WebAppMgrProxy.h \
 	SoundPlayer.h \
 	SoundPlayerPool.h \
+	FeedbackMixer.h \
 	MemoryWatcher.h \
 	ProcessBase.h \
 	WebAppBase.h \
@@ -756,6 +775,11 @@ contains(CONFIG_BUILD, haptics) {
 	DEFINES += HAPTICS=1
 }
 
+contains(CONFIG_BUILD, feedbackmixer) {
+	DEFINES += HAVE_PULSE_FEEDBACK
+	LIBS += -lpulse-simple -lpulse
+}
+
 DESTDIR = ./$${BUILD_TYPE}-$${MACHINE_NAME}
 
 OBJECTS_DIR = $$DESTDIR/.obj